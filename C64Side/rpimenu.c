@@ -126,6 +126,74 @@ __asm__ ("loop2:");
 }
 
 
+// only the rows which changed, see buildScreenDelta in kernel_menu.cpp
+void updateScreenDelta()
+{
+    __asm__ ("pha");
+    __asm__ ("lda $fb");
+    __asm__ ("pha");
+    __asm__ ("lda $fc");
+    __asm__ ("pha");
+    __asm__ ("lda $fd");
+    __asm__ ("pha");
+    __asm__ ("lda $fe");
+    __asm__ ("pha");
+
+    __asm__ ("lda #250");
+    __asm__ ("dwait: cmp $d012");
+    __asm__ ("bne dwait");
+
+    // start delta transfer
+    __asm__ ("lda #$02");
+    __asm__ ("sta $df00");
+
+__asm__ ("drow:");
+    // screen address of the next row, 0 = done
+    __asm__ ("lda $df09");
+    __asm__ ("beq ddone");
+    __asm__ ("sta $fc");
+    __asm__ ("clc");
+    __asm__ ("adc #$d4");
+    __asm__ ("sta $fe");
+    __asm__ ("lda $df09");
+    __asm__ ("sta $fb");
+    __asm__ ("sta $fd");
+
+    __asm__ ("ldy #$00");
+__asm__ ("dloop:");
+    __asm__ ("lda $df09");
+    __asm__ ("sta ($fb),y");
+    __asm__ ("lda $df09");
+    __asm__ ("sta ($fd),y");
+    __asm__ ("iny");
+    __asm__ ("lsr");
+    __asm__ ("lsr");
+    __asm__ ("lsr");
+    __asm__ ("lsr");
+    __asm__ ("sta ($fd),y");
+    __asm__ ("lda $df09");
+    __asm__ ("sta ($fb),y");
+    __asm__ ("iny");
+    __asm__ ("cpy #40");
+    __asm__ ("bne dloop");
+    __asm__ ("jmp drow");
+
+__asm__ ("ddone:");
+    __asm__ ("pla");
+    __asm__ ("sta $fe");
+    __asm__ ("pla");
+    __asm__ ("sta $fd");
+    __asm__ ("pla");
+    __asm__ ("sta $fc");
+    __asm__ ("pla");
+    __asm__ ("sta $fb");
+    __asm__ ("pla");
+
+    // execute code on the RPi (changed upper/lower case, border/bg color etc.)
+    __asm__ ("jsr $df10");
+}
+
+
 void copyCharset()
 {
     __asm__ ("pha");
@@ -202,6 +270,44 @@ void readSIDKick_Version()
 }
 
 
+// bus timing calibration requested on the RPi (settings screen), see buscal.h
+void calibrateTiming()
+{
+    __asm__ ("sei");
+    __asm__ ("lda $d011");
+    __asm__ ("and #$ef");
+    __asm__ ("sta $d011");
+
+__asm__ ("calround:");
+    // start round, the RPi switches to the next candidate timing
+    __asm__ ("sta $df06");
+
+    // 256 x 15 cycles: read pattern byte, echo it inverted
+    __asm__ ("ldx #$00");
+__asm__ ("calloop:");
+    __asm__ ("lda $df07");
+    __asm__ ("eor #$ff");
+    __asm__ ("sta $df08");
+    __asm__ ("inx");
+    __asm__ ("bne calloop");
+
+    // wait until the RPi is back to the configured timing
+    __asm__ ("ldy #$00");
+__asm__ ("caldelay:");
+    __asm__ ("dey");
+    __asm__ ("bne caldelay");
+
+    __asm__ ("lda $df06");
+    __asm__ ("cmp #$ca");
+    __asm__ ("beq calround");
+
+    __asm__ ("lda $d011");
+    __asm__ ("ora #$10");
+    __asm__ ("sta $d011");
+    __asm__ ("cli");
+}
+
+
 #define VK_LEFT		157
 #define VK_RIGHT	29
 #define VK_UP		145
@@ -210,7 +316,7 @@ void readSIDKick_Version()
 
 int main (void)
 {
-    char key, x, firstHit;
+    char key, x, firstHit, fullUpdate;
 	unsigned char /*joy1, joy1prev, */joy2, joy2prev;
 
     *(unsigned char*)(0x01) = 15;
@@ -286,8 +392,11 @@ int main (void)
 
         // sendKeypress
         //key = cgetc();
+        fullUpdate = 0;
         if ( ( key == 29 || key == 's' || key == 'S' ) && *((char *)(0x0427)) != 0 )
         {
+            // color RAM is changed here, i.e. the RPi's copy is outdated
+            fullUpdate = 1;
             __asm__ ("lda #$0a");
             __asm__ ("ldx #$20");
             __asm__ ("loop:");
@@ -299,7 +408,17 @@ int main (void)
         wireDetection();
         *((char *)(0xdf01)) = key;
 		waitvsync();
-        updateScreen();
+        if ( fullUpdate )
+            updateScreen(); else
+            updateScreenDelta();
+
+        if ( *((unsigned char *)(0xdf06)) == 0xca )
+        {
+            calibrateTiming();
+            *((char *)(0xdf01)) = 0; // dummy keypress, shows the result
+            waitvsync();
+            updateScreenDelta();
+        }
 
 		if ( firstHit )
 			for ( x = 0; x < 15; x++ )
@@ -25,6 +25,8 @@
 #include <circle/devicenameservice.h>
 #include <circle/sched/scheduler.h>
 #include <circle/logger.h>
+#include <circle/synchronize.h>
+#include <circle/util.h>
 #include <assert.h>
 
 #define VOLUME_TO_CHIP(volume)		((unsigned) -(((volume) << 8) / 100))
@@ -41,7 +43,15 @@ CVCHIQSoundBaseDevice::CVCHIQSoundBaseDevice (CVCHIQDevice *pVCHIQDevice,
 	m_Destination (Destination),
 	m_State (VCHIQSoundCreated),
 	m_VCHIInstance (0),
-	m_hService (0)
+	m_hService (0),
+	m_pSpanQueue (0),
+	m_nSpanFrames (0),
+	m_nSpanIn (0),
+	m_nSpanOut (0),
+	m_nSpanUnderruns (0),
+	m_bSpanDrain (FALSE),
+	m_pChunkCallback (0),
+	m_pChunkCallbackParam (0)
 {
 	//assert (44100 <= nSampleRate && nSampleRate <= 48000);
 	assert (Destination < VCHIQSoundDestinationUnknown);
@@ -53,6 +63,9 @@ CVCHIQSoundBaseDevice::~CVCHIQSoundBaseDevice (void)
 {
 	assert (m_State <= VCHIQSoundIdle);
 
+	delete [] m_pSpanQueue;
+	m_pSpanQueue = 0;
+
 	CDeviceNameService::Get ()->RemoveDevice ("sndvchiq", FALSE);
 }
 
@@ -312,6 +325,55 @@ void CVCHIQSoundBaseDevice::SetControl (int nVolume, TVCHIQSoundDestination Dest
 	}
 }
 
+void CVCHIQSoundBaseDevice::SetChunkSize (unsigned nChunkSize)
+{
+	assert (nChunkSize > 0);
+
+	m_nChunkSize = nChunkSize;
+}
+
+boolean CVCHIQSoundBaseDevice::AllocateSpanQueue (unsigned nFrames)
+{
+	assert (m_pSpanQueue == 0);
+	assert (nFrames > 0 && (nFrames & (nFrames-1)) == 0);
+
+	m_pSpanQueue = new s16[nFrames * 2];
+	if (m_pSpanQueue == 0)
+	{
+		return FALSE;
+	}
+
+	m_nSpanFrames = nFrames;
+	ClearSpanQueue ();
+
+	return TRUE;
+}
+
+void CVCHIQSoundBaseDevice::ClearSpanQueue (void)
+{
+	assert (!IsActive ());
+
+	m_nSpanIn = m_nSpanOut = 0;
+	m_nSpanUnderruns = 0;
+	m_bSpanDrain = FALSE;
+}
+
+void CVCHIQSoundBaseDevice::CommitSpan (unsigned nFrames)
+{
+	assert (nFrames <= m_nSpanFrames - (m_nSpanIn - m_nSpanOut));
+
+	// the frames must be in memory before the consumer sees the new write position
+	DataMemBarrier ();
+
+	m_nSpanIn += nFrames;
+}
+
+void CVCHIQSoundBaseDevice::RegisterChunkCallback (TSoundDataCallback *pCallback, void *pParam)
+{
+	m_pChunkCallbackParam = pParam;
+	m_pChunkCallback = pCallback;
+}
+
 int CVCHIQSoundBaseDevice::CallMessage (VC_AUDIO_MSG_T *pMessage)
 {
 	m_Event.Clear ();
@@ -343,6 +405,11 @@ int CVCHIQSoundBaseDevice::QueueMessage (VC_AUDIO_MSG_T *pMessage)
 
 int CVCHIQSoundBaseDevice::WriteChunk (void)
 {
+	if (m_pSpanQueue != 0)
+	{
+		return WriteSpanChunk ();
+	}
+
 	s16 Buffer[m_nChunkSize];
 	unsigned nWords = GetChunk (Buffer, m_nChunkSize);
 	if (nWords == 0)
@@ -392,6 +459,133 @@ int CVCHIQSoundBaseDevice::WriteChunk (void)
 	return 0;
 }
 
+// sends the next chunk straight out of the span queue (vchi_msg_queue() copies the data into the slot)
+int CVCHIQSoundBaseDevice::WriteSpanChunk (void)
+{
+	unsigned nFrames = m_nChunkSize / 2;
+	unsigned nAvail = m_nSpanIn - m_nSpanOut;
+
+	// read the frames only after the write position
+	DataMemBarrier ();
+
+	if (nAvail == 0 && m_bSpanDrain)
+	{
+		m_State = VCHIQSoundIdle;
+
+		return 0;
+	}
+
+	if (nAvail < nFrames && !m_bSpanDrain)
+	{
+		m_nSpanUnderruns++;
+	}
+
+	VC_AUDIO_MSG_T Msg;
+
+	Msg.type = VC_AUDIO_MSG_TYPE_WRITE;
+	Msg.u.write.max_packet = 4000;
+	Msg.u.write.cookie1 = VC_AUDIO_WRITE_COOKIE1;
+	Msg.u.write.cookie2 = VC_AUDIO_WRITE_COOKIE2;
+	Msg.u.write.silence = 0;
+
+	int nResult;
+
+	if (nAvail == 0)
+	{
+		// nothing rendered yet: keep the transfer running with a chunk of silence
+		s16 Silence[m_nChunkSize];
+		memset (Silence, 0, sizeof Silence);
+
+		Msg.u.write.count = sizeof Silence;
+		nResult = vchi_msg_queue (m_hService, &Msg, sizeof Msg, VCHI_FLAGS_BLOCK_UNTIL_QUEUED, 0);
+		if (nResult == 0)
+		{
+			nResult = QueueData (Silence, sizeof Silence, Msg.u.write.max_packet);
+		}
+		if (nResult != 0)
+		{
+			return nResult;
+		}
+
+		m_nWritePos += sizeof Silence;
+	}
+	else
+	{
+		if (nFrames > nAvail)
+		{
+			nFrames = nAvail;
+		}
+
+		nResult = WriteSpanFrames (&Msg, nFrames);
+		if (nResult != 0)
+		{
+			return nResult;
+		}
+	}
+
+	if (m_pChunkCallback != 0)
+	{
+		(*m_pChunkCallback) (m_pChunkCallbackParam);
+	}
+
+	return 0;
+}
+
+int CVCHIQSoundBaseDevice::WriteSpanFrames (VC_AUDIO_MSG_T *pMsg, unsigned nFrames)
+{
+	int nResult;
+
+	unsigned nPos = m_nSpanOut & (m_nSpanFrames-1);
+	unsigned nFirst = m_nSpanFrames - nPos;
+	if (nFirst > nFrames)
+	{
+		nFirst = nFrames;
+	}
+
+	unsigned nBytes = nFrames * 2 * sizeof (s16);
+	pMsg->u.write.count = nBytes;
+
+	nResult = vchi_msg_queue (m_hService, pMsg, sizeof *pMsg, VCHI_FLAGS_BLOCK_UNTIL_QUEUED, 0);
+	if (nResult == 0)
+	{
+		nResult = QueueData (&m_pSpanQueue[nPos * 2], nFirst * 2 * sizeof (s16), pMsg->u.write.max_packet);
+	}
+	if (nResult == 0 && nFirst < nFrames)
+	{
+		nResult = QueueData (&m_pSpanQueue[0], (nFrames - nFirst) * 2 * sizeof (s16), pMsg->u.write.max_packet);
+	}
+	if (nResult != 0)
+	{
+		return nResult;
+	}
+
+	m_nWritePos += nBytes;
+	m_nSpanOut += nFrames;
+
+	return 0;
+}
+
+int CVCHIQSoundBaseDevice::QueueData (const void *pData, unsigned nBytes, unsigned nMaxPacket)
+{
+	const u8 *pBuffer8 = (const u8 *) pData;
+	while (nBytes > 0)
+	{
+		unsigned nBytesToQueue = nBytes <= nMaxPacket ? nBytes : nMaxPacket;
+
+		int nResult = vchi_msg_queue (m_hService, pBuffer8, nBytesToQueue,
+					      VCHI_FLAGS_BLOCK_UNTIL_QUEUED, 0);
+		if (nResult != 0)
+		{
+			return nResult;
+		}
+
+		pBuffer8 += nBytesToQueue;
+		nBytes -= nBytesToQueue;
+	}
+
+	return 0;
+}
+
 void CVCHIQSoundBaseDevice::Callback (const VCHI_CALLBACK_REASON_T Reason, void *hMessage)
 {
 	if (Reason != VCHI_CALLBACK_MSG_AVAILABLE)
@@ -91,6 +91,49 @@ public:
 
 	void Callback (const VCHI_CALLBACK_REASON_T Reason, void *hMessage);
 
+	/// \param nChunkSize	number of samples transfered at once (takes effect with the next chunk)
+	void SetChunkSize (unsigned nChunkSize);
+
+	/// \brief Allocates a queue the producer renders into directly (replaces AllocateQueue() and Write())
+	/// \param nFrames	size of the queue in stereo frames (power of 2)
+	/// \return Operation successful?
+	boolean AllocateSpanQueue (unsigned nFrames);
+
+	/// \brief Discards all frames in the span queue (only while not active)
+	void ClearSpanQueue (void);
+
+	/// \brief Plays the remaining frames of the span queue, then becomes inactive (instead of sending silence)
+	void DrainSpanQueue (void)			{ m_bSpanDrain = TRUE; }
+
+	/// \brief Reserves a contiguous span at the write position of the span queue
+	/// \param nFrames	number of stereo frames to be written (always the same, the queue size must be a multiple of it)
+	/// \return Pointer to 2*nFrames s16 words (left, right, ...), 0 if the queue is full
+	s16 *ReserveSpan (unsigned nFrames)
+	{
+		unsigned nPos = m_nSpanIn & (m_nSpanFrames-1);
+		if (m_nSpanFrames - (m_nSpanIn - m_nSpanOut) < nFrames)
+		{
+			return 0;
+		}
+
+		return &m_pSpanQueue[nPos * 2];
+	}
+
+	/// \brief Makes the frames written to the reserved span available for playback
+	void CommitSpan (unsigned nFrames);
+
+	/// \return Number of frames in the span queue waiting for playback
+	unsigned GetSpanFramesQueued (void) const	{ return m_nSpanIn - m_nSpanOut; }
+
+	/// \return Number of frames sent to the device, but not yet played
+	unsigned GetFramesInFlight (void) const		{ return (m_nWritePos - m_nCompletePos) / (2 * sizeof (s16)); }
+
+	/// \return Number of chunks which had to be sent with missing frames
+	unsigned GetSpanUnderruns (void) const		{ return m_nSpanUnderruns; }
+
+	/// \brief The callback is called after a chunk from the span queue has been sent
+	void RegisterChunkCallback (TSoundDataCallback *pCallback, void *pParam);
+
 protected:
 	/// \brief May overload this to provide the sound samples!
 	/// \param pBuffer	buffer where the samples have to be placed
@@ -106,6 +149,9 @@ private:
 	int QueueMessage (VC_AUDIO_MSG_T *pMessage);	// does not wait for completion
 
 	int WriteChunk (void);
+	int WriteSpanChunk (void);
+	int WriteSpanFrames (VC_AUDIO_MSG_T *pMsg, unsigned nFrames);
+	int QueueData (const void *pData, unsigned nBytes, unsigned nMaxPacket);
 
 	static void CallbackStub (void *pParam, const VCHI_CALLBACK_REASON_T Reason, void *hMessage);
 
@@ -124,6 +170,16 @@ private:
 
 	unsigned m_nWritePos;
 	unsigned m_nCompletePos;
+
+	s16 *m_pSpanQueue;				// interleaved stereo frames, the producer renders into it directly
+	unsigned m_nSpanFrames;
+	volatile unsigned m_nSpanIn;	// free running frame counters
+	volatile unsigned m_nSpanOut;
+	volatile unsigned m_nSpanUnderruns;
+	volatile boolean m_bSpanDrain;
+
+	TSoundDataCallback *m_pChunkCallback;
+	void *m_pChunkCallbackParam;
 };
 
 #endif
@@ -37,6 +37,7 @@ chunkpool_init(struct chunkpool *ctx, int size)
     ctx->chunk = -1;
     ctx->chunk_pos = 0;
     ctx->chunk_max = (0x1fffff / size) * size;
+    ctx->failed = 0;
 }
 
 void
@@ -64,16 +65,16 @@ chunkpool_malloc(struct chunkpool *ctx)
 	    LOG(LOG_BRIEF, ("chunk_size %d\n", ctx->chunk_size));
 	    LOG(LOG_BRIEF, ("chunk_max %d\n", ctx->chunk_max));
 	    LOG(LOG_BRIEF, ("chunk %d\n", ctx->chunk));
-	    //exit(1);
-        return;
+	    ctx->failed = 1;
+	    return NULL;
 	}
 	m = malloc(ctx->chunk_max);
 	if (m == NULL)
 	{
 	    LOG(LOG_ERROR, ("out of memory error in file %s, line %d\n",
 			    __FILE__, __LINE__));
-	    //exit(1);
-		return;
+	    ctx->failed = 1;
+	    return NULL;
 	}
 	ctx->chunk += 1;
 	ctx->chunks[ctx->chunk] = m;
@@ -91,6 +92,9 @@ void *
 chunkpool_calloc(struct chunkpool *ctx)
 {
     void *p = chunkpool_malloc(ctx);
-    memset(p, 0, ctx->chunk_size);
+    if (p != NULL)
+    {
+        memset(p, 0, ctx->chunk_size);
+    }
     return p;
 }
@@ -34,6 +34,7 @@ struct chunkpool {
     int chunk_pos;
     int chunk_max;
     void *chunks[32];
+    int failed;         /* set when malloc returned NULL, see below */
 };
 
 void
@@ -42,6 +43,8 @@ chunkpool_init(struct chunkpool *ctx, int size);
 void
 chunkpool_free(struct chunkpool *ctx);
 
+/* returns NULL when out of chunks or memory and sets ctx->failed,
+ * which stays set until chunkpool_init */
 void *
 chunkpool_malloc(struct chunkpool *ctx);
 
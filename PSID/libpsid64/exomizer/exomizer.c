@@ -35,6 +35,7 @@
 #include "optimal.h"
 #include "output.h"
 #include "sfx.h"
+#include "exomizer.h"
 
 static
 int
@@ -122,9 +123,11 @@ generate_output(match_ctx ctx,
     return len;
 }
 
+/* returns NULL if out of memory */
 static
 search_nodep
-do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
+do_compress(match_ctx ctx, encode_match_data emd, int max_passes,
+            const struct exomizer_options *options, unsigned int t0)
 {
     matchp_cache_enum mpce;
     matchp_snp_enum snpe;
@@ -132,11 +135,17 @@ do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
     search_nodep best_snp;
     int pass;
     float old_size;
+    unsigned int t1, t2;
 
     pass = 1;
 
+    t1 = t0;
+
     matchp_cache_get_enum(ctx, mpce);
-    optimal_optimize(emd, matchp_cache_enum_get_next, mpce);
+    if (optimal_optimize(emd, matchp_cache_enum_get_next, mpce) < 0)
+    {
+        return NULL;
+    }
 
     best_snp = NULL;
     old_size = 1000000.0;
@@ -146,9 +155,8 @@ do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
         snp = search_buffer(ctx, optimal_encode, emd);
         if (snp == NULL)
         {
-            //fprintf(stderr, "error: search_buffer() returned NULL\n");
-            //exit(-1);
-            return;
+            LOG(LOG_ERROR, ("error: search_buffer() returned NULL\n"));
+            return NULL;
         }
 
         float size = snp->total_score;
@@ -175,11 +183,26 @@ do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
             break;
         }
 
+        /* assume the next pass takes as long as this one, the tables
+         * must not be changed after the last search */
+        if (options->clock != NULL && options->time_budget > 0)
+        {
+            t2 = options->clock();
+            if ((t2 - t0) + (t2 - t1) > options->time_budget)
+            {
+                break;
+            }
+            t1 = t2;
+        }
+
         optimal_free(emd);
         optimal_init(emd);
 
         matchp_snp_get_enum(snp, snpe);
-        optimal_optimize(emd, matchp_snp_enum_get_next, snpe);
+        if (optimal_optimize(emd, matchp_snp_enum_get_next, snpe) < 0)
+        {
+            return NULL;
+        }
     }
 
     return best_snp;
@@ -187,6 +210,16 @@ do_compress(match_ctx ctx, encode_match_data emd, int max_passes)
 
 
 int exomizer(unsigned char *srcbuf, int len, int load, int start, unsigned char *destbuf)
+{
+    struct exomizer_options options;
+
+    memset(&options, 0, sizeof(options));
+
+    return exomizer_ex(srcbuf, len, load, start, destbuf, &options);
+}
+
+int exomizer_ex(unsigned char *srcbuf, int len, int load, int start, unsigned char *destbuf,
+                const struct exomizer_options *options)
 {
     int destlen;
     int max_offset = 65536;
@@ -195,15 +228,49 @@ int exomizer(unsigned char *srcbuf, int len, int load, int start, unsigned char
     encode_match_data emd;
     encode_match_priv optimal_priv;
     search_nodep snp;
+    unsigned int t0;
+
+    t0 = 0;
+    if (options->clock != NULL)
+    {
+        t0 = options->clock();
+    }
+
+    if (options->max_offset > 0)
+    {
+        max_offset = options->max_offset;
+    }
+    if (options->max_passes > 0)
+    {
+        max_passes = options->max_passes;
+    }
 
-    match_ctx_init(ctx, srcbuf, len, max_offset);
+    if (options->max_depth > 0)
+    {
+        match_ctx_init_fast(ctx, srcbuf, len, max_offset, options->max_depth);
+    }
+    else
+    {
+        match_ctx_init(ctx, srcbuf, len, max_offset);
+    }
 
     emd->out = NULL;
     emd->priv = optimal_priv;
 
     optimal_init(emd);
 
-    snp = do_compress(ctx, emd, max_passes);
+    snp = NULL;
+    if (!ctx->m_pool->failed)
+    {
+        snp = do_compress(ctx, emd, max_passes, options, t0);
+    }
+    if (snp == NULL)
+    {
+        /* out of memory, the match lists or tables are incomplete */
+        optimal_free(emd);
+        match_ctx_free(ctx);
+        return -1;
+    }
 
     destlen = generate_output(ctx, snp, sfx_c64ne, optimal_encode, emd,
                               load, len, start, destbuf);
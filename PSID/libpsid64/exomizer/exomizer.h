@@ -32,8 +32,28 @@ extern "C" {
 #endif
 
 
+/* returns the size of the crunched file, or -1 if out of memory */
 int exomizer(unsigned char *srcbuf, int len, int load, int start, unsigned char *destbuf);
 
+/* trades compression ratio for speed, exomizer() uses all zeros */
+struct exomizer_options {
+    /* > 0: hash chain match finder examining this many candidates
+     * per index, 0: exhaustive match lists */
+    int max_depth;
+    /* largest offset used, 0: 65536 */
+    int max_offset;
+    /* number of optimal parse passes, 0: until the size does not improve */
+    int max_passes;
+    /* no further pass is started if it would end later than time_budget
+     * ticks of clock() after the start, 0 or no clock: no limit */
+    unsigned int time_budget;
+    unsigned int (*clock)(void);
+};
+
+/* returns the size of the crunched file, or -1 if out of memory */
+int exomizer_ex(unsigned char *srcbuf, int len, int load, int start, unsigned char *destbuf,
+                const struct exomizer_options *options);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,11 @@
 #include "radix.h"
 
 
+/* used by match_ctx_init_fast only */
+#define FAST_LEN2_MAX_OFFSET 4096
+#define FAST_NICE_LEN 256
+#define FAST_MAX_LEN 4096
+
 struct match_node {
     int index;
     struct match_node *next;
@@ -49,6 +54,11 @@ matchp match_new(match_ctx ctx, /* IN/OUT */
                  unsigned short int offset)
 {
     matchp m = chunkpool_malloc(ctx->m_pool);
+    if (m == NULL)
+    {
+        /* ctx->m_pool->failed is set, the list is left unchanged */
+        return NULL;
+    }
     m->len = len;
     m->offset = offset;
 
@@ -60,15 +70,15 @@ matchp match_new(match_ctx ctx, /* IN/OUT */
 }
 
 
-void match_ctx_init(match_ctx ctx,      /* IN/OUT */
-                    const unsigned char *buf,      /* IN */
-                    int buf_len,        /* IN */
-                    int max_offset)
+/* common to both match finders: the rle lengths
+ * in both directions and an empty cache */
+static
+void match_ctx_init_rle(match_ctx ctx,  /* IN/OUT */
+                        const unsigned char *buf,  /* IN */
+                        int buf_len,    /* IN */
+                        int max_offset) /* IN */
 {
-    struct match_node *np;
-    struct chunkpool map_pool[1];
-
-    int c, i;
+    int i;
     int val;
 
     memset(ctx->info, 0, sizeof(ctx->info));
@@ -76,9 +86,9 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
     memset(ctx->rle_r, 0, sizeof(ctx->rle_r));
 
     chunkpool_init(ctx->m_pool, sizeof(match));
-    chunkpool_init(map_pool, sizeof(match));
 
     ctx->max_offset = max_offset;
+    ctx->max_depth = 0;
 
     ctx->buf = buf;
     ctx->len = buf_len;
@@ -108,6 +118,21 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
         }
         val = buf[i];
     }
+}
+
+void match_ctx_init(match_ctx ctx,      /* IN/OUT */
+                    const unsigned char *buf,      /* IN */
+                    int buf_len,        /* IN */
+                    int max_offset)
+{
+    struct match_node *np;
+    struct chunkpool map_pool[1];
+
+    int c, i;
+
+    match_ctx_init_rle(ctx, buf, buf_len, max_offset);
+
+    chunkpool_init(map_pool, sizeof(match));
 
     /* add extra nodes to rle sequences */
     for(c = 0; c < 256; ++c)
@@ -135,6 +160,10 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
             }
 
             np = chunkpool_malloc(ctx->m_pool);
+            if (np == NULL)
+            {
+                break;
+            }
             np->index = i;
             np->next = NULL;
             rle_map[rle_len] = 1;
@@ -170,6 +199,10 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
                 if(rle_map[rle_len] && prev_np != NULL && rle_len > 0)
                 {
                     np = chunkpool_malloc(ctx->m_pool);
+                    if (np == NULL)
+                    {
+                        break;
+                    }
                     np->index = i;
                     np->next = prev_np;
                     ctx->info[i]->single = np;
@@ -213,6 +246,146 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
     chunkpool_free(map_pool);
 }
 
+void match_ctx_init_fast(match_ctx ctx, /* IN/OUT */
+                         const unsigned char *buf,      /* IN */
+                         int buf_len,   /* IN */
+                         int max_offset,        /* IN */
+                         int max_depth) /* IN */
+{
+    /* chain heads are keyed by the byte at an index and the one before
+     * it. The buffer is processed backwards and every index is added
+     * after its own matches are found, i.e. the chains only hold later
+     * indexes, nearest (= smallest offset) first. */
+    static int chain_head[65536];
+    static int chain_next[65536];
+    int prev_offset;
+    int prev_pos;
+    int i;
+
+    match_ctx_init_rle(ctx, buf, buf_len, max_offset);
+    ctx->max_depth = max_depth;
+
+    /* limiting the rle lengths limits all lengths derived from them,
+     * the optimal parse then has much smaller length tables to build */
+    for (i = 0; i < buf_len; ++i)
+    {
+        if (ctx->rle[i] > FAST_MAX_LEN - 1)
+        {
+            ctx->rle[i] = FAST_MAX_LEN - 1;
+        }
+        if (ctx->rle_r[i] > FAST_MAX_LEN - 1)
+        {
+            ctx->rle_r[i] = FAST_MAX_LEN - 1;
+        }
+    }
+
+    memset(chain_head, 0xff, sizeof(chain_head));
+
+    prev_offset = 0;
+    prev_pos = 0;
+
+    for (i = buf_len - 1; i >= 0; --i)
+    {
+        matchp matches;
+        int best_len;
+        int best_offset;
+        int best_pos;
+        int depth;
+        int key;
+        int j;
+
+        matches = NULL;
+
+        /* the literal is always last in the list */
+        match_new(ctx, &matches, 1, 0);
+
+        /* nearest single byte copy, only short offsets pay off */
+        for (j = i + 1; j < buf_len && j - i < 17; ++j)
+        {
+            if (buf[j] == buf[i])
+            {
+                match_new(ctx, &matches, 1, j - i);
+                break;
+            }
+        }
+
+        if (i == 0)
+        {
+            ctx->info[i]->cache = matches;
+            break;
+        }
+
+        key = buf[i] | (buf[i - 1] << 8);
+        best_len = 1;
+        best_offset = 0;
+        best_pos = 0;
+        depth = max_depth;
+        for (j = chain_head[key]; j >= 0 && depth > 0; j = chain_next[j])
+        {
+            int offset;
+            int len;
+            int pos;
+
+            offset = j - i;
+            if (offset > ctx->max_offset)
+            {
+                break;
+            }
+            --depth;
+
+            if (offset == prev_offset)
+            {
+                /* the best match of the previous index ends at the
+                 * same position, no need to compare again */
+                pos = prev_pos;
+            }
+            else
+            {
+                /* compare backwards, common rle runs are skipped at once */
+                pos = i;
+                while (pos >= 0 && buf[pos] == buf[pos + offset])
+                {
+                    int offset1 = ctx->rle[pos];
+                    int offset2 = ctx->rle[pos + offset];
+                    int skip = offset1 < offset2 ? offset1 : offset2;
+
+                    pos -= 1 + skip;
+                }
+            }
+            len = i - pos;
+            if (len > FAST_MAX_LEN)
+            {
+                len = FAST_MAX_LEN;
+            }
+
+            /* only matches longer than the nearer ones are useful,
+             * far two byte matches hardly ever beat two literals */
+            if (len > best_len &&
+                (len > 2 || offset <= FAST_LEN2_MAX_OFFSET))
+            {
+                best_len = len;
+                best_offset = offset;
+                best_pos = pos;
+                match_new(ctx, &matches, len, offset);
+            }
+            if (pos < 0 || len >= FAST_NICE_LEN)
+            {
+                /* we have reached the start or the match is long
+                 * enough, not worth looking for better ones */
+                break;
+            }
+        }
+
+        prev_offset = best_offset;
+        prev_pos = best_pos;
+
+        chain_next[i] = chain_head[key];
+        chain_head[key] = i;
+
+        ctx->info[i]->cache = matches;
+    }
+}
+
 void match_ctx_free(match_ctx ctx)      /* IN/OUT */
 {
     chunkpool_free(ctx->m_pool);
@@ -263,6 +436,10 @@ const_matchp matches_calc(match_ctx ctx,        /* IN/OUT */
 
     /* proces the literal match and add it to matches */
     mp = match_new(ctx, &matches, 1, 0);
+    if (mp == NULL)
+    {
+        return matches;
+    }
 
     /* get possible match */
     np = ctx->info[index]->single;
@@ -320,6 +497,10 @@ const_matchp matches_calc(match_ctx ctx,        /* IN/OUT */
         {
             /* allocate match struct and add it to matches */
             mp = match_new(ctx, &matches, 1, offset);
+            if (mp == NULL)
+            {
+                break;
+            }
         }
 
         /* Here we know that the current match is atleast as long as
@@ -337,6 +518,10 @@ const_matchp matches_calc(match_ctx ctx,        /* IN/OUT */
         {
             /* allocate match struct and add it to matches */
             mp = match_new(ctx, &matches, index - pos, offset);
+            if (mp == NULL)
+            {
+                break;
+            }
         }
         if(pos < 0)
         {
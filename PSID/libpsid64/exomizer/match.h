@@ -54,6 +54,7 @@ struct match_ctx {
     const unsigned char *buf;
     int len;
     int max_offset;
+    int max_depth;      /* > 0: lists built by match_ctx_init_fast */
 };
 
 typedef struct match_ctx match_ctx[1];
@@ -64,6 +65,16 @@ void match_ctx_init(match_ctx ctx,      /* IN/OUT */
                     int buf_len,        /* IN */
                     int max_offset);    /* IN */
 
+/* speed oriented alternative to match_ctx_init: the match lists are
+ * built from hash chains over two bytes, at most max_depth candidates
+ * are examined per index. The lists have the same layout (longest
+ * match first, the literal last) but are not exhaustive. */
+void match_ctx_init_fast(match_ctx ctx, /* IN/OUT */
+                         const unsigned char *buf,      /* IN */
+                         int buf_len,   /* IN */
+                         int max_offset,        /* IN */
+                         int max_depth);        /* IN */
+
 void match_ctx_free(match_ctx ctx);     /* IN/OUT */
 
 /* this needs to be called with the indexes in
@@ -73,12 +73,17 @@ interval_nodep interval_node_clone(interval_nodep inp)
 	{
 	    LOG(LOG_ERROR, ("out of memory error in file %s, line %d\n",
 			    __FILE__, __LINE__));
-	    //exit(0);
-        return;
+	    return NULL;
 	}
 	/* copy contents */
 	*inp2 = *inp;
 	inp2->next = interval_node_clone(inp->next);
+	if (inp->next != NULL && inp2->next == NULL)
+	{
+	    /* NULL for a non-empty list means out of memory */
+	    free(inp2);
+	    return NULL;
+	}
     }
 
     return inp2;
@@ -177,8 +182,7 @@ float optimal_encode(const_matchp mp, encode_match_data emd)
         {
         case 0:
             LOG(LOG_ERROR, ("bad len\n"));
-    //        exit(1);
-            return;
+            return 1000000.0f;
             break;
         case 1:
 #if 1
@@ -239,6 +243,7 @@ struct _optimize_arg {
     int max_depth;
     int flags;
     struct chunkpool in_pool[1];
+    interval_nodep *memo;
 };
 
 #define CACHE_KEY(START, DEPTH, MAXDEPTH) ((int)((START)*(MAXDEPTH)|DEPTH))
@@ -264,7 +269,14 @@ optimize1(optimize_arg arg, int start, int depth)
             break;
         }
         int key = CACHE_KEY(start, depth, arg->max_depth);
-        best_inp = radix_node_get(arg->cache, key);
+        if (arg->memo != NULL)
+        {
+            best_inp = arg->memo[key];
+        }
+        else
+        {
+            best_inp = radix_node_get(arg->cache, key);
+        }
         if (best_inp != NULL)
         {
             break;
@@ -323,13 +335,25 @@ optimize1(optimize_arg arg, int start, int depth)
                 {
                     /* allocate if null */
                     best_inp = chunkpool_malloc(arg->in_pool);
+                    if (best_inp == NULL)
+                    {
+                        /* arg->in_pool->failed is set */
+                        return NULL;
+                    }
                 }
                 *best_inp = *inp;
             }
         }
         if (best_inp != NULL)
         {
-            radix_node_set(arg->cache, key, best_inp);
+            if (arg->memo != NULL)
+            {
+                arg->memo[key] = best_inp;
+            }
+            else
+            {
+                radix_node_set(arg->cache, key, best_inp);
+            }
         }
     }
     while (0);
@@ -338,12 +362,16 @@ optimize1(optimize_arg arg, int start, int depth)
     return best_inp;
 }
 
+/* sets *failed if out of memory, a NULL result alone is no error */
 static interval_nodep
-optimize(int stats[65536], int stats2[65536], int max_depth, int flags)
+optimize(int stats[65536], int stats2[65536], int max_depth, int flags,
+         int *failed)
 {
     optimize_arg arg;
 
     interval_nodep inp;
+    interval_nodep best;
+    int limit;
 
     arg->stats = stats;
     arg->stats2 = stats2;
@@ -355,16 +383,35 @@ optimize(int stats[65536], int stats2[65536], int max_depth, int flags)
 
     radix_tree_init(arg->cache);
 
+    /* the intervals only start where stats are non-zero, a flat
+     * memo over these is much faster than the radix tree. The tree
+     * is kept for when there is not enough memory. */
+    for (limit = 65535; limit > 1 && stats[limit] == 0; --limit);
+    arg->memo = calloc((limit + 1) * max_depth, sizeof(interval_nodep));
+
     inp = optimize1(arg, 1, 0);
 
     /* use normal malloc for the winner */
-    inp = interval_node_clone(inp);
+    best = NULL;
+    if (arg->in_pool->failed || arg->cache->mem->failed)
+    {
+        *failed = 1;
+    }
+    else
+    {
+        best = interval_node_clone(inp);
+        if (inp != NULL && best == NULL)
+        {
+            *failed = 1;
+        }
+    }
 
     /* cleanup */
+    free(arg->memo);
     radix_tree_free(arg->cache, NULL, NULL);
     chunkpool_free(arg->in_pool);
 
-    return inp;
+    return best;
 }
 
 
@@ -383,6 +430,13 @@ void optimal_init(encode_match_data emd)        /* OUT */
     data->offset_f = optimal_encode_int;
     data->len_f = optimal_encode_int;
     inpp = malloc(sizeof(interval_nodep[8]));
+    data->offset_f_priv = inpp;
+    data->len_f_priv = NULL;
+    if (inpp == NULL)
+    {
+        /* optimal_optimize() fails */
+        return;
+    }
     inpp[0] = NULL;
     inpp[1] = NULL;
     inpp[2] = NULL;
@@ -391,8 +445,6 @@ void optimal_init(encode_match_data emd)        /* OUT */
     inpp[5] = NULL;
     inpp[6] = NULL;
     inpp[7] = NULL;
-    data->offset_f_priv = inpp;
-    data->len_f_priv = NULL;
 }
 
 void optimal_free(encode_match_data emd)        /* IN */
@@ -446,9 +498,9 @@ void freq_stats_dump_raw(int arr[65536])
 }
 #endif /* RH */
 
-void optimal_optimize(encode_match_data emd,    /* IN/OUT */
-                      matchp_enum_get_next_f * f,       /* IN */
-                      void *matchp_enum)        /* IN */
+int optimal_optimize(encode_match_data emd,     /* IN/OUT */
+                     matchp_enum_get_next_f * f,        /* IN */
+                     void *matchp_enum) /* IN */
 {
     encode_match_privp data;
     const_matchp mp;
@@ -457,17 +509,23 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
     static int offset_parr[8][65536];
     static int len_arr[65536];
     int treshold;
+    int failed;
 
     int i, j;
     void *priv1;
 
     data = emd->priv;
+    failed = 0;
 
     memset(offset_arr, 0, sizeof(offset_arr));
     memset(offset_parr, 0, sizeof(offset_parr));
     memset(len_arr, 0, sizeof(len_arr));
 
     offset = data->offset_f_priv;
+    if (offset == NULL)
+    {
+        return -1;
+    }
 
     /* first the lens */
     priv1 = matchp_enum;
@@ -484,7 +542,7 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
         len_arr[i] += len_arr[i + 1];
     }
 
-    data->len_f_priv = optimize(len_arr, NULL, 16, -1);
+    data->len_f_priv = optimize(len_arr, NULL, 16, -1, &failed);
 
     /* then the offsets */
     priv1 = matchp_enum;
@@ -500,8 +558,7 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
             {
             case 0:
                 LOG(LOG_NORMAL, ("bad len\n"));
-                //exit(0);
-                return;
+                return -1;
                 break;
             case 1:
 #if 1
@@ -539,14 +596,24 @@ void optimal_optimize(encode_match_data emd,    /* IN/OUT */
         }
     }
 
-    offset[0] = optimize(offset_arr[0], offset_parr[0], 1 << 2, 2);
-    offset[1] = optimize(offset_arr[1], offset_parr[1], 1 << 4, 4);
-    offset[2] = optimize(offset_arr[2], offset_parr[2], 1 << 4, 4);
-    offset[3] = optimize(offset_arr[3], offset_parr[3], 1 << 4, 4);
-    offset[4] = optimize(offset_arr[4], offset_parr[4], 1 << 4, 4);
-    offset[5] = optimize(offset_arr[5], offset_parr[5], 1 << 4, 4);
-    offset[6] = optimize(offset_arr[6], offset_parr[6], 1 << 4, 4);
-    offset[7] = optimize(offset_arr[7], offset_parr[7], 1 << 4, 4);
+    offset[0] = optimize(offset_arr[0], offset_parr[0], 1 << 2, 2,
+                         &failed);
+    offset[1] = optimize(offset_arr[1], offset_parr[1], 1 << 4, 4,
+                         &failed);
+    offset[2] = optimize(offset_arr[2], offset_parr[2], 1 << 4, 4,
+                         &failed);
+    offset[3] = optimize(offset_arr[3], offset_parr[3], 1 << 4, 4,
+                         &failed);
+    offset[4] = optimize(offset_arr[4], offset_parr[4], 1 << 4, 4,
+                         &failed);
+    offset[5] = optimize(offset_arr[5], offset_parr[5], 1 << 4, 4,
+                         &failed);
+    offset[6] = optimize(offset_arr[6], offset_parr[6], 1 << 4, 4,
+                         &failed);
+    offset[7] = optimize(offset_arr[7], offset_parr[7], 1 << 4, 4,
+                         &failed);
+
+    return failed ? -1 : 0;
 }
 
 #if 0 /* RH */
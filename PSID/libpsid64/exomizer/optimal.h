@@ -38,9 +38,10 @@ void optimal_init(encode_match_data emp);       /* IN/OUT */
 
 void optimal_free(encode_match_data emd);       /* IN */
 
-void optimal_optimize(encode_match_data emd,    /* IN/OUT */
-                      matchp_enum_get_next_f * f,       /* IN */
-                      void *priv);      /* IN */
+/* returns -1 if out of memory */
+int optimal_optimize(encode_match_data emd,     /* IN/OUT */
+                     matchp_enum_get_next_f * f,        /* IN */
+                     void *priv);       /* IN */
 
 void optimal_fixup(encode_match_data emd,       /* IN/OUT */
                    int max_len, /* IN */
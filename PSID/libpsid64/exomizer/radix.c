@@ -88,7 +88,7 @@ void radix_tree_free(radix_root rr,     /* IN */
     chunkpool_free(rr->mem);
 }
 
-void radix_node_set(radix_rootp rrp,    /* IN */
+void radix_node_set(radix_root rrp,     /* IN */
                     unsigned int index, /* IN */
                     void *data) /* IN */
 {
@@ -103,6 +103,11 @@ void radix_node_set(radix_rootp rrp,    /* IN */
         /*LOG(LOG_DUMP, ("calloc called\n")); */
         /* not deep enough, let's deepen the tree */
 	rnp = chunkpool_calloc(rrp->mem);
+        if (rnp == NULL)
+        {
+            /* not cached, rrp->mem->failed is set */
+            return;
+        }
 
         rnp[0].rn = rrp->root;
         rrp->root = rnp;
@@ -122,6 +127,10 @@ void radix_node_set(radix_rootp rrp,    /* IN */
             /*LOG(LOG_DUMP, ("calloc called\n")); */
             /* tree is not grown in this interval */
 	    *rnpp = chunkpool_calloc(rrp->mem);
+            if (*rnpp == NULL)
+            {
+                return;
+            }
         }
         node_index = ((index >> (RADIX_TREE_NODE_RADIX * depth)) &
                       RADIX_TREE_NODE_MASK);
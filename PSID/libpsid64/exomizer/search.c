@@ -31,6 +31,10 @@
 #include "log.h"
 #include "search.h"
 
+/* with the fast match finder at most this many lengths are
+ * tried for a match, counted down from its full length */
+#define FAST_LEN_TRIES 32
+
 #if 0 /* RH */
 void search_node_free(search_nodep snp) /* IN */
 {
@@ -75,7 +79,8 @@ search_nodep search_buffer(match_ctx ctx,       /* IN */
 
     int len = ctx->len;
 
-    memset(snp_arr, 0, sizeof(snp_arr));
+    /* only the nodes 0..len are used */
+    memset(snp_arr, 0, (len + 1) * sizeof(search_node));
 
     snp = snp_arr[len];
     snp->index = len;
@@ -224,6 +229,20 @@ search_nodep search_buffer(match_ctx ctx,       /* IN */
                 end_len = next->len + (next->offset > 0);
             }
 #endif
+            if(ctx->max_depth > 0)
+            {
+                /* the shorter lengths are covered by the next (nearer)
+                 * match in the list, long ones are cut short. Every
+                 * list ends with the literal so all nodes stay reachable. */
+                if(next != NULL)
+                {
+                    end_len = next->len + (next->offset > 0);
+                }
+                if(end_len < mp->len - FAST_LEN_TRIES)
+                {
+                    end_len = mp->len - FAST_LEN_TRIES;
+                }
+            }
             *tmp = *mp;
             for(tmp->len = mp->len; tmp->len >= end_len; --(tmp->len))
             {
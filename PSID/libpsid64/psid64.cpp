@@ -47,7 +47,7 @@
 
 #include "reloc65.h"
 #include "screen.h"
-//#include "sidid.h"
+#include "sidid.h"
 //#include "theme.h"
 //#include "stilview/stil.h"
 #include "exomizer/exomizer.h"
@@ -69,7 +69,6 @@
 //////////////////////////////////////////////////////////////////////////////
 //                     L O C A L   D E F I N I T I O N S
 //////////////////////////////////////////////////////////////////////////////
-static char* emptyString = "";
 
 #if defined(HAVE_IOS_OPENMODE)
     typedef std::ios::openmode openmode;
@@ -204,6 +203,8 @@ const char* Psid64::txt_notEnoughC64Memory = "PSID64: C64 memory has no space fo
 const char* Psid64::txt_fileIoError = "PSID64: File I/O error";
 const char* Psid64::txt_noSidTuneLoaded = "PSID64: No SID tune loaded";
 const char* Psid64::txt_noSidTuneConverted = "PSID64: No SID tune converted";
+const char* Psid64::txt_compressionFailed = "PSID64: Compression does not reduce the size";
+const char* Psid64::txt_compressionOutOfMemory = "PSID64: Compression ran out of memory";
 //const char* Psid64::txt_sidIdConfigError = "PSID64: Cannot read SID ID configuration file";
 
 
@@ -217,6 +218,7 @@ Psid64::Psid64() :
     m_noDriver(false),
     m_blankScreen(false),
     m_compress(false),
+    m_compressOptions(NULL),
     m_initialSong(0),
     m_useGlobalComment(false),
     m_verbose(false),
@@ -231,9 +233,14 @@ Psid64::Psid64() :
     m_tuneInfo(),
 //    m_database(),
     //m_stil(new STIL),
-    //m_sidId(new SidId),
+    m_sidId(NULL),
     m_screen(new Screen),
     //m_stilText(),
+    m_stilEntry(NULL),
+    m_stilText(),
+    m_stilTextSize(0),
+    m_songLengths(),
+    m_numSongLengths(0),
     m_songlengthsData(),
     m_songlengthsSize(0),
     m_driverPage(0),
@@ -241,7 +248,7 @@ Psid64::Psid64() :
     m_charPage(0),
     m_stilPage(0),
     m_songlengthsPage(0),
-    //m_playerId(),
+    m_playerId(NULL),
     m_programData(NULL),
     m_programSize(0)
 {
@@ -291,6 +298,21 @@ Psid64::~Psid64()
 
 
 
+void
+Psid64::setSongLengths(const uint_least16_t* lengths, int numSongs)
+{
+    if (numSongs > SIDTUNE_MAX_SONGS)
+    {
+	numSongs = SIDTUNE_MAX_SONGS;
+    }
+    for (int i = 0; i < numSongs; ++i)
+    {
+	m_songLengths[i] = lengths[i];
+    }
+    m_numSongLengths = numSongs;
+}
+
+
 bool Psid64::load( unsigned char* sidData, int sidLength )
 {
 	if ( !m_tune.load( sidData, sidLength ) )
@@ -394,7 +416,7 @@ Psid64::convert()
     const uint_least8_t* p_start = c64buf + m_tuneInfo.loadAddr;
     const uint_least8_t* p_end = p_start + m_tuneInfo.c64dataLen;
     //vector<uint_least8_t> buffer(p_start, p_end);
-    //m_playerId = m_sidId->identify(buffer);
+    m_playerId = m_sidId ? m_sidId->identify(p_start, p_end - p_start) : NULL;
 
     // fill the blocks structure
     //vector<block_t> blocks;
@@ -433,8 +455,8 @@ Psid64::convert()
     {
 	block_t stil_text_block;
 	stil_text_block.load = m_stilPage << 8;
-	stil_text_block.size = 0;
-	stil_text_block.data = (uint_least8_t*)emptyString;//(uint_least8_t*) m_stilText.c_str();
+	stil_text_block.size = m_stilTextSize;
+	stil_text_block.data = m_stilText;
 	//stil_text_block.description = "STIL text";
 	//blocks.push_back(stil_text_block);
 	blocks[ nBlocks++ ] = stil_text_block;
@@ -656,19 +678,33 @@ Psid64::convert()
     // free memory of relocated driver
     delete[] psid_mem;
 
-	/*if ( m_programSize > 37 * 1024)
+    if (m_compress)
     {
 	// Use Exomizer to compress the program data. The first two bytes
 	// of m_programData are skipped as these contain the load address.
 	uint_least8_t* compressedData = new uint_least8_t[0x10000];
-	m_programSize = exomizer(m_programData + 2, m_programSize - 2,
-	                         load_addr, boot_addr, compressedData);
+	int compressedSize;
+	if (m_compressOptions)
+	    compressedSize = exomizer_ex(m_programData + 2, m_programSize - 2,
+	                                 load_addr, boot_addr, compressedData, m_compressOptions);
+	else
+	    compressedSize = exomizer(m_programData + 2, m_programSize - 2,
+	                              load_addr, boot_addr, compressedData);
+	// the program has no BASIC starter, i.e. cannot be used uncompressed,
+	// the caller converts again without compression (see psidConvertCached)
+	if (compressedSize <= 0 || (unsigned int) compressedSize >= m_programSize)
+	{
+	    delete[] compressedData;
+	    m_statusString = compressedSize < 0 ? txt_compressionOutOfMemory : txt_compressionFailed;
+	    return false;
+	}
 	// set BASIC line number
 	compressedData[4] = (uint_least8_t) (lineNumber & 0xff);
 	compressedData[5] = (uint_least8_t) (lineNumber >> 8);
 	delete[] m_programData;
 	m_programData = compressedData;
-    }*/
+	m_programSize = compressedSize;
+    }
 
     return true;
 }
@@ -900,34 +936,42 @@ Psid64::formatStilText()
 	m_statusString = m_stil->getErrorStr();
 	return false;
     }
+*/
+    // the STIL entry is looked up by the caller (see setStilText)
+    m_stilTextSize = 0;
+    if (m_stilEntry == NULL)
+    {
+	return true;
+    }
+    const char* str = m_stilEntry;
 
-    // convert the stil text and remove all double whitespace characters
-    unsigned int n = str.length();
-    m_stilText.reserve(n);
+    // convert the stil text and remove all double whitespace characters,
+    // the text is cut if it does not fit
+    const unsigned int maxSize = MAX_STIL_TEXT - 1;
 
     // start the scroll text with some space characters (to separate end
     // from beginning and to make sure the color effect has reached the end
     // of the line before the first character is visible)
     for (unsigned int i = 0; i < (STIL_EOT_SPACES-1); ++i)
     {
-	m_stilText += Screen::iso2scr(' ');
+	m_stilText[m_stilTextSize++] = Screen::iso2scr(' ');
     }
 
     bool space = true;
     bool realText = false;
-    for (unsigned int i = 0; i < n; ++i)
+    for (unsigned int i = 0; str[i] && m_stilTextSize < maxSize - 1; ++i)
     {
-	if (isspace(str[i]))
+	if (str[i] == ' ' || str[i] == '\t' || str[i] == '\r' || str[i] == '\n')
 	{
 	    space = true;
 	}
 	else
 	{
 	    if (space) {
-	       m_stilText += Screen::iso2scr(' ');
+	       m_stilText[m_stilTextSize++] = Screen::iso2scr(' ');
 	       space = false;
 	    }
-	    m_stilText += Screen::iso2scr(str[i]);
+	    m_stilText[m_stilTextSize++] = Screen::iso2scr(str[i]);
 	    realText = true;
 	}
     }
@@ -936,14 +980,14 @@ Psid64::formatStilText()
     if (realText)
     {
 	// end-of-text marker
-	m_stilText += 0xff;
+	m_stilText[m_stilTextSize++] = 0xff;
     }
     else
     {
 	// no STIL text at all
-	m_stilText.clear();
+	m_stilTextSize = 0;
     }
-*/
+
     return true;
 }
 
@@ -957,10 +1001,7 @@ Psid64::getSongLengths()
 	// retrieve song length database information
 	m_tune.selectSong(i + 1);
 
-	int_least32_t length = 0;
-
-	#if 0
-	int_least32_t length = m_database.length (m_tune);
+	int_least32_t length = (i < m_numSongLengths) ? m_songLengths[i] : 0;
 	if (length > 0)
 	{
 	    // maximum representable length is 99:59
@@ -996,7 +1037,6 @@ Psid64::getSongLengths()
 	    have_songlengths = true;
 	}
 	else
-	#endif
 	{
 	    // no song length data for this song
 	    m_songlengthsData[i] = 0x00;
@@ -1125,12 +1165,12 @@ Psid64::findFreeSpace()
     uint_least8_t driver;
 
     // calculate size of the STIL text in pages
-    uint_least8_t stilSize = 0;//(m_stilText.length() + 255) >> 8;
+    uint_least8_t stilSize = (m_stilTextSize + 255) >> 8;
     uint_least8_t songlengthsSize = (m_songlengthsSize + 255) >> 8;
 
 	hasCustomCharset = true;
 restartBuild:
-    stilSize = 0;//(m_stilText.length() + 255) >> 8;
+    stilSize = (m_stilTextSize + 255) >> 8;
     songlengthsSize = (m_songlengthsSize + 255) >> 8;
     startp = m_tuneInfo.relocStartPage;
     maxp = m_tuneInfo.relocPages;
@@ -1763,9 +1803,19 @@ Psid64::drawScreen()
     }
     m_screen->write(" [RUN/STOP] Stop [CBM] Go to Sidekick64\n");
 
-    // flashing bottom line (should be exactly 38 characters)
+    // flashing bottom line (should be exactly 38 characters), the player
+    // line of the original layout does not fit above the clock
     m_screen->move(1,24);
-    m_screen->write("Website: http://psid64.sourceforge.net");
+    if (m_playerId != NULL)
+    {
+	char b[39];
+	sprintf(b, "Player: %-30.30s", m_playerId);
+	m_screen->write(b);
+    }
+    else
+    {
+	m_screen->write("Website: http://psid64.sourceforge.net");
+    }
 
 	if ( hasCustomCharset )
 	{
@@ -4,6 +4,10 @@
     psid64 - create a C64 executable from a PSID file
     Copyright (C) 2015  Roland Hermans <rolandh@users.sourceforge.net>
 
+    this code has been modified for integration into the Sidekick64 software
+    (no STL, the patterns of all players are matched in a single pass over
+    the tune)
+
     This program is free software; you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
     the Free Software Foundation; either version 2 of the License, or
@@ -25,8 +29,7 @@
 
 #include "sidid.h"
 
-#include <fstream>
-#include <sstream>
+#include <string.h>
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -49,191 +52,428 @@
 //                       L O C A L   F U N C T I O N S
 //////////////////////////////////////////////////////////////////////////////
 
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 //                      G L O B A L   F U N C T I O N S
 //////////////////////////////////////////////////////////////////////////////
 
-void SidId::Pattern::clear()
+SidId::SidId() :
+    m_names(NULL),
+    m_playerName(NULL),
+    m_patterns(NULL),
+    m_parts(NULL),
+    m_values(NULL),
+    m_nodes(NULL),
+    m_outputs(NULL),
+    m_nextPart(NULL),
+    m_minPos(NULL)
 {
-    m_values.clear();
+    clear();
 }
 
 
-void SidId::Pattern::pushValue(uint_least16_t value)
+SidId::~SidId()
 {
-    m_values.push_back(value);
+    clear();
 }
 
 
-bool SidId::Pattern::match(const std::vector<uint_least8_t>& buffer) const
+void SidId::clear()
 {
-    const uint_least8_t* p_buffer = &buffer.front();
-    const uint_least16_t* p_values = &m_values.front();
-    size_t buffer_size = buffer.size();
-    size_t i = 0;
-    size_t j = 0;
+    delete[] m_names;
+    delete[] m_playerName;
+    delete[] m_patterns;
+    delete[] m_parts;
+    delete[] m_values;
+    delete[] m_nodes;
+    delete[] m_outputs;
+    delete[] m_nextPart;
+    delete[] m_minPos;
+
+    m_names = NULL;
+    m_playerName = NULL;
+    m_patterns = NULL;
+    m_parts = NULL;
+    m_values = NULL;
+    m_nodes = NULL;
+    m_outputs = NULL;
+    m_nextPart = NULL;
+    m_minPos = NULL;
+
+    m_numPlayers = m_numPatterns = m_numParts = m_numValues = 0;
+    m_numNodes = m_numOutputs = m_namesSize = 0;
+}
+
+
+// the first pass only counts, the second one stores
+bool SidId::parse(const char* text, int size, bool store)
+{
+    int players = 0, patterns = 0, parts = 0, values = 0, names = 0;
+    int partStart = 0, patternStart = 0, patternValues = 0;
+    bool dead = false;              // pattern can never match, see advance()
 
-    while (true)
+    for (int i = 0; i < size; )
     {
-        // search for first matching byte
-        while ((i < buffer_size) && (p_buffer[i] != p_values[j]))
+        while (i < size && isSpace(text[i]))
         {
             ++i;
         }
-        if (i == buffer_size)
+        if (i == size)
         {
             break;
         }
-        size_t saved_i = i;
-        size_t saved_j = j;
-
-        // check if subsequent bytes match as well
-        while ((i < buffer_size)
-               && ((p_buffer[i] == p_values[j])
-                   || (p_values[j] == MATCH_WILDCARD_ONE)))
+        const char* token = &text[i];
+        int len = 0;
+        while (i < size && !isSpace(text[i]))
         {
             ++i;
-            ++j;
+            ++len;
         }
 
-        if (p_values[j] == MATCH_END)
+        bool isEnd = (len == 3) && !strncmp(token, "END", 3);
+        bool isAnd = (len == 3) && !strncmp(token, "AND", 3);
+
+        if (isEnd || isAnd)
         {
-            // all parts matched
-            break;
+            if (players == 0)
+            {
+                // first player definition did not start with a name
+                return false;
+            }
+            if (isAnd && values == partStart)
+            {
+                dead = true;
+            }
+            if (values > partStart)
+            {
+                if (store)
+                {
+                    Part& p = m_parts[parts];
+                    p.pattern = patterns;
+                    p.index = parts - patternStart;
+                    p.values = partStart;
+                    p.length = values - partStart;
+                }
+                ++parts;
+            }
+            partStart = values;
+            if (isEnd)
+            {
+                if (dead && store)
+                {
+                    // drop it (the first pass counts it, which gives upper
+                    // bounds for the allocation)
+                    parts = patternStart;
+                    values = partStart = patternValues;
+                }
+                else
+                {
+                    if (store)
+                    {
+                        m_patterns[patterns].player = players - 1;
+                        m_patterns[patterns].firstPart = patternStart;
+                        m_patterns[patterns].numParts = parts - patternStart;
+                    }
+                    ++patterns;
+                }
+                patternStart = parts;
+                patternValues = values;
+                dead = false;
+            }
         }
-        else if (p_values[j] == MATCH_WILDCARD_MULTIPLE)
+        else if ((len == 2) && (token[0] == '?') && (token[1] == '?'))
         {
-            // this part did match, continue with next part
-            ++j;
+            if (values == partStart)
+            {
+                dead = true;
+            }
+            if (store)
+            {
+                m_values[values] = MATCH_WILDCARD_ONE;
+            }
+            ++values;
+        }
+        else if ((len == 2) && (hexValue(token[0]) >= 0)
+                 && (hexValue(token[1]) >= 0))
+        {
+            if (store)
+            {
+                m_values[values] = hexValue(token[0]) * 16 + hexValue(token[1]);
+            }
+            ++values;
         }
         else
         {
-            // retry matching after first byte of current match attempt
-            i = saved_i + 1;
-            j = saved_j;
+            // start of new player definition (as in the original, a pattern
+            // which is not finished yet belongs to the new player)
+            if (store)
+            {
+                m_playerName[players] = names;
+                memcpy(&m_names[names], token, len);
+                m_names[names + len] = 0;
+                for (int j = 0; j < len; ++j)
+                {
+                    if (m_names[names + j] == '_')
+                    {
+                        m_names[names + j] = ' ';
+                    }
+                }
+            }
+            names += len + 1;
+            ++players;
         }
     }
 
-    return (p_values[j] == MATCH_END);
+    m_numPlayers = players;
+    m_numPatterns = patterns;
+    m_numParts = parts;
+    m_numValues = values;
+    m_namesSize = names;
+    return true;
 }
 
 
-SidId::Player::Player(const std::string& name) : m_name(name)
+// enters the longest wildcard-free sequence of the part into the trie
+void SidId::addAnchor(int part)
 {
-    // do nothing
-}
+    Part& p = m_parts[part];
+    const uint_least16_t* v = &m_values[p.values];
 
+    p.anchor = 0;
+    p.anchorLength = 0;
+    for (int i = 0; i < p.length; )
+    {
+        if (v[i] == MATCH_WILDCARD_ONE)
+        {
+            ++i;
+            continue;
+        }
+        int j = i;
+        while (j < p.length && v[j] != MATCH_WILDCARD_ONE)
+        {
+            ++j;
+        }
+        if (j - i > p.anchorLength)
+        {
+            p.anchor = i;
+            p.anchorLength = j - i;
+        }
+        i = j;
+    }
 
-void SidId::Player::addPattern(const Pattern& pattern)
-{
-    m_patterns.push_back(pattern);
+    int s = 0;
+    for (int i = 0; i < p.anchorLength; ++i)
+    {
+        uint_least8_t c = (uint_least8_t) v[p.anchor + i];
+        int n = m_nodes[s].child;
+        while (n >= 0 && m_nodes[n].value != c)
+        {
+            n = m_nodes[n].sibling;
+        }
+        if (n < 0)
+        {
+            n = m_numNodes++;
+            m_nodes[n].child = -1;
+            m_nodes[n].sibling = m_nodes[s].child;
+            m_nodes[n].fail = 0;
+            m_nodes[n].output = -1;
+            m_nodes[n].dict = -1;
+            m_nodes[n].value = c;
+            m_nodes[s].child = n;
+        }
+        s = n;
+    }
+
+    m_outputs[m_numOutputs].part = part;
+    m_outputs[m_numOutputs].next = m_nodes[s].output;
+    m_nodes[s].output = m_numOutputs++;
 }
 
 
-const std::string& SidId::Player::name() const
+void SidId::buildAutomaton()
 {
-    return m_name;
+    m_nodes[0].child = -1;
+    m_nodes[0].sibling = -1;
+    m_nodes[0].fail = 0;
+    m_nodes[0].output = -1;
+    m_nodes[0].dict = -1;
+    m_nodes[0].value = 0;
+    m_numNodes = 1;
+    m_numOutputs = 0;
+
+    for (int i = 0; i < m_numParts; ++i)
+    {
+        addAnchor(i);
+    }
+
+    // the root has a transition for every byte
+    for (int c = 0; c < 256; ++c)
+    {
+        m_rootNext[c] = 0;
+    }
+    for (int n = m_nodes[0].child; n >= 0; n = m_nodes[n].sibling)
+    {
+        m_rootNext[m_nodes[n].value] = n;
+    }
+
+    // failure and dictionary links in breadth-first order
+    int* queue = new int[m_numNodes];
+    int head = 0;
+    int tail = 0;
+    for (int n = m_nodes[0].child; n >= 0; n = m_nodes[n].sibling)
+    {
+        queue[tail++] = n;
+    }
+    while (head < tail)
+    {
+        int s = queue[head++];
+        for (int n = m_nodes[s].child; n >= 0; n = m_nodes[n].sibling)
+        {
+            int f = step(m_nodes[s].fail, m_nodes[n].value);
+            m_nodes[n].fail = (f == n) ? 0 : f;
+            m_nodes[n].dict = (m_nodes[f].output >= 0) ? f : m_nodes[f].dict;
+            queue[tail++] = n;
+        }
+    }
+    delete[] queue;
 }
 
 
-    bool SidId::Player::match(const std::vector<uint_least8_t>& buffer) const
+int SidId::step(int state, uint_least8_t c) const
+{
+    while (state != 0)
     {
-        for (std::vector<Pattern>::const_iterator iter = m_patterns.begin();
-             iter != m_patterns.end(); ++iter)
+        for (int n = m_nodes[state].child; n >= 0; n = m_nodes[n].sibling)
         {
-            if (iter->match(buffer))
+            if (m_nodes[n].value == c)
             {
-                return true;
+                return n;
             }
         }
-        return false;
+        state = m_nodes[state].fail;
     }
+    return m_rootNext[c];
+}
 
 
-std::string SidId::trim(const std::string& str, const std::string& whitespace)
+bool SidId::verify(const Part& part, const uint_least8_t* buffer, int pos) const
 {
-    const size_t begin_pos = str.find_first_not_of(whitespace);
-    if (begin_pos == std::string::npos)
+    const uint_least16_t* v = &m_values[part.values];
+    for (int i = 0; i < part.length; ++i)
     {
-        return "";
+        if ((v[i] != MATCH_WILDCARD_ONE) && (v[i] != buffer[pos + i]))
+        {
+            return false;
+        }
     }
-    const size_t end_pos = str.find_last_not_of(whitespace);
-    return str.substr(begin_pos, end_pos - begin_pos + 1);
+    return true;
 }
 
 
-bool SidId::readConfigFile(const std::string& filename)
+// returns true if the pattern matched completely. The semantics are those of
+// the original matcher, which searched for the first value of each part:
+// parse() drops patterns with a part starting with ?? or an empty part before
+// AND, as they never matched (hence every part has an anchor), and keeps empty
+// patterns ("END" only), which always match
+bool SidId::advance(int pattern) const
 {
-    m_players.clear();
-    std::ifstream f;
-    f.open(filename.c_str());
-    if (!f)
+    return m_nextPart[pattern] >= m_patterns[pattern].numParts;
+}
+
+
+bool SidId::readConfig(const char* text, int size)
+{
+    clear();
+
+    // count, allocate, store
+    if (!parse(text, size, false))
     {
         return false;
     }
-    std::string line;
-    while (std::getline(f, line))
+
+    int anchorBytes = 0;
+    m_names = new char[m_namesSize > 0 ? m_namesSize : 1];
+    m_playerName = new int[m_numPlayers > 0 ? m_numPlayers : 1];
+    m_patterns = new Pattern[m_numPatterns > 0 ? m_numPatterns : 1];
+    m_parts = new Part[m_numParts > 0 ? m_numParts : 1];
+    m_values = new uint_least16_t[m_numValues > 0 ? m_numValues : 1];
+    m_nextPart = new int[m_numPatterns > 0 ? m_numPatterns : 1];
+    m_minPos = new int[m_numPatterns > 0 ? m_numPatterns : 1];
+
+    parse(text, size, true);
+
+    anchorBytes = m_numValues;      // upper bound for the number of nodes
+    m_nodes = new Node[anchorBytes + 1];
+    m_outputs = new Output[m_numParts > 0 ? m_numParts : 1];
+
+    buildAutomaton();
+    return true;
+}
+
+
+const char* SidId::identify(const uint_least8_t* buffer, int size)
+{
+    int best = m_numPlayers;
+
+    for (int i = 0; i < m_numPatterns; ++i)
+    {
+        m_nextPart[i] = 0;
+        m_minPos[i] = 0;
+        if (advance(i) && m_patterns[i].player < best)
+        {
+            best = m_patterns[i].player;
+        }
+    }
+
+    int state = 0;
+    for (int i = 0; i < size && best > 0; ++i)
     {
-        line = trim(line);
-        if (!line.empty())
+        state = step(state, buffer[i]);
+
+        int o = (m_nodes[state].output >= 0) ? state : m_nodes[state].dict;
+        for (; o >= 0; o = m_nodes[o].dict)
         {
-            Pattern pattern;
-            std::istringstream line_ss(line);
-            std::string token;
-            while (line_ss >> token)
+            for (int e = m_nodes[o].output; e >= 0; e = m_outputs[e].next)
             {
-                if (token == "??")
+                const Part& part = m_parts[m_outputs[e].part];
+                int pattern = part.pattern;
+                if (m_nextPart[pattern] != part.index
+                    || m_patterns[pattern].player >= best)
                 {
-                    pattern.pushValue(MATCH_WILDCARD_ONE);
+                    continue;
                 }
-                else if (token == "AND")
+
+                // the anchor ends at i
+                int pos = i + 1 - part.anchor - part.anchorLength;
+                if (pos < m_minPos[pattern] || pos + part.length > size
+                    || !verify(part, buffer, pos))
                 {
-                    pattern.pushValue(MATCH_WILDCARD_MULTIPLE);
+                    continue;
                 }
-                else if (token == "END")
-                {
-                    pattern.pushValue(MATCH_END);
-                    if (m_players.empty())
-                    {
-                        // first player definition did not start with a name
-                        return false;
-                    }
-                    m_players.back().addPattern(pattern);
-                    pattern.clear();
-                }
-                else if ((token.size() == 2)
-                         && isxdigit(token[0]) && isxdigit(token[1]))
-                {
-                    uint_least16_t i;
-                    std::stringstream token_ss(token);
-                    token_ss >> std::hex >> i;
 
-                    pattern.pushValue(i);
-                }
-                else
+                m_minPos[pattern] = pos + part.length;
+                ++m_nextPart[pattern];
+                if (advance(pattern))
                 {
-                    // start of new player definition
-                    m_players.push_back(Player(token));
+                    best = m_patterns[pattern].player;
                 }
             }
         }
     }
 
-    return true;
-}
-
-
-std::string SidId::identify(const std::vector<uint_least8_t>& buffer)
-{
-    for (std::vector<Player>::const_iterator iter = m_players.begin();
-         iter != m_players.end(); ++iter)
-    {
-        if (iter->match(buffer))
-        {
-            return iter->name();
-        }
-    }
-
-    return "";
+    return (best < m_numPlayers) ? &m_names[m_playerName[best]] : NULL;
 }
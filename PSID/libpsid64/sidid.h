@@ -4,6 +4,10 @@
     psid64 - create a C64 executable from a PSID file
     Copyright (C) 2015  Roland Hermans <rolandh@users.sourceforge.net>
 
+    this code has been modified for integration into the Sidekick64 software
+    (no STL, the patterns of all players are matched in a single pass over
+    the tune)
+
     This program is free software; you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
     the Free Software Foundation; either version 2 of the License, or
@@ -26,9 +30,6 @@
 //                             I N C L U D E S
 //////////////////////////////////////////////////////////////////////////////
 
-#include <string>
-#include <vector>
-
 #include "../sidplay/sidint.h"
 
 
@@ -41,39 +42,97 @@
 //                     D A T A   D E C L A R A T O R S
 //////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Player identification with the patterns of sidid.cfg.
+ *
+ * A pattern consists of parts separated by AND which have to be found in
+ * this order, a part is a byte sequence which may contain single byte
+ * wildcards (??). For each part its longest sequence without wildcards is
+ * entered into one Aho-Corasick automaton. The tune is scanned once, every
+ * hit of such an anchor is verified against the complete part and advances
+ * the pattern it belongs to. The first player (in the order of sidid.cfg)
+ * with a completely matched pattern is reported.
+ */
 class SidId
 {
-    class Pattern
+    struct Part
     {
-        std::vector<uint_least16_t> m_values;
-    public:
-        void clear();
-        void pushValue(uint_least16_t value);
-        bool match(const std::vector<uint_least8_t>& buffer) const;
+        int pattern;                // pattern this part belongs to
+        int index;                  // position within the pattern
+        int values;                 // first value in m_values
+        int length;
+        int anchor;                 // offset of the anchor within the part
+        int anchorLength;
     };
 
-    class Player
+    struct Pattern
     {
-        std::string m_name;
-        std::vector<Pattern> m_patterns;
-    public:
-        explicit Player(const std::string& name);
-        void addPattern(const Pattern& pattern);
-        const std::string& name() const;
-        bool match(const std::vector<uint_least8_t>& buffer) const;
+        int player;
+        int firstPart;
+        int numParts;
     };
 
-    std::vector<Player> m_players;
+    struct Node
+    {
+        int child;                  // first child
+        int sibling;                // next child of the parent
+        int fail;                   // longest proper suffix in the trie
+        int output;                 // first entry in m_outputs, -1 if none
+        int dict;                   // next node with output on the fail chain
+        uint_least8_t value;
+    };
+
+    struct Output
+    {
+        int part;
+        int next;
+    };
+
+    int m_numPlayers;
+    int m_numPatterns;
+    int m_numParts;
+    int m_numValues;
+    int m_numNodes;
+    int m_numOutputs;
+    int m_namesSize;
+
+    char* m_names;
+    int* m_playerName;              // offset in m_names
+    Pattern* m_patterns;
+    Part* m_parts;
+    uint_least16_t* m_values;
+    Node* m_nodes;
+    Output* m_outputs;
+    int m_rootNext[256];
+
+    // matching state per pattern
+    int* m_nextPart;
+    int* m_minPos;
 
     static const uint_least16_t MATCH_WILDCARD_ONE = 0x100;
-    static const uint_least16_t MATCH_WILDCARD_MULTIPLE = 0x101;
-    static const uint_least16_t MATCH_END = 0x102;
 
-    static std::string trim(const std::string& str,
-                            const std::string& whitespace = " \t\n\r");
+    void clear();
+    bool parse(const char* text, int size, bool store);
+    void addAnchor(int part);
+    void buildAutomaton();
+    int step(int state, uint_least8_t c) const;
+    bool verify(const Part& part, const uint_least8_t* buffer, int pos) const;
+    bool advance(int pattern) const;
+
 public:
-    bool readConfigFile(const std::string& filename);
-    std::string identify(const std::vector<uint_least8_t>& buffer);
+    SidId();
+    ~SidId();
+
+    /**
+     * Parse the contents of sidid.cfg and build the automaton.
+     */
+    bool readConfig(const char* text, int size);
+
+    /**
+     * Return the name of the player routine used in the buffer, NULL if it
+     * is unknown.
+     */
+    const char* identify(const uint_least8_t* buffer, int size);
 };
 
 #endif // SIDID_H
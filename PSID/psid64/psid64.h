@@ -45,8 +45,9 @@
 //////////////////////////////////////////////////////////////////////////////
 
 class Screen;
-//class SidId;
+class SidId;
 class STIL;
+struct exomizer_options;
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -177,6 +178,16 @@ public:
         return m_compress;
     }
 
+    /**
+     * Set the Exomizer options (e.g. the fast match finder and a time
+     * budget) used when compressing. The options are not copied, NULL
+     * selects the exhaustive defaults.
+     */
+    inline void setCompressOptions(const exomizer_options* options)
+    {
+        m_compressOptions = options;
+    }
+
     /**
      * Set the initial song number. When 0 or larger than the total number of
      * songs, the initial song as specified in the SID file header is used.
@@ -194,6 +205,41 @@ public:
 	return m_initialSong;
     }
 
+    /**
+     * Set the song lengths (in seconds, 0 = unknown) of the subtunes, e.g.
+     * from the HVSC song length database. Used by the next conversion for
+     * the time display and the progress bar.
+     */
+    void setSongLengths(const uint_least16_t* lengths, int numSongs);
+
+    /**
+     * Set the STIL entry (plain text as in STIL.txt) which the next
+     * conversion shows as scroll text. The text is not copied and must stay
+     * valid until convert() returns, NULL means no STIL text.
+     */
+    inline void setStilText(const char* stilText)
+    {
+        m_stilEntry = stilText;
+    }
+
+    /**
+     * Set the player identification (sidid.cfg) used by the next
+     * conversion, NULL disables the identification.
+     */
+    inline void setSidId(SidId* sidId)
+    {
+        m_sidId = sidId;
+    }
+
+    /**
+     * Get the name of the player routine found by the most recent
+     * conversion, NULL if it is unknown.
+     */
+    inline const char* getPlayerId() const
+    {
+        return m_playerId;
+    }
+
     /**
      * Set the use global comment flag. When set, PSID64 tries to extract
      * the global comment field of a PSID from the STIL database.
@@ -274,6 +320,36 @@ public:
      */
     //bool write(std::ostream& out = std::cout);
 
+    /**
+     * Get the memory layout of the most recently generated C64 executable:
+     * start pages of driver, screen, charset, STIL text and song lengths,
+     * 0 means not present.
+     */
+    inline uint_least8_t getDriverPage() const
+    {
+        return m_driverPage;
+    }
+
+    inline uint_least8_t getScreenPage() const
+    {
+        return m_screenPage;
+    }
+
+    inline uint_least8_t getCharPage() const
+    {
+        return m_charPage;
+    }
+
+    inline uint_least8_t getStilPage() const
+    {
+        return m_stilPage;
+    }
+
+    inline uint_least8_t getSonglengthsPage() const
+    {
+        return m_songlengthsPage;
+    }
+
     // converted file
     uint_least8_t *m_programData;
     unsigned int m_programSize;
@@ -289,6 +365,7 @@ private:
     static const unsigned int NUM_SCREEN_PAGES = 4; // size of screen in pages
     static const unsigned int NUM_CHAR_PAGES = 4; // size of charset in pages
     static const unsigned int STIL_EOT_SPACES = 10; // number of spaces before EOT
+    static const unsigned int MAX_STIL_TEXT = 0x1000; // incl. end-of-text marker
     static const unsigned int BAR_X = 15;
     static const unsigned int BAR_WIDTH = 19;
     static const unsigned int BAR_SPRITE_SCREEN_OFFSET = 0x300;
@@ -299,12 +376,15 @@ private:
     static const char* txt_fileIoError;
     static const char* txt_noSidTuneLoaded;
     static const char* txt_noSidTuneConverted;
+    static const char* txt_compressionFailed;
+    static const char* txt_compressionOutOfMemory;
     //static const char* txt_sidIdConfigError;
 
     // configuration options
     bool m_noDriver;
     bool m_blankScreen;
     bool m_compress;
+    const exomizer_options* m_compressOptions;
     int m_initialSong;
     bool m_useGlobalComment;
     bool m_verbose;
@@ -322,12 +402,17 @@ private:
     SidTuneMod m_tune;
     SidTuneInfo m_tuneInfo;
     //SidDatabase m_database;
+    uint_least16_t m_songLengths[SIDTUNE_MAX_SONGS];
+    int m_numSongLengths;
     //STIL *m_stil;
-    //SidId *m_sidId;
+    SidId *m_sidId;
 
     // conversion data
     Screen *m_screen;
     //std::string m_stilText;
+    const char* m_stilEntry;
+    uint_least8_t m_stilText[MAX_STIL_TEXT];
+    unsigned int m_stilTextSize;
     uint_least8_t m_songlengthsData[4 * SIDTUNE_MAX_SONGS];
     size_t m_songlengthsSize;
     uint_least8_t m_driverPage; // startpage of driver, 0 means no driver
@@ -335,7 +420,7 @@ private:
     uint_least8_t m_charPage; // startpage of chars, 0 means no chars
     uint_least8_t m_stilPage; // startpage of stil, 0 means no stil
     uint_least8_t m_songlengthsPage; // startpage of song length data, 0 means no song lengths
-    //std::string m_playerId;
+    const char* m_playerId;
 
     // member functions
     int_least32_t roundDiv(int_least32_t dividend, int_least32_t divisor);
@@ -0,0 +1,176 @@
+//
+// host stand-ins for the GPIO, cycle counter, cache and latch primitives used by the FIQ handlers:
+// every access which is visible on the bus (or changes timing) is appended to an event log,
+// the bus macros of helpers.h/lowlevel_arm64.h are repeated on top of these primitives
+//
+#ifndef _busstub_h
+#define _busstub_h
+
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+
+#include "gpio_defs.h"
+#include "Vice/m93c86.h"
+
+#define ARM_GPIO_BASE		0x3F200000
+#define ARM_GPIO_GPSET0		(ARM_GPIO_BASE + 0x1C)
+#define ARM_GPIO_GPCLR0		(ARM_GPIO_BASE + 0x28)
+#define ARM_GPIO_GPLEV0		(ARM_GPIO_BASE + 0x34)
+
+// event log
+enum { EV_WRITE32, EV_WAIT, EV_PREFETCH, EV_RESETCC, EV_EEPROM };
+
+extern void simEvent( u32 type, u64 a, u64 b );
+extern u32 simRead32( u32 reg );
+
+static inline u32 read32( u32 reg ) { return simRead32( reg ); }
+static inline void write32( u32 reg, u32 v ) { simEvent( EV_WRITE32, reg, v ); }
+
+// timing: the handlers only wait for points in time relative to the start of the cycle
+extern u32 WAIT_FOR_SIGNALS, WAIT_CYCLE_MULTIPLEXER, WAIT_CYCLE_READ, WAIT_CYCLE_READ_BADLINE, WAIT_CYCLE_READ_VIC2,
+	WAIT_CYCLE_WRITEDATA, WAIT_CYCLE_WRITEDATA_VIC2, WAIT_CYCLE_MULTIPLEXER_VIC2, WAIT_TRIGGER_DMA, WAIT_RELEASE_DMA;
+
+#define BEGIN_CYCLE_COUNTER			u64 armCycleCounter = 0; (void)armCycleCounter;
+#define WAIT_UP_TO_CYCLE( wc )		{ simEvent( EV_WAIT, (wc) + armCycleCounter, 0 ); }
+#define RESET_CPU_CYCLE_COUNTER		simEvent( EV_RESETCC, 0, 0 );
+
+#define PREFETCH( kind, ptr )		{ simEvent( EV_PREFETCH, kind, (u64)(ptr) ); }
+#define CACHE_PRELOADL1KEEP( ptr )	PREFETCH( 1, ptr )
+#define CACHE_PRELOADL1STRM( ptr )	PREFETCH( 2, ptr )
+#define CACHE_PRELOADL2KEEP( ptr )	PREFETCH( 3, ptr )
+#define CACHE_PRELOADL2STRM( ptr )	PREFETCH( 4, ptr )
+#define CACHE_PRELOADL2STRMW( ptr )	PREFETCH( 5, ptr )
+
+#define CACHE_PRELOAD_DATA_CACHE( p, size, FUNC )			\
+	{ u8 *ptr = (u8*)( p );									\
+	for ( u32 i = 0; i < (size+63) / 64; i++ )	{			\
+		FUNC( ptr );										\
+		ptr += 64;											\
+	} }
+
+// lowlevel_arm64.h
+#define SET_GPIO( set )	write32( ARM_GPIO_GPSET0, (set) );
+#define CLR_GPIO( clr )	write32( ARM_GPIO_GPCLR0, (clr) );
+#define	SETCLR_GPIO( set, clr )	SET_GPIO( set )	CLR_GPIO( clr )
+
+#define PUT_DATA_ON_BUS_AND_CLEAR257_WAIT( D, WAIT ) \
+		u32 DD = ( (D) & 255 ) << D0;													\
+		write32( ARM_GPIO_GPSET0, DD  );												\
+		write32( ARM_GPIO_GPCLR0, (D_FLAG & ( ~DD )) | (1 << GPIO_OE) | bCTRL257 );		\
+		WAIT_UP_TO_CYCLE( WAIT );														\
+		write32( ARM_GPIO_GPSET0, (1 << GPIO_OE) );
+
+#define PUT_DATA_ON_BUS_AND_CLEAR257( D )			PUT_DATA_ON_BUS_AND_CLEAR257_WAIT( D, WAIT_CYCLE_READ )
+#define PUT_DATA_ON_BUS_AND_CLEAR257_VIC2( D )		PUT_DATA_ON_BUS_AND_CLEAR257_WAIT( D, WAIT_CYCLE_READ_VIC2 )
+#define PUT_DATA_ON_BUS_AND_CLEAR257_BADLINE( D )	PUT_DATA_ON_BUS_AND_CLEAR257_WAIT( D, WAIT_CYCLE_READ_BADLINE )
+
+#define GET_DATA_FROM_BUS_AND_CLEAR257( D ) \
+			SET_BANK2_INPUT															\
+			write32( ARM_GPIO_GPCLR0, (1 << GPIO_OE) | bCTRL257 );					\
+			WAIT_UP_TO_CYCLE( WAIT_CYCLE_WRITEDATA );								\
+			D = ( read32( ARM_GPIO_GPLEV0 ) >> D0 ) & 255;							\
+			write32( ARM_GPIO_GPSET0, 1 << GPIO_OE );								\
+			SET_BANK2_OUTPUT
+
+// helpers.h
+#define START_AND_READ_ADDR0to7_RW_RESET_CS	\
+	u32 g2, g3;								\
+	BEGIN_CYCLE_COUNTER						\
+	WAIT_UP_TO_CYCLE( WAIT_FOR_SIGNALS );	\
+	g2 = read32( ARM_GPIO_GPLEV0 );			\
+	write32( ARM_GPIO_GPSET0, bCTRL257 );
+
+#define START_AND_READ_ADDR0to7_RW_RESET_CS_NO_MULTIPLEX \
+	u32 g2, g3;								\
+	BEGIN_CYCLE_COUNTER						\
+	WAIT_UP_TO_CYCLE( WAIT_FOR_SIGNALS );	\
+	g2 = read32( ARM_GPIO_GPLEV0 );
+
+#define READ_ADDR0to7_RW_RESET_CS_AND_MULTIPLEX	\
+	g2 = read32( ARM_GPIO_GPLEV0 );			\
+	write32( ARM_GPIO_GPSET0, bCTRL257 );
+
+#define WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA	\
+	WAIT_UP_TO_CYCLE( WAIT_CYCLE_MULTIPLEXER ); \
+	g3 = read32( ARM_GPIO_GPLEV0 );
+
+#define WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA_VIC2	\
+	WAIT_UP_TO_CYCLE( WAIT_CYCLE_MULTIPLEXER_VIC2 ); \
+	g3 = read32( ARM_GPIO_GPLEV0 );
+
+#define READ_ADDR8to12_ROMLH_IO12_BA	\
+	g3 = read32( ARM_GPIO_GPLEV0 );
+
+#define READ_D0to7_FROM_BUS( D )	{ GET_DATA_FROM_BUS_AND_CLEAR257( D ) }
+#define WRITE_D0to7_TO_BUS( D )		{ PUT_DATA_ON_BUS_AND_CLEAR257( D ) }
+#define WRITE_D0to7_TO_BUS_VIC( D )	{ PUT_DATA_ON_BUS_AND_CLEAR257_VIC2( D ) }
+#define WRITE_D0to7_TO_BUS_BADLINE( D )	{ PUT_DATA_ON_BUS_AND_CLEAR257_BADLINE( D ) }
+
+#define FINISH_BUS_HANDLING						\
+	write32( ARM_GPIO_GPCLR0, bCTRL257 );		\
+	RESET_CPU_CYCLE_COUNTER
+
+#define OUTPUT_LATCH_AND_FINISH_BUS_HANDLING	\
+	write32( ARM_GPIO_GPCLR0, bCTRL257 );		\
+	outputLatch();								\
+	RESET_CPU_CYCLE_COUNTER
+
+#define IO1_ACCESS			(!(g3 & bIO1))
+#define IO2_ACCESS			(!(g3 & bIO2))
+#define ROML_ACCESS			(!(g3 & bROML))
+#define ROMH_ACCESS			(!(g3 & bROMH))
+#define ROML_OR_ROMH_ACCESS (ROML_ACCESS||ROMH_ACCESS)
+
+#define GET_IO12_ADDRESS	 ((g2>>A0)&255)
+#define GET_ADDRESS0to7		 ((g2>>A0)&255)
+#define GET_ADDRESS8to12	 ((g3>>A8)&31)
+#define GET_ADDRESS			 (GET_ADDRESS0to7|(GET_ADDRESS8to12<<8))
+#define GET_ADDRESS_CACHEOPT ((GET_ADDRESS0to7<<5)|GET_ADDRESS8to12)
+
+#define CPU_RESET			(!(g2&bRESET))
+#define CPU_READS_FROM_BUS	(g2 & bRW)
+#define CPU_WRITES_TO_BUS	(!(g2 & bRW))
+
+#define VIC_HALF_CYCLE		(!(g2 & bPHI))
+#define VIC_BADLINE			(!(g3 & bBA) && (g2 & bRW))
+
+#define	UPDATE_COUNTERS_MIN( c64CycleCount, resetCounter )	\
+	c64CycleCount ++;										\
+	if ( !( g2 & bRESET ) ) {								\
+		resetCounter ++;									\
+	} else {												\
+		resetCounter = 0;									\
+	}
+
+// latch.h
+#define LATCH_LED0 			(1<<D1)
+#define LATCH_LED1 			(1<<D2)
+
+extern u32 latchD, latchDOld;
+
+static inline void outputLatch()
+{
+	if ( latchD != latchDOld )
+	{
+		latchDOld = latchD;
+
+		write32( ARM_GPIO_GPSET0, ( D_FLAG & latchD ) | (1 << GPIO_OE) );
+		write32( ARM_GPIO_GPCLR0, ( D_FLAG & ( ~latchD ) ) );
+
+		BEGIN_CYCLE_COUNTER
+		WAIT_UP_TO_CYCLE( 50 );
+		write32( ARM_GPIO_GPSET0, (1 << LATCH_CONTROL) );
+		WAIT_UP_TO_CYCLE( 50 + 50 );
+		write32( ARM_GPIO_GPCLR0, (1 << LATCH_CONTROL) );
+	}
+}
+
+static inline void setLatchFIQ( u32 f ) { latchD |= f; }
+static inline void clrLatchFIQ( u32 f ) { latchD &= ~f; }
+
+#endif
@@ -0,0 +1,312 @@
+/*
+  _________.__    .___      __   .__        __           _________                        .___
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __      /   _____/ ____  __ __  ____    __| _/
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /      \_____  \ /  _ \|  |  \/    \  / __ |
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <       /        (  <_> )  |  /   |  \/ /_/ |
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     /_______  /\____/|____/|___|  /\____ |
+        \/         \/    \/     \/       \/     \/             \/                  \/      \/
+
+ efbussim.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - host-side bus simulator comparing the generated bankswitch FIQ handlers to the hand-written ones
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// feeds random bus cycles (reads, writes, VIC half cycles, badlines, reset pulses) into the hand-written
+// handlers (legacy_handlers.h) and the ones generated from kernel_ef_mappers.h, and compares the sequence
+// of GPIO accesses, wait points, prefetches and EEPROM calls as well as the cartridge state after each cycle
+//
+// build: g++ -std=gnu++14 -O2 -Wall -I. -I../.. -o efbussim efbussim.cpp
+// usage: efbussim [cycles per mapper]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "busstub.h"
+
+// same as in crt.h
+#define BS_HUCKY	0x11
+
+// same as in kernel_ef.cpp
+typedef struct
+{
+	u8  ram[ 256 ];
+	u32 nBanks;
+	u8	bankswitchType;
+	u32 ROM_LH;
+	u8	*flashBank;
+	u8	*flash_cacheoptimized;
+	u8  reg0, reg0old, reg2;
+	u32 jumper;
+	u8	memconfig[ 16 ];
+	u32 resetCounter, resetCounter2,
+		cyclesSinceReset,
+		resetPressed, resetReleased, resetEFRAM;
+	u64 c64CycleCount;
+	u32 releaseDMA;
+	u32 flashFitsInCache;
+	u32 eapiState;
+	u8 eapiBufferIn[ 4 ];
+	u8 eapiBufferOut[ 4 ];
+	u32 eapiBufCountIn;
+	u32 eapiBufCountOut;
+	u32 eapiBufPosOut;
+	u32 mainloopCount;
+	u32 eapiCRTModified;
+	s32 eeprom_cs, eeprom_data, eeprom_clock;
+	u32 eeprom_next_data;
+	s32 eeprom_delayed_write;
+	u32 triggerDMA, dmaCountWrites;
+	u32 LONGBOARD;
+	u32 hasKernal;
+} __attribute__((packed)) EFSTATE;
+
+static u8 flash_cacheoptimized_pool[ 1024 * 1024 + 8 * 1024 ];
+static volatile EFSTATE ef;
+static u32 epyxDisable = 0;
+
+u32 latchD, latchDOld;
+
+u32 WAIT_FOR_SIGNALS = 1000, WAIT_CYCLE_MULTIPLEXER = 2000, WAIT_CYCLE_READ = 3000, WAIT_CYCLE_READ_BADLINE = 4000,
+	WAIT_CYCLE_READ_VIC2 = 5000, WAIT_CYCLE_WRITEDATA = 6000, WAIT_CYCLE_WRITEDATA_VIC2 = 7000,
+	WAIT_CYCLE_MULTIPLEXER_VIC2 = 8000, WAIT_TRIGGER_DMA = 9000, WAIT_RELEASE_DMA = 10000;
+
+// same as in kernel_ef.cpp
+#define TRIGGER_CAN_ASSERT_DMA ( ef.dmaCountWrites == 3 ? true : false )
+#define TRIGGER_DMA_COUNT_WRITES { 	if ( CPU_WRITES_TO_BUS ) ef.dmaCountWrites ++; else ef.dmaCountWrites = 0; }
+#define TRIGGER_DMA( cycles ) { ef.triggerDMA = cycles; }
+#define	HANDLE_DMA_TRIGGER_RELEASE \
+	if ( ef.triggerDMA ) {							\
+		ef.releaseDMA = ef.triggerDMA;				\
+		ef.triggerDMA = 0;							\
+		WAIT_UP_TO_CYCLE( WAIT_TRIGGER_DMA );		\
+		CLR_GPIO( bDMA );							\
+		setLatchFIQ( LATCH_LED0 );					\
+	} else											\
+	if ( ef.releaseDMA > 0 && --ef.releaseDMA == 0 )\
+	{												\
+		WAIT_UP_TO_CYCLE( WAIT_RELEASE_DMA );		\
+		SET_GPIO( bDMA );							\
+		clrLatchFIQ( LATCH_LED0 );					\
+	}
+
+// EEPROM of the GMod2: only the calls are recorded, the data line follows a simple state
+int m93c86_addr = 0;
+uint8_t m93c86_data[ M93C86_SIZE ];
+static u32 eepromState = 1;
+
+uint8_t m93c86_read_data() { simEvent( EV_EEPROM, 0, eepromState ); return eepromState & 1; }
+void m93c86_write_data( uint8_t v ) { simEvent( EV_EEPROM, 1, v ); eepromState = eepromState * 3 + v; }
+void m93c86_write_select( uint8_t v ) { simEvent( EV_EEPROM, 2, v ); eepromState = eepromState * 5 + v; }
+void m93c86_write_clock( uint8_t v ) { simEvent( EV_EEPROM, 3, v ); eepromState = eepromState * 7 + v; m93c86_addr = eepromState & 1023; }
+
+#include "kernel_ef_mappers.h"
+#include "legacy_handlers.h"
+
+//
+// bus model: GPLEV0 returns the signals of the current cycle, the 257-multiplexer selects A0..A7/RW/RESET/PHI2 or
+// A8..A12/ROML/ROMH/IO1/IO2/BA, D0..D7 carry the byte written by the CPU
+//
+struct EVENT { u32 type; u64 a, b; };
+
+static std::vector< EVENT > events;
+static u32 busG2, busG3, busData, mux257;
+
+void simEvent( u32 type, u64 a, u64 b )
+{
+	if ( type == EV_WRITE32 && a == ARM_GPIO_GPSET0 && ( b & bCTRL257 ) ) mux257 = 1;
+	if ( type == EV_WRITE32 && a == ARM_GPIO_GPCLR0 && ( b & bCTRL257 ) ) mux257 = 0;
+	EVENT e = { type, a, b };
+	events.push_back( e );
+}
+
+u32 simRead32( u32 reg )
+{
+	if ( reg != ARM_GPIO_GPLEV0 )
+		return 0;
+	return ( ( mux257 ? busG3 : busG2 ) & ~D_FLAG ) | ( busData << D0 );
+}
+
+struct SNAPSHOT
+{
+	EFSTATE ef;
+	u32 epyxDisable, latchD, latchDOld, eepromState;
+	int m93c86_addr;
+};
+
+static void saveState( SNAPSHOT *s )
+{
+	memcpy( &s->ef, (void*)&ef, sizeof( EFSTATE ) );
+	s->epyxDisable = epyxDisable;
+	s->latchD = latchD;
+	s->latchDOld = latchDOld;
+	s->eepromState = eepromState;
+	s->m93c86_addr = m93c86_addr;
+}
+
+static void loadState( const SNAPSHOT *s )
+{
+	memcpy( (void*)&ef, &s->ef, sizeof( EFSTATE ) );
+	epyxDisable = s->epyxDisable;
+	latchD = s->latchD;
+	latchDOld = s->latchDOld;
+	eepromState = s->eepromState;
+	m93c86_addr = s->m93c86_addr;
+}
+
+static u32 rnd( u32 n ) { return (u32)( rand() % n ); }
+
+// one random bus cycle, reset is pulled in bursts such that the reset handling is reached
+static void randomCycle( u32 *resetBurst )
+{
+	busG2 = ( (u32)rand() << 1 ) ^ (u32)rand();
+	busG3 = ( (u32)rand() << 1 ) ^ (u32)rand();
+	busData = rnd( 256 );
+
+	// RW, PHI2, RESET
+	if ( rnd( 10 ) < 7 ) busG2 |= bRW; else busG2 &= ~bRW;
+	if ( rnd( 10 ) < 2 ) busG2 &= ~bPHI; else busG2 |= bPHI;
+	if ( *resetBurst == 0 && rnd( 200 ) == 0 )
+		*resetBurst = 1 + rnd( 8 );
+	if ( *resetBurst ) { busG2 &= ~bRESET; ( *resetBurst ) --; } else busG2 |= bRESET;
+
+	// at most one of ROML, ROMH, IO1, IO2
+	busG3 |= bROML | bROMH | bIO1 | bIO2;
+	switch ( rnd( 6 ) )
+	{
+	case 0: busG3 &= ~bROML; break;
+	case 1: busG3 &= ~bROMH; break;
+	case 2: busG3 &= ~bIO1; break;
+	case 3: busG3 &= ~bIO2; break;
+	default: break;
+	}
+	if ( rnd( 10 ) == 0 ) busG3 &= ~bBA; else busG3 |= bBA;
+
+	// the register decoders mostly look at the low addresses
+	if ( rnd( 2 ) )
+		busG2 &= ~( 0xf0 << A0 );
+
+	mux257 = 0;
+}
+
+struct MAPPER
+{
+	const char *name;
+	void (*legacy)( void * );
+	void (*generated)( void * );
+	u32 nBanks, bankswitchType, longboard;
+};
+
+static const MAPPER mappers[] =
+{
+	{ "nobank",			KernelEFFIQHandler_nobank,		KernelEFFIQHandlerT<EFMapperNoBank>,		1, 0, 0 },
+	{ "nobank (long)",	KernelEFFIQHandler_nobank,		KernelEFFIQHandlerT<EFMapperNoBank>,		1, 0, 1 },
+	{ "Prophet64",		KernelEFFIQHandler_Prophet,		KernelEFFIQHandlerT<EFMapperProphet>,		32, 0, 0 },
+	{ "GMod2",			KernelEFFIQHandler_GMOD2,		KernelEFFIQHandlerT<EFMapperGMOD2>,			64, 0, 0 },
+	{ "Ocean (256k)",	KernelEFFIQHandler_Ocean,		KernelEFFIQHandlerT<EFMapperOcean>,			32, 0, 0 },
+	{ "Ocean (512k)",	KernelEFFIQHandler_Ocean,		KernelEFFIQHandlerT<EFMapperOcean>,			64, 0, 0 },
+	{ "RGCD",			KernelEFFIQHandler_RGCD,		KernelEFFIQHandlerT<EFMapperRGCD>,			8, 0, 0 },
+	{ "Hucky",			KernelEFFIQHandler_RGCD,		KernelEFFIQHandlerT<EFMapperRGCD>,			8, BS_HUCKY, 0 },
+	{ "Zaxxon",			KernelEFFIQHandler_Zaxxon,		KernelEFFIQHandlerT<EFMapperZaxxon>,		2, 0, 0 },
+	{ "C64GS",			KernelEFFIQHandler_C64GS,		KernelEFFIQHandlerT<EFMapperC64GS>,			64, 0, 0 },
+	{ "Dinamic",		KernelEFFIQHandler_Dinamic,		KernelEFFIQHandlerT<EFMapperDinamic>,		16, 0, 0 },
+	{ "Comal80",		KernelEFFIQHandler_Comal80,		KernelEFFIQHandlerT<EFMapperComal80>,		4, 0, 0 },
+	{ "Simons' Basic",	KernelEFFIQHandler_SimonsBasic,	KernelEFFIQHandlerT<EFMapperSimonsBasic>,	2, 0, 0 },
+	{ "Epyx FL",		KernelEFFIQHandler_EpyxFL,		KernelEFFIQHandlerT<EFMapperEpyxFL>,		1, 0, 0 },
+};
+
+static void printEvents( const char *title, const std::vector< EVENT > &ev )
+{
+	printf( "  %s:\n", title );
+	for ( size_t i = 0; i < ev.size(); i++ )
+		printf( "    %u %08llx %08llx\n", ev[ i ].type, (unsigned long long)ev[ i ].a, (unsigned long long)ev[ i ].b );
+}
+
+int main( int argc, char **argv )
+{
+	u32 nCycles = argc > 1 ? atoi( argv[ 1 ] ) : 1000000;
+	u32 failed = 0;
+
+	for ( u32 i = 0; i < sizeof( flash_cacheoptimized_pool ); i++ )
+		flash_cacheoptimized_pool[ i ] = rand();
+
+	for ( u32 m = 0; m < sizeof( mappers ) / sizeof( MAPPER ); m++ )
+	{
+		const MAPPER *M = &mappers[ m ];
+
+		srand( 1234 + m );
+		memset( (void*)&ef, 0, sizeof( EFSTATE ) );
+		ef.flash_cacheoptimized = flash_cacheoptimized_pool;
+		ef.flashBank = flash_cacheoptimized_pool;
+		ef.nBanks = M->nBanks;
+		ef.bankswitchType = M->bankswitchType;
+		ef.LONGBOARD = M->longboard;
+		epyxDisable = 0;
+		latchD = latchDOld = 0;
+
+		u32 resetBurst = 0, mismatches = 0;
+		u64 nEvents = 0;
+		SNAPSHOT before, afterLegacy, afterGenerated;
+
+		for ( u32 c = 0; c < nCycles; c++ )
+		{
+			randomCycle( &resetBurst );
+
+			// exercise the DMA trigger/release paths and leave the reset state every now and then
+			if ( rnd( 500 ) == 0 ) ef.triggerDMA = 1 + rnd( 4 );
+			if ( rnd( 300 ) == 0 ) ef.resetCounter = 0;
+
+			saveState( &before );
+
+			u32 g2 = busG2, g3 = busG3, d = busData;
+			events.clear();
+			M->legacy( NULL );
+			std::vector< EVENT > evLegacy = events;
+			saveState( &afterLegacy );
+
+			loadState( &before );
+			busG2 = g2; busG3 = g3; busData = d; mux257 = 0;
+			events.clear();
+			M->generated( NULL );
+			saveState( &afterGenerated );
+
+			nEvents += events.size();
+
+			bool same = evLegacy.size() == events.size() &&
+						memcmp( &afterLegacy, &afterGenerated, sizeof( SNAPSHOT ) ) == 0;
+			for ( size_t i = 0; same && i < events.size(); i++ )
+				same = evLegacy[ i ].type == events[ i ].type && evLegacy[ i ].a == events[ i ].a && evLegacy[ i ].b == events[ i ].b;
+
+			if ( !same && mismatches++ < 3 )
+			{
+				printf( "%s: mismatch in cycle %u (g2=%08x g3=%08x d=%02x)\n", M->name, c, g2, g3, d );
+				printEvents( "hand-written", evLegacy );
+				printEvents( "generated", events );
+			}
+		}
+
+		printf( "%-16s %u cycles, %llu bus events, %u mismatches\n", M->name, nCycles, (unsigned long long)nEvents, mismatches );
+		if ( mismatches )
+			failed ++;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,670 @@
+//
+// hand-written bankswitch FIQ handlers of kernel_ef.cpp before they were generated from kernel_ef_mappers.h,
+// kept unchanged as reference for efbussim
+//
+static void KernelEFFIQHandler_Prophet( void *pParam )
+{
+	register u32 D, addr;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	addr = GET_ADDRESS0to7 << 5;
+	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	{
+		D = ef.flashBank[ addr ];
+		WRITE_D0to7_TO_BUS( D )
+	} else
+	if ( CPU_WRITES_TO_BUS && IO2_ACCESS && GET_IO12_ADDRESS == 0 )
+	{
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 );
+
+		if ( ( D >> 5 ) & 1 )
+		{ // cartridge off 
+			SET_GPIO( bGAME | bEXROM );
+		} else
+		{ // cartridge on
+			SETCLR_GPIO( bGAME, bEXROM );
+		}
+
+		ef.reg0 = D & 0x1f;
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+	} 
+		
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		ef.releaseDMA = 0;
+		ef.reg0 = 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	//CLEAR_LEDS_EVERY_8K_CYCLES
+	static u32 cycleCount = 0;
+	if ( !((++cycleCount)&8191) )
+		clrLatchFIQ( LATCH_LED0 );
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+static void KernelEFFIQHandler_GMOD2( void *pParam )
+{
+	register u32 D, addr;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	addr = GET_ADDRESS0to7 << 5;
+	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
+
+	extern int m93c86_addr;
+	extern uint8_t m93c86_data[M93C86_SIZE];
+	CACHE_PRELOADL2STRMW( &m93c86_data[ m93c86_addr * 2 ] );
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	ef.mainloopCount = 0;
+
+	TRIGGER_DMA_COUNT_WRITES
+
+	addr = GET_ADDRESS_CACHEOPT;
+	
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	{
+		D = ef.flashBank[ addr ];
+		WRITE_D0to7_TO_BUS( D )
+	} else
+	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		if (ef.eeprom_cs) {
+			D = m93c86_read_data() << 7;
+			WRITE_D0to7_TO_BUS( D )
+		} else
+			WRITE_D0to7_TO_BUS( 0 )
+	} else
+	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	{
+		READ_D0to7_FROM_BUS( D )
+
+		if ( ( D & 0xc0 ) == 0xc0 ) {
+			SETCLR_GPIO( bEXROM, bGAME ); 
+		} else if ( ( D & 0x40 ) == 0x00 ) {
+			SETCLR_GPIO( bGAME, bEXROM ); 
+		} else if ( ( D & 0x40 ) == 0x40 ) {
+			SET_GPIO( bGAME | bEXROM ); 
+		}
+		ef.eeprom_cs = ( D >> 6 ) & 1;
+		ef.eeprom_data = ( D >> 4 ) & 1;
+		ef.eeprom_clock = ( D >> 5 ) & 1;
+		m93c86_write_select( (uint8_t)ef.eeprom_cs );
+		if ( ef.eeprom_cs ) {
+			m93c86_write_data( (uint8_t)( ef.eeprom_data ) );
+			m93c86_write_clock( (uint8_t)( ef.eeprom_clock ) );
+		}
+
+		if ( ef.reg0 != (D & 0x3f) )
+		{
+			ef.reg0 = D & 0x3f;
+			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+			CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+		}
+	} 
+
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		ef.releaseDMA = 0;
+		ef.reg0 = 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	HANDLE_DMA_TRIGGER_RELEASE
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+static void KernelEFFIQHandler_Ocean( void *pParam )
+{
+	register u32 D, addr;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	addr = GET_ADDRESS0to7 << 5;
+	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
+	{
+		D = ef.flashBank[ addr ];
+		WRITE_D0to7_TO_BUS( D )
+	} 
+	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	{
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 );
+		ef.reg0 = D & 0x3f;
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+	} 
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		ef.releaseDMA = 0;
+		ef.reg0 = 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+		if ( ef.nBanks > 32 )
+			{SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );} else
+			{SETCLR_GPIO( bDMA | bNMI, bEXROM | bGAME );} 
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	//CLEAR_LEDS_EVERY_8K_CYCLES
+	static u32 cycleCount = 0;
+	if ( !((++cycleCount)&8191) )
+		clrLatchFIQ( LATCH_LED0 );
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+static void KernelEFFIQHandler_RGCD( void *pParam )
+{
+	register u32 D, addr;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	addr = GET_ADDRESS0to7 << 5;
+	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS && !ef.reg2 )
+	{
+		D = ef.flashBank[ addr ];
+		WRITE_D0to7_TO_BUS( D )
+	} 
+
+	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	{
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 );
+		if ( D & 8 )
+		{
+			ef.reg2 = 1;
+			SET_GPIO( bDMA | bNMI | bGAME | bEXROM );
+		}
+		D &= 7;
+		if ( ef.bankswitchType == BS_HUCKY )
+			ef.reg0 = (D ^ 7) & (ef.nBanks - 1); else
+			ef.reg0 = D & (ef.nBanks - 1); 
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+	} 
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		ef.releaseDMA = 0;
+		ef.reg0 = ef.reg2 = 0;
+		if ( ef.bankswitchType == BS_HUCKY )
+			ef.reg0 = 7 & (ef.nBanks - 1);
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+		SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	//CLEAR_LEDS_EVERY_8K_CYCLES
+	static u32 cycleCount = 0;
+	if ( !((++cycleCount)&8191) )
+		clrLatchFIQ( LATCH_LED0 );
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+static void KernelEFFIQHandler_Zaxxon( void *pParam )
+{
+	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
+	register u8 *bank0 = &ef.flash_cacheoptimized[ 0 ];
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	{
+		D = *(u8*)&bank0[ (addr&0b1111111101111) * 2 + 0 ];
+		ef.reg0 = GET_ADDRESS & 0x1000 ? 1 : 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
+		WRITE_D0to7_TO_BUS( D )
+	} else
+	if ( CPU_READS_FROM_BUS && ROMH_ACCESS )
+	{
+		D = *(u8*)&flashBankR[ ( addr & 0x3fff ) * 2 + 1 ];
+		WRITE_D0to7_TO_BUS( D )
+	} 
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		SET_GPIO( bDMA | bNMI ); 
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+static void KernelEFFIQHandler_C64GS( void *pParam )
+{
+	register u32 D, addr;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	addr = GET_ADDRESS0to7 << 5;
+	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	{
+		D = ef.flashBank[ addr ];
+		WRITE_D0to7_TO_BUS( D )
+	} else
+
+	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		setLatchFIQ( LATCH_LED0 | LATCH_LED1 );
+		ef.reg0 = 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+	} else
+
+	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	{
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 | LATCH_LED1 );
+		ef.reg0 = GET_IO12_ADDRESS & 0x3f;
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+	} 
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		ef.releaseDMA = 0;
+		ef.reg0 = 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
+		clrLatchFIQ( LATCH_LED1 );
+		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	if ( ef.releaseDMA > 0 && --ef.releaseDMA == 0 )
+	{
+		WAIT_UP_TO_CYCLE( WAIT_RELEASE_DMA ); 
+		SET_GPIO( bDMA ); 
+		clrLatchFIQ( LATCH_LED1 );
+	}
+
+	//CLEAR_LEDS_EVERY_8K_CYCLES
+	static u32 cycleCount = 0;
+	if ( !((++cycleCount)&8191) )
+		clrLatchFIQ( LATCH_LED0 );
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+
+static void KernelEFFIQHandler_Dinamic( void *pParam )
+{
+	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	{
+		D = *(u32*)&flashBankR[ addr * 2 ];
+
+		WRITE_D0to7_TO_BUS( D )
+	} else
+
+	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		addr = GET_IO12_ADDRESS;
+		if ( ( addr & 0x0f ) == addr )
+		{
+			ef.reg0 = addr & 0x0f;
+			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
+		}
+	} 
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		SET_GPIO( bDMA | bNMI ); 
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+
+static void KernelEFFIQHandler_Comal80( void *pParam )
+{
+	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
+	{
+		D = *(u32*)&flashBankR[ addr * 2 ];
+		if ( ROMH_ACCESS )
+			D >>= 8; 
+
+		WRITE_D0to7_TO_BUS( D )
+	} else
+
+	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		WRITE_D0to7_TO_BUS( ef.reg2 )
+	} else
+
+	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	{
+		READ_D0to7_FROM_BUS( D )
+
+		ef.reg2 = D & 0xc7;
+		ef.reg0 = D & 3;
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
+
+		if ( D & 0x40 )
+			{SET_GPIO( bEXROM | bGAME );} else
+			{CLR_GPIO( bEXROM | bGAME );}
+	}
+
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		SET_GPIO( bDMA | bNMI ); 
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+static void KernelEFFIQHandler_SimonsBasic( void *pParam )
+{
+	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
+	{
+		D = *(u32*)&flashBankR[ addr * 2 ];
+		if ( ROMH_ACCESS )
+			D >>= 8; 
+
+		WRITE_D0to7_TO_BUS( D )
+	} else
+
+	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		SETCLR_GPIO( bGAME, bEXROM );
+	} else
+
+	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	{
+		CLR_GPIO( bGAME | bEXROM );
+	}
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		SETCLR_GPIO( bDMA | bNMI, bGAME | bEXROM );
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+
+static void KernelEFFIQHandler_EpyxFL( void *pParam )
+{
+	register u32 D, addr;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	{
+		D = *(u32*)&ef.flash_cacheoptimized[ addr * 2 ];
+		epyxDisable = 512 * 2;
+		WRITE_D0to7_TO_BUS( D )
+	} else
+
+	if ( CPU_READS_FROM_BUS && IO2_ACCESS )
+	{
+		addr |= 0b0000000011111; // access 0x1f00 + IO_ADDRESS
+		D = *(u32*)&ef.flash_cacheoptimized[ addr * 2 ];
+		WRITE_D0to7_TO_BUS( D )
+	} else
+
+	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		SETCLR_GPIO( bGAME, bEXROM );
+		epyxDisable = 512 * 2;
+		WRITE_D0to7_TO_BUS( 0 )
+	} 
+
+	if ( CPU_RESET )
+	{
+		epyxDisable = 512 * 2;
+		SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );
+	} else
+	if ( epyxDisable && --epyxDisable == 0 )
+    {
+		SET_GPIO( bEXROM | bGAME );
+    }
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+
+
+static void KernelEFFIQHandler_nobank( void *pParam )
+{
+	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
+
+	// after this call we have some time (until signals are valid, multiplexers have switched, the RPi can/should read again)
+	START_AND_READ_ADDR0to7_RW_RESET_CS_NO_MULTIPLEX
+
+	addr = GET_ADDRESS0to7 << 5;
+	CACHE_PRELOADL2KEEP( &flashBankR[ addr * 2 ] );
+
+	if ( VIC_HALF_CYCLE )
+	{
+		// FINETUNED = experimental code to explore VIC2-timings
+		#ifdef FINETUNED
+		WAIT_UP_TO_CYCLE( 100 );
+		g2 = read32( ARM_GPIO_GPLEV0 );	
+		SET_GPIO( bCTRL257 );	
+		register u32 t;
+		READ_CYCLE_COUNTER( t );
+		WAIT_UP_TO_CYCLE_AFTER( 75+50, t );
+		g3 = read32( ARM_GPIO_GPLEV0 );	
+		#else
+		READ_ADDR0to7_RW_RESET_CS_AND_MULTIPLEX
+		WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA_VIC2
+		#endif
+
+		if ( ROMH_ACCESS ) 
+		{
+			D = *(u8*)&flashBankR[ GET_ADDRESS_CACHEOPT * 2 + 1 ];
+			WRITE_D0to7_TO_BUS_VIC( D )
+		}
+
+		FINISH_BUS_HANDLING
+		return;
+	}  
+
+	SET_GPIO( bCTRL257 );	
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	// read the rest of the signals
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	// VIC2 read during badline?
+	if ( VIC_BADLINE )
+	{
+		if ( !ef.LONGBOARD )
+			READ_ADDR8to12_ROMLH_IO12_BA
+
+		if ( ROMH_ACCESS ) 
+		{
+			D = *(u8*)&flashBankR[ addr * 2 + 1 ];
+			WRITE_D0to7_TO_BUS_BADLINE( D )
+		}
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	//
+	// starting from here: CPU communication
+	//
+	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
+	{
+		D = *(u32*)&flashBankR[ addr * 2 ];
+		if ( ROMH_ACCESS )
+			D >>= 8; 
+
+		WRITE_D0to7_TO_BUS( D )
+		goto cleanup;
+	}
+
+	// reset handling: when button #2 is pressed together with #1 then the EF ram is erased, DMA is released as well
+	if ( !( g2 & bRESET ) ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		SET_GPIO( bDMA | bNMI ); 
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+cleanup:
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
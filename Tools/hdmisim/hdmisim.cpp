@@ -0,0 +1,182 @@
+/*
+  _________.__    .___      __   .__        __           _________                        .___
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __      /   _____/ ____  __ __  ____    __| _/
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /      \_____  \ /  _ \|  |  \/    \  / __ |
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <       /        (  <_> )  |  /   |  \/ /_/ |
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     /_______  /\____/|____/|___|  /\____ |
+        \/         \/    \/     \/       \/     \/             \/                  \/      \/
+
+ hdmisim.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - host-side stand-in for the VCHIQ sound device to measure the HDMI latency profiles
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// simulates the path C64 emulation -> span queue of the VCHIQ device -> GPU for both latency profiles,
+// using the real profile table and drift controller (hdmisync.cpp), and reports latency and underruns
+//
+// build: g++ -O2 -I. -I../.. -o hdmisim hdmisim.cpp ../../hdmisync.cpp
+// usage: hdmisim [clock drift in ppm] [max. stall of the main loop in ms] [seconds]
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <circle/types.h>
+#include "hdmisync.h"
+
+#define CLOCKFREQ			985248
+#define SAMPLERATE			44100
+#define PCM_QUEUE_FRAMES	8192				// as in sound.h
+#define MIXER_BLOCK_SIZE	32					// as in mixer.h
+
+struct SIMRESULT
+{
+	double latencyAvg, latencyMax;	// ms from producing a sample until the GPU plays it
+	u32 glitches;					// chunks the GPU had to pad with silence
+	u32 overruns;					// blocks dropped because the span queue was full
+	u32 profileAtEnd;
+};
+
+static SIMRESULT simulate( u32 profile, double driftPPM, double stallMs, double seconds, u32 seed )
+{
+	srand( seed );
+
+	hdmiProfileRequested = hdmiProfileActive = profile;
+
+	u32 startFrames = hdmiStartFrames( SAMPLERATE );
+	u32 chunkFrames = hdmiProfiles[ profile ].chunkSize / 2;
+
+	hdmiSyncReset( CLOCKFREQ, SAMPLERATE );
+
+	// state of the producer (main loop of the SID kernel)
+	double cycles = 0.0;
+	unsigned long long nextSampleCycleX65536 = 0, samplesElapsed = 0;
+	u32 mixerPos = 0;
+	bool started = false, needData = false, underrun = false;
+	double stallUntil = 0.0;
+
+	// state of the VCHIQ device
+	s32 span = 0;						// frames in the span queue
+	double inFlight = 0.0;				// frames handed to the GPU
+	double dacRate = SAMPLERATE * ( 1.0 + driftPPM * 1e-6 );
+
+	SIMRESULT r = { 0.0, 0.0, 0, 0, 0 };
+	double latencySum = 0.0;
+	u32 latencyCount = 0;
+
+	const double dt = 0.0001;
+	for ( double t = 0.0; t < seconds; t += dt )
+	{
+		// the main loop is sometimes busy with other things (display updates, ...)
+		if ( stallMs > 0.0 && t >= stallUntil && ( rand() % 1000 ) == 0 )
+			stallUntil = t + stallMs * 1e-3 * ( rand() % 1000 ) / 1000.0;
+		bool stalled = t < stallUntil;
+
+		cycles += CLOCKFREQ * dt;
+
+		if ( !stalled )
+		{
+			// emulation catches up with the C64, the mixer renders whole blocks into the span queue
+			while ( ( nextSampleCycleX65536 >> 16 ) <= (unsigned long long)cycles )
+			{
+				samplesElapsed ++;
+				nextSampleCycleX65536 += cyclesPerSampleX65536;
+
+				if ( ++ mixerPos < MIXER_BLOCK_SIZE )
+					continue;
+				mixerPos = 0;
+
+				if ( span + MIXER_BLOCK_SIZE <= PCM_QUEUE_FRAMES )
+					span += MIXER_BLOCK_SIZE; else
+					r.overruns ++;
+			}
+
+			if ( samplesElapsed > startFrames && !started )
+				started = true;
+
+			// mirrors updateHDMISync() in sound.cpp
+			if ( needData )
+			{
+				needData = false;
+				if ( hdmiSyncUpdate( span + (s32)inFlight, underrun, samplesElapsed ) )
+				{
+					chunkFrames = hdmiProfiles[ hdmiProfileActive ].chunkSize / 2;
+					while ( span + (s32)inFlight < hdmiSync.target && span + MIXER_BLOCK_SIZE <= PCM_QUEUE_FRAMES )
+						span += MIXER_BLOCK_SIZE;
+				}
+				underrun = false;
+			}
+		}
+
+		// GPU side: plays at its own clock, the device sends the next chunk from the span queue when only one chunk is left
+		if ( started )
+		{
+			inFlight -= dacRate * dt;
+			if ( inFlight < 0.0 )
+				inFlight = 0.0;
+
+			if ( inFlight <= chunkFrames )
+			{
+				s32 take = span < (s32)chunkFrames ? span : (s32)chunkFrames;
+				if ( take < (s32)chunkFrames )
+				{
+					underrun = true;
+					if ( t > 1.0 )
+						r.glitches ++;
+				}
+				// an empty queue is bridged with a chunk of silence
+				span -= take;
+				inFlight += take ? take : chunkFrames;
+				needData = true;
+			}
+
+			if ( t > 1.0 )
+			{
+				double latency = ( span + inFlight ) * 1000.0 / dacRate;
+				latencySum += latency;
+				latencyCount ++;
+				if ( latency > r.latencyMax )
+					r.latencyMax = latency;
+			}
+		}
+	}
+
+	r.latencyAvg = latencySum / (double)( latencyCount ? latencyCount : 1 );
+	r.profileAtEnd = hdmiProfileActive;
+	return r;
+}
+
+int main( int argc, char **argv )
+{
+	double driftPPM = argc > 1 ? atof( argv[ 1 ] ) : 1000.0;
+	double stallMs = argc > 2 ? atof( argv[ 2 ] ) : 2.0;
+	double seconds = argc > 3 ? atof( argv[ 3 ] ) : 60.0;
+
+	printf( "clock drift %.0f ppm, main loop stalls up to %.1f ms, %.0f s\n\n", driftPPM, stallMs, seconds );
+	printf( "%-12s %10s %10s %9s %9s %8s %9s %s\n", "profile", "lat. avg", "lat. max", "glitches", "overruns", "ppm", "fill/tgt", "at end" );
+
+	for ( u32 p = 0; p < HDMI_PROFILES; p++ )
+	{
+		SIMRESULT r = simulate( p, driftPPM, stallMs, seconds, 1 );
+		printf( "%-12s %7.1f ms %7.1f ms %9u %9u %8d %4d/%-4d %s\n", hdmiProfiles[ p ].name, r.latencyAvg, r.latencyMax, r.glitches, r.overruns, 
+			hdmiSync.ppm, hdmiSync.fillAvg, hdmiSync.target, hdmiProfiles[ r.profileAtEnd ].name );
+	}
+
+	return 0;
+}
@@ -0,0 +1,404 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ hvscidx.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - host-side conversion of the HVSC databases to the binary indices of hvscformat.h
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// builds the indices which the menu searches on the SD card instead of parsing the HVSC text files:
+//   -s  DOCUMENTS/Songlengths.md5 (HVSC #68 or later, MD5 of the complete file) -> songlengths.idx
+//   -t  DOCUMENTS/STIL.txt -> stil.idx (the menu reads the entries from STIL.txt, copy both)
+// copy the output to SD:C64/. The index is read back and every entry is looked up again before the tool exits.
+//
+// build: g++ -O2 -Wall -I../.. -o hvscidx hvscidx.cpp
+// usage: hvscidx -s Songlengths.md5 songlengths.idx
+//        hvscidx -t STIL.txt stil.idx
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#define HVSC_HOST
+#include "hvscformat.h"
+
+typedef std::vector<unsigned char> BUFFER;
+
+static int readAll( const char *fn, BUFFER &b )
+{
+	FILE *f = fopen( fn, "rb" );
+	if ( f == NULL )
+		return 0;
+	unsigned char tmp[ 65536 ];
+	size_t n;
+	while ( ( n = fread( tmp, 1, sizeof( tmp ), f ) ) > 0 )
+		b.insert( b.end(), tmp, tmp + n );
+	fclose( f );
+	return 1;
+}
+
+static int writeAll( const char *fn, const BUFFER &b )
+{
+	FILE *f = fopen( fn, "wb" );
+	if ( f == NULL )
+		return 0;
+	int ok = fwrite( b.data(), 1, b.size(), f ) == b.size();
+	fclose( f );
+	return ok;
+}
+
+static void put16( BUFFER &b, unsigned int v )
+{
+	b.push_back( v & 255 ); b.push_back( ( v >> 8 ) & 255 );
+}
+
+static void put32( BUFFER &b, unsigned int v )
+{
+	put16( b, v & 65535 ); put16( b, v >> 16 );
+}
+
+static void set32( BUFFER &b, size_t ofs, unsigned int v )
+{
+	for ( int i = 0; i < 4; i++ )
+		b[ ofs + i ] = ( v >> ( i * 8 ) ) & 255;
+}
+
+static unsigned int fnv1a( const BUFFER &b )
+{
+	unsigned int h = 2166136261u;
+	for ( size_t i = 0; i < b.size(); i++ )
+		h = ( h ^ b[ i ] ) * 16777619u;
+	return h ? h : 1;		// 0 means "no index"
+}
+
+static int hexDigit( char c )
+{
+	if ( c >= '0' && c <= '9' ) return c - '0';
+	if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+//
+// song lengths
+//
+typedef struct
+{
+	unsigned char md5[ 16 ];
+	std::vector<unsigned short> lengths;
+} TUNE;
+
+static bool tuneLess( const TUNE &a, const TUNE &b )
+{
+	return hvscCompareMD5( a.md5, b.md5 ) < 0;
+}
+
+// "m:ss", "m:ss.mmm", older versions append attributes, e.g. "3:22(G)". Returns the next character or NULL.
+static const char *parseTime( const char *p, unsigned int *seconds )
+{
+	unsigned int m = 0, s = 0, ms = 0, msDigits = 0;
+
+	if ( *p < '0' || *p > '9' )
+		return NULL;
+	while ( *p >= '0' && *p <= '9' ) m = m * 10 + *p++ - '0';
+	if ( *p++ != ':' )
+		return NULL;
+	if ( *p < '0' || *p > '9' )
+		return NULL;
+	while ( *p >= '0' && *p <= '9' ) s = s * 10 + *p++ - '0';
+	if ( *p == '.' )
+		for ( p++; *p >= '0' && *p <= '9'; p++, msDigits++ )
+			if ( msDigits < 3 ) ms = ms * 10 + *p - '0';
+	while ( msDigits < 3 ) { ms *= 10; msDigits++; }
+	if ( *p == '(' )
+		while ( *p && *p != ')' ) p++;
+	if ( *p == ')' )
+		p++;
+
+	unsigned int t = m * 60 + s + ( ms >= 500 ? 1 : 0 );
+	if ( t == 0 && ms > 0 ) t = 1;
+	*seconds = t > 65535 ? 65535 : t;
+	return p;
+}
+
+static int buildSongLengths( const BUFFER &text, BUFFER &out, unsigned int *nTunes )
+{
+	std::vector<TUNE> tunes;
+	std::string line;
+	unsigned int lineNr = 0, nErrors = 0;
+
+	for ( size_t i = 0; i <= text.size(); i++ )
+	{
+		char c = i < text.size() ? text[ i ] : '\n';
+		if ( c == '\r' )
+			continue;
+		if ( c != '\n' )
+		{
+			line += c;
+			continue;
+		}
+		lineNr ++;
+		if ( line.empty() || line[ 0 ] == ';' || line[ 0 ] == '[' )
+		{
+			line.clear();
+			continue;
+		}
+
+		TUNE t;
+		const char *p = line.c_str();
+		int ok = line.size() > 33 && p[ 32 ] == '=';
+		for ( int j = 0; ok && j < 16; j++ )
+		{
+			int hi = hexDigit( p[ j * 2 ] ), lo = hexDigit( p[ j * 2 + 1 ] );
+			if ( hi < 0 || lo < 0 ) ok = 0; else t.md5[ j ] = hi * 16 + lo;
+		}
+
+		for ( p += 33; ok && *p; )
+		{
+			while ( *p == ' ' || *p == '\t' ) p++;
+			if ( !*p ) break;
+			unsigned int s;
+			if ( ( p = parseTime( p, &s ) ) == NULL ) ok = 0; else t.lengths.push_back( s );
+		}
+
+		if ( !ok || t.lengths.empty() || t.lengths.size() > 256 )
+		{
+			if ( nErrors ++ < 10 )
+				fprintf( stderr, "line %u ignored: %s\n", lineNr, line.c_str() );
+		} else
+			tunes.push_back( t );
+
+		line.clear();
+	}
+
+	// the same tune may be listed more than once, keep the first one
+	std::stable_sort( tunes.begin(), tunes.end(), tuneLess );
+	std::vector<TUNE> unique;
+	for ( size_t i = 0; i < tunes.size(); i++ )
+		if ( unique.empty() || hvscCompareMD5( unique.back().md5, tunes[ i ].md5 ) != 0 )
+			unique.push_back( tunes[ i ] );
+
+	BUFFER entries, lengths;
+	unsigned int bucket[ HVSC_BUCKETS + 1 ];
+	unsigned int b = 0;
+
+	for ( size_t i = 0; i < unique.size(); i++ )
+	{
+		while ( b <= hvscBucket( unique[ i ].md5 ) )
+			bucket[ b ++ ] = (unsigned int)i;
+
+		entries.insert( entries.end(), unique[ i ].md5, unique[ i ].md5 + 16 );
+		put32( entries, (unsigned int)lengths.size() );
+
+		put16( lengths, (unsigned int)unique[ i ].lengths.size() );
+		for ( size_t j = 0; j < unique[ i ].lengths.size(); j++ )
+			put16( lengths, unique[ i ].lengths[ j ] );
+	}
+	while ( b <= HVSC_BUCKETS )
+		bucket[ b ++ ] = (unsigned int)unique.size();
+
+	out.clear();
+	out.push_back( 'S' ); out.push_back( 'K' ); out.push_back( 'S' ); out.push_back( 'L' );
+	put32( out, HVSC_SL_VERSION );
+	put32( out, (unsigned int)unique.size() );
+	put32( out, fnv1a( text ) );
+	put32( out, 0 );		// lengths offset, below
+	put32( out, (unsigned int)lengths.size() );
+	put32( out, 0 ); put32( out, 0 );
+
+	for ( unsigned int i = 0; i <= HVSC_BUCKETS; i++ )
+		put32( out, bucket[ i ] );
+	out.insert( out.end(), entries.begin(), entries.end() );
+	set32( out, 16, (unsigned int)out.size() );
+	out.insert( out.end(), lengths.begin(), lengths.end() );
+
+	*nTunes = (unsigned int)unique.size();
+
+	// read back: every tune via the bucket table, as songLengthsLookup does
+	const unsigned char *idx = out.data();
+	const unsigned int entriesOfs = HVSC_SL_HEADER_SIZE + ( HVSC_BUCKETS + 1 ) * 4;
+	for ( size_t i = 0; i < unique.size(); i++ )
+	{
+		unsigned int bk = hvscBucket( unique[ i ].md5 );
+		unsigned int first = hvscRead32( &idx[ HVSC_SL_HEADER_SIZE + bk * 4 ] );
+		unsigned int last = hvscRead32( &idx[ HVSC_SL_HEADER_SIZE + bk * 4 + 4 ] );
+		int e = hvscFindEntry( &idx[ entriesOfs + first * HVSC_SL_ENTRY_SIZE ], last - first, HVSC_SL_ENTRY_SIZE, unique[ i ].md5, 16 );
+		if ( e < 0 )
+			return 0;
+		const unsigned char *l = &idx[ hvscRead32( &idx[ 16 ] ) + hvscRead32( &idx[ entriesOfs + ( first + e ) * HVSC_SL_ENTRY_SIZE + 16 ] ) ];
+		if ( hvscRead16( l ) != unique[ i ].lengths.size() )
+			return 0;
+		for ( size_t j = 0; j < unique[ i ].lengths.size(); j++ )
+			if ( hvscRead16( &l[ 2 + j * 2 ] ) != unique[ i ].lengths[ j ] )
+				return 0;
+	}
+
+	return 1;
+}
+
+//
+// STIL
+//
+typedef struct
+{
+	unsigned char key[ 8 ];
+	unsigned int offset, length;
+	std::string path;
+} STILENTRY;
+
+static bool stilLess( const STILENTRY &a, const STILENTRY &b )
+{
+	return hvscCompareKey( a.key, b.key, 8 ) < 0;
+}
+
+static int buildStil( const BUFFER &text, BUFFER &out, unsigned int *nEntries )
+{
+	std::vector<STILENTRY> stil;
+	STILENTRY *cur = NULL;
+
+	for ( size_t i = 0; i < text.size(); )
+	{
+		// one line, without CR/LF
+		size_t lineStart = i, lineEnd = i;
+		while ( lineEnd < text.size() && text[ lineEnd ] != '\n' ) lineEnd ++;
+		i = lineEnd + 1;
+		if ( lineEnd > lineStart && text[ lineEnd - 1 ] == '\r' ) lineEnd --;
+
+		if ( lineEnd > lineStart && text[ lineStart ] == '/' )
+		{
+			STILENTRY e;
+			e.path.assign( (const char *)&text[ lineStart ], lineEnd - lineStart );
+			hvscPathKey( e.path.c_str(), e.key );
+			e.offset = (unsigned int)( i < text.size() ? i : text.size() );
+			e.length = 0;
+			stil.push_back( e );
+			cur = &stil.back();
+		} else
+		if ( lineEnd == lineStart )
+			cur = NULL;		// an empty line ends the entry
+		else
+		if ( cur != NULL )
+			cur->length = (unsigned int)( lineEnd - cur->offset );
+	}
+
+	std::stable_sort( stil.begin(), stil.end(), stilLess );
+	std::vector<STILENTRY> unique;
+	for ( size_t i = 0; i < stil.size(); i++ )
+	{
+		if ( !unique.empty() && hvscCompareKey( unique.back().key, stil[ i ].key, 8 ) == 0 )
+		{
+			if ( unique.back().path != stil[ i ].path )
+				fprintf( stderr, "hash collision, ignored: %s %s\n", unique.back().path.c_str(), stil[ i ].path.c_str() );
+			continue;
+		}
+		unique.push_back( stil[ i ] );
+	}
+
+	unsigned int bucket[ HVSC_BUCKETS + 1 ];
+	unsigned int b = 0;
+
+	out.clear();
+	out.push_back( 'S' ); out.push_back( 'K' ); out.push_back( 'S' ); out.push_back( 'T' );
+	put32( out, HVSC_STIL_VERSION );
+	put32( out, (unsigned int)unique.size() );
+	put32( out, fnv1a( text ) );
+	put32( out, (unsigned int)text.size() );
+	put32( out, 0 ); put32( out, 0 ); put32( out, 0 );
+
+	for ( size_t i = 0; i < unique.size(); i++ )
+		while ( b <= hvscBucket( unique[ i ].key ) )
+			bucket[ b ++ ] = (unsigned int)i;
+	while ( b <= HVSC_BUCKETS )
+		bucket[ b ++ ] = (unsigned int)unique.size();
+
+	for ( unsigned int i = 0; i <= HVSC_BUCKETS; i++ )
+		put32( out, bucket[ i ] );
+	for ( size_t i = 0; i < unique.size(); i++ )
+	{
+		out.insert( out.end(), unique[ i ].key, unique[ i ].key + 8 );
+		put32( out, unique[ i ].offset );
+		put32( out, unique[ i ].length );
+	}
+
+	*nEntries = (unsigned int)unique.size();
+
+	// read back: every entry by its path, as stilLookup does
+	const unsigned char *idx = out.data();
+	const unsigned int entriesOfs = HVSC_STIL_HEADER_SIZE + ( HVSC_BUCKETS + 1 ) * 4;
+	for ( size_t i = 0; i < unique.size(); i++ )
+	{
+		unsigned char key[ 8 ];
+		hvscPathKey( unique[ i ].path.c_str(), key );
+		unsigned int bk = hvscBucket( key );
+		unsigned int first = hvscRead32( &idx[ HVSC_STIL_HEADER_SIZE + bk * 4 ] );
+		unsigned int last = hvscRead32( &idx[ HVSC_STIL_HEADER_SIZE + bk * 4 + 4 ] );
+		int e = hvscFindEntry( &idx[ entriesOfs + first * HVSC_STIL_ENTRY_SIZE ], last - first, HVSC_STIL_ENTRY_SIZE, key, 8 );
+		if ( e < 0 )
+			return 0;
+		const unsigned char *p = &idx[ entriesOfs + ( first + e ) * HVSC_STIL_ENTRY_SIZE ];
+		if ( hvscRead32( p + 8 ) != unique[ i ].offset || hvscRead32( p + 12 ) != unique[ i ].length ||
+			 unique[ i ].offset + unique[ i ].length > text.size() )
+			return 0;
+	}
+
+	return 1;
+}
+
+int main( int argc, char **argv )
+{
+	if ( argc != 4 || ( strcmp( argv[ 1 ], "-s" ) != 0 && strcmp( argv[ 1 ], "-t" ) != 0 ) )
+	{
+		fprintf( stderr, "usage: hvscidx -s Songlengths.md5 songlengths.idx\n" );
+		fprintf( stderr, "       hvscidx -t STIL.txt stil.idx\n" );
+		return 1;
+	}
+
+	BUFFER text, out;
+	if ( !readAll( argv[ 2 ], text ) )
+	{
+		fprintf( stderr, "cannot read %s\n", argv[ 2 ] );
+		return 1;
+	}
+
+	unsigned int nTunes;
+	int ok = argv[ 1 ][ 1 ] == 's' ? buildSongLengths( text, out, &nTunes ) : buildStil( text, out, &nTunes );
+	if ( !ok )
+	{
+		fprintf( stderr, "verification failed\n" );
+		return 1;
+	}
+
+	if ( !writeAll( argv[ 3 ], out ) )
+	{
+		fprintf( stderr, "cannot write %s\n", argv[ 3 ] );
+		return 1;
+	}
+
+	printf( "%u %s, %u bytes\n", nTunes, argv[ 1 ][ 1 ] == 's' ? "tunes" : "entries", (unsigned int)out.size() );
+	return 0;
+}
@@ -0,0 +1,516 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ launchsim.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - host-side benchmark of the PRG hand-over (LAUNCH_FIQ in launch.h, C64Side/cart.a)
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// runs the copy loops of the reset trap on a small 6502 core, every CPU cycle goes through the LAUNCH_FIQ handler
+// of launch.h: 'stream' is the previous loader (one LDA $DE00 per byte), 'window' the current one (WINDOWCOPY with
+// the unrolled loop at WLOOPADR for PRGs of at least WMINPAGES pages, otherwise the stream loop). The loops are
+// hand-assembled copies of C64Side/cart.a, keep them in sync. Reports the C64 cycles of the hand-over (upper part
+// incl. the copy to $a000, lower part) and checks the RAM contents afterwards.
+//
+// build: g++ -std=gnu++14 -O2 -Wall -I. -I../.. -I../efbussim -o launchsim launchsim.cpp
+// usage: launchsim
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "busstub.h"
+
+// stand-ins for what launch.h expects from helpers.h/latch.h/lowlevel_arm64.h
+#define AAA __attribute__ ((aligned (128)))
+#define FORCE_READ_LINEARa( p, size, acc ) {}
+#define LED_ON( n ) setLatchFIQ( LATCH_LED0 << (n) );
+
+class CLogger;
+static CLogger *logger = NULL;
+int readFile( CLogger *, const char *, const char *, u8 *, u32 * ) { return 0; }
+
+#include "launch.h"
+
+u32 latchD, latchDOld;
+
+u32 WAIT_FOR_SIGNALS = 1000, WAIT_CYCLE_MULTIPLEXER = 2000, WAIT_CYCLE_READ = 3000, WAIT_CYCLE_READ_BADLINE = 4000,
+	WAIT_CYCLE_READ_VIC2 = 5000, WAIT_CYCLE_WRITEDATA = 6000, WAIT_CYCLE_WRITEDATA_VIC2 = 7000,
+	WAIT_CYCLE_MULTIPLEXER_VIC2 = 8000, WAIT_TRIGGER_DMA = 9000, WAIT_RELEASE_DMA = 10000;
+
+//
+// bus model: same as in efbussim, additionally the byte put on the bus by the handler is captured
+// (GPSET0 with the data followed by GPCLR0 with OE)
+//
+static u32 busG2, busG3, busData, mux257;
+static u32 lastSetD, lastSetValid, drivenValid, drivenData;
+
+void simEvent( u32 type, u64 a, u64 b )
+{
+	if ( type != EV_WRITE32 )
+		return;
+	if ( a == ARM_GPIO_GPSET0 && ( b & bCTRL257 ) ) mux257 = 1;
+	if ( a == ARM_GPIO_GPCLR0 && ( b & bCTRL257 ) ) mux257 = 0;
+
+	if ( a == ARM_GPIO_GPCLR0 && ( b & ( 1 << GPIO_OE ) ) && lastSetValid )
+	{
+		drivenValid = 1;
+		drivenData = lastSetD;
+	}
+	lastSetValid = ( a == ARM_GPIO_GPSET0 && !( b & ( ( 1 << GPIO_OE ) | bCTRL257 ) ) );
+	lastSetD = (u32)( ( b & D_FLAG ) >> D0 ) & 255;
+}
+
+u32 simRead32( u32 reg )
+{
+	if ( reg != ARM_GPIO_GPLEV0 )
+		return 0;
+	return ( ( mux257 ? busG3 : busG2 ) & ~D_FLAG ) | ( busData << D0 );
+}
+
+static void launchHandler( void * )
+{
+	register u32 D;
+
+	START_AND_READ_ADDR0to7_RW_RESET_CS
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	LAUNCH_FIQ( 0 )
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+	(void)D;
+}
+
+//
+// C64: 64k RAM, ROML at $8000-$9fff (reads), IO1 at $de00, IO2 at $df00 depending on $01; no ROMs, no VIC
+//
+static u8 ram[ 65536 ];
+static u64 c64Cycles;
+
+static u8 busCycle( u16 addr, bool write, u8 data )
+{
+	busG2 = ( ( addr & 255 ) << A0 ) | bPHI | bRESET | ( write ? 0 : bRW );
+	busG3 = ( ( ( addr >> 8 ) & 31 ) << A8 ) | bROML | bROMH | bIO1 | bIO2 | bBA;
+
+	bool cart = false, roml = ( ram[ 1 ] & 3 ) == 3, io = ( ram[ 1 ] & 3 ) && ( ram[ 1 ] & 4 );
+	if ( roml && !write && addr >= 0x8000 && addr < 0xa000 ) { busG3 &= ~bROML; cart = true; }
+	if ( io && ( addr & 0xff00 ) == 0xde00 ) { busG3 &= ~bIO1; cart = true; }
+	if ( io && ( addr & 0xff00 ) == 0xdf00 ) { busG3 &= ~bIO2; cart = true; }
+
+	busData = data;
+	mux257 = 0;
+	lastSetValid = drivenValid = 0;
+	launchHandler( NULL );
+	c64Cycles ++;
+
+	if ( write )
+	{
+		if ( !cart ) ram[ addr ] = data;
+		return data;
+	}
+	if ( cart )
+		return drivenValid ? (u8)drivenData : 0xff;
+	return ram[ addr ];
+}
+
+//
+// 6502 subset: only the instructions of the loops below, with the bus accesses (incl. dummy reads) of the real CPU
+//
+static u16 PC;
+static u8 A, X, Y, SP, fN, fZ, fC;
+
+static u8 rd( u16 a ) { return busCycle( a, false, 0 ); }
+static void wr( u16 a, u8 v ) { busCycle( a, true, v ); }
+static u8 fetch() { return rd( PC ++ ); }
+static u16 fetch16() { u16 l = fetch(); return l | ( fetch() << 8 ); }
+static u8 nz( u8 v ) { fN = v >> 7; fZ = v == 0; return v; }
+static void push( u8 v ) { wr( 0x100 + SP --, v ); }
+static u8 pull() { return rd( 0x100 + ++ SP ); }
+
+static void compare( u8 r, u8 v ) { fC = r >= v; nz( r - v ); }
+static void adc( u8 v ) { u32 s = A + v + fC; fC = s > 255; A = nz( s ); }
+static void sbc( u8 v ) { u32 s = A + ( v ^ 255 ) + fC; fC = s > 255; A = nz( s ); }
+
+static void branch( bool take )
+{
+	signed char rel = (signed char)fetch();
+	if ( !take ) return;
+	rd( PC );
+	u16 n = PC + rel;
+	if ( ( n ^ PC ) & 0xff00 ) rd( ( PC & 0xff00 ) | ( n & 0xff ) );
+	PC = n;
+}
+
+static u16 absIndexed( u8 idx, bool write )
+{
+	u16 b = fetch16(), a = b + idx;
+	if ( write || ( ( a ^ b ) & 0xff00 ) ) rd( ( b & 0xff00 ) | ( a & 0xff ) );
+	return a;
+}
+
+static u16 indirectY()
+{
+	u8 z = fetch();
+	u16 b = rd( z ) | ( rd( (u8)( z + 1 ) ) << 8 ), a = b + Y;
+	rd( ( b & 0xff00 ) | ( a & 0xff ) );
+	return a;
+}
+
+// runs until BRK, returns false on an unknown opcode
+static bool run( u16 start )
+{
+	PC = start; SP = 0xf0; A = X = Y = 0; fN = fZ = fC = 0;
+	while ( true )
+	{
+		u8 op = fetch(), z, t;
+		u16 a;
+		switch ( op )
+		{
+		case 0x00: return true;
+		case 0xa9: A = nz( fetch() ); break;
+		case 0xa2: X = nz( fetch() ); break;
+		case 0xa0: Y = nz( fetch() ); break;
+		case 0xc9: compare( A, fetch() ); break;
+		case 0x69: adc( fetch() ); break;
+		case 0xe9: sbc( fetch() ); break;
+		case 0x65: adc( rd( fetch() ) ); break;
+		case 0x49: A = nz( A ^ fetch() ); break;
+		case 0x0a: rd( PC ); fC = A >> 7; A = nz( A << 1 ); break;
+		case 0xe0: compare( X, fetch() ); break;
+		case 0xc0: compare( Y, fetch() ); break;
+		case 0xe5: sbc( rd( fetch() ) ); break;
+		case 0xe4: compare( X, rd( fetch() ) ); break;
+		case 0xa4: Y = nz( rd( fetch() ) ); break;
+		case 0xa5: A = nz( rd( fetch() ) ); break;
+		case 0x85: wr( fetch(), A ); break;
+		case 0x84: wr( fetch(), Y ); break;
+		case 0x86: wr( fetch(), X ); break;
+		case 0xc6: z = fetch(); t = rd( z ); wr( z, t ); wr( z, nz( t - 1 ) ); break;
+		case 0xe6: z = fetch(); t = rd( z ); wr( z, t ); wr( z, nz( t + 1 ) ); break;
+		case 0xad: A = nz( rd( fetch16() ) ); break;
+		case 0xac: Y = nz( rd( fetch16() ) ); break;
+		case 0x8d: wr( fetch16(), A ); break;
+		case 0x8e: wr( fetch16(), X ); break;
+		case 0xee: a = fetch16(); t = rd( a ); wr( a, t ); wr( a, nz( t + 1 ) ); break;
+		case 0xbd: A = nz( rd( absIndexed( X, false ) ) ); break;
+		case 0xb9: A = nz( rd( absIndexed( Y, false ) ) ); break;
+		case 0x9d: wr( absIndexed( X, true ), A ); break;
+		case 0x99: wr( absIndexed( Y, true ), A ); break;
+		case 0x91: wr( indirectY(), A ); break;
+		case 0xe8: rd( PC ); nz( ++ X ); break;
+		case 0xc8: rd( PC ); nz( ++ Y ); break;
+		case 0x88: rd( PC ); nz( -- Y ); break;
+		case 0xa8: rd( PC ); Y = nz( A ); break;
+		case 0xaa: rd( PC ); X = nz( A ); break;
+		case 0x8a: rd( PC ); A = nz( X ); break;
+		case 0x18: rd( PC ); fC = 0; break;
+		case 0x38: rd( PC ); fC = 1; break;
+		case 0x48: rd( PC ); push( A ); break;
+		case 0x68: rd( PC ); rd( 0x100 + SP ); A = nz( pull() ); break;
+		case 0xd0: branch( !fZ ); break;
+		case 0xf0: branch( fZ ); break;
+		case 0x90: branch( !fC ); break;
+		case 0xb0: branch( fC ); break;
+		case 0x4c: PC = fetch16(); break;
+		case 0x6c: a = fetch16(); PC = rd( a ) | ( rd( ( a & 0xff00 ) | ( ( a + 1 ) & 255 ) ) << 8 ); break;
+		case 0x20:
+			z = fetch(); rd( 0x100 + SP );
+			push( PC >> 8 ); push( PC & 255 );
+			PC = z | ( fetch() << 8 );
+			break;
+		case 0x60:
+			rd( PC ); rd( 0x100 + SP );
+			PC = pull(); PC |= pull() << 8;
+			rd( PC ++ );
+			break;
+		default:
+			printf( "unknown opcode %02x at %04x\n", op, PC - 1 );
+			return false;
+		}
+	}
+}
+
+//
+// minimal assembler, two passes over the same code (labels are resolved in the 2nd pass)
+//
+struct ASM
+{
+	u8 *mem;
+	u16 org, pc;
+	u16 labels[ 64 ];
+
+	void begin( u8 *m, u16 o ) { mem = m; org = pc = o; }
+	void b( u8 v ) { mem[ pc - org ] = v; pc ++; }
+	void w( u16 v ) { b( v & 255 ); b( v >> 8 ); }
+	void op( u8 o ) { b( o ); }
+	void op( u8 o, u8 v ) { b( o ); b( v ); }
+	void opw( u8 o, u16 v ) { b( o ); w( v ); }
+	void label( u32 l ) { labels[ l ] = pc; }
+	void br( u8 o, u32 l ) { b( o ); b( (u8)( labels[ l ] - ( pc + 1 ) ) ); }
+};
+
+enum { L_WPATCHLO, L_WCHUNK, L_WROUND, L_WPATCH, L_WDONE, L_WCALL, L_WLOOP, L_LOOPs0, L_LOOPs1, L_LOOPsWINDOW, L_LOOPsDONE, L_COPY, L_T0, L_T1, L_TWINDOW, L_TDONE, L_A0, L_A1, L_END };
+
+static const u16 TRAPADR = 0x033c, MEMCPYADR = 0x1000, WINDOWCOPYADR = 0x8400;
+
+// see WLOOPADR, WPAGES, WMINPAGES in C64Side/cart.a
+static const u16 WLOOPADR = 0x02a7, WPAGES = 13, WENTRY = WLOOPADR + 6 * WPAGES + 4;
+static const u8 WMINPAGES = 2;
+
+// see WLOOP in C64Side/cart.a (copied to WLOOPADR at warmstart)
+static void asmWindowLoop( ASM &s )
+{
+	s.label( L_WLOOP );
+	for ( u32 k = 0; k < WPAGES; k++ )
+	{
+		s.opw( 0xb9, 0x9000 + k * 256 );
+		s.opw( 0x99, k * 256 );
+	}
+	s.op( 0xc8 );
+	s.br( 0xd0, L_WLOOP );
+	s.op( 0x60 );
+}
+
+// see WINDOWCOPY in C64Side/cart.a
+static void asmWindowCopy( ASM &s )
+{
+	s.op( 0x84, 0x02 );
+	s.op( 0xa2, 0x00 );
+	s.label( L_WPATCHLO );
+	s.op( 0xa5, 0xfb ); s.opw( 0x9d, WLOOPADR + 4 );
+	s.op( 0x8a ); s.op( 0x18 ); s.op( 0x69, 6 ); s.op( 0xaa );
+	s.op( 0xe0, 6 * WPAGES );
+	s.br( 0xd0, L_WPATCHLO );
+	s.op( 0xa2, 0x00 ); s.op( 0x86, 0xfe );
+	s.label( L_WCHUNK );
+	s.op( 0xa5, 0x02 );
+	s.br( 0xf0, L_WDONE );
+	s.op( 0xc9, WPAGES );
+	s.br( 0x90, L_WROUND );
+	s.op( 0xa9, WPAGES );
+	s.label( L_WROUND );
+	s.op( 0x85, 0xfd );
+	s.op( 0x0a ); s.op( 0x65, 0xfd ); s.op( 0x0a );
+	s.op( 0xaa );
+	s.op( 0x49, 0xff ); s.op( 0x38 ); s.op( 0xe9, 2 );
+	s.opw( 0x8d, WLOOPADR + 6 * WPAGES + 2 );
+	s.op( 0x8a ); s.op( 0x49, 0xff ); s.op( 0x38 ); s.op( 0x69, 6 * WPAGES );
+	s.op( 0xaa );
+	s.op( 0x18 ); s.op( 0x69, WLOOPADR & 255 ); s.opw( 0x8d, WENTRY );
+	s.op( 0xa9, WLOOPADR >> 8 ); s.op( 0x69, 0 ); s.opw( 0x8d, WENTRY + 1 );
+	s.op( 0xa5, 0xfe ); s.opw( 0x8d, 0xde03 );
+	s.op( 0xa9, 0x90 ); s.op( 0x85, 0xfb );
+	s.label( L_WPATCH );
+	s.op( 0xa5, 0xfb ); s.opw( 0x9d, WLOOPADR + 2 ); s.op( 0xe6, 0xfb );
+	s.op( 0xa5, 0xfc ); s.opw( 0x9d, WLOOPADR + 5 ); s.op( 0xe6, 0xfc );
+	s.op( 0x8a ); s.op( 0x18 ); s.op( 0x69, 6 ); s.op( 0xaa );
+	s.op( 0xe0, 6 * WPAGES );
+	s.br( 0xd0, L_WPATCH );
+	s.op( 0xa0, 0x00 );
+	s.opw( 0x20, s.labels[ L_WCALL ] );
+	s.op( 0xa5, 0xfe ); s.op( 0x18 ); s.op( 0x65, 0xfd ); s.op( 0x85, 0xfe );
+	s.op( 0xa5, 0x02 ); s.op( 0x38 ); s.op( 0xe5, 0xfd ); s.op( 0x85, 0x02 );
+	s.opw( 0x4c, s.labels[ L_WCHUNK ] );
+	s.label( L_WDONE );
+	s.opw( 0x8d, 0xde04 );
+	s.op( 0x60 );
+	s.label( L_WCALL );
+	s.opw( 0x6c, WENTRY );
+}
+
+// see MEMCPYA000 in C64Side/cart.a
+static void asmMemcpyA000( ASM &s, bool window )
+{
+	s.opw( 0x8d, 0xde02 );
+	s.opw( 0xad, 0xde01 ); s.opw( 0xad, 0xde01 );
+	s.op( 0xa8 );
+	s.op( 0xc9, 0 );
+	s.br( 0xd0, L_COPY );
+	s.op( 0x60 );
+	s.label( L_COPY );
+	s.op( 0x48 );
+	if ( window )
+	{
+		s.op( 0xc0, WMINPAGES );
+		s.br( 0xb0, L_TWINDOW );
+	}
+	s.label( L_T0 );
+	s.op( 0xa2, 0x00 );
+	s.label( L_T1 );
+	s.opw( 0xad, 0xde00 );
+	s.opw( 0x9d, 0x2000 );
+	s.op( 0xe8 );
+	s.br( 0xd0, L_T1 );
+	s.opw( 0xee, s.labels[ L_T1 ] + 5 );
+	s.op( 0x88 );
+	s.br( 0xd0, L_T0 );
+	if ( window )
+	{
+		s.br( 0xf0, L_TDONE );
+		s.label( L_TWINDOW );
+		s.op( 0xa9, 0x00 ); s.op( 0x85, 0xfb );
+		s.op( 0xa9, 0x20 ); s.op( 0x85, 0xfc );
+		s.opw( 0x20, WINDOWCOPYADR );
+	}
+	s.label( L_TDONE );
+	s.op( 0xa5, 0x01 ); s.op( 0x85, 0xfb );
+	s.op( 0xa9, 0x34 ); s.op( 0x85, 0x01 );
+	s.op( 0x68 ); s.op( 0xa8 );
+	s.label( L_A0 );
+	s.op( 0xa2, 0x00 );
+	s.label( L_A1 );
+	s.opw( 0xbd, 0x2000 );
+	s.opw( 0x9d, 0xa000 );
+	s.op( 0xe8 );
+	s.br( 0xd0, L_A1 );
+	s.opw( 0xee, s.labels[ L_A1 ] + 2 );
+	s.opw( 0xee, s.labels[ L_A1 ] + 5 );
+	s.op( 0x88 );
+	s.br( 0xd0, L_A0 );
+	s.op( 0xa5, 0xfb ); s.op( 0x85, 0x01 );
+	s.op( 0x60 );
+}
+
+// see RESET_TRAP in C64Side/cart.a (without saving/restoring registers and starting the program)
+static void asmTrap( ASM &s, bool window )
+{
+	s.opw( 0x20, MEMCPYADR );
+	s.opw( 0x8d, 0xde00 );
+	s.opw( 0xac, 0xde01 ); s.opw( 0xac, 0xde01 );
+	s.opw( 0xad, 0xde00 ); s.opw( 0x8d, s.labels[ L_LOOPs1 ] + 4 );
+	if ( window ) s.op( 0x85, 0xfb );
+	s.opw( 0xad, 0xde00 ); s.opw( 0x8d, s.labels[ L_LOOPs1 ] + 5 );
+	if ( window )
+	{
+		s.op( 0x85, 0xfc );
+		s.op( 0xc9, 0x04 );
+		s.br( 0x90, L_LOOPs0 );
+		s.op( 0xc0, WMINPAGES );
+		s.br( 0xb0, L_LOOPsWINDOW );
+	}
+	s.label( L_LOOPs0 );
+	s.op( 0xa2, 0x00 );
+	s.label( L_LOOPs1 );
+	s.opw( 0xad, 0xde00 );
+	s.opw( 0x9d, 0x0801 );
+	s.op( 0xe8 );
+	s.br( 0xd0, L_LOOPs1 );
+	s.opw( 0xee, s.labels[ L_LOOPs1 ] + 5 );
+	s.op( 0x88 );
+	s.br( 0xd0, L_LOOPs0 );
+	if ( window )
+	{
+		s.br( 0xf0, L_LOOPsDONE );
+		s.label( L_LOOPsWINDOW );
+		s.opw( 0x20, WINDOWCOPYADR );
+	}
+	s.label( L_LOOPsDONE );
+	s.op( 0x00 );
+}
+
+static void assemble( bool window )
+{
+	ASM s;
+	memset( s.labels, 0, sizeof( s.labels ) );
+	for ( u32 pass = 0; pass < 2; pass++ )
+	{
+		s.begin( &launchCode[ WINDOWCOPYADR - 0x8000 ], WINDOWCOPYADR );
+		asmWindowCopy( s );
+		if ( s.pc > 0x9000 )
+			printf( "WINDOWCOPY overlaps the PRG window\n" );
+		s.begin( &ram[ WLOOPADR ], WLOOPADR );
+		asmWindowLoop( s );
+		if ( WENTRY + 2 > 0x0300 )
+			printf( "WLOOP does not fit into $02a7-$02ff\n" );
+		s.begin( &ram[ MEMCPYADR ], MEMCPYADR );
+		asmMemcpyA000( s, window );
+		s.begin( &ram[ TRAPADR ], TRAPADR );
+		asmTrap( s, window );
+	}
+}
+
+// hands over a PRG of 'size' bytes (loaded to $0801), returns the C64 cycles or 0 on error
+static u64 handOver( const u8 *prg, u32 size, bool window )
+{
+	memset( ram, 0, sizeof( ram ) );
+	ram[ 1 ] = 0x37;
+
+	launchGetProgram( NULL, true, (u8*)prg, size );
+	launchPrepareAndWarmCache();
+	assemble( window );
+
+	c64Cycles = 0;
+	if ( !run( TRAPADR ) )
+		return 0;
+
+	if ( memcmp( &ram[ 0x0801 ], &prg[ 2 ], size - 2 ) )
+	{
+		for ( u32 i = 0; i < size - 2; i++ )
+			if ( ram[ 0x0801 + i ] != prg[ 2 + i ] )
+			{
+				printf( "%s: mismatch at $%04x (%02x instead of %02x)\n", window ? "window" : "stream", 0x0801 + i, ram[ 0x0801 + i ], prg[ 2 + i ] );
+				break;
+			}
+		return 0;
+	}
+
+	return c64Cycles;
+}
+
+int main( int argc, char **argv )
+{
+	static const u32 blocks[] = { 1, 2, 3, 4, 10, 50, 100, 150, 200, 240 };
+	static u8 prg[ 65536 ];
+	u32 failed = 0;
+
+	srand( 1234 );
+	launchInitLoader( false, false );
+
+	printf( "blocks  bytes      stream     window  (C64 cycles, upper part incl. copy to $a000)\n" );
+	for ( u32 i = 0; i < sizeof( blocks ) / sizeof( blocks[ 0 ] ); i++ )
+	{
+		u32 size = 2 + blocks[ i ] * 254;
+		if ( size > 0x10001 - 0x0801 ) size = 0x10001 - 0x0801;
+
+		prg[ 0 ] = 0x01; prg[ 1 ] = 0x08;
+		for ( u32 j = 2; j < size; j++ )
+			prg[ j ] = rand() & 255;
+
+		u64 cStream = handOver( prg, size, false );
+		u64 cWindow = handOver( prg, size, true );
+		if ( !cStream || !cWindow )
+		{
+			failed ++;
+			continue;
+		}
+
+		double saved = 100.0 * ( 1.0 - (double)cWindow / (double)cStream );
+		printf( "%6u %6u  %10llu %10llu  %5.1f%% %s\n", blocks[ i ], size - 2,
+			(unsigned long long)cStream, (unsigned long long)cWindow, fabs( saved ), saved < 0.0 ? "more" : "less" );
+	}
+
+	return failed ? 1 : 0;
+}
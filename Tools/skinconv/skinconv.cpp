@@ -0,0 +1,267 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ skinconv.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - host-side conversion of splash screens to pre-dithered, display-ready skins
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// converts the splash screens to the format of skinformat.h, such that the menu and the kernels only copy the pixels:
+// a .tga (24/32 bit, uncompressed, at least 240x240) becomes a dithered RGB565 image for the TFT (same ordered dither
+// as tftLoadBackgroundTGA), a .logo (128x64, 8 bit per pixel) or a 128x64 .tga with -m becomes a 1 bit image for the OLED
+// (same threshold as splashScreenFile). The output keeps the name of the original file on the SD card.
+//
+// build: g++ -O2 -Wall -I../.. -o skinconv skinconv.cpp
+// usage: skinconv [-d dither] [-m] [-r] input output
+//   -d  dither amount for the TFT (default 8, the value the kernels use; 0 = none)
+//   -m  convert a .tga for the OLED
+//   -r  PackBits-compress the pixels
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "skinformat.h"
+
+typedef std::vector<unsigned char> BUFFER;
+
+static int readAll( const char *fn, BUFFER &b )
+{
+	FILE *f = fopen( fn, "rb" );
+	if ( f == NULL )
+		return 0;
+	unsigned char tmp[ 65536 ];
+	size_t n;
+	while ( ( n = fread( tmp, 1, sizeof( tmp ), f ) ) > 0 )
+		b.insert( b.end(), tmp, tmp + n );
+	fclose( f );
+	return 1;
+}
+
+// as in tft_st7789.cpp
+static int ditherColor( int v, int x, int y, int d )
+{
+	const int tm[ 4 * 4 ] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
+	int r = (int)( (float)v + (float)d * ( tm[ ( x & 3 ) + ( y & 3 ) * 4 ] / 16.0f - 0.5f ) );
+	return r < 0 ? 0 : ( r > 255 ? 255 : r );
+}
+
+static unsigned int rgb24to16( unsigned int r, unsigned int g, unsigned int b )
+{
+	return ( r & 0xf8 ) << 8 | ( g & 0xfc ) << 3 | b >> 3;
+}
+
+// RGB, top row first (as tftLoadTGA, which ignores the origin bit of the header)
+static int decodeTGA( const BUFFER &tga, int *w, int *h, BUFFER &rgb )
+{
+	if ( tga.size() < 18 || tga[ 1 ] != 0 || ( tga[ 2 ] != 2 && tga[ 2 ] != 3 ) )
+		return 0;
+	*w = tga[ 12 ] + tga[ 13 ] * 256;
+	*h = tga[ 14 ] + tga[ 15 ] * 256;
+	int bpp = tga[ 16 ] / 8;
+	if ( ( bpp != 3 && bpp != 4 ) || tga.size() < 18 + (size_t)*w * *h * bpp )
+		return 0;
+
+	rgb.resize( *w * *h * 3 );
+	for ( int j = 0; j < *h; j++ )
+		for ( int i = 0; i < *w; i++ )
+		{
+			const unsigned char *s = &tga[ 18 + ( i + j * *w ) * bpp ];
+			unsigned char *d = &rgb[ ( i + ( *h - 1 - j ) * *w ) * 3 ];
+			d[ 0 ] = s[ 2 ];
+			d[ 1 ] = s[ 1 ];
+			d[ 2 ] = s[ 0 ];
+		}
+	return 1;
+}
+
+static void packBits( const BUFFER &src, unsigned int unit, BUFFER &dst )
+{
+	unsigned int n = src.size() / unit;
+	unsigned int i = 0, litStart = 0;
+
+	#define SAME( a, b ) ( memcmp( &src[ (a) * unit ], &src[ (b) * unit ], unit ) == 0 )
+
+	while ( i < n )
+	{
+		unsigned int run = 1;
+		while ( i + run < n && run < 129 && SAME( i, i + run ) )
+			run ++;
+
+		// a run of 2 only pays off if no literals are pending
+		if ( run >= 3 || ( run == 2 && litStart == i ) )
+		{
+			while ( litStart < i )
+			{
+				unsigned int l = i - litStart > 128 ? 128 : i - litStart;
+				dst.push_back( l - 1 );
+				dst.insert( dst.end(), &src[ litStart * unit ], &src[ ( litStart + l ) * unit ] );
+				litStart += l;
+			}
+			dst.push_back( 257 - run );
+			dst.insert( dst.end(), &src[ i * unit ], &src[ ( i + 1 ) * unit ] );
+			i += run;
+			litStart = i;
+		} else
+			i ++;
+	}
+	while ( litStart < n )
+	{
+		unsigned int l = n - litStart > 128 ? 128 : n - litStart;
+		dst.push_back( l - 1 );
+		dst.insert( dst.end(), &src[ litStart * unit ], &src[ ( litStart + l ) * unit ] );
+		litStart += l;
+	}
+
+	#undef SAME
+}
+
+int main( int argc, char **argv )
+{
+	int dither = 8, mono = 0, rle = 0;
+	const char *in = NULL, *out = NULL;
+
+	for ( int a = 1; a < argc; a++ )
+	{
+		if ( !strcmp( argv[ a ], "-d" ) && a + 1 < argc )
+			dither = atoi( argv[ ++ a ] ); else
+		if ( !strcmp( argv[ a ], "-m" ) )
+			mono = 1; else
+		if ( !strcmp( argv[ a ], "-r" ) )
+			rle = 1; else
+		if ( in == NULL )
+			in = argv[ a ]; else
+		if ( out == NULL )
+			out = argv[ a ];
+	}
+
+	if ( in == NULL || out == NULL )
+	{
+		printf( "usage: skinconv [-d dither] [-m] [-r] input output\n" );
+		return 1;
+	}
+
+	BUFFER file;
+	if ( !readAll( in, file ) )
+	{
+		printf( "cannot read '%s'\n", in );
+		return 1;
+	}
+
+	BUFFER pixels;
+	unsigned int format, width, height;
+
+	int w, h;
+	BUFFER rgb;
+	int isTGA = decodeTGA( file, &w, &h, rgb );
+
+	if ( !isTGA && file.size() == 128 * 64 )
+	{
+		// .logo: 8 bit per pixel, the OLED shows everything >= 128
+		format = SKIN_MONO; width = 128; height = 64;
+		pixels.assign( 1024, 0 );
+		for ( int i = 0; i < 8192; i++ )
+			if ( file[ i ] >= 128 )
+				pixels[ ( i & 127 ) + ( ( i / 128 ) / 8 ) * 128 ] |= 1 << ( ( i / 128 ) & 7 );
+	} else
+	if ( isTGA && mono )
+	{
+		if ( w < 128 || h < 64 )
+		{
+			printf( "'%s' is %dx%d, the OLED needs 128x64\n", in, w, h );
+			return 1;
+		}
+		format = SKIN_MONO; width = 128; height = 64;
+		pixels.assign( 1024, 0 );
+		for ( int y = 0; y < 64; y++ )
+			for ( int x = 0; x < 128; x++ )
+			{
+				const unsigned char *p = &rgb[ ( x + y * w ) * 3 ];
+				if ( ( p[ 0 ] * 77 + p[ 1 ] * 150 + p[ 2 ] * 29 ) >> 8 >= 128 )
+					pixels[ x + ( y / 8 ) * 128 ] |= 1 << ( y & 7 );
+			}
+	} else
+	if ( isTGA )
+	{
+		// smaller images are not supported: the firmware would keep parts of the previous background
+		if ( w < 240 || h < 240 )
+		{
+			printf( "'%s' is %dx%d, the TFT needs 240x240\n", in, w, h );
+			return 1;
+		}
+		format = SKIN_RGB565; width = 240; height = 240;
+		pixels.resize( 240 * 240 * 2 );
+		for ( int y = 0; y < 240; y++ )
+			for ( int x = 0; x < 240; x++ )
+			{
+				const unsigned char *p = &rgb[ ( x + y * w ) * 3 ];
+				unsigned int c;
+				if ( dither )
+					c = rgb24to16( ditherColor( p[ 0 ], x, y, dither ), ditherColor( p[ 1 ], x, y, dither ), ditherColor( p[ 2 ], x, y, dither ) ); else
+					c = rgb24to16( p[ 0 ], p[ 1 ], p[ 2 ] );
+				pixels[ ( x + y * 240 ) * 2 + 0 ] = c & 255;
+				pixels[ ( x + y * 240 ) * 2 + 1 ] = c >> 8;
+			}
+	} else
+	{
+		printf( "'%s' is neither an uncompressed 24/32 bit .tga nor a 128x64 .logo\n", in );
+		return 1;
+	}
+
+	BUFFER packed;
+	if ( rle )
+		packBits( pixels, format == SKIN_RGB565 ? 2 : 1, packed );
+	const BUFFER &data = rle ? packed : pixels;
+
+	unsigned int size = pixels.size();
+	unsigned char header[ SKIN_HEADER_SIZE ] = {
+		'S', 'K', '6', '4', (unsigned char)format, (unsigned char)( rle ? SKIN_RLE : 0 ),
+		(unsigned char)( width & 255 ), (unsigned char)( width >> 8 ), (unsigned char)( height & 255 ), (unsigned char)( height >> 8 ),
+		(unsigned char)( size & 255 ), (unsigned char)( ( size >> 8 ) & 255 ), (unsigned char)( ( size >> 16 ) & 255 ), (unsigned char)( size >> 24 ), 0, 0 };
+
+	BUFFER skin( header, header + SKIN_HEADER_SIZE );
+	skin.insert( skin.end(), data.begin(), data.end() );
+
+	// decode with the loader of the firmware and compare
+	BUFFER check( size );
+	if ( !skinDecode( &skin[ 0 ], skin.size(), format, width, height, &check[ 0 ] ) || check != pixels )
+	{
+		printf( "internal error: the converted image does not decode correctly\n" );
+		return 1;
+	}
+
+	FILE *f = fopen( out, "wb" );
+	if ( f == NULL || fwrite( &skin[ 0 ], 1, skin.size(), f ) != skin.size() )
+	{
+		printf( "cannot write '%s'\n", out );
+		if ( f ) fclose( f );
+		return 1;
+	}
+	fclose( f );
+
+	printf( "%s: %s %ux%u, %u -> %u bytes\n", out, format == SKIN_RGB565 ? "RGB565" : "mono", width, height, (unsigned int)file.size(), (unsigned int)skin.size() );
+	return 0;
+}
@@ -0,0 +1,354 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ buscal.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - calibration of the bus timing (WAIT_*) per machine
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/timer.h>
+#include <circle/string.h>
+#include "lowlevel_arm64.h"
+#include "helpers.h"
+#include "buscal.h"
+#include "linux/kernel.h"
+
+BUSCAL busCal AAA;
+
+const char busCalParamNames[ BUSCAL_PARAMS ][ 32 ] = {
+	"WAIT_FOR_SIGNALS",
+	"WAIT_CYCLE_MULTIPLEXER",
+	"WAIT_CYCLE_READ",
+	"WAIT_CYCLE_WRITEDATA"
+};
+
+// sweep range relative to the configured value (ARM cycles)
+static const s32 busCalRange[ BUSCAL_PARAMS ][ 2 ] = {
+	{ -40, 100 },
+	{ -100, 150 },
+	{ -200, 0 },		// hold time: only look for tighter values
+	{ -150, 150 }
+};
+
+static u32 *const busCalValue[ BUSCAL_PARAMS ] = {
+	&WAIT_FOR_SIGNALS, &WAIT_CYCLE_MULTIPLEXER, &WAIT_CYCLE_READ, &WAIT_CYCLE_WRITEDATA
+};
+
+static u32 busCalNTSC = 0;
+
+static char busCalFile[ 4096 ];
+
+const char *busCalMachineName()
+{
+	static char name[ 32 ];
+	strcpy( name, modeC128 ? "C128-" : "C64-" );
+	strcat( name, busCalNTSC ? "NTSC-" : "PAL-" );
+	strcat( name, modeVIC ? "NEWVIC" : "OLDVIC" );
+	return name;
+}
+
+static void busCalPrepare()
+{
+	for ( u32 i = 0; i < BUSCAL_PARAMS; i++ )
+		busCal.next[ i ] = busCal.base[ i ];
+	busCal.next[ busCal.param ] = busCal.first[ busCal.param ] + busCal.step * BUSCAL_STEP;
+
+	// touch what the FIQ handler will need
+	CACHE_PRELOAD_DATA_CACHE( &busCal, sizeof( BUSCAL ), CACHE_PRELOADL2KEEP );
+
+	busCal.prepared = 1;
+}
+
+void busCalRequest()
+{
+	memset( &busCal, 0, sizeof( BUSCAL ) );
+
+	for ( u32 i = 0; i < BUSCAL_PARAMS; i++ )
+	{
+		busCal.base[ i ] = *busCalValue[ i ];
+		busCal.first[ i ] = max( 0, (s32)busCal.base[ i ] + busCalRange[ i ][ 0 ] );
+		s32 last = (s32)busCal.base[ i ] + busCalRange[ i ][ 1 ];
+		busCal.nSteps[ i ] = min( BUSCAL_MAX_STEPS, ( last - busCal.first[ i ] ) / BUSCAL_STEP + 1 );
+	}
+
+	// a few corner cases, then pseudo random bytes
+	const u8 corner[ 4 ] = { 0x00, 0xff, 0x55, 0xaa };
+	u32 seed = 0x2545f491;
+	for ( u32 i = 0; i < BUSCAL_TRANSFERS; i++ )
+	{
+		seed = seed * 1103515245 + 12345;
+		if ( i < 4 ) busCal.pattern[ i ] = corner[ i ]; else
+		if ( i < 12 ) busCal.pattern[ i ] = 1 << ( i - 4 ); else
+		if ( i < 20 ) busCal.pattern[ i ] = ~( 1 << ( i - 12 ) ); else
+			busCal.pattern[ i ] = seed >> 24;
+	}
+
+	busCalPrepare();
+	busCal.state = BUSCAL_REQUESTED;
+}
+
+//
+// stored timings: one line per machine, e.g.
+// C64-PAL-NEWVIC WAIT_FOR_SIGNALS 40 WAIT_CYCLE_MULTIPLEXER 215 WAIT_CYCLE_READ 395 WAIT_CYCLE_WRITEDATA 480
+//
+static u32 busCalLineMatches( const char *line, const char *machine )
+{
+	u32 l = strlen( machine );
+	return strncmp( line, machine, l ) == 0 && ( line[ l ] == ' ' || line[ l ] == '\t' );
+}
+
+static const char *busCalNextToken( const char *p, char *token, u32 maxLen )
+{
+	while ( *p == ' ' || *p == '\t' ) p ++;
+	u32 l = 0;
+	while ( *p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' )
+	{
+		if ( l < maxLen - 1 ) token[ l ++ ] = *p;
+		p ++;
+	}
+	token[ l ] = 0;
+	return p;
+}
+
+static u32 busCalLoad( CLogger *logger )
+{
+	u32 size = 0;
+	memset( busCalFile, 0, sizeof( busCalFile ) );
+	if ( !getFileSize( logger, "SD:", BUSCAL_FILENAME, &size ) || size >= sizeof( busCalFile ) ||
+		 !readFile( logger, "SD:", BUSCAL_FILENAME, (u8*)busCalFile, &size ) )
+	{
+		busCalFile[ 0 ] = 0;
+		return 0;
+	}
+	busCalFile[ size ] = 0;
+	return size;
+}
+
+static void busCalApplyStored( CLogger *logger )
+{
+	if ( !busCalLoad( logger ) )
+		return;
+
+	const char *machine = busCalMachineName();
+
+	for ( const char *line = busCalFile; *line; )
+	{
+		if ( busCalLineMatches( line, machine ) )
+		{
+			char name[ 32 ], value[ 16 ];
+			const char *p = busCalNextToken( line, name, 32 );
+			while ( true )
+			{
+				p = busCalNextToken( p, name, 32 );
+				p = busCalNextToken( p, value, 16 );
+				if ( !name[ 0 ] || !value[ 0 ] )
+					break;
+				for ( u32 i = 0; i < BUSCAL_PARAMS; i++ )
+					if ( strcmp( name, busCalParamNames[ i ] ) == 0 )
+						*busCalValue[ i ] = atoi( value );
+			}
+			logger->Write( "RaspiMenu", LogNotice, "calibrated timing for %s: %d %d %d %d", machine,
+				WAIT_FOR_SIGNALS, WAIT_CYCLE_MULTIPLEXER, WAIT_CYCLE_READ, WAIT_CYCLE_WRITEDATA );
+			return;
+		}
+
+		while ( *line && *line != '\n' ) line ++;
+		if ( *line ) line ++;
+	}
+}
+
+static void busCalSave( CLogger *logger )
+{
+	const char *machine = busCalMachineName();
+	CString out, entry;
+
+	// keep the other machines
+	busCalLoad( logger );
+	for ( const char *line = busCalFile; *line; )
+	{
+		const char *end = line;
+		while ( *end && *end != '\n' ) end ++;
+		if ( *end ) end ++;
+
+		if ( !busCalLineMatches( line, machine ) )
+		{
+			char tmp[ 256 ];
+			u32 l = min( (u32)( end - line ), (u32)sizeof( tmp ) - 1 );
+			memcpy( tmp, line, l );
+			tmp[ l ] = 0;
+			out.Append( tmp );
+		}
+		line = end;
+	}
+
+	entry.Format( "%s %s %d %s %d %s %d %s %d\n", machine,
+		busCalParamNames[ 0 ], busCal.result[ 0 ], busCalParamNames[ 1 ], busCal.result[ 1 ],
+		busCalParamNames[ 2 ], busCal.result[ 2 ], busCalParamNames[ 3 ], busCal.result[ 3 ] );
+	out.Append( entry );
+
+	writeFile( logger, "SD:", BUSCAL_FILENAME, (u8*)(const char*)out, out.GetLength() );
+}
+
+// centre of the passing window which contains the configured value (or else the widest one), for the hold time
+// its lower edge plus BUSCAL_HOLD_MARGIN
+static s32 busCalWindow( u32 p )
+{
+	s32 baseStep = ( (s32)busCal.base[ p ] - busCal.first[ p ] ) / BUSCAL_STEP;
+	s32 bestLo = -1, bestHi = -1;
+
+	for ( s32 lo = 0; lo < (s32)busCal.nSteps[ p ]; )
+	{
+		if ( !busCal.pass[ p ][ lo ] ) { lo ++; continue; }
+
+		s32 hi = lo;
+		while ( hi + 1 < (s32)busCal.nSteps[ p ] && busCal.pass[ p ][ hi + 1 ] ) hi ++;
+
+		bool containsBase = baseStep >= lo && baseStep <= hi;
+		if ( bestLo < 0 || containsBase || ( hi - lo > bestHi - bestLo && !( baseStep >= bestLo && baseStep <= bestHi ) ) )
+		{
+			bestLo = lo;
+			bestHi = hi;
+		}
+		if ( containsBase )
+			break;
+		lo = hi + 1;
+	}
+
+	if ( bestLo < 0 )
+		return -1;
+
+	if ( busCalValue[ p ] == &WAIT_CYCLE_READ )
+		return busCal.first[ p ] + bestLo * BUSCAL_STEP + BUSCAL_HOLD_MARGIN;
+
+	return busCal.first[ p ] + ( ( bestLo + bestHi ) / 2 ) * BUSCAL_STEP;
+}
+
+static void busCalFinish( CLogger *logger )
+{
+	bool ok = true;
+
+	for ( u32 p = 0; p < BUSCAL_PARAMS; p++ )
+	{
+		s32 v = busCalWindow( p );
+		if ( v < 0 )
+		{
+			logger->Write( "RaspiMenu", LogWarning, "timing calibration: no working value for %s", busCalParamNames[ p ] );
+			ok = false;
+			v = busCal.base[ p ];
+		}
+		busCal.result[ p ] = v;
+	}
+
+	if ( !ok )
+	{
+		busCal.state = BUSCAL_FAILED;
+		return;
+	}
+
+	for ( u32 p = 0; p < BUSCAL_PARAMS; p++ )
+	{
+		*busCalValue[ p ] = busCal.result[ p ];
+		busCal.base[ p ] = busCal.result[ p ];
+	}
+
+	busCal.state = BUSCAL_DONE;
+
+	logger->Write( "RaspiMenu", LogNotice, "timing calibration for %s: %d %d %d %d", busCalMachineName(),
+		busCal.result[ 0 ], busCal.result[ 1 ], busCal.result[ 2 ], busCal.result[ 3 ] );
+
+	busCalSave( logger );
+}
+
+void busCalUpdate( CLogger *logger )
+{
+	if ( busCal.timedOut == 1 )
+	{
+		busCal.timedOut = 2;
+		logger->Write( "RaspiMenu", LogWarning, "timing calibration: no response from the C64 while testing %s, configured timing restored",
+			busCalParamNames[ busCal.param ] );
+		return;
+	}
+
+	if ( ( busCal.state != BUSCAL_REQUESTED && busCal.state != BUSCAL_RUNNING ) || !busCal.roundDone )
+		return;
+
+	busCal.roundDone = 0;
+
+	// rounds started before a candidate was prepared ran with the configured timing
+	if ( busCal.roundValid )
+	{
+		busCal.pass[ busCal.param ][ busCal.step ] = busCal.errors == 0 &&
+			busCal.nReads == BUSCAL_TRANSFERS && busCal.nWrites == BUSCAL_TRANSFERS;
+
+		if ( ++ busCal.step >= busCal.nSteps[ busCal.param ] )
+		{
+			busCal.step = 0;
+			if ( ++ busCal.param >= BUSCAL_PARAMS )
+			{
+				busCalFinish( logger );
+				return;
+			}
+		}
+	}
+
+	if ( !busCal.prepared )
+		busCalPrepare();
+}
+
+void busCalMeasureClock( CLogger *logger, u32 c64CycleCount, bool busy )
+{
+	static u32 started = 0, done = 0;
+	static u32 t0, c0;
+
+	if ( done )
+		return;
+
+	// the FIQ handler does not count cycles while the menu is updated, the C64 needs a moment to report C128/VIC
+	if ( busy || c64CycleCount < 1000000 )
+	{
+		started = 0;
+		return;
+	}
+
+	u32 t = CTimer::GetClockTicks();
+
+	if ( !started )
+	{
+		t0 = t;
+		c0 = c64CycleCount;
+		started = 1;
+		return;
+	}
+
+	if ( t - t0 < 500000 )
+		return;
+
+	// PAL 985248 Hz, NTSC 1022727 Hz
+	u64 rate = (u64)( c64CycleCount - c0 ) * 1000000 / ( t - t0 );
+	busCalNTSC = rate > 1004000 ? 1 : 0;
+	done = 1;
+
+	busCalApplyStored( logger );
+}
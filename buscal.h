@@ -0,0 +1,156 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ buscal.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - calibration of the bus timing (WAIT_*) per machine
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _buscal_h
+#define _buscal_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "lowlevel_arm64.h"
+
+//
+// the calibration is started from the settings screen of the menu, the C64 (rpimenu.c, calibrateTiming) then runs rounds of
+//   STA $DF06                          start of a round, the FIQ handler switches to the candidate timing
+//   256 x ( LDA $DF07, EOR #$FF, STA $DF08 )   pattern from the RPi, echoed back inverted
+//   delay, LDA $DF06                    $CA = next round, anything else = done
+// the candidate is active for BUSCAL_ROUND_CYCLES C64 cycles (or until all transfers are seen), the C64 waits longer than
+// that before it reads $DF06, i.e. the status is always read with the configured timing.
+//
+// one timing value is swept at a time, the others keep their configured values. The calibrated value is the centre of the
+// contiguous window of passing rounds. WAIT_CYCLE_READ (data hold time) is only swept below the configured value as the
+// end of its window cannot be observed by the CPU, it is set to the lowest passing value plus BUSCAL_HOLD_MARGIN (the
+// centre of a one-sided window would move towards the failure edge with every run). The VIC related values are not
+// touched as the VIC never accesses IO2.
+//
+// if a candidate crashes the C64 no further round is started: after BUSCAL_TIMEOUT_CYCLES the FIQ handler restores the
+// configured timing and gives up (BUSCAL_FAILED), the button resets the C64 as usual.
+//
+#define BUSCAL_MAGIC			0xca
+#define BUSCAL_TRANSFERS		256
+#define BUSCAL_ROUND_CYCLES		4500		// the C64 loop takes 256*15 cycles (screen blanked, no IRQs), then waits 1280 cycles
+#define BUSCAL_PARAMS			4
+#define BUSCAL_MAX_STEPS		64
+#define BUSCAL_STEP				5			// ARM cycles
+#define BUSCAL_HOLD_MARGIN		50			// ARM cycles above the lowest working WAIT_CYCLE_READ
+#define BUSCAL_TIMEOUT_CYCLES	1000000		// about 1s without a new round
+
+#define BUSCAL_FILENAME			"SD:C64/timing.cfg"
+
+enum
+{
+	BUSCAL_IDLE = 0,
+	BUSCAL_REQUESTED,			// C64 is told via $DF06 to start calibrateTiming, normal menu operation
+	BUSCAL_RUNNING,				// only the calibration registers are served
+	BUSCAL_DONE,
+	BUSCAL_FAILED
+};
+
+typedef struct
+{
+	volatile u32 state;
+
+	// current round, updated by the FIQ handler
+	volatile u32 roundActive, roundDone, roundValid, roundStart;
+	volatile u32 nReads, nWrites, errors;
+	volatile u32 timedOut;		// set by the FIQ handler, 2 once reported
+
+	// candidate for the next round, set up by the main loop
+	volatile u32 prepared;
+	volatile u32 next[ BUSCAL_PARAMS ];
+	u32 base[ BUSCAL_PARAMS ];
+
+	// sweep
+	u32 param, step;
+	s32 first[ BUSCAL_PARAMS ];
+	u32 nSteps[ BUSCAL_PARAMS ];
+	u8  pass[ BUSCAL_PARAMS ][ BUSCAL_MAX_STEPS ];
+	u32 result[ BUSCAL_PARAMS ];
+
+	u8  pattern[ BUSCAL_TRANSFERS ];
+} BUSCAL;
+
+extern BUSCAL busCal;
+
+extern const char busCalParamNames[ BUSCAL_PARAMS ][ 32 ];
+
+// settings screen: request a calibration, the C64 picks it up after the next screen update
+extern void busCalRequest();
+
+// main loop of the menu: evaluates finished rounds and prepares the next candidate
+extern void busCalUpdate( CLogger *logger );
+
+// main loop of the menu: measures the C64 clock (PAL/NTSC), once known applies the stored timing for this machine
+extern void busCalMeasureClock( CLogger *logger, u32 c64CycleCount, bool busy );
+
+// e.g. "C64-PAL-8565"
+extern const char *busCalMachineName();
+
+//
+// called from the FIQ handler
+//
+static __attribute__( ( always_inline ) ) inline void busCalStartRound( u32 c64Cycle )
+{
+	busCal.roundValid = busCal.prepared;
+	busCal.prepared = 0;
+	if ( busCal.roundValid )
+	{
+		WAIT_FOR_SIGNALS = busCal.next[ 0 ];
+		WAIT_CYCLE_MULTIPLEXER = busCal.next[ 1 ];
+		WAIT_CYCLE_READ = busCal.next[ 2 ];
+		WAIT_CYCLE_WRITEDATA = busCal.next[ 3 ];
+	}
+	busCal.nReads = busCal.nWrites = busCal.errors = 0;
+	busCal.roundStart = c64Cycle;
+	busCal.roundActive = 1;
+	busCal.state = BUSCAL_RUNNING;
+}
+
+static __attribute__( ( always_inline ) ) inline void busCalEndRound()
+{
+	WAIT_FOR_SIGNALS = busCal.base[ 0 ];
+	WAIT_CYCLE_MULTIPLEXER = busCal.base[ 1 ];
+	WAIT_CYCLE_READ = busCal.base[ 2 ];
+	WAIT_CYCLE_WRITEDATA = busCal.base[ 3 ];
+	busCal.roundActive = 0;
+	busCal.roundDone = 1;
+}
+
+// no new round for too long: the candidate timing probably crashed the C64
+static __attribute__( ( always_inline ) ) inline void busCalCheckTimeout( u32 c64Cycle )
+{
+	if ( c64Cycle - busCal.roundStart > BUSCAL_TIMEOUT_CYCLES )
+	{
+		busCalEndRound();
+		busCal.roundDone = 0;
+		busCal.timedOut = 1;
+		busCal.state = BUSCAL_FAILED;
+	}
+}
+
+#endif
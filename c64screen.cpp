@@ -37,8 +37,11 @@
 #include "dirscan.h"
 #include "config.h"
 #include "crt.h"
+#include "buscal.h"
+#include "prefetch.h"
 #include "kernel_menu.h"
-#include "PSID/psid64/psid64.h"
+#include "psidcache.h"
+#include "d2efcache.h"
 
 const int VK_F1 = 133;
 const int VK_F2 = 137;
@@ -90,7 +93,7 @@ u8 c64color[ 40 * 25 + 1024 * 4 ];
 
 char *errorMsg = NULL;
 
-char errorMessages[8][41] = {
+char errorMessages[11][41] = {
 //   1234567890123456789012345678901234567890
 	"                NO ERROR                ",
 	"  ERROR: UNKNOWN/UNSUPPORTED .CRT TYPE  ",
@@ -100,6 +103,9 @@ char errorMessages[8][41] = {
 	"         WRONG SYSTEM, NO C128!         ",
 	"         SID-WIRE NOT DETECTED!         ",
 	"         DISK2EASYFLASH FAILED!         ",
+	"      TIMING CALIBRATED AND SAVED       ",
+	"       TIMING CALIBRATION FAILED!       ",
+	"        PSID CONVERSION FAILED!         ",
 };
 
 /*char *extraMsg = NULL;
@@ -603,6 +609,49 @@ void snapJoy( int dir )
 		joyIdx = oldJoyIdx;
 }
 
+// file under the cursor for the speculative load (prefetch.h), the path is built as in handleC64 when the file is started
+void prefetchFileUnderCursor()
+{
+	u32 kind = PREFETCH_NONE;
+
+	if ( menuScreen == MENU_BROWSER && cursorPos >= 0 && cursorPos < nDirEntries )
+	{
+		u32 f = dir[ cursorPos ].f;
+		if ( f & DIR_PRG_FILE ) kind = PREFETCH_PRG; else
+		if ( f & DIR_CRT_FILE ) kind = PREFETCH_CRT; else
+		if ( f & DIR_SID_FILE ) kind = PREFETCH_SID; else
+		if ( f & DIR_D64_FILE ) kind = PREFETCH_D64; else
+		if ( f & DIR_FILE_IN_D64 ) kind = PREFETCH_FILE_IN_D64;
+	}
+
+	if ( kind == PREFETCH_NONE )
+	{
+		prefetchSelect( NULL, PREFETCH_NONE );
+		return;
+	}
+
+	// build path, for files in a .D64 this is the disk image
+	char path[ 8192 ] = {0};
+	s32 n = 0, c = cursorPos;
+	u32 nodes[ 256 ];
+
+	nodes[ n ++ ] = c;
+	while ( dir[ c ].parent != 0xffffffff )
+		c = nodes[ n ++ ] = dir[ c ].parent;
+
+	s32 stopPath = ( dir[ cursorPos ].f & DIR_FILE_IN_D64 ) ? 1 : 0;
+
+	strcat( path, "SD:" );
+	for ( s32 i = n - 1; i >= stopPath; i -- )
+	{
+		if ( i != n-1 )
+			strcat( path, "\\" );
+		strcat( path, (char*)dir[ nodes[i] ].name );
+	}
+
+	prefetchSelect( path, kind );
+}
+
 // ugly, hard-coded handling of UI
 void handleC64( int k, u32 *launchKernel, char *FILENAME, char *filenameKernal, char *menuItemStr, u32 *startC128 = NULL )
 {
@@ -612,6 +661,16 @@ void handleC64( int k, u32 *launchKernel, char *FILENAME, char *filenameKernal,
 
 	lastKeyDebug = k;
 
+	// result of the timing calibration (started from the settings screen)
+	if ( busCal.state == BUSCAL_DONE || busCal.state == BUSCAL_FAILED )
+	{
+		errorMsg = errorMessages[ busCal.state == BUSCAL_DONE ? 8 : 9 ];
+		busCal.state = BUSCAL_IDLE;
+		previousMenuScreen = menuScreen;
+		menuScreen = MENU_ERROR;
+		return;
+	}
+
 	if ( menuScreen == MENU_MAIN )
 	{
 		if ( k == VK_SHIFT_RETURN )
@@ -981,11 +1040,10 @@ void handleC64( int k, u32 *launchKernel, char *FILENAME, char *filenameKernal,
 		if ( typeInName == 0 && ( k == VK_MOUNT || k == VK_MOUNT_START ) && dir[ cursorPos ].f & DIR_D64_FILE )
 		{
 			typeInName = 0;
-			extern int createD2EF( unsigned char *diskimage, int imageSize, unsigned char *cart, int build, int mode, int autostart );
 
-			unsigned char *cart = new unsigned char[ 1024 * 1025 ];
+			unsigned char *cart = new unsigned char[ D2EFCACHE_MAX_CRT_SIZE ];
 			unsigned char *diskimage = new unsigned char[ 1024 * 1024 ];
-			u32 diSize = 0, crtSize = 0;
+			u32 diSize = 0;
 
 			int autostart = (k == VK_MOUNT_START) ? 1 : 0;
 
@@ -1014,18 +1072,15 @@ void handleC64( int k, u32 *launchKernel, char *FILENAME, char *filenameKernal,
 			{
 				//logger->Write( "d2ef", LogNotice, "loaded %d bytes D64", diSize );
 
-				crtSize = createD2EF( diskimage, diSize, cart, 2, 0, autostart );
+				// the .crt is taken from the cache if this disk has been converted before
+				u32 err = 0, tempKernel = 0;
+				if ( d2efConvertCached( logger, diskimage, diSize, cart, 2, 0, autostart, FILENAME ) )
+					tempKernel = checkCRTFile( logger, DRIVE, FILENAME, &err ); else
+					err = 1;
 
-				//logger->Write( "d2ef", LogNotice, "loaded %d bytes D64", diSize );
-
-				strcpy( FILENAME, "SD:C64/temp.crt" );
-				writeFile( logger, DRIVE, FILENAME, cart, crtSize );
-
-				u32 err = 0;
-				u32 tempKernel = checkCRTFile( logger, DRIVE, FILENAME, &err );
 				if ( err > 0 )
 				{
-					err = 8; // D2EF error
+					err = 7; // D2EF error
 					*launchKernel = 0;
 					errorMsg = errorMessages[ err ];
 					previousMenuScreen = menuScreen;
@@ -1345,40 +1400,28 @@ void handleC64( int k, u32 *launchKernel, char *FILENAME, char *filenameKernal,
 					} else
 					{
 						unsigned char sidData[ 65536 ];
-						u32 sidSize = 0;
+						u32 sidSize = 0, err = 0;
 
-						if ( readFile( logger, DRIVE, path, sidData, &sidSize ) )
-						{
-						}
+						if ( !readFile( logger, DRIVE, path, sidData, &sidSize ) || sidSize == 0 )
+							err = 3;
 
 						logger->Write( "exec", LogNotice, "bytes: '%d'", sidSize );
 
-						Psid64 *psid64 = new Psid64();
+						// convert the PSID file (or take the .prg from the cache)
+						if ( !err && ( !psidConvertCached( logger, path, sidData, sidSize, prgDataLaunch, &prgSizeLaunch ) || prgSizeLaunch == 0 ) )
+							err = 10;
 
-						psid64->setVerbose(false);
-						psid64->setUseGlobalComment(false);
-						psid64->setBlankScreen(false);
-						psid64->setNoDriver(false);
-
-						if ( !psid64->load( sidData, sidSize ) )
+						if ( !err )
 						{
-							//return false;
-						}
-						//logger->Write( "exec", LogNotice, "psid loaded" );
-
-						// convert the PSID file
-						if ( !psid64->convert() ) 
+							*launchKernel = 41;
+							errorMsg = NULL;
+						} else
 						{
-							//return false;
+							*launchKernel = 0;
+							errorMsg = errorMessages[ err ];
+							previousMenuScreen = menuScreen;
+							menuScreen = MENU_ERROR;
 						}
-						//logger->Write( "exec", LogNotice, "psid converted, prg size %d", psid64->m_programSize );
-
-						memcpy( &prgDataLaunch[0], psid64->m_programData, psid64->m_programSize );
-						prgSizeLaunch = psid64->m_programSize;
-
-						delete psid64;
-
-						*launchKernel = 41; 
 					}
 					return;
 				}
@@ -1498,6 +1541,11 @@ void handleC64( int k, u32 *launchKernel, char *FILENAME, char *filenameKernal,
 			previousMenuScreen = menuScreen;
 			menuScreen = MENU_ERROR;
 		}
+		if( (k == 't' || k == 'T') && typeInName == 0 && busCal.state == BUSCAL_IDLE )
+		{
+			// the C64 runs calibrateTiming after this screen update
+			busCalRequest();
+		}
 
 		applySIDSettings();
 	} else
@@ -1702,10 +1750,11 @@ void printSettingsScreen()
 	clearC64();
 	//               "012345678901234567890123456789012345XXXX"
 	printC64( 0,  1, "   .- Sidekick64 -- Frenetic -.         ", skinValues.SKIN_MENU_TEXT_HEADER, 0 );
-	printC64( 0, 23, "    F5 Back to Menu, S Save Settings    ", skinValues.SKIN_MENU_TEXT_HEADER, 0 );
+	printC64( 0, 23, "  F5 Back, S Save Settings, T Calibrate ", skinValues.SKIN_MENU_TEXT_HEADER, 0 );
 	//               "012345678901234567890123456789012345XXXX"
-	printC64( 4, 23, "F5", skinValues.SKIN_MENU_TEXT_FOOTER, 128, 0 );
-	printC64( 21, 23, "S", skinValues.SKIN_MENU_TEXT_FOOTER, 128, 0 );
+	printC64( 2, 23, "F5", skinValues.SKIN_MENU_TEXT_FOOTER, 128, 0 );
+	printC64( 11, 23, "S", skinValues.SKIN_MENU_TEXT_FOOTER, 128, 0 );
+	printC64( 28, 23, "T", skinValues.SKIN_MENU_TEXT_FOOTER, 128, 0 );
 
 	s32 x = 1, x2 = 7,y1 = 1-1, y2 = 1-2;
 	s32 l = curSettingsLine;
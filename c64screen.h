@@ -48,6 +48,7 @@ extern void renderC64();
 extern void readSettingsFile();
 extern void applySIDSettings();
 extern void settingsGetGEORAMInfo( char *filename, u32 *size );
+extern void prefetchFileUnderCursor();
 
 
 #endif
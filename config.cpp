@@ -33,6 +33,8 @@
 #include "lowlevel_arm64.h"
 #include "config.h"
 #include "helpers.h"
+#include "hdmisync.h"
+#include "workset.h"
 #include "linux/kernel.h"
 
 //#define DEBUG_OUT
@@ -199,6 +201,20 @@ int readConfig( CLogger *logger, char *DRIVE, char *FILENAME )
 					if ( strstr( ptr, "ST7789" ) )
 						screenType = 1;
 				}
+
+				if ( strcmp( ptr, "HDMI_AUDIO" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					if ( ptr && strstr( ptr, "LOWLATENCY" ) )
+						hdmiProfileRequested = HDMI_PROFILE_LOWLATENCY; else
+						hdmiProfileRequested = HDMI_PROFILE_STANDARD;
+				}
+
+				if ( strcmp( ptr, "CACHE_PROFILE" ) == 0 )
+				{
+					ptr = strtok_r( NULL, " \t", &rest );
+					workingSetProfile = ( ptr && strstr( ptr, "ON" ) ) ? 1 : 0;
+				}
 			}
 		}
 	}
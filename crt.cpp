@@ -28,6 +28,8 @@
  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "crt.h"
+#include "helpers.h"
+#include "prefetch.h"
 
 u32 swapBytesU32( u8 *buf )
 {
@@ -43,10 +45,53 @@ u16 swapBytesU16( u8 *buf )
 
 #define readCRT( dst, bytes ) memcpy( (dst), crt, bytes ); crt += bytes; 
 
+// .CRT header, parsed from the first 64 bytes
+static int parseCRTHeader( CRT_HEADER *crtHeader, u8 *rawCRT )
+{
+	CRT_HEADER header;
+
+	// now "parse" the file which we already have in memory
+	u8 *crt = rawCRT;
+
+	readCRT( &header.signature, 16 );
+
+	if ( memcmp( CRT_HEADER_SIG, header.signature, 16 ) )
+	{
+		//logger->Write( "RPiFlash-CRTHeader", LogNotice, "no CRT file." );
+		return -1;
+	}
+
+	readCRT( &header.length, 4 );
+	readCRT( &header.version, 2 );
+	readCRT( &header.type, 2 );
+	readCRT( &header.exrom, 1 );
+	readCRT( &header.game, 1 );
+	readCRT( &header.reserved, 6 );
+	readCRT( &header.name, 32 );
+	header.name[ 32 ] = 0;
+
+	header.length = swapBytesU32( (u8*)&header.length );
+	header.version = swapBytesU16( (u8*)&header.version );
+	header.type = swapBytesU16( (u8*)&header.type );
+
+	memcpy( crtHeader, &header, sizeof( header ) );
+
+	return 0;
+}
+
 // .CRT reading - header only!
 int readCRTHeader( CLogger *logger, CRT_HEADER *crtHeader, const char *DRIVE, const char *FILENAME )
 {
-	CRT_HEADER header;
+	u8 rawCRT[ 64 ];
+	u32 filesize;
+
+	// already loaded while the cursor was on it?
+	if ( prefetchGet( FILENAME, rawCRT, &filesize, 64 ) )
+	{
+		if ( filesize < 64 )
+			return -2;
+		return parseCRTHeader( crtHeader, rawCRT );
+	}
 
 	FATFS m_FileSystem;
 
@@ -60,7 +105,7 @@ int readCRTHeader( CLogger *logger, CRT_HEADER *crtHeader, const char *DRIVE, co
 	// get filesize
 	FILINFO info;
 	u32 result = f_stat( FILENAME, &info );
-	u32 filesize = (u32)info.fsize;
+	filesize = (u32)info.fsize;
 
 	// open file
 	FIL file;
@@ -77,7 +122,6 @@ int readCRTHeader( CLogger *logger, CRT_HEADER *crtHeader, const char *DRIVE, co
 
 	// read data in one big chunk
 	u32 nBytesRead;
-	u8 rawCRT[ 64 ];
 	result = f_read( &file, rawCRT, 64, &nBytesRead );
 
 	if ( result != FR_OK )
@@ -99,33 +143,7 @@ int readCRTHeader( CLogger *logger, CRT_HEADER *crtHeader, const char *DRIVE, co
 		return -15;
 	}
 
-	// now "parse" the file which we already have in memory
-	u8 *crt = rawCRT;
-
-	readCRT( &header.signature, 16 );
-
-	if ( memcmp( CRT_HEADER_SIG, header.signature, 16 ) )
-	{
-		//logger->Write( "RPiFlash-CRTHeader", LogNotice, "no CRT file." );
-		return -1;
-	}
-
-	readCRT( &header.length, 4 );
-	readCRT( &header.version, 2 );
-	readCRT( &header.type, 2 );
-	readCRT( &header.exrom, 1 );
-	readCRT( &header.game, 1 );
-	readCRT( &header.reserved, 6 );
-	readCRT( &header.name, 32 );
-	header.name[ 32 ] = 0;
-
-	header.length = swapBytesU32( (u8*)&header.length );
-	header.version = swapBytesU16( (u8*)&header.version );
-	header.type = swapBytesU16( (u8*)&header.type );
-
-	memcpy( crtHeader, &header, sizeof( header ) );
-
-	return 0;
+	return parseCRTHeader( crtHeader, rawCRT );
 }
 
 // .CRT reading
@@ -133,40 +151,46 @@ void readCRTFile( CLogger *logger, CRT_HEADER *crtHeader, const char *DRIVE, con
 {
 	CRT_HEADER header;
 
-	FATFS m_FileSystem;
+	u8 rawCRT[ 1032 * 1024 ];
+	u32 filesize;
 
-	// mount file system
-	if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
-		logger->Write( "RaspiFlash", LogPanic, "Cannot mount drive: %s", DRIVE );
+	// already loaded while the cursor was on it?
+	if ( !prefetchGet( FILENAME, rawCRT, &filesize, 1032 * 1024 ) )
+	{
+		FATFS m_FileSystem;
 
-	// get filesize
-	FILINFO info;
-	u32 result = f_stat( FILENAME, &info );
-	u32 filesize = (u32)info.fsize;
+		// mount file system
+		if ( f_mount( &m_FileSystem, DRIVE, 1 ) != FR_OK )
+			logger->Write( "RaspiFlash", LogPanic, "Cannot mount drive: %s", DRIVE );
 
-	// open file
-	FIL file;
-	result = f_open( &file, FILENAME, FA_READ | FA_OPEN_EXISTING );
-	if ( result != FR_OK )
-		logger->Write( "RaspiFlash", LogPanic, "Cannot open file: %s", FILENAME );
+		// get filesize
+		FILINFO info;
+		u32 result = f_stat( FILENAME, &info );
+		filesize = (u32)info.fsize;
 
-	if ( filesize > 1032 * 1024 )
-		filesize = 1032 * 1024;
+		// open file
+		FIL file;
+		result = f_open( &file, FILENAME, FA_READ | FA_OPEN_EXISTING );
+		if ( result != FR_OK )
+			logger->Write( "RaspiFlash", LogPanic, "Cannot open file: %s", FILENAME );
 
-	// read data in one big chunk
-	u32 nBytesRead;
-	u8 rawCRT[ 1032 * 1024 ];
-	result = f_read( &file, rawCRT, filesize, &nBytesRead );
+		if ( filesize > 1032 * 1024 )
+			filesize = 1032 * 1024;
 
-	if ( result != FR_OK )
-		logger->Write( "RaspiFlash", LogError, "Read error" );
+		// read data in one big chunk
+		u32 nBytesRead;
+		result = f_read( &file, rawCRT, filesize, &nBytesRead );
 
-	if ( f_close( &file ) != FR_OK )
-		logger->Write( "RaspiFlash", LogPanic, "Cannot close file" );
+		if ( result != FR_OK )
+			logger->Write( "RaspiFlash", LogError, "Read error" );
 
-	// unmount file system
-	if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
-		logger->Write( "RaspiFlash", LogPanic, "Cannot unmount drive: %s", DRIVE );
+		if ( f_close( &file ) != FR_OK )
+			logger->Write( "RaspiFlash", LogPanic, "Cannot close file" );
+
+		// unmount file system
+		if ( f_mount( 0, DRIVE, 0 ) != FR_OK )
+			logger->Write( "RaspiFlash", LogPanic, "Cannot unmount drive: %s", DRIVE );
+	}
 
 
 	// now "parse" the file which we already have in memory
@@ -586,7 +610,7 @@ void writeChanges2CRTFile( CLogger *logger, const char *DRIVE, const char *FILEN
 
 
 	// write file
-	result = f_open( &file, FILENAME, FA_CREATE_ALWAYS | FA_WRITE );
+	result = createFile( &file, FILENAME );
 	if ( result != FR_OK )
 		logger->Write( "RaspiFlash", LogPanic, "Cannot open file: %s", FILENAME );
 
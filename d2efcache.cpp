@@ -0,0 +1,179 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ d2efcache.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - cache of D2EF converted EasyFlash images on the SD card
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/timer.h>
+#include "helpers.h"
+#include "d2efcache.h"
+#include "sdcache.h"
+#include "D2EF/binaries.h"
+
+extern int createD2EF( unsigned char *diskimage, int imageSize, unsigned char *cart, int build, int mode, int autostart );
+
+// statistics since the menu has been started
+static SDCACHESTATS d2efCache = { "D2EF cache", 0, 0, 0 };
+
+static void stampBinary( u32 *stamp, const u8 *data, u32 size )
+{
+	for ( u32 i = 0; i < size; i++ )
+		*stamp = ( *stamp ^ data[ i ] ) * 16777619u;
+}
+
+// FNV-1a of the loader code D2EF copies into every image
+static u32 d2efLoaderStamp()
+{
+	static u32 stamp = 0;
+	if ( stamp == 0 )
+	{
+		stamp = 2166136261u;
+		stampBinary( &stamp, kapi_hi, kapi_hi_size );
+		stampBinary( &stamp, kapi_nm, kapi_nm_size );
+		stampBinary( &stamp, kapi_lo, kapi_lo_size );
+		stampBinary( &stamp, launcher_hi, launcher_hi_size );
+		stampBinary( &stamp, startup, startup_size );
+		stampBinary( &stamp, sprites, sprites_size );
+		stampBinary( &stamp, kapi_hi_auto, kapi_hi_size_auto );
+		stampBinary( &stamp, kapi_nm_auto, kapi_nm_size_auto );
+		stampBinary( &stamp, kapi_lo_auto, kapi_lo_size_auto );
+		stampBinary( &stamp, launcher_hi_auto, launcher_hi_size_auto );
+		stampBinary( &stamp, startup_auto, startup_size_auto );
+		stampBinary( &stamp, sprites_auto, sprites_size_auto );
+	}
+	return stamp;
+}
+
+static u32 getBE32( const u8 *p )
+{
+	return ( (u32)p[ 0 ] << 24 ) | ( (u32)p[ 1 ] << 16 ) | ( (u32)p[ 2 ] << 8 ) | p[ 3 ];
+}
+
+// EasyFlash CRT header, the CHIP packets have to fill the file exactly (a truncated file ends within one)
+static int d2efCheckCRT( const u8 *crt, u32 size )
+{
+	if ( size < 0x40 || memcmp( crt, "C64 CARTRIDGE   ", 16 ) != 0 )
+		return 0;
+
+	u32 headerLength = getBE32( &crt[ 0x10 ] );
+	u32 type = ( (u32)crt[ 0x16 ] << 8 ) | crt[ 0x17 ];
+	if ( type != 32 || headerLength < 0x40 || headerLength > size )
+		return 0;
+
+	u32 pos = headerLength;
+	while ( pos < size )
+	{
+		if ( size - pos < 0x10 || memcmp( &crt[ pos ], "CHIP", 4 ) != 0 )
+			return 0;
+		u32 length = getBE32( &crt[ pos + 4 ] );
+		if ( length < 0x10 || length > size - pos )
+			return 0;
+		pos += length;
+	}
+	return 1;
+}
+
+// returns the size of the cached .crt, 0 if there is no valid entry
+static u32 d2efCacheLoad( CLogger *logger, const char *name, u8 *cart )
+{
+	FATFS m_FileSystem;
+	if ( f_mount( &m_FileSystem, "SD:", 1 ) != FR_OK )
+		return 0;
+
+	u32 size = 0;
+	FILINFO info;
+	FIL file;
+	if ( f_stat( name, &info ) == FR_OK && f_open( &file, name, FA_READ | FA_OPEN_EXISTING ) == FR_OK )
+	{
+		u32 nBytesRead;
+		if ( info.fsize <= D2EFCACHE_MAX_CRT_SIZE &&
+			 f_read( &file, cart, (u32)info.fsize, &nBytesRead ) == FR_OK && nBytesRead == (u32)info.fsize )
+			size = nBytesRead;
+		f_close( &file );
+
+		// a new conversion replaces it
+		if ( !d2efCheckCRT( cart, size ) )
+		{
+			logger->Write( "RaspiMenu", LogWarning, "D2EF cache: ignoring invalid entry %s", name );
+			size = 0;
+		}
+	}
+
+	f_mount( 0, "SD:", 0 );
+	return size;
+}
+
+int d2efConvertCached( CLogger *logger, u8 *diskImage, u32 diskSize, u8 *cart, int build, int mode, int autostart, char *crtName )
+{
+	u32 stamp = d2efLoaderStamp();
+
+	u8 options[ 8 ] = { (u8)build, (u8)mode, (u8)autostart, (u8)D2EFCACHE_VERSION,
+						(u8)stamp, (u8)( stamp >> 8 ), (u8)( stamp >> 16 ), (u8)( stamp >> 24 ) };
+
+	u8 key[ MD5_DIGEST_SIZE ];
+	MD5CTX ctx;
+	md5Init( &ctx );
+	md5Update( &ctx, diskImage, diskSize );
+	md5Update( &ctx, options, sizeof( options ) );
+	md5Final( &ctx, key );
+
+	char name[ 64 ];
+	sdCacheFileName( name, D2EFCACHE_PATH, key, ".crt" );
+
+	u32 crtSize = d2efCacheLoad( logger, name, cart );
+	if ( crtSize )
+	{
+		d2efCache.hits ++;
+		logger->Write( "RaspiMenu", LogNotice, "D2EF cache hit: %s (%u hits, %u misses)", name, d2efCache.hits, d2efCache.misses );
+	} else
+	{
+		d2efCache.misses ++;
+
+		u32 t0 = CTimer::GetClockTicks();
+
+		int size = createD2EF( diskImage, diskSize, cart, build, mode, autostart );
+
+		if ( size <= 0x40 )
+		{
+			logger->Write( "RaspiMenu", LogWarning, "D2EF conversion failed" );
+			crtName[ 0 ] = 0;
+			return 0;
+		}
+		crtSize = size;
+
+		u32 t = CTimer::GetClockTicks() - t0;
+		sdCacheConverted( logger, &d2efCache, t, crtSize );
+
+		// e.g. SD card full: it is launched from the copy anyway
+		const void *data[ 1 ] = { cart };
+		sdCacheStore( logger, &d2efCache, D2EFCACHE_PATH, name, 1, data, &crtSize );
+	}
+
+	// EAPI writes go to the copy, as before the cache
+	strcpy( crtName, D2EFCACHE_TEMP_CRT );
+	return writeFile( logger, "SD:", crtName, cart, crtSize );
+}
@@ -0,0 +1,60 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ d2efcache.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - cache of D2EF converted EasyFlash images on the SD card
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _d2efcache_h
+#define _d2efcache_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "md5.h"
+
+//
+// mounting a .d64 runs Disk2EasyFlash (parsing the disk, bundling the files, building the EasyFlash image) on every
+// start. The .crt is stored in D2EFCACHE_PATH and loaded from there when the same disk is mounted again. The key is
+// the MD5 of the .d64, the D2EF options (build, mode, autostart), a stamp of the loader binaries (D2EF/binaries.cpp)
+// and D2EFCACHE_VERSION -- increase the latter whenever D2EF changes its output otherwise.
+//
+// one plain .crt per disk, named after the key. It is never launched in place: the EasyFlash kernel writes EAPI
+// changes back into the .crt it was started from, the entry would no longer match its key. An entry is only used
+// if its CRT header and CHIP packets are complete (e.g. not truncated by a power loss).
+//
+#define D2EFCACHE_PATH			"SD:C64/D2EFCACHE"
+#define D2EFCACHE_VERSION		1
+
+// the copy which is launched
+#define D2EFCACHE_TEMP_CRT		"SD:C64/temp.crt"
+
+// size of the buffer for the .crt (1 MB + header)
+#define D2EFCACHE_MAX_CRT_SIZE	( 1024 * 1025 )
+
+// converts the .d64 to a .crt (using 'cart' as buffer, D2EFCACHE_MAX_CRT_SIZE bytes), or takes it from the cache, and
+// writes it to D2EFCACHE_TEMP_CRT. 'crtName' receives the file to launch. Returns 0 if the conversion failed.
+extern int d2efConvertCached( CLogger *logger, u8 *diskImage, u32 diskSize, u8 *cart, int build, int mode, int autostart, char *crtName );
+
+#endif
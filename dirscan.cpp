@@ -30,6 +30,7 @@
  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "dirscan.h"
+#include "prefetch.h"
 #include "linux/kernel.h"
 #include <circle/util.h>
 
@@ -236,6 +237,10 @@ u8 d64buf[ 1024 * 1024 ];
 
 int readD64File( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 *size )
 {
+	// already loaded while the cursor was on it?
+	if ( prefetchGet( FILENAME, data, size, 822400 ) )
+		return *size <= 822400;
+
 	// get filesize
 	FILINFO info;
 	u32 res = f_stat( FILENAME, &info );
@@ -0,0 +1,138 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ fiqstats.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - opt-in timing instrumentation of the FIQ bus handlers
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/string.h>
+#include "lowlevel_arm64.h"
+#include "gpio_defs.h"
+#include "helpers.h"
+#include "fiqstats.h"
+
+#if defined( FIQ_STATS ) && !defined( MACHINE_C264 )
+
+FIQSTATS fiqStats[ FIQ_CLASSES ] AAA;
+u32 fiqStatsMinGap;
+u32 fiqStatsPendingClass, fiqStatsPendingData;
+s32 fiqStatsPendingMargin;
+
+static const char *fiqClassName[ FIQ_CLASSES ] =
+{
+	"ROML read", "ROMH read", "Kernal read", "IO1 read", "IO2 read",
+	"IO1 write", "IO2 write", "VIC", "other", "no transfer"
+};
+
+static char fiqStatsText[ 16384 ];
+
+void fiqStatsReset()
+{
+	memset( fiqStats, 0, sizeof( fiqStats ) );
+	for ( u32 i = 0; i < FIQ_CLASSES; i++ )
+		fiqStats[ i ].minMargin = 0x7fffffff;
+	fiqStatsMinGap = 0xffffffff;
+	fiqStatsPendingClass = FIQ_CLASS_NO_TRANSFER;
+	fiqStatsPendingData = 0;
+	fiqStatsPendingMargin = 0;
+}
+
+static void appendHistogram( CString &out, const char *name, const u32 *hist )
+{
+	CString line;
+	line.Format( "  %-12s", name );
+	out.Append( line );
+
+	for ( u32 b = 0; b < FIQ_STATS_BUCKETS; b++ )
+		if ( hist[ b ] )
+		{
+			line.Format( b == FIQ_STATS_BUCKETS - 1 ? " >=%u:%u" : " %u:%u", b << FIQ_STATS_BUCKET_SHIFT, hist[ b ] );
+			out.Append( line );
+		}
+	out.Append( "\n" );
+}
+
+u32 fiqStatsReport( char *buf, u32 maxLen, const char *title )
+{
+	CString out, line;
+
+	line.Format( "FIQ handler timing: %s\n", title ? title : "" );
+	out.Append( line );
+	line.Format( "all values in ARM cycles relative to the handler entry, histogram buckets are %u cycles wide\n", 1 << FIQ_STATS_BUCKET_SHIFT );
+	out.Append( line );
+	line.Format( "WAIT_FOR_SIGNALS %u, WAIT_CYCLE_MULTIPLEXER %u, WAIT_CYCLE_READ %u, WAIT_CYCLE_WRITEDATA %u\n",
+		WAIT_FOR_SIGNALS, WAIT_CYCLE_MULTIPLEXER, WAIT_CYCLE_READ, WAIT_CYCLE_WRITEDATA );
+	out.Append( line );
+	line.Format( "WAIT_CYCLE_READ_BADLINE %u, WAIT_CYCLE_READ_VIC2 %u, WAIT_CYCLE_MULTIPLEXER_VIC2 %u\n",
+		WAIT_CYCLE_READ_BADLINE, WAIT_CYCLE_READ_VIC2, WAIT_CYCLE_MULTIPLEXER_VIC2 );
+	out.Append( line );
+	line.Format( "min. time between the exit of a handler and the entry of the next one: %u\n\n",
+		fiqStatsMinGap == 0xffffffff ? 0 : fiqStatsMinGap );
+	out.Append( line );
+
+	out.Append( "class            count     late  max.data  max.exit  min.margin\n" );
+	for ( u32 i = 0; i < FIQ_CLASSES; i++ )
+	{
+		const FIQSTATS *s = &fiqStats[ i ];
+		if ( s->count == 0 )
+			continue;
+		if ( i == FIQ_CLASS_NO_TRANSFER )
+			line.Format( "%-12s %9u        -         -  %8u           -\n", fiqClassName[ i ], s->count, s->maxExit ); else
+			line.Format( "%-12s %9u %8u  %8u  %8u  %10d\n", fiqClassName[ i ], s->count, s->late, s->maxData, s->maxExit, s->minMargin );
+		out.Append( line );
+	}
+
+	out.Append( "\ndata-out histograms (start of bucket:count)\n" );
+	for ( u32 i = 0; i < FIQ_CLASS_NO_TRANSFER; i++ )
+		if ( fiqStats[ i ].count )
+			appendHistogram( out, fiqClassName[ i ], fiqStats[ i ].histData );
+
+	out.Append( "\nexit histograms (start of bucket:count)\n" );
+	for ( u32 i = 0; i < FIQ_CLASSES; i++ )
+		if ( fiqStats[ i ].count )
+			appendHistogram( out, fiqClassName[ i ], fiqStats[ i ].histExit );
+
+	u32 len = out.GetLength();
+	if ( len >= maxLen )
+		len = maxLen - 1;
+	memcpy( buf, (const char *)out, len );
+	buf[ len ] = 0;
+
+	return len;
+}
+
+void fiqStatsWrite( CLogger *logger, const char *title )
+{
+	u32 len = fiqStatsReport( fiqStatsText, sizeof( fiqStatsText ), title );
+	writeFile( logger, "SD:", "SD:C64/fiqstats.txt", (u8*)fiqStatsText, len );
+
+	u32 late = 0;
+	for ( u32 i = 0; i < FIQ_CLASSES; i++ )
+		late += fiqStats[ i ].late;
+	logger->Write( "RaspiMenu", LogNotice, "FIQ timing written to SD:C64/fiqstats.txt, %u late accesses", late );
+}
+
+#endif
@@ -0,0 +1,146 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ fiqstats.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - opt-in timing instrumentation of the FIQ bus handlers
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _fiqstats_h
+#define _fiqstats_h
+
+//
+// build with 'make kernel=menu FIQ_STATS=1' to measure the FIQ handlers (C64/C128 only):
+// the data transfer macros (PUT_DATA_ON_BUS_..., GET_DATA_FROM_BUS_...) sample PMCCNTR_EL0 when the data
+// is on the bus (or the handler is about to wait for the CPU's data), FINISH_BUS_HANDLING samples it again at exit.
+// Both are relative to the handler entry (armCycleCounter), the margin is the wait target minus the time at data-out,
+// i.e. a negative margin means the handler was late and the access may have glitched.
+//
+// the sampling adds a few ARM cycles per C64 cycle, the bookkeeping happens at exit after the bus is released.
+//
+#if defined( FIQ_STATS ) && !defined( MACHINE_C264 )
+
+#include <circle/logger.h>
+
+// access classes, determined at the data transfer from g2/g3
+enum
+{
+	FIQ_CLASS_ROML_READ = 0,
+	FIQ_CLASS_ROMH_READ,
+	FIQ_CLASS_KERNAL_READ,
+	FIQ_CLASS_IO1_READ,
+	FIQ_CLASS_IO2_READ,
+	FIQ_CLASS_IO1_WRITE,
+	FIQ_CLASS_IO2_WRITE,
+	FIQ_CLASS_VIC,				// half cycles and badlines
+	FIQ_CLASS_OTHER,			// e.g. RAM reads of the launch kernels, SID accesses
+	FIQ_CLASS_NO_TRANSFER,		// cycles in which the handler did not touch the data bus
+	FIQ_CLASSES
+};
+
+#define FIQ_STATS_BUCKETS		64
+#define FIQ_STATS_BUCKET_SHIFT	4		// 16 ARM cycles per bucket, the last bucket collects everything above
+
+typedef struct
+{
+	u32 count, late;
+	u32 maxData, maxExit;
+	s32 minMargin;
+	u32 histData[ FIQ_STATS_BUCKETS ];
+	u32 histExit[ FIQ_STATS_BUCKETS ];
+} FIQSTATS;
+
+extern FIQSTATS fiqStats[ FIQ_CLASSES ];
+extern u32 fiqStatsMinGap;
+extern u32 fiqStatsPendingClass, fiqStatsPendingData;
+extern s32 fiqStatsPendingMargin;
+
+extern void fiqStatsReset();
+
+// formats the statistics as text, returns the length
+extern u32 fiqStatsReport( char *buf, u32 maxLen, const char *title );
+
+// writes the report to SD:C64/fiqstats.txt
+extern void fiqStatsWrite( CLogger *logger, const char *title );
+
+#define FIQ_STATS_CLASSIFY												\
+	( !( g2 & bPHI ) || ( !( g3 & bBA ) && ( g2 & bRW ) ) ? FIQ_CLASS_VIC :	\
+	( g2 & bRW ) ?														\
+		( !( g3 & bROML ) ? FIQ_CLASS_ROML_READ :						\
+		  !( g3 & bROMH ) ? FIQ_CLASS_ROMH_READ :						\
+		  !( g3 & bCS ) ? FIQ_CLASS_KERNAL_READ :						\
+		  !( g3 & bIO1 ) ? FIQ_CLASS_IO1_READ :							\
+		  !( g3 & bIO2 ) ? FIQ_CLASS_IO2_READ : FIQ_CLASS_OTHER ) :		\
+		( !( g3 & bIO1 ) ? FIQ_CLASS_IO1_WRITE :							\
+		  !( g3 & bIO2 ) ? FIQ_CLASS_IO2_WRITE : FIQ_CLASS_OTHER ) )
+
+// data is on the bus (or is about to be read), 'deadline' is the cycle the handler will wait for
+#define FIQ_STATS_DATA( deadline ) {											\
+	u64 ccStats;																\
+	READ_CYCLE_COUNTER( ccStats );												\
+	fiqStatsPendingClass = FIQ_STATS_CLASSIFY;									\
+	fiqStatsPendingData = (u32)( ccStats - armCycleCounter );					\
+	fiqStatsPendingMargin = (s32)( deadline ) - (s32)fiqStatsPendingData; }
+
+#define FIQ_STATS_EXIT {														\
+	u64 ccStats;																\
+	READ_CYCLE_COUNTER( ccStats );												\
+	fiqStatsExit( (u32)( ccStats - armCycleCounter ), (u32)armCycleCounter ); }
+
+static __attribute__( ( always_inline ) ) inline u32 fiqStatsBucket( u32 c )
+{
+	c >>= FIQ_STATS_BUCKET_SHIFT;
+	return c < FIQ_STATS_BUCKETS ? c : FIQ_STATS_BUCKETS - 1;
+}
+
+// 'gap' is the counter value at entry, i.e. the time since the previous handler reset the counter
+static __attribute__( ( always_inline ) ) inline void fiqStatsExit( u32 exit, u32 gap )
+{
+	FIQSTATS *s = &fiqStats[ fiqStatsPendingClass ];
+
+	s->count ++;
+	s->histExit[ fiqStatsBucket( exit ) ] ++;
+	if ( exit > s->maxExit ) s->maxExit = exit;
+
+	if ( fiqStatsPendingClass != FIQ_CLASS_NO_TRANSFER )
+	{
+		s->histData[ fiqStatsBucket( fiqStatsPendingData ) ] ++;
+		if ( fiqStatsPendingData > s->maxData ) s->maxData = fiqStatsPendingData;
+		if ( fiqStatsPendingMargin < s->minMargin ) s->minMargin = fiqStatsPendingMargin;
+		if ( fiqStatsPendingMargin < 0 ) s->late ++;
+	}
+
+	if ( gap < fiqStatsMinGap ) fiqStatsMinGap = gap;
+
+	fiqStatsPendingClass = FIQ_CLASS_NO_TRANSFER;
+}
+
+#else
+
+#define FIQ_STATS_DATA( deadline )
+#define FIQ_STATS_EXIT
+
+#endif
+
+#endif
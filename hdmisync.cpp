@@ -0,0 +1,151 @@
+/*
+  _________.__    .___      __   .__        __           _________                        .___
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __      /   _____/ ____  __ __  ____    __| _/
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /      \_____  \ /  _ \|  |  \/    \  / __ |
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <       /        (  <_> )  |  /   |  \/ /_/ |
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     /_______  /\____/|____/|___|  /\____ |
+        \/         \/    \/     \/       \/     \/             \/                  \/      \/
+
+ hdmisync.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - HDMI audio latency profiles and clock drift compensation
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/types.h>
+#include <circle/util.h>
+#include "hdmisync.h"
+
+//
+// latency profiles: the standard profile keeps the queue and chunk size we always used, but starts playback at
+// 150% of the queue instead of 450% (the latter only worked because the old PCMBuffer silently wrapped),
+// the low latency profile trades robustness against ~4x less delay between a register write and the sound
+//
+const HDMIPROFILE hdmiProfiles[ HDMI_PROFILES ] = 
+{
+	{ "standard",		50, 2000, 150, 150 },
+	{ "low latency",	15,  384, 150, 125 }
+};
+
+u32 hdmiProfileRequested = HDMI_PROFILE_STANDARD;
+u32 hdmiProfileActive = HDMI_PROFILE_STANDARD;
+
+u32 hdmiQueueFrames( u32 sampleRate )
+{
+	return hdmiProfiles[ hdmiProfileActive ].queueMsecs * sampleRate / 1000;
+}
+
+u32 hdmiStartFrames( u32 sampleRate )
+{
+	return hdmiQueueFrames( sampleRate ) * hdmiProfiles[ hdmiProfileActive ].startPercent / 100;
+}
+
+//
+// HDMI clock drift compensation
+// the HDMI audio clock is not derived from the C64 clock, so we resample the emulation output with a fractional 
+// step and let a PI controller keep the queue fill level at its target (proportional term reacts within a few
+// seconds, the integral term learns the actual clock ratio and removes the remaining offset)
+//
+#define HDMISYNC_KP			10.0	// ppm per frame of fill error
+#define HDMISYNC_KI			1.25	// ppm per frame of fill error and second
+#define HDMISYNC_MAX_PPM	5000.0	// never bend the pitch by more than 0.5%
+
+// underruns during the first refills are part of starting up
+#define HDMISYNC_WARMUP		32
+
+HDMISYNCSTATS hdmiSync;
+u32 cyclesPerSampleX65536;
+
+static u32 hdmiSyncClockFreq, hdmiSyncSampleRate;
+static double hdmiSyncFillAvg, hdmiSyncIntegral;
+static unsigned long long hdmiSyncLastSamples;
+
+static inline double clampPPM( double v )
+{
+	if ( v < -HDMISYNC_MAX_PPM ) return -HDMISYNC_MAX_PPM;
+	if ( v >  HDMISYNC_MAX_PPM ) return  HDMISYNC_MAX_PPM;
+	return v;
+}
+
+void hdmiSyncReset( u32 clockFreq, u32 sampleRate )
+{
+	u32 fallbacks = hdmiSync.fallbacks;
+	memset( &hdmiSync, 0, sizeof( HDMISYNCSTATS ) );
+	hdmiSync.fallbacks = fallbacks;
+	hdmiSync.target = hdmiQueueFrames( sampleRate ) * hdmiProfiles[ hdmiProfileActive ].targetPercent / 100;
+	hdmiSync.rateHz = sampleRate;
+	hdmiSync.fillMin = 0x7fffffff;
+
+	hdmiSyncClockFreq = clockFreq;
+	hdmiSyncSampleRate = sampleRate;
+	hdmiSyncFillAvg = hdmiSyncIntegral = 0.0;
+	hdmiSyncLastSamples = 0;
+
+	cyclesPerSampleX65536 = ( ( unsigned long long )clockFreq << 16 ) / sampleRate;
+}
+
+bool hdmiSyncUpdate( s32 fill, bool underrun, unsigned long long samplesElapsed )
+{
+	bool fallback = false;
+
+	if ( hdmiSync.updates > HDMISYNC_WARMUP && underrun )
+	{
+		hdmiSync.underruns ++;
+
+		if ( hdmiProfileActive != HDMI_PROFILE_STANDARD && hdmiSync.underruns >= HDMI_FALLBACK_UNDERRUNS )
+		{
+			hdmiProfileActive = HDMI_PROFILE_STANDARD;
+			hdmiSync.fallbacks ++;
+			hdmiSync.target = hdmiQueueFrames( hdmiSyncSampleRate ) * hdmiProfiles[ hdmiProfileActive ].targetPercent / 100;
+			hdmiSync.underruns = 0;
+			fallback = true;
+		}
+	}
+
+	hdmiSync.fill = fill;
+	if ( fill < hdmiSync.fillMin ) hdmiSync.fillMin = fill;
+	if ( fill > hdmiSync.fillMax ) hdmiSync.fillMax = fill;
+
+	// the device consumes whole chunks, smooth the fill level a bit
+	if ( hdmiSync.updates ++ == 0 )
+	{
+		hdmiSyncFillAvg = fill;
+		hdmiSyncLastSamples = samplesElapsed;
+		return fallback;
+	}
+	hdmiSyncFillAvg += ( (double)fill - hdmiSyncFillAvg ) * ( 1.0 / 8.0 );
+
+	double dt = (double)( samplesElapsed - hdmiSyncLastSamples ) / (double)hdmiSyncSampleRate;
+	hdmiSyncLastSamples = samplesElapsed;
+
+	double err = (double)hdmiSync.target - hdmiSyncFillAvg;
+
+	hdmiSyncIntegral = clampPPM( hdmiSyncIntegral + HDMISYNC_KI * err * dt );
+
+	double ppm = clampPPM( HDMISYNC_KP * err + hdmiSyncIntegral );
+
+	// fill level below target => produce samples faster => less emulated cycles per sample
+	double rate = (double)hdmiSyncSampleRate * ( 1.0 + ppm * 1e-6 );
+	cyclesPerSampleX65536 = (u32)( (double)hdmiSyncClockFreq * 65536.0 / rate );
+
+	hdmiSync.fillAvg = (s32)hdmiSyncFillAvg;
+	hdmiSync.ppm = (s32)ppm;
+	hdmiSync.rateHz = (u32)( rate + 0.5 );
+
+	return fallback;
+}
@@ -0,0 +1,86 @@
+/*
+  _________.__    .___      __   .__        __           _________                        .___
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __      /   _____/ ____  __ __  ____    __| _/
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /      \_____  \ /  _ \|  |  \/    \  / __ |
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <       /        (  <_> )  |  /   |  \/ /_/ |
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     /_______  /\____/|____/|___|  /\____ |
+        \/         \/    \/     \/       \/     \/             \/                  \/      \/
+
+ hdmisync.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - HDMI audio latency profiles and clock drift compensation
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _hdmisync_h_
+#define _hdmisync_h_
+
+#include <circle/types.h>
+
+//
+// HDMI audio latency profiles
+// the span queue of the VCHIQ device is always allocated with PCM_QUEUE_FRAMES, a profile sets the fill target and the chunk size
+//
+#define HDMI_PROFILE_STANDARD		0
+#define HDMI_PROFILE_LOWLATENCY		1
+#define HDMI_PROFILES				2
+
+typedef struct
+{
+	const char *name;
+	u32 queueMsecs;			// nominal queue duration, start threshold and fill target are relative to it
+	u32 chunkSize;			// number of s16 words transferred to the sound device at once
+	u32 startPercent;		// emulated audio (relative to the queue) before playback is started
+	u32 targetPercent;		// fill level (span queue + chunks in flight) the drift controller aims for
+} HDMIPROFILE;
+
+extern const HDMIPROFILE hdmiProfiles[ HDMI_PROFILES ];
+extern u32 hdmiProfileRequested;	// from the config file
+extern u32 hdmiProfileActive;		// falls back to HDMI_PROFILE_STANDARD on repeated underruns
+
+// the low latency profile is given up after this many underruns
+#define HDMI_FALLBACK_UNDERRUNS		4
+
+//
+// HDMI clock drift compensation: a PI controller on the number of queued frames (span queue + chunks in flight)
+// steers a fractional resampling step, i.e. the number of emulated cycles per output sample in 16.16 fixed point
+//
+typedef struct
+{
+	s32 fill, fillAvg, fillMin, fillMax;	// queued frames at the last refill, smoothed, extremes
+	s32 target;								// fill level the controller aims for
+	s32 ppm;								// current rate correction
+	u32 rateHz;								// resulting output sample rate
+	u32 updates, underruns, overruns;		// overruns: blocks dropped because the span queue was full
+	u32 fallbacks;							// switches from low latency to standard profile
+} HDMISYNCSTATS;
+
+extern HDMISYNCSTATS hdmiSync;
+extern u32 cyclesPerSampleX65536;
+
+// frames of the queue, of the start threshold and of the fill target for the active profile
+extern u32 hdmiQueueFrames( u32 sampleRate );
+extern u32 hdmiStartFrames( u32 sampleRate );
+
+extern void hdmiSyncReset( u32 clockFreq, u32 sampleRate );
+
+// call once per chunk taken by the sound device with the frames not yet played and whether the chunk was short,
+// returns true if the active profile fell back to HDMI_PROFILE_STANDARD
+extern bool hdmiSyncUpdate( s32 fill, bool underrun, unsigned long long samplesElapsed );
+
+#endif
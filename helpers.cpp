@@ -28,10 +28,15 @@
  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "helpers.h"
+#include "prefetch.h"
 
 // file reading
 int readFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 *size )
 {
+	// already loaded while the cursor was on it?
+	if ( prefetchGet( FILENAME, data, size ) )
+		return 1;
+
 	FATFS m_FileSystem;
 
 	// mount file system
@@ -101,6 +106,12 @@ int getFileSize( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 *
 
 
 // file writing
+FRESULT createFile( FIL *file, const char *FILENAME )
+{
+	prefetchInvalidate( FILENAME );
+	return f_open( file, FILENAME, FA_WRITE | FA_CREATE_ALWAYS );
+}
+
 int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size )
 {
 	FATFS m_FileSystem;
@@ -111,7 +122,7 @@ int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *dat
 
 	// open file
 	FIL file;
-	u32 result = f_open( &file, FILENAME, FA_WRITE | FA_CREATE_ALWAYS );
+	u32 result = createFile( &file, FILENAME );
 	if ( result != FR_OK )
 	{
 		logger->Write( "RaspiMenu", LogNotice, "Cannot open file: %s", FILENAME );
@@ -37,6 +37,10 @@ extern int readFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u
 extern int getFileSize( CLogger *logger, const char *DRIVE, const char *FILENAME, u32 *size );
 extern int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME, u8 *data, u32 size );
 
+// opens a file for writing (created or truncated), all writes to the SD card go through here such that the file is
+// dropped from the prefetch slots (prefetch.h) and never served with its old contents
+extern FRESULT createFile( FIL *file, const char *FILENAME );
+
 #define START_AND_READ_ADDR0to7_RW_RESET_CS	\
 	register u32 g2, g3;					\
 	BEGIN_CYCLE_COUNTER						\
@@ -73,11 +77,13 @@ extern int writeFile( CLogger *logger, const char *DRIVE, const char *FILENAME,
 
 #define FINISH_BUS_HANDLING						\
 	write32( ARM_GPIO_GPCLR0, bCTRL257 );		\
+	FIQ_STATS_EXIT								\
 	RESET_CPU_CYCLE_COUNTER					
 
 #define OUTPUT_LATCH_AND_FINISH_BUS_HANDLING	\
 	write32( ARM_GPIO_GPCLR0, bCTRL257 );		\
 	outputLatch();								\
+	FIQ_STATS_EXIT								\
 	RESET_CPU_CYCLE_COUNTER					
 
 #define NO_IO12_ACCESS		((g3 & bIO1) && (g3 & bIO2))
@@ -0,0 +1,264 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ hvscformat.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - binary indices of the HVSC databases (song lengths, STIL), built on the host
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _hvscformat_h
+#define _hvscformat_h
+
+//
+// parsing the HVSC text databases on the RPi is far too slow, Tools/hvscidx converts them once to sorted binary indices
+// which are searched directly on the SD card (only the header and the bucket table are kept in RAM).
+//
+// song lengths, SD:C64/songlengths.idx, from DOCUMENTS/Songlengths.md5 (little endian):
+//   0   'S' 'K' 'S' 'L'
+//   4   version (HVSC_SL_VERSION)
+//   8   number of tunes
+//   12  stamp: FNV-1a of Songlengths.md5, changes with every HVSC update (e.g. part of the PSID cache key)
+//   16  offset and size of the lengths (4 bytes each)
+//   24  reserved (0)
+//   32  bucket table: HVSC_BUCKETS + 1 entries (4 bytes), index of the first tune whose MD5 starts with the bucket number
+//       (upper 12 bits), the last one is the number of tunes
+//   ..  tunes: sorted by MD5, HVSC_SL_ENTRY_SIZE bytes each: MD5 (16 bytes), offset of its lengths (4 bytes)
+//   ..  lengths: per tune the number of subtunes (2 bytes) followed by the length of each subtune in seconds (2 bytes)
+//
+// the MD5 is the one of the complete .sid file (as used by Songlengths.md5 since HVSC #68)
+//
+// STIL, SD:C64/stil.idx, from DOCUMENTS/STIL.txt which is copied to SD:C64/STIL.txt as well:
+//   0   'S' 'K' 'S' 'T'
+//   4   version (HVSC_STIL_VERSION)
+//   8   number of entries
+//   12  stamp: FNV-1a of STIL.txt
+//   16  size of STIL.txt, the index is ignored if the file on the SD card has a different size
+//   20  reserved (0)
+//   32  bucket table as above (upper 12 bits of the hash)
+//   ..  entries: sorted by hash, HVSC_STIL_ENTRY_SIZE bytes each: hash of the path (8 bytes, big endian such that the byte
+//       order is the numeric order), offset and length of the entry text in STIL.txt (4 bytes each)
+//
+// the hash is the 64 bit FNV-1a of the HVSC path (e.g. "/musicians/h/hubbard_rob/commando.sid") in lower case and with
+// slashes, directories (global comments) end with a slash. The entry text are the lines following the path up to the
+// next empty line.
+//
+// header only, Tools/hvscidx includes it as well (with HVSC_HOST defined, i.e. without the reader for the SD card)
+//
+#define HVSC_HEADER_SIZE		32
+
+#define HVSC_SL_HEADER_SIZE		HVSC_HEADER_SIZE
+#define HVSC_SL_VERSION			1
+#define HVSC_SL_ENTRY_SIZE		20
+
+#define HVSC_STIL_HEADER_SIZE	HVSC_HEADER_SIZE
+#define HVSC_STIL_VERSION		1
+#define HVSC_STIL_ENTRY_SIZE	16
+
+#define HVSC_BUCKET_BITS		12
+#define HVSC_BUCKETS			( 1 << HVSC_BUCKET_BITS )
+
+static inline unsigned int hvscRead32( const unsigned char *p )
+{
+	return p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( (unsigned int)p[ 3 ] << 24 );
+}
+
+static inline unsigned int hvscRead16( const unsigned char *p )
+{
+	return p[ 0 ] | ( p[ 1 ] << 8 );
+}
+
+static inline unsigned int hvscBucket( const unsigned char *md5 )
+{
+	return ( md5[ 0 ] << 4 ) | ( md5[ 1 ] >> 4 );
+}
+
+static inline int hvscIsSongLengths( const unsigned char *header )
+{
+	return header[ 0 ] == 'S' && header[ 1 ] == 'K' && header[ 2 ] == 'S' && header[ 3 ] == 'L' && hvscRead32( &header[ 4 ] ) == HVSC_SL_VERSION;
+}
+
+static inline int hvscIsStil( const unsigned char *header )
+{
+	return header[ 0 ] == 'S' && header[ 1 ] == 'K' && header[ 2 ] == 'S' && header[ 3 ] == 'T' && hvscRead32( &header[ 4 ] ) == HVSC_STIL_VERSION;
+}
+
+// the key of an entry (MD5 or path hash) is stored at its beginning, the bucket is taken from its upper 12 bits
+static inline int hvscCompareKey( const unsigned char *a, const unsigned char *b, unsigned int keySize )
+{
+	for ( unsigned int i = 0; i < keySize; i++ )
+		if ( a[ i ] != b[ i ] )
+			return a[ i ] < b[ i ] ? -1 : 1;
+	return 0;
+}
+
+static inline int hvscCompareMD5( const unsigned char *a, const unsigned char *b )
+{
+	return hvscCompareKey( a, b, 16 );
+}
+
+// path hash, stored as key (big endian)
+static inline void hvscPathKey( const char *path, unsigned char *key )
+{
+	unsigned long long h = 14695981039346656037ull;
+	for ( ; *path; path++ )
+	{
+		unsigned char c = *path == '\\' ? '/' : *path;
+		if ( c >= 'A' && c <= 'Z' ) c += 'a' - 'A';
+		h = ( h ^ c ) * 1099511628211ull;
+	}
+	for ( unsigned int i = 0; i < 8; i++ )
+		key[ i ] = (unsigned char)( h >> ( 56 - i * 8 ) );
+}
+
+// binary search in 'n' consecutive entries, returns the index or -1
+static inline int hvscFindEntry( const unsigned char *entries, unsigned int n, unsigned int entrySize, const unsigned char *key, unsigned int keySize )
+{
+	int lo = 0, hi = (int)n - 1;
+	while ( lo <= hi )
+	{
+		int m = ( lo + hi ) >> 1;
+		int c = hvscCompareKey( &entries[ m * entrySize ], key, keySize );
+		if ( c == 0 )
+			return m;
+		if ( c < 0 ) lo = m + 1; else hi = m - 1;
+	}
+	return -1;
+}
+
+#ifndef HVSC_HOST
+
+#include <fatfs/ff.h>
+
+//
+// reading an index on the SD card: header and bucket table are read when it is opened the first time, the entries of
+// one bucket (about 15 for the complete HVSC) are searched in chunks in case there are more
+//
+#define HVSC_INDEX_UNKNOWN		0
+#define HVSC_INDEX_OK			1
+#define HVSC_INDEX_MISSING		2
+
+#define HVSC_INDEX_CHUNK		64		// entries read at once
+
+typedef struct
+{
+	const char		*name;
+	unsigned int	entrySize, keySize;
+	// checks the header (and anything else the index depends on)
+	int				(*isValid)( const unsigned char *header );
+
+	unsigned int	state;
+	unsigned char	header[ HVSC_HEADER_SIZE ];
+	unsigned int	bucket[ HVSC_BUCKETS + 1 ];
+	unsigned char	entries[ HVSC_INDEX_CHUNK * HVSC_SL_ENTRY_SIZE ];	// the larger of both entry sizes
+} HVSCINDEX;
+
+static inline int hvscIndexRead( FIL *file, unsigned int ofs, void *data, unsigned int size )
+{
+	unsigned int nBytesRead;
+	return f_lseek( file, ofs ) == FR_OK && f_read( file, data, size, &nBytesRead ) == FR_OK && nBytesRead == size;
+}
+
+// opens the index (SD card mounted), returns 0 if it is missing or invalid -- which is remembered
+static inline int hvscIndexOpen( HVSCINDEX *index, FIL *file )
+{
+	if ( index->state == HVSC_INDEX_MISSING )
+		return 0;
+
+	if ( f_open( file, index->name, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+	{
+		index->state = HVSC_INDEX_MISSING;
+		return 0;
+	}
+
+	if ( index->state == HVSC_INDEX_UNKNOWN )
+	{
+		unsigned char table[ ( HVSC_BUCKETS + 1 ) * 4 ];
+
+		if ( !hvscIndexRead( file, 0, index->header, HVSC_HEADER_SIZE ) || !index->isValid( index->header ) ||
+			 !hvscIndexRead( file, HVSC_HEADER_SIZE, table, sizeof( table ) ) )
+		{
+			f_close( file );
+			index->state = HVSC_INDEX_MISSING;
+			return 0;
+		}
+
+		for ( unsigned int i = 0; i <= HVSC_BUCKETS; i++ )
+			index->bucket[ i ] = hvscRead32( &table[ i * 4 ] );
+
+		index->state = HVSC_INDEX_OK;
+	}
+
+	return 1;
+}
+
+// stamp of the index (offset 12 in both headers), 0 if there is none; mounts the SD card the first time
+static inline unsigned int hvscIndexStamp( HVSCINDEX *index )
+{
+	if ( index->state == HVSC_INDEX_UNKNOWN )
+	{
+		FATFS m_FileSystem;
+		if ( f_mount( &m_FileSystem, "SD:", 1 ) != FR_OK )
+			return 0;
+
+		FIL file;
+		if ( hvscIndexOpen( index, &file ) )
+			f_close( &file );
+
+		f_mount( 0, "SD:", 0 );
+	}
+
+	return index->state == HVSC_INDEX_OK ? hvscRead32( &index->header[ 12 ] ) : 0;
+}
+
+// searches the entry with 'key' in the opened index, returns a pointer to it (valid until the next search) or 0
+static inline const unsigned char *hvscIndexFind( HVSCINDEX *index, FIL *file, const unsigned char *key )
+{
+	const unsigned int entriesOfs = HVSC_HEADER_SIZE + ( HVSC_BUCKETS + 1 ) * 4;
+	const unsigned int entrySize = index->entrySize;
+
+	unsigned int first = index->bucket[ hvscBucket( key ) ];
+	unsigned int last = index->bucket[ hvscBucket( key ) + 1 ];
+
+	while ( first < last )
+	{
+		unsigned int n = last - first < HVSC_INDEX_CHUNK ? last - first : HVSC_INDEX_CHUNK;
+		if ( !hvscIndexRead( file, entriesOfs + first * entrySize, index->entries, n * entrySize ) )
+			break;
+
+		int idx = hvscFindEntry( index->entries, n, entrySize, key, index->keySize );
+		if ( idx >= 0 )
+			return &index->entries[ idx * entrySize ];
+
+		// sorted: the entry can only be in a later chunk
+		if ( hvscCompareKey( &index->entries[ ( n - 1 ) * entrySize ], key, index->keySize ) > 0 )
+			break;
+		first += n;
+	}
+
+	return 0;
+}
+
+#endif
+
+#endif
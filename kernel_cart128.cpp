@@ -69,16 +69,8 @@ void CKernelCart128::Run( void )
 
 		if ( !tftLoadBackgroundTGA( (char*)DRIVE, fn ) )
 		{
-			tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-			int w, h; 
 			extern char FILENAME_LOGO_RGBA[128];
-			extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-			if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-			{
-				tftBlendRGBA( tempTGA, tftBackground, 0 );
-			}
+			tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 			tftCopyBackground2Framebuffer();
 			
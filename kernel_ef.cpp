@@ -28,6 +28,7 @@
  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "kernel_ef.h"
+#include "workset.h"
 
 // use this, it you want LEDs to show EF accesses
 #define LED
@@ -383,6 +384,54 @@ __attribute__( ( always_inline ) ) inline void prefetchHeuristic8()
 	FORCE_READ_LINEAR( ef.flashBank, 8192 )
 }
 
+//
+// bank residency model for cartridges which do not fit into the L2 cache (e.g. 1 MB EasyFlash):
+// a bank gets a stamp when it is fetched from DRAM, the clock only advances with such fetches. A bank counts as resident
+// as long as fewer than efResidentBanks other banks have been fetched since -- this is FIFO-like and errs on the side of
+// "cold", i.e. at worst we stall the C64 for a few cycles without need.
+//
+#define EF_RESIDENT_BYTES		( 256 * 1024 )		// half of the L2, the rest is kept for the kernel, the handler, EF-RAM etc.
+#define EF_MAX_BANKS			128
+
+static u32 efBankStamp[ EF_MAX_BANKS ] AAA;
+static u32 efBankClock, efResidentBanks, efBankSize;
+
+static void efResidencyReset( u32 bankSize )
+{
+	memset( efBankStamp, 0, sizeof( efBankStamp ) );
+	efBankSize = bankSize;
+	efResidentBanks = EF_RESIDENT_BYTES / bankSize;
+	efBankClock = efResidentBanks;					// stamp 0 = never fetched = cold
+}
+
+// returns true if the bank has to be fetched from DRAM, and marks it as resident
+__attribute__( ( always_inline ) ) inline bool efBankIsCold( u32 bank )
+{
+	if ( efBankClock - efBankStamp[ bank ] < efResidentBanks )
+		return false;
+	efBankStamp[ bank ] = ++ efBankClock;
+	return true;
+}
+
+// called on a bank switch (flashBank already points to the new bank): warm banks only get a hint for the prefetcher,
+// cold banks are fetched now while the C64 is stalled by a DMA for NUM_DMA_CYCLES
+__attribute__( ( always_inline ) ) inline void prefetchBankSwitch( u32 bank, u64 armCycleCounter )
+{
+	if ( efBankIsCold( bank ) )
+	{
+		WAIT_UP_TO_CYCLE( WAIT_TRIGGER_DMA ); 
+		CLR_GPIO( bDMA ); 
+		ef.releaseDMA = NUM_DMA_CYCLES;
+
+		// the prefetch hints are not reliable enough: touch one word per cache line (one load per line, not per byte)
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, efBankSize, CACHE_PRELOADL2KEEP )
+		__attribute__((unused)) volatile u32 forceRead;
+		for ( register u32 i = 0; i < efBankSize; i += 64 )
+			forceRead = *(u32*)&ef.flashBank[ i ];
+	} else
+		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, efBankSize, CACHE_PRELOADL2KEEP )
+}
+
 
 __attribute__( ( always_inline ) ) inline void prefetchComplete()
 {
@@ -401,6 +450,18 @@ __attribute__( ( always_inline ) ) inline void prefetchComplete()
 		CACHE_PRELOAD_DATA_CACHE( kernalROM, 8192, CACHE_PRELOADL2KEEP );
 }
 
+// preloads what the handler used during a previous launch (see workset.h)
+__attribute__( ( always_inline ) ) inline void prefetchWorkingSet()
+{
+	wsPreload( ef.flash_cacheoptimized );
+
+	CACHE_PRELOAD_DATA_CACHE( ef.ram, 256, CACHE_PRELOADL1KEEP )
+	FORCE_READ_LINEAR32( ef.ram, 256 )
+
+	if ( ef.hasKernal )
+		CACHE_PRELOAD_DATA_CACHE( kernalROM, 8192, CACHE_PRELOADL2KEEP );
+}
+
 static u32 LED_INIT1_HIGH;	
 static u32 LED_INIT1_LOW;	
 static u32 LED_INIT2_HIGH;	
@@ -440,20 +501,36 @@ static void initScreenAndLEDCodes()
 
 static bool irqFallingEdge = true;
 
-#ifdef COMPILE_MENU
+#define TRIGGER_CAN_ASSERT_DMA ( ef.dmaCountWrites == 3 ? true : false )
+#define TRIGGER_DMA_COUNT_WRITES { 	if ( CPU_WRITES_TO_BUS ) ef.dmaCountWrites ++; else ef.dmaCountWrites = 0; }
+#define TRIGGER_DMA( cycles ) { ef.triggerDMA = cycles; }
+#define	HANDLE_DMA_TRIGGER_RELEASE \
+	if ( ef.triggerDMA ) {							\
+		ef.releaseDMA = ef.triggerDMA;				\
+		ef.triggerDMA = 0;							\
+		WAIT_UP_TO_CYCLE( WAIT_TRIGGER_DMA );		\
+		CLR_GPIO( bDMA );							\
+		setLatchFIQ( LATCH_LED0 );					\
+	} else											\
+	if ( ef.releaseDMA > 0 && --ef.releaseDMA == 0 )\
+	{												\
+		WAIT_UP_TO_CYCLE( WAIT_RELEASE_DMA );		\
+		SET_GPIO( bDMA );							\
+		clrLatchFIQ( LATCH_LED0 );					\
+	}	
+
+
+#define HANDLE_KERNAL_IF_REQUIRED \
+	if ( ef.hasKernal && ROMH_ACCESS && KERNAL_ACCESS ) {	\
+		WRITE_D0to7_TO_BUS( kernalROM[ GET_ADDRESS ] );		\
+		FINISH_BUS_HANDLING									\
+		return;												\
+	}
 
-static void KernelEFFIQHandler_nobank( void *pParam );
-static void KernelEFFIQHandler_Zaxxon( void *pParam );
-static void KernelEFFIQHandler_Prophet( void *pParam );
-static void KernelEFFIQHandler_Ocean( void *pParam );
-static void KernelEFFIQHandler_RGCD( void *pParam );
-static void KernelEFFIQHandler_GMOD2( void *pParam );
-static void KernelEFFIQHandler_C64GS( void *pParam );
-static void KernelEFFIQHandler_Dinamic( void *pParam );
-static void KernelEFFIQHandler_SimonsBasic( void *pParam );
-static void KernelEFFIQHandler_Comal80( void *pParam );
-static void KernelEFFIQHandler_EpyxFL( void *pParam );
+// bankswitch FIQ handlers generated from the mapper descriptions
+#include "kernel_ef_mappers.h"
 
+#ifdef COMPILE_MENU
 static void KernelEFFIQHandler( void *pParam );
 void KernelEFRun( CGPIOPinFIQ m_InputPin, CKernelMenu *kernelMenu, const char *FILENAME, const char *menuItemStr, const char *FILENAME_KERNAL = NULL )
 #else
@@ -524,16 +601,8 @@ void CKernelEF::Run( void )
 
 		if ( !tftLoadBackgroundTGA( (char*)DRIVE, fn ) )
 		{
-			tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-			int w, h; 
 			extern char FILENAME_LOGO_RGBA[128];
-			extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-			if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-			{
-				tftBlendRGBA( tempTGA, tftBackground, 0 );
-			}
+			tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 			tftCopyBackground2Framebuffer();
 
@@ -628,29 +697,29 @@ void CKernelEF::Run( void )
 	TGPIOInterruptHandler *myHandler = FIQ_HANDLER;
 	#ifdef COMPILE_MENU
 	if ( ef.bankswitchType == BS_NONE )
-		myHandler = KernelEFFIQHandler_nobank;
+		myHandler = KernelEFFIQHandlerT<EFMapperNoBank>;
 	if ( ef.bankswitchType == BS_ZAXXON )
-		myHandler = KernelEFFIQHandler_Zaxxon;
+		myHandler = KernelEFFIQHandlerT<EFMapperZaxxon>;
 	if ( ef.bankswitchType == BS_PROPHET )
-		myHandler = KernelEFFIQHandler_Prophet;
+		myHandler = KernelEFFIQHandlerT<EFMapperProphet>;
 	if ( ef.bankswitchType == BS_FUNPLAY )
 		ef.bankswitchType = BS_MAGICDESK;
 	if ( ef.bankswitchType == BS_OCEAN )
-		myHandler = KernelEFFIQHandler_Ocean;
+		myHandler = KernelEFFIQHandlerT<EFMapperOcean>;
 	if ( ef.bankswitchType == BS_RGCD || ef.bankswitchType == BS_HUCKY )
-		myHandler = KernelEFFIQHandler_RGCD;
+		myHandler = KernelEFFIQHandlerT<EFMapperRGCD>;
 	if ( ef.bankswitchType == BS_GMOD2 )
-		myHandler = KernelEFFIQHandler_GMOD2;
+		myHandler = KernelEFFIQHandlerT<EFMapperGMOD2>;
 	if ( ef.bankswitchType == BS_C64GS )
-		myHandler = KernelEFFIQHandler_C64GS;
+		myHandler = KernelEFFIQHandlerT<EFMapperC64GS>;
 	if ( ef.bankswitchType == BS_DINAMIC )
-		myHandler = KernelEFFIQHandler_Dinamic;
+		myHandler = KernelEFFIQHandlerT<EFMapperDinamic>;
 	if ( ef.bankswitchType == BS_COMAL80 )
-		myHandler = KernelEFFIQHandler_Comal80;
+		myHandler = KernelEFFIQHandlerT<EFMapperComal80>;
 	if ( ef.bankswitchType == BS_EPYXFL )
-		myHandler = KernelEFFIQHandler_EpyxFL;
+		myHandler = KernelEFFIQHandlerT<EFMapperEpyxFL>;
 	if ( ef.bankswitchType == BS_SIMONSBASIC )
-		myHandler = KernelEFFIQHandler_SimonsBasic;
+		myHandler = KernelEFFIQHandlerT<EFMapperSimonsBasic>;
 	#endif
 	m_InputPin.ConnectInterrupt( myHandler, FIQ_PARENT );
 
@@ -703,6 +772,18 @@ void CKernelEF::Run( void )
 	InvalidateInstructionCache();
 
 
+	// working set of a previous launch (see workset.h), or record one
+	bool hasWorkingSet = false;
+	workingSet.recording = 0;
+	if ( ef.bankswitchType == BS_EASYFLASH || ef.bankswitchType == BS_MAGICDESK )
+	{
+		hasWorkingSet = wsLoad( logger, DRIVE, FILENAME, ef.nBanks );
+		if ( !hasWorkingSet && workingSetProfile )
+			wsStartRecording();
+	}
+
+	if ( hasWorkingSet )
+		prefetchWorkingSet(); else
 	if ( ef.flashFitsInCache )
 		prefetchComplete(); else
 		prefetchHeuristic();
@@ -714,10 +795,16 @@ void CKernelEF::Run( void )
 	FORCE_READ_LINEAR32a( &ef, sizeof( EFSTATE ), 65536 );
 	FORCE_READ_LINEAR32a( myHandler, 4096, 65536 );
 
+	if ( hasWorkingSet )
+		prefetchWorkingSet(); else
 	if ( ef.flashFitsInCache )
 		prefetchComplete(); else
 		prefetchHeuristic();
 
+	// prefetchHeuristic has fetched the start bank (and a bit more)
+	efResidencyReset( ef.bankswitchType == BS_MAGICDESK ? 8192 : 16384 );
+	efBankIsCold( ef.reg0 );
+
 	// ready to go...
 
 	if ( ef.hasKernal )
@@ -747,6 +834,12 @@ void CKernelEF::Run( void )
 			writeFile( logger, DRIVE, fn, m93c86_data, 2048 );
 		}
 
+		if ( workingSet.recording && ef.c64CycleCount > WS_PROFILE_CYCLES )
+		{
+			workingSet.recording = 0;
+			wsSave( logger, DRIVE, FILENAME, ef.nBanks );
+		}
+
 		if ( ef.mainloopCount++ > 10000 && ef.eapiCRTModified ) 
 		{
 			writeChanges2CRTFile( logger, (char*)DRIVE, (char*)FILENAME, (u8*)ef.flash_cacheoptimized, false );
@@ -772,874 +865,162 @@ void CKernelEF::Run( void )
 }
 
 
-#define TRIGGER_CAN_ASSERT_DMA ( ef.dmaCountWrites == 3 ? true : false )
-#define TRIGGER_DMA_COUNT_WRITES { 	if ( CPU_WRITES_TO_BUS ) ef.dmaCountWrites ++; else ef.dmaCountWrites = 0; }
-#define TRIGGER_DMA( cycles ) { ef.triggerDMA = cycles; }
-#define	HANDLE_DMA_TRIGGER_RELEASE \
-	if ( ef.triggerDMA ) {							\
-		ef.releaseDMA = ef.triggerDMA;				\
-		ef.triggerDMA = 0;							\
-		WAIT_UP_TO_CYCLE( WAIT_TRIGGER_DMA );		\
-		CLR_GPIO( bDMA );							\
-		setLatchFIQ( LATCH_LED0 );					\
-	} else											\
-	if ( ef.releaseDMA > 0 && --ef.releaseDMA == 0 )\
-	{												\
-		WAIT_UP_TO_CYCLE( WAIT_RELEASE_DMA );		\
-		SET_GPIO( bDMA );							\
-		clrLatchFIQ( LATCH_LED0 );					\
-	}	
-
-
-#define HANDLE_KERNAL_IF_REQUIRED \
-	if ( ef.hasKernal && ROMH_ACCESS && KERNAL_ACCESS ) {	\
-		WRITE_D0to7_TO_BUS( kernalROM[ GET_ADDRESS ] );		\
-		FINISH_BUS_HANDLING									\
-		return;												\
-	}
 
 
-//#ifdef COMPILE_MENU
-#if 1
-static void KernelEFFIQHandler_Prophet( void *pParam )
+#if 0
+this is an example of how to slow down the C64 using DMA
+static void KernelEFFIQHandler_nobank( void *pParam )
 {
 	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
 
 	START_AND_READ_ADDR0to7_RW_RESET_CS
 
-	addr = GET_ADDRESS0to7 << 5;
-	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
-
 	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
 
 	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
 
 	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
+	static int firstByte = 0;
+	//
+	// starting from here: CPU communication
+	//
+	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
 	{
-		D = ef.flashBank[ addr ];
+		D = *(u32*)&flashBankR[ addr * 2 ];
+		if ( ROMH_ACCESS )
+			D >>= 8; 
+
 		WRITE_D0to7_TO_BUS( D )
-	} else
-	if ( CPU_WRITES_TO_BUS && IO2_ACCESS && GET_IO12_ADDRESS == 0 )
-	{
-		READ_D0to7_FROM_BUS( D )
-		setLatchFIQ( LATCH_LED0 );
+		firstByte = 1;
 
-		if ( ( D >> 5 ) & 1 )
-		{ // cartridge off 
-			SET_GPIO( bGAME | bEXROM );
-		} else
-		{ // cartridge on
-			SETCLR_GPIO( bGAME, bEXROM );
-		}
+		goto cleanup;
+	}
 
-		ef.reg0 = D & 0x1f;
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-	} 
-		
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+	TRIGGER_DMA_COUNT_WRITES
+
+	static int bremse = 0;
+	static int triggerDMA = 0;
+	if ( firstByte )
+	if ( ++bremse > 100000 && TRIGGER_CAN_ASSERT_DMA )
+	{
+		TRIGGER_DMA( 50000 )
+		bremse = 0;
+		goto cleanup;
+	}
+
+	// reset handling: when button #2 is pressed together with #1 then the EF ram is erased, DMA is released as well
+	if ( !( g2 & bRESET ) ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
 	
 	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
 	{
 		ef.resetCounter = 0x8000000;
-		ef.releaseDMA = 0;
-		ef.reg0 = 0;
-		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+		SET_GPIO( bDMA | bNMI ); 
 		FINISH_BUS_HANDLING
 		return;
 	}
 
+cleanup:
+	HANDLE_DMA_TRIGGER_RELEASE
+
 	//CLEAR_LEDS_EVERY_8K_CYCLES
-	static u32 cycleCount = 0;
+	/*static u32 cycleCount = 0;
 	if ( !((++cycleCount)&8191) )
-		clrLatchFIQ( LATCH_LED0 );
+		clrLatchFIQ( LATCH_LED0 );*/
 
 	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
 }
 #endif
 
 
-static volatile u32 forceRead; 
 
-static void KernelEFFIQHandler_GMOD2( void *pParam )
+#ifdef COMPILE_MENU
+static void KernelEFFIQHandler( void *pParam )
+#else
+void CKernelEF::FIQHandler (void *pParam)
+#endif
 {
 	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
 
+	// after this call we have some time (until signals are valid, multiplexers have switched, the RPi can/should read again)
+	//START_AND_READ_ADDR0to7_RW_RESET_CS
 	START_AND_READ_ADDR0to7_RW_RESET_CS
 
+	// we got the A0..A7 part of the address which we will access
 	addr = GET_ADDRESS0to7 << 5;
-	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
 
-	extern int m93c86_addr;
-	extern uint8_t m93c86_data[M93C86_SIZE];
-	CACHE_PRELOADL2STRMW( &m93c86_data[ m93c86_addr * 2 ] );
+	CACHE_PRELOADL2STRM( &flashBankR[ addr * 2 ] );
+	CACHE_PRELOADL1KEEP( &ef.ram[ 0 ] );
+	CACHE_PRELOADL1KEEP( &ef.ram[ 64 ] );
+	CACHE_PRELOADL1KEEP( &ef.ram[ 128 ] );
+	CACHE_PRELOADL1KEEP( &ef.ram[ 192 ] );
 
 	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
 
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	ef.mainloopCount = 0;
-
-	TRIGGER_DMA_COUNT_WRITES
-
-	addr = GET_ADDRESS_CACHEOPT;
-	
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
-	{
-		D = ef.flashBank[ addr ];
-		WRITE_D0to7_TO_BUS( D )
-	} else
-	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
-	{
-		if (ef.eeprom_cs) {
-			D = m93c86_read_data() << 7;
-			WRITE_D0to7_TO_BUS( D )
-		} else
-			WRITE_D0to7_TO_BUS( 0 )
-	} else
-	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	//
+	//
+	//
+	if ( VIC_HALF_CYCLE )
 	{
-		READ_D0to7_FROM_BUS( D )
+		WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+//		READ_ADDR0to7_RW_RESET_CS_AND_MULTIPLEX
+//		WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA_VIC2
 
-		if ( ( D & 0xc0 ) == 0xc0 ) {
-			SETCLR_GPIO( bEXROM, bGAME ); 
-		} else if ( ( D & 0x40 ) == 0x00 ) {
-			SETCLR_GPIO( bGAME, bEXROM ); 
-		} else if ( ( D & 0x40 ) == 0x40 ) {
-			SET_GPIO( bGAME | bEXROM ); 
-		}
-		ef.eeprom_cs = ( D >> 6 ) & 1;
-		ef.eeprom_data = ( D >> 4 ) & 1;
-		ef.eeprom_clock = ( D >> 5 ) & 1;
-		m93c86_write_select( (uint8_t)ef.eeprom_cs );
-		if ( ef.eeprom_cs ) {
-			m93c86_write_data( (uint8_t)( ef.eeprom_data ) );
-			m93c86_write_clock( (uint8_t)( ef.eeprom_clock ) );
-		}
+		addr |= GET_ADDRESS8to12;
 
-		if ( ef.reg0 != (D & 0x3f) )
+		if ( ROML_OR_ROMH_ACCESS )
 		{
-			ef.reg0 = D & 0x3f;
-			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
-			CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+			// get both ROML and ROMH with one read
+			D = *(u32*)&flashBankR[ addr * 2 ];
+			if ( ROMH_ACCESS ) D >>= 8;
+			WRITE_D0to7_TO_BUS_VIC( D )
+			setLatchFIQ( LED_ROM_ACCESS );
+			WS_RECORD( (u32)( &flashBankR[ addr * 2 ] - ef.flash_cacheoptimized ) )
+		} else
+		if ( IO2_ACCESS && ( ef.bankswitchType == BS_EASYFLASH ) )
+		{
+			WRITE_D0to7_TO_BUS_VIC( ef.ram[ GET_IO12_ADDRESS ] );
+			setLatchFIQ( LED_IO2 );
+		} else
+		if ( IO1_ACCESS && ( ef.bankswitchType == BS_EASYFLASH ) )
+		{
+			WRITE_D0to7_TO_BUS_VIC( easyflash_IO1_Read( GET_IO12_ADDRESS ) );
+			setLatchFIQ( LED_IO1 );
 		}
-	} 
 
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		ef.releaseDMA = 0;
-		ef.reg0 = 0;
-		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
 		FINISH_BUS_HANDLING
 		return;
-	}
-
-	HANDLE_DMA_TRIGGER_RELEASE
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-static void KernelEFFIQHandler_Ocean( void *pParam )
-{
-	register u32 D, addr;
+	}  
 
-	START_AND_READ_ADDR0to7_RW_RESET_CS
+//	if ( modeC128 && VIC_HALF_CYCLE )
+//		WAIT_CYCLE_MULTIPLEXER += 15;
+	
+	ef.mainloopCount = 0;
 
-	addr = GET_ADDRESS0to7 << 5;
-	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
+	// read the rest of the signals
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
 
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+//	if ( modeC128 && VIC_HALF_CYCLE )
+//		WAIT_CYCLE_MULTIPLEXER -= 15;
 
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+	// make our address complete
+	addr |= GET_ADDRESS8to12;
 
-	addr = GET_ADDRESS_CACHEOPT;
 
-	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
-	{
-		D = ef.flashBank[ addr ];
-		WRITE_D0to7_TO_BUS( D )
-	} 
-	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
+	// VIC2 read during badline?
+	if ( VIC_BADLINE )
 	{
-		READ_D0to7_FROM_BUS( D )
-		setLatchFIQ( LATCH_LED0 );
-		ef.reg0 = D & 0x3f;
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-	} 
+		if ( !ef.LONGBOARD )
+			READ_ADDR8to12_ROMLH_IO12_BA
 
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		ef.releaseDMA = 0;
-		ef.reg0 = 0;
-		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-		if ( ef.nBanks > 32 )
-			{SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );} else
-			{SETCLR_GPIO( bDMA | bNMI, bEXROM | bGAME );} 
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	//CLEAR_LEDS_EVERY_8K_CYCLES
-	static u32 cycleCount = 0;
-	if ( !((++cycleCount)&8191) )
-		clrLatchFIQ( LATCH_LED0 );
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-static void KernelEFFIQHandler_RGCD( void *pParam )
-{
-	register u32 D, addr;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	addr = GET_ADDRESS0to7 << 5;
-	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS && !ef.reg2 )
-	{
-		D = ef.flashBank[ addr ];
-		WRITE_D0to7_TO_BUS( D )
-	} 
-
-	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
-	{
-		READ_D0to7_FROM_BUS( D )
-		setLatchFIQ( LATCH_LED0 );
-		if ( D & 8 )
-		{
-			ef.reg2 = 1;
-			SET_GPIO( bDMA | bNMI | bGAME | bEXROM );
-		}
-		D &= 7;
-		if ( ef.bankswitchType == BS_HUCKY )
-			ef.reg0 = (D ^ 7) & (ef.nBanks - 1); else
-			ef.reg0 = D & (ef.nBanks - 1); 
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-	} 
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		ef.releaseDMA = 0;
-		ef.reg0 = ef.reg2 = 0;
-		if ( ef.bankswitchType == BS_HUCKY )
-			ef.reg0 = 7 & (ef.nBanks - 1);
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-		SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	//CLEAR_LEDS_EVERY_8K_CYCLES
-	static u32 cycleCount = 0;
-	if ( !((++cycleCount)&8191) )
-		clrLatchFIQ( LATCH_LED0 );
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-static void KernelEFFIQHandler_Zaxxon( void *pParam )
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-	register u8 *bank0 = &ef.flash_cacheoptimized[ 0 ];
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
-	{
-		D = *(u8*)&bank0[ (addr&0b1111111101111) * 2 + 0 ];
-		ef.reg0 = GET_ADDRESS & 0x1000 ? 1 : 0;
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
-		WRITE_D0to7_TO_BUS( D )
-	} else
-	if ( CPU_READS_FROM_BUS && ROMH_ACCESS )
-	{
-		D = *(u8*)&flashBankR[ ( addr & 0x3fff ) * 2 + 1 ];
-		WRITE_D0to7_TO_BUS( D )
-	} 
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		SET_GPIO( bDMA | bNMI ); 
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-static void KernelEFFIQHandler_C64GS( void *pParam )
-{
-	register u32 D, addr;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	addr = GET_ADDRESS0to7 << 5;
-	CACHE_PRELOADL2STRM( &ef.flashBank[ addr ] );
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
-	{
-		D = ef.flashBank[ addr ];
-		WRITE_D0to7_TO_BUS( D )
-	} else
-
-	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
-	{
-		setLatchFIQ( LATCH_LED0 | LATCH_LED1 );
-		ef.reg0 = 0;
-		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-	} else
-
-	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
-	{
-		READ_D0to7_FROM_BUS( D )
-		setLatchFIQ( LATCH_LED0 | LATCH_LED1 );
-		ef.reg0 = GET_IO12_ADDRESS & 0x3f;
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
-		CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
-	} 
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		ef.releaseDMA = 0;
-		ef.reg0 = 0;
-		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
-		clrLatchFIQ( LATCH_LED1 );
-		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	if ( ef.releaseDMA > 0 && --ef.releaseDMA == 0 )
-	{
-		WAIT_UP_TO_CYCLE( WAIT_RELEASE_DMA ); 
-		SET_GPIO( bDMA ); 
-		clrLatchFIQ( LATCH_LED1 );
-	}
-
-	//CLEAR_LEDS_EVERY_8K_CYCLES
-	static u32 cycleCount = 0;
-	if ( !((++cycleCount)&8191) )
-		clrLatchFIQ( LATCH_LED0 );
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-
-static void KernelEFFIQHandler_Dinamic( void *pParam )
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
-	{
-		D = *(u32*)&flashBankR[ addr * 2 ];
-
-		WRITE_D0to7_TO_BUS( D )
-	} else
-
-	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
-	{
-		addr = GET_IO12_ADDRESS;
-		if ( ( addr & 0x0f ) == addr )
-		{
-			ef.reg0 = addr & 0x0f;
-			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
-		}
-	} 
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		SET_GPIO( bDMA | bNMI ); 
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-
-static void KernelEFFIQHandler_Comal80( void *pParam )
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
-	{
-		D = *(u32*)&flashBankR[ addr * 2 ];
-		if ( ROMH_ACCESS )
-			D >>= 8; 
-
-		WRITE_D0to7_TO_BUS( D )
-	} else
-
-	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
-	{
-		WRITE_D0to7_TO_BUS( ef.reg2 )
-	} else
-
-	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
-	{
-		READ_D0to7_FROM_BUS( D )
-
-		ef.reg2 = D & 0xc7;
-		ef.reg0 = D & 3;
-		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
-
-		if ( D & 0x40 )
-			{SET_GPIO( bEXROM | bGAME );} else
-			{CLR_GPIO( bEXROM | bGAME );}
-	}
-
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		SET_GPIO( bDMA | bNMI ); 
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-static void KernelEFFIQHandler_SimonsBasic( void *pParam )
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
-	{
-		D = *(u32*)&flashBankR[ addr * 2 ];
-		if ( ROMH_ACCESS )
-			D >>= 8; 
-
-		WRITE_D0to7_TO_BUS( D )
-	} else
-
-	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
-	{
-		SETCLR_GPIO( bGAME, bEXROM );
-	} else
-
-	if ( CPU_WRITES_TO_BUS && IO1_ACCESS )
-	{
-		CLR_GPIO( bGAME | bEXROM );
-	}
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		SETCLR_GPIO( bDMA | bNMI, bGAME | bEXROM );
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-
-static void KernelEFFIQHandler_EpyxFL( void *pParam )
-{
-	register u32 D, addr;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	if ( CPU_READS_FROM_BUS && ROML_ACCESS )
-	{
-		D = *(u32*)&ef.flash_cacheoptimized[ addr * 2 ];
-		epyxDisable = 512 * 2;
-		WRITE_D0to7_TO_BUS( D )
-	} else
-
-	if ( CPU_READS_FROM_BUS && IO2_ACCESS )
-	{
-		addr |= 0b0000000011111; // access 0x1f00 + IO_ADDRESS
-		D = *(u32*)&ef.flash_cacheoptimized[ addr * 2 ];
-		WRITE_D0to7_TO_BUS( D )
-	} else
-
-	if ( CPU_READS_FROM_BUS && IO1_ACCESS )
-	{
-		SETCLR_GPIO( bGAME, bEXROM );
-		epyxDisable = 512 * 2;
-		WRITE_D0to7_TO_BUS( 0 )
-	} 
-
-	if ( CPU_RESET )
-	{
-		epyxDisable = 512 * 2;
-		SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );
-	} else
-	if ( epyxDisable && --epyxDisable == 0 )
-    {
-		SET_GPIO( bEXROM | bGAME );
-    }
-
-	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-
-
-#if 0
-this is an example of how to slow down the C64 using DMA
-static void KernelEFFIQHandler_nobank( void *pParam )
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-	static int firstByte = 0;
-	//
-	// starting from here: CPU communication
-	//
-	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
-	{
-		D = *(u32*)&flashBankR[ addr * 2 ];
-		if ( ROMH_ACCESS )
-			D >>= 8; 
-
-		WRITE_D0to7_TO_BUS( D )
-		firstByte = 1;
-
-		goto cleanup;
-	}
-
-	TRIGGER_DMA_COUNT_WRITES
-
-	static int bremse = 0;
-	static int triggerDMA = 0;
-	if ( firstByte )
-	if ( ++bremse > 100000 && TRIGGER_CAN_ASSERT_DMA )
-	{
-		TRIGGER_DMA( 50000 )
-		bremse = 0;
-		goto cleanup;
-	}
-
-	// reset handling: when button #2 is pressed together with #1 then the EF ram is erased, DMA is released as well
-	if ( !( g2 & bRESET ) ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		SET_GPIO( bDMA | bNMI ); 
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-cleanup:
-	HANDLE_DMA_TRIGGER_RELEASE
-
-	//CLEAR_LEDS_EVERY_8K_CYCLES
-	/*static u32 cycleCount = 0;
-	if ( !((++cycleCount)&8191) )
-		clrLatchFIQ( LATCH_LED0 );*/
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-#endif
-
-
-
-
-#ifdef COMPILE_MENU
-static void KernelEFFIQHandler_nobank( void *pParam )
-#else
-void CKernelEF::FIQHandler (void *pParam)
-#endif
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-
-	// after this call we have some time (until signals are valid, multiplexers have switched, the RPi can/should read again)
-	START_AND_READ_ADDR0to7_RW_RESET_CS_NO_MULTIPLEX
-
-	addr = GET_ADDRESS0to7 << 5;
-	CACHE_PRELOADL2KEEP( &flashBankR[ addr * 2 ] );
-
-	if ( VIC_HALF_CYCLE )
-	{
-		// FINETUNED = experimental code to explore VIC2-timings
-		#ifdef FINETUNED
-		WAIT_UP_TO_CYCLE( 100 );
-		g2 = read32( ARM_GPIO_GPLEV0 );	
-		SET_GPIO( bCTRL257 );	
-		register u32 t;
-		READ_CYCLE_COUNTER( t );
-		WAIT_UP_TO_CYCLE_AFTER( 75+50, t );
-		g3 = read32( ARM_GPIO_GPLEV0 );	
-		#else
-		READ_ADDR0to7_RW_RESET_CS_AND_MULTIPLEX
-		WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA_VIC2
-		#endif
-
-		if ( ROMH_ACCESS ) 
-		{
-			D = *(u8*)&flashBankR[ GET_ADDRESS_CACHEOPT * 2 + 1 ];
-			WRITE_D0to7_TO_BUS_VIC( D )
-		}
-
-		FINISH_BUS_HANDLING
-		return;
-	}  
-
-	SET_GPIO( bCTRL257 );	
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	// read the rest of the signals
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-	addr = GET_ADDRESS_CACHEOPT;
-
-	// VIC2 read during badline?
-	if ( VIC_BADLINE )
-	{
-		if ( !ef.LONGBOARD )
-			READ_ADDR8to12_ROMLH_IO12_BA
-
-		if ( ROMH_ACCESS ) 
-		{
-			D = *(u8*)&flashBankR[ addr * 2 + 1 ];
-			WRITE_D0to7_TO_BUS_BADLINE( D )
-		}
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-	//
-	// starting from here: CPU communication
-	//
-	if ( CPU_READS_FROM_BUS && ROML_OR_ROMH_ACCESS )
-	{
-		D = *(u32*)&flashBankR[ addr * 2 ];
-		if ( ROMH_ACCESS )
-			D >>= 8; 
-
-		WRITE_D0to7_TO_BUS( D )
-		goto cleanup;
-	}
-
-	// reset handling: when button #2 is pressed together with #1 then the EF ram is erased, DMA is released as well
-	if ( !( g2 & bRESET ) ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
-	
-	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
-	{
-		ef.resetCounter = 0x8000000;
-		SET_GPIO( bDMA | bNMI ); 
-		FINISH_BUS_HANDLING
-		return;
-	}
-
-cleanup:
-
-	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
-}
-
-
-
-
-
-
-
-
-
-
-
-#ifdef COMPILE_MENU
-static void KernelEFFIQHandler( void *pParam )
-#else
-void CKernelEF::FIQHandler (void *pParam)
-#endif
-{
-	register u32 D, addr;
-	register u8 *flashBankR = ef.flashBank;
-
-	// after this call we have some time (until signals are valid, multiplexers have switched, the RPi can/should read again)
-	//START_AND_READ_ADDR0to7_RW_RESET_CS
-	START_AND_READ_ADDR0to7_RW_RESET_CS
-
-	// we got the A0..A7 part of the address which we will access
-	addr = GET_ADDRESS0to7 << 5;
-
-	CACHE_PRELOADL2STRM( &flashBankR[ addr * 2 ] );
-	CACHE_PRELOADL1KEEP( &ef.ram[ 0 ] );
-	CACHE_PRELOADL1KEEP( &ef.ram[ 64 ] );
-	CACHE_PRELOADL1KEEP( &ef.ram[ 128 ] );
-	CACHE_PRELOADL1KEEP( &ef.ram[ 192 ] );
-
-	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
-
-	//
-	//
-	//
-	if ( VIC_HALF_CYCLE )
-	{
-		WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-//		READ_ADDR0to7_RW_RESET_CS_AND_MULTIPLEX
-//		WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA_VIC2
-
-		addr |= GET_ADDRESS8to12;
-
-		if ( ROML_OR_ROMH_ACCESS )
-		{
-			// get both ROML and ROMH with one read
-			D = *(u32*)&flashBankR[ addr * 2 ];
-			if ( ROMH_ACCESS ) D >>= 8;
-			WRITE_D0to7_TO_BUS_VIC( D )
-			setLatchFIQ( LED_ROM_ACCESS );
-		} else
-		if ( IO2_ACCESS && ( ef.bankswitchType == BS_EASYFLASH ) )
-		{
-			WRITE_D0to7_TO_BUS_VIC( ef.ram[ GET_IO12_ADDRESS ] );
-			setLatchFIQ( LED_IO2 );
-		} else
-		if ( IO1_ACCESS && ( ef.bankswitchType == BS_EASYFLASH ) )
-		{
-			WRITE_D0to7_TO_BUS_VIC( easyflash_IO1_Read( GET_IO12_ADDRESS ) );
-			setLatchFIQ( LED_IO1 );
-		}
-
-		FINISH_BUS_HANDLING
-		return;
-	}  
-
-//	if ( modeC128 && VIC_HALF_CYCLE )
-//		WAIT_CYCLE_MULTIPLEXER += 15;
-	
-	ef.mainloopCount = 0;
-
-	// read the rest of the signals
-	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
-
-//	if ( modeC128 && VIC_HALF_CYCLE )
-//		WAIT_CYCLE_MULTIPLEXER -= 15;
-
-	// make our address complete
-	addr |= GET_ADDRESS8to12;
-
-
-	// VIC2 read during badline?
-	if ( VIC_BADLINE )
-	{
-		if ( !ef.LONGBOARD )
-			READ_ADDR8to12_ROMLH_IO12_BA
-
-		if ( ROMH_ACCESS ) 
-		{
-			if ( ef.bankswitchType == BS_MAGICDESK )
-				D = *(u32*)&flashBankR[ addr ]; else
-				D = *(u8*)&flashBankR[ addr * 2 + 1 ];
-			WRITE_D0to7_TO_BUS_BADLINE( D )
-		}
+		if ( ROMH_ACCESS ) 
+		{
+			if ( ef.bankswitchType == BS_MAGICDESK )
+				D = *(u32*)&flashBankR[ addr ]; else
+				D = *(u8*)&flashBankR[ addr * 2 + 1 ];
+			WRITE_D0to7_TO_BUS_BADLINE( D )
+		}
 		FINISH_BUS_HANDLING
 		return;
 	}
@@ -1663,6 +1044,7 @@ void CKernelEF::FIQHandler (void *pParam)
 
 			WRITE_D0to7_TO_BUS( D )
 			setLatchFIQ( LED_ROM_ACCESS );
+			WS_RECORD( (u32)( &flashBankR[ ef.bankswitchType == BS_MAGICDESK ? addr : addr * 2 ] - ef.flash_cacheoptimized ) )
 			goto cleanup;
 		}
 
@@ -1703,14 +1085,9 @@ void CKernelEF::FIQHandler (void *pParam)
 
 				if ( ( GET_IO12_ADDRESS & 2 ) == 0 )
 				{
-					// if the EF-ROM does not fit into the RPi's cache: stall the CPU with a DMA and prefetch the data
+					// if the EF-ROM does not fit into the RPi's cache: prefetch the bank, stall the CPU with a DMA if it is cold
 					if ( !ef.flashFitsInCache )
-					{
-						WAIT_UP_TO_CYCLE( WAIT_TRIGGER_DMA ); 
-						CLR_GPIO( bDMA ); 
-						ef.releaseDMA = NUM_DMA_CYCLES;
-						prefetchHeuristic();
-					}
+						prefetchBankSwitch( ef.reg0, armCycleCounter );
 				} else 
 					setGAMEEXROM();
 			}
@@ -1731,14 +1108,9 @@ void CKernelEF::FIQHandler (void *pParam)
 
 			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
 
-			// if the EF-ROM does not fit into the RPi's cache: stall the CPU with a DMA and prefetch the data
+			// if the EF-ROM does not fit into the RPi's cache: prefetch the bank, stall the CPU with a DMA if it is cold
 			if ( !ef.flashFitsInCache )
-			{
-				WAIT_UP_TO_CYCLE( WAIT_TRIGGER_DMA ); 
-				CLR_GPIO( bDMA ); 
-				ef.releaseDMA = NUM_DMA_CYCLES;
-				prefetchHeuristic();
-			}
+				prefetchBankSwitch( ef.reg0, armCycleCounter );
 
 			setGAMEEXROM();
 		}
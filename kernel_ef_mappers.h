@@ -0,0 +1,567 @@
+/*
+  _________.__    .___      __   .__        __       ___________.__                .__
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __   \_   _____/|  | _____    _____|  |__
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    |    __)  |  | \__  \  /  ___/  |  \
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     |     \   |  |__/ __ \_\___ \|   Y  \
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \    \___  /   |____(____  /____  >___|  /
+        \/         \/    \/     \/       \/     \/        \/              \/     \/     \/
+
+ kernel_ef_mappers.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - Sidekick Flash: bankswitch FIQ handlers generated from mapper descriptions
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _kernel_ef_mappers_h
+#define _kernel_ef_mappers_h
+
+//
+// this file is included by kernel_ef.cpp (and Tools/efbussim) after 'ef', 'epyxDisable' and the bus macros are defined
+//
+// every mapper is described by a traits struct derived from EFMapper: the constants select the building blocks
+// of the FIQ handler, the static functions implement the cartridge registers. KernelEFFIQHandlerT<> puts them
+// together, all constants are known at compile time, i.e. each handler only contains the code its mapper needs.
+//
+// the functions get the bus state (g2, g3) and the cycle counter such that the usual macros can be used
+//
+#define EF_INLINE		static __attribute__( ( always_inline ) ) inline
+#define EF_BUS_ARGS		u32 g2, u32 g3, u64 armCycleCounter
+#define EF_BUS			g2, g3, armCycleCounter
+
+// layout of the flash in ef.flash_cacheoptimized (addresses are always GET_ADDRESS_CACHEOPT)
+#define EF_ROM_8K		0		// 8k banks, ROML and ROMH see the same bank
+#define EF_ROM_16K		1		// 16k banks, ROML and ROMH interleaved (one 32 bit read gets both)
+#define EF_ROM_CUSTOM	2		// mapper provides romRead()
+
+// prefetching of the flash line once A0..A7 are known
+#define EF_PREFETCH_NONE	0
+#define EF_PREFETCH_8K		1
+#define EF_PREFETCH_16K		2
+
+// which IO accesses the mapper reacts to
+#define EF_IO1_READ		1
+#define EF_IO1_WRITE	2
+#define EF_IO2_READ		4
+#define EF_IO2_WRITE	8
+
+// DMA handling at the end of a cycle
+#define EF_DMA_NONE		0
+#define EF_DMA_TRIGGER	1		// HANDLE_DMA_TRIGGER_RELEASE (stall the CPU while e.g. the EEPROM is busy)
+#define EF_DMA_RELEASE	2		// release a DMA asserted by the mapper, LED1 shows it
+
+struct EFMapper
+{
+	static const u32 romLines = 0;					// bROML and/or bROMH
+	static const u32 romLayout = EF_ROM_8K;
+	static const u32 prefetch = EF_PREFETCH_NONE;
+	static const u32 io = 0;						// EF_IO1_READ | ...
+	static const u32 regMask = 0, regAddr = 0;		// IO writes only if ( GET_IO12_ADDRESS & regMask ) == regAddr
+	static const u32 dma = EF_DMA_NONE;
+	static const bool ledClear = false;				// turn off LED0 every 8k cycles
+	static const bool vic = false;					// serve ROMH to the VIC as well (half cycles and badlines)
+
+	EF_INLINE bool romEnabled() { return true; }
+	EF_INLINE u32  romRead( u32 addr, u8 *flashBank, u32 g3 ) { return 0; }
+	EF_INLINE void cycleStart( EF_BUS_ARGS ) {}	// after A0..A7 are known
+	EF_INLINE void cycleBus( EF_BUS_ARGS ) {}		// after all bus signals are known
+	EF_INLINE void io1Read( EF_BUS_ARGS ) {}
+	EF_INLINE void io1Write( EF_BUS_ARGS ) {}
+	EF_INLINE void io2Read( EF_BUS_ARGS ) {}
+	EF_INLINE void io2Write( EF_BUS_ARGS ) {}
+	EF_INLINE void beforeReset( EF_BUS_ARGS ) {}
+	EF_INLINE void reset() {}						// reset line held for more than 3 cycles
+};
+
+// selects an 8k bank and prefetches it
+EF_INLINE void efSelectBank8K( u32 bank )
+{
+	ef.reg0 = bank;
+	ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 ];
+	CACHE_PRELOAD_DATA_CACHE( ef.flashBank, 8192, CACHE_PRELOADL2STRM )
+}
+
+template <class M>
+static void KernelEFFIQHandlerT( void *pParam )
+{
+	register u32 D, addr;
+	register u8 *flashBankR = ef.flashBank;
+
+	// = START_AND_READ_ADDR0to7_RW_RESET_CS, the multiplexer is switched later if we also serve the VIC
+	START_AND_READ_ADDR0to7_RW_RESET_CS_NO_MULTIPLEX
+	if ( !M::vic )
+		write32( ARM_GPIO_GPSET0, bCTRL257 );
+
+	if ( M::prefetch == EF_PREFETCH_8K )
+		CACHE_PRELOADL2STRM( &flashBankR[ GET_ADDRESS0to7 << 5 ] );
+	if ( M::prefetch == EF_PREFETCH_16K )
+		CACHE_PRELOADL2KEEP( &flashBankR[ ( GET_ADDRESS0to7 << 5 ) * 2 ] );
+
+	M::cycleStart( g2, 0, armCycleCounter );		// A8..A12 etc. are not read yet
+
+	if ( M::vic )
+	{
+		if ( VIC_HALF_CYCLE )
+		{
+			READ_ADDR0to7_RW_RESET_CS_AND_MULTIPLEX
+			WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA_VIC2
+
+			if ( ROMH_ACCESS )
+			{
+				D = *(u8*)&flashBankR[ GET_ADDRESS_CACHEOPT * 2 + 1 ];
+				WRITE_D0to7_TO_BUS_VIC( D )
+			}
+
+			FINISH_BUS_HANDLING
+			return;
+		}
+
+		SET_GPIO( bCTRL257 );
+	}
+
+	UPDATE_COUNTERS_MIN( ef.c64CycleCount, ef.resetCounter2 )
+
+	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
+
+	M::cycleBus( EF_BUS );
+
+	addr = GET_ADDRESS_CACHEOPT;
+
+	// VIC2 read during badline?
+	if ( M::vic && VIC_BADLINE )
+	{
+		if ( !ef.LONGBOARD )
+			READ_ADDR8to12_ROMLH_IO12_BA
+
+		if ( ROMH_ACCESS )
+		{
+			D = *(u8*)&flashBankR[ addr * 2 + 1 ];
+			WRITE_D0to7_TO_BUS_BADLINE( D )
+		}
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+	//
+	// starting from here: CPU communication
+	//
+	if ( M::romLines && CPU_READS_FROM_BUS && ( ~g3 & M::romLines ) && M::romEnabled() )
+	{
+		if ( M::romLayout == EF_ROM_8K )
+			D = flashBankR[ addr ]; else
+		if ( M::romLayout == EF_ROM_16K )
+		{
+			D = *(u32*)&flashBankR[ addr * 2 ];
+			if ( ( M::romLines & bROMH ) && ROMH_ACCESS )
+				D >>= 8;
+		} else
+			D = M::romRead( addr, flashBankR, g3 );
+
+		WRITE_D0to7_TO_BUS( D )
+
+		// the VIC-aware handler does not look at the reset line in cycles with ROM reads
+		if ( M::vic )
+			goto cleanup;
+	} else
+	if ( ( M::io & EF_IO1_READ ) && CPU_READS_FROM_BUS && IO1_ACCESS )
+	{
+		M::io1Read( EF_BUS );
+	} else
+	if ( ( M::io & EF_IO2_READ ) && CPU_READS_FROM_BUS && IO2_ACCESS )
+	{
+		M::io2Read( EF_BUS );
+	} else
+	if ( ( M::io & EF_IO1_WRITE ) && CPU_WRITES_TO_BUS && IO1_ACCESS && ( GET_IO12_ADDRESS & M::regMask ) == M::regAddr )
+	{
+		M::io1Write( EF_BUS );
+	} else
+	if ( ( M::io & EF_IO2_WRITE ) && CPU_WRITES_TO_BUS && IO2_ACCESS && ( GET_IO12_ADDRESS & M::regMask ) == M::regAddr )
+	{
+		M::io2Write( EF_BUS );
+	}
+
+	M::beforeReset( EF_BUS );
+
+	if ( CPU_RESET ) { ef.resetCounter ++; } else { ef.resetCounter = 0; }
+
+	if ( ef.resetCounter > 3 && ef.resetCounter < 0x8000000 )
+	{
+		ef.resetCounter = 0x8000000;
+		M::reset();
+		FINISH_BUS_HANDLING
+		return;
+	}
+
+cleanup:
+	if ( M::dma == EF_DMA_TRIGGER )
+	{
+		HANDLE_DMA_TRIGGER_RELEASE
+	}
+
+	if ( M::dma == EF_DMA_RELEASE && ef.releaseDMA > 0 && --ef.releaseDMA == 0 )
+	{
+		WAIT_UP_TO_CYCLE( WAIT_RELEASE_DMA );
+		SET_GPIO( bDMA );
+		clrLatchFIQ( LATCH_LED1 );
+	}
+
+	if ( M::ledClear )
+	{
+		//CLEAR_LEDS_EVERY_8K_CYCLES
+		static u32 cycleCount = 0;
+		if ( !((++cycleCount)&8191) )
+			clrLatchFIQ( LATCH_LED0 );
+	}
+
+	OUTPUT_LATCH_AND_FINISH_BUS_HANDLING
+}
+
+//
+// the mappers
+//
+
+// generic 8k/16k cartridge without bankswitching
+struct EFMapperNoBank : EFMapper
+{
+	static const u32 romLines = bROML | bROMH;
+	static const u32 romLayout = EF_ROM_16K;
+	static const u32 prefetch = EF_PREFETCH_16K;
+	static const bool vic = true;
+
+	EF_INLINE void reset() { SET_GPIO( bDMA | bNMI ); }
+};
+
+// Prophet64: bank and cartridge on/off in $DF00
+struct EFMapperProphet : EFMapper
+{
+	static const u32 romLines = bROML;
+	static const u32 prefetch = EF_PREFETCH_8K;
+	static const u32 io = EF_IO2_WRITE;
+	static const u32 regMask = 0xff, regAddr = 0x00;
+	static const bool ledClear = true;
+
+	EF_INLINE void io2Write( EF_BUS_ARGS )
+	{
+		register u32 D;
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 );
+
+		if ( ( D >> 5 ) & 1 )
+		{ // cartridge off
+			SET_GPIO( bGAME | bEXROM );
+		} else
+		{ // cartridge on
+			SETCLR_GPIO( bGAME, bEXROM );
+		}
+
+		efSelectBank8K( D & 0x1f );
+	}
+
+	EF_INLINE void reset()
+	{
+		ef.releaseDMA = 0;
+		efSelectBank8K( 0 );
+		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+	}
+};
+
+// GMod2: bank, EXROM and the serial EEPROM in $DE00
+extern int m93c86_addr;
+extern uint8_t m93c86_data[ M93C86_SIZE ];
+
+struct EFMapperGMOD2 : EFMapper
+{
+	static const u32 romLines = bROML;
+	static const u32 prefetch = EF_PREFETCH_8K;
+	static const u32 io = EF_IO1_READ | EF_IO1_WRITE;
+	static const u32 dma = EF_DMA_TRIGGER;
+
+	EF_INLINE void cycleStart( EF_BUS_ARGS )
+	{
+		CACHE_PRELOADL2STRMW( &m93c86_data[ m93c86_addr * 2 ] );
+	}
+
+	EF_INLINE void cycleBus( EF_BUS_ARGS )
+	{
+		ef.mainloopCount = 0;
+		TRIGGER_DMA_COUNT_WRITES
+	}
+
+	EF_INLINE void io1Read( EF_BUS_ARGS )
+	{
+		register u32 D;
+		if (ef.eeprom_cs) {
+			D = m93c86_read_data() << 7;
+			WRITE_D0to7_TO_BUS( D )
+		} else
+			WRITE_D0to7_TO_BUS( 0 )
+	}
+
+	EF_INLINE void io1Write( EF_BUS_ARGS )
+	{
+		register u32 D;
+		READ_D0to7_FROM_BUS( D )
+
+		if ( ( D & 0xc0 ) == 0xc0 ) {
+			SETCLR_GPIO( bEXROM, bGAME );
+		} else if ( ( D & 0x40 ) == 0x00 ) {
+			SETCLR_GPIO( bGAME, bEXROM );
+		} else if ( ( D & 0x40 ) == 0x40 ) {
+			SET_GPIO( bGAME | bEXROM );
+		}
+		ef.eeprom_cs = ( D >> 6 ) & 1;
+		ef.eeprom_data = ( D >> 4 ) & 1;
+		ef.eeprom_clock = ( D >> 5 ) & 1;
+		m93c86_write_select( (uint8_t)ef.eeprom_cs );
+		if ( ef.eeprom_cs ) {
+			m93c86_write_data( (uint8_t)( ef.eeprom_data ) );
+			m93c86_write_clock( (uint8_t)( ef.eeprom_clock ) );
+		}
+
+		if ( ef.reg0 != (D & 0x3f) )
+			efSelectBank8K( D & 0x3f );
+	}
+
+	EF_INLINE void reset()
+	{
+		ef.releaseDMA = 0;
+		efSelectBank8K( 0 );
+		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+	}
+};
+
+// Ocean type 1: bank in $DE00, 8k banks at ROML and ROMH
+struct EFMapperOcean : EFMapper
+{
+	static const u32 romLines = bROML | bROMH;
+	static const u32 prefetch = EF_PREFETCH_8K;
+	static const u32 io = EF_IO1_WRITE;
+	static const bool ledClear = true;
+
+	EF_INLINE void io1Write( EF_BUS_ARGS )
+	{
+		register u32 D;
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 );
+		efSelectBank8K( D & 0x3f );
+	}
+
+	EF_INLINE void reset()
+	{
+		ef.releaseDMA = 0;
+		efSelectBank8K( 0 );
+		if ( ef.nBanks > 32 )
+			{SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );} else
+			{SETCLR_GPIO( bDMA | bNMI, bEXROM | bGAME );}
+	}
+};
+
+// RGCD and Hucky: bank in $DE00 (inverted for Hucky), bit 3 disables the cartridge
+struct EFMapperRGCD : EFMapper
+{
+	static const u32 romLines = bROML;
+	static const u32 prefetch = EF_PREFETCH_8K;
+	static const u32 io = EF_IO1_WRITE;
+	static const bool ledClear = true;
+
+	EF_INLINE bool romEnabled() { return !ef.reg2; }
+
+	EF_INLINE void io1Write( EF_BUS_ARGS )
+	{
+		register u32 D;
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 );
+		if ( D & 8 )
+		{
+			ef.reg2 = 1;
+			SET_GPIO( bDMA | bNMI | bGAME | bEXROM );
+		}
+		D &= 7;
+		if ( ef.bankswitchType == BS_HUCKY )
+			efSelectBank8K( (D ^ 7) & (ef.nBanks - 1) ); else
+			efSelectBank8K( D & (ef.nBanks - 1) );
+	}
+
+	EF_INLINE void reset()
+	{
+		ef.releaseDMA = 0;
+		ef.reg2 = 0;
+		if ( ef.bankswitchType == BS_HUCKY )
+			efSelectBank8K( 7 & (ef.nBanks - 1) ); else
+			efSelectBank8K( 0 );
+		SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );
+	}
+};
+
+// Zaxxon: ROML mirrors the first 4k, reading from its upper/lower half selects the ROMH bank
+struct EFMapperZaxxon : EFMapper
+{
+	static const u32 romLines = bROML | bROMH;
+	static const u32 romLayout = EF_ROM_CUSTOM;
+
+	EF_INLINE u32 romRead( u32 addr, u8 *flashBank, u32 g3 )
+	{
+		register u32 D;
+		if ( ROML_ACCESS )
+		{
+			D = *(u8*)&ef.flash_cacheoptimized[ (addr&0b1111111101111) * 2 + 0 ];
+			ef.reg0 = GET_ADDRESS8to12 & 0x10 ? 1 : 0;
+			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
+		} else
+			D = *(u8*)&flashBank[ ( addr & 0x3fff ) * 2 + 1 ];
+		return D;
+	}
+
+	EF_INLINE void reset() { SET_GPIO( bDMA | bNMI ); }
+};
+
+// C64 Game System: bank from the address of a write to IO1, reading IO1 selects bank 0
+struct EFMapperC64GS : EFMapper
+{
+	static const u32 romLines = bROML;
+	static const u32 prefetch = EF_PREFETCH_8K;
+	static const u32 io = EF_IO1_READ | EF_IO1_WRITE;
+	static const u32 dma = EF_DMA_RELEASE;
+	static const bool ledClear = true;
+
+	EF_INLINE void io1Read( EF_BUS_ARGS )
+	{
+		setLatchFIQ( LATCH_LED0 | LATCH_LED1 );
+		efSelectBank8K( 0 );
+	}
+
+	EF_INLINE void io1Write( EF_BUS_ARGS )
+	{
+		register u32 D __attribute__((unused));
+		READ_D0to7_FROM_BUS( D )
+		setLatchFIQ( LATCH_LED0 | LATCH_LED1 );
+		efSelectBank8K( GET_IO12_ADDRESS & 0x3f );
+	}
+
+	EF_INLINE void reset()
+	{
+		ef.releaseDMA = 0;
+		ef.reg0 = 0;
+		ef.flashBank = &ef.flash_cacheoptimized[ 0 ];
+		clrLatchFIQ( LATCH_LED1 );
+		SETCLR_GPIO( bGAME | bDMA | bNMI, bEXROM );
+	}
+};
+
+// Dinamic: bank from the address of a read from $DE00-$DE0F
+struct EFMapperDinamic : EFMapper
+{
+	static const u32 romLines = bROML;
+	static const u32 romLayout = EF_ROM_16K;
+	static const u32 io = EF_IO1_READ;
+
+	EF_INLINE void io1Read( EF_BUS_ARGS )
+	{
+		register u32 addr = GET_IO12_ADDRESS;
+		if ( ( addr & 0x0f ) == addr )
+		{
+			ef.reg0 = addr & 0x0f;
+			ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
+		}
+	}
+
+	EF_INLINE void reset() { SET_GPIO( bDMA | bNMI ); }
+};
+
+// Comal80: bank and cartridge mode in $DE00 (readable)
+struct EFMapperComal80 : EFMapper
+{
+	static const u32 romLines = bROML | bROMH;
+	static const u32 romLayout = EF_ROM_16K;
+	static const u32 io = EF_IO1_READ | EF_IO1_WRITE;
+
+	EF_INLINE void io1Read( EF_BUS_ARGS )
+	{
+		WRITE_D0to7_TO_BUS( ef.reg2 )
+	}
+
+	EF_INLINE void io1Write( EF_BUS_ARGS )
+	{
+		register u32 D;
+		READ_D0to7_FROM_BUS( D )
+
+		ef.reg2 = D & 0xc7;
+		ef.reg0 = D & 3;
+		ef.flashBank = &ef.flash_cacheoptimized[ ef.reg0 * 8192 * 2 ];
+
+		if ( D & 0x40 )
+			{SET_GPIO( bEXROM | bGAME );} else
+			{CLR_GPIO( bEXROM | bGAME );}
+	}
+
+	EF_INLINE void reset() { SET_GPIO( bDMA | bNMI ); }
+};
+
+// Simons' Basic: reading IO1 switches to 8k, writing to 16k mode
+struct EFMapperSimonsBasic : EFMapper
+{
+	static const u32 romLines = bROML | bROMH;
+	static const u32 romLayout = EF_ROM_16K;
+	static const u32 io = EF_IO1_READ | EF_IO1_WRITE;
+
+	EF_INLINE void io1Read( EF_BUS_ARGS ) { SETCLR_GPIO( bGAME, bEXROM ); }
+	EF_INLINE void io1Write( EF_BUS_ARGS ) { CLR_GPIO( bGAME | bEXROM ); }
+	EF_INLINE void reset() { SETCLR_GPIO( bDMA | bNMI, bGAME | bEXROM ); }
+};
+
+// Epyx Fastload: accesses to ROML or IO1 keep the cartridge on (capacitor), IO2 shows the last page of the ROM
+struct EFMapperEpyxFL : EFMapper
+{
+	static const u32 romLines = bROML;
+	static const u32 romLayout = EF_ROM_CUSTOM;
+	static const u32 io = EF_IO1_READ | EF_IO2_READ;
+
+	EF_INLINE u32 romRead( u32 addr, u8 *flashBank, u32 g3 )
+	{
+		epyxDisable = 512 * 2;
+		return *(u32*)&ef.flash_cacheoptimized[ addr * 2 ];
+	}
+
+	EF_INLINE void io1Read( EF_BUS_ARGS )
+	{
+		SETCLR_GPIO( bGAME, bEXROM );
+		epyxDisable = 512 * 2;
+		WRITE_D0to7_TO_BUS( 0 )
+	}
+
+	EF_INLINE void io2Read( EF_BUS_ARGS )
+	{
+		register u32 D, addr = GET_ADDRESS_CACHEOPT | 0b0000000011111; // access 0x1f00 + IO_ADDRESS
+		D = *(u32*)&ef.flash_cacheoptimized[ addr * 2 ];
+		WRITE_D0to7_TO_BUS( D )
+	}
+
+	EF_INLINE void beforeReset( EF_BUS_ARGS )
+	{
+		if ( CPU_RESET )
+		{
+			epyxDisable = 512 * 2;
+			SETCLR_GPIO( bDMA | bNMI | bGAME, bEXROM );
+		} else
+		if ( epyxDisable && --epyxDisable == 0 )
+		{
+			SET_GPIO( bEXROM | bGAME );
+		}
+	}
+};
+
+#endif
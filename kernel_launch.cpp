@@ -47,6 +47,9 @@ static u32	configGAMEEXROMSet, configGAMEEXROMClr;
 static u32	resetCounter, c64CycleCount;
 static u32	disableCart, transferStarted, currentOfs, transferPart;
 
+// PRG window at $9000-$9FFF, see launch.h
+static u32	prgWindow, prgWindowBase;
+
 u32 prgSize;
 unsigned char prgData[ 65536 ] AAA;
 static u32 startAddr, prgSizeAboveA000, prgSizeBelowA000;
@@ -132,16 +135,8 @@ void CKernelLaunch::Run( void )
 	} else
 	if ( screenType == 1 )
 	{
-		tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-		int w, h; 
 		extern char FILENAME_LOGO_RGBA[128];
-		extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-		if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-		{
-			tftBlendRGBA( tempTGA, tftBackground, 0 );
-		}
+		tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 		tftCopyBackground2Framebuffer();
 		tftInitImm();
@@ -187,6 +182,7 @@ void CKernelLaunch::Run( void )
 
 	c64CycleCount = resetCounter = 0;
 	disableCart = transferStarted = currentOfs = 0;
+	prgWindow = prgWindowBase = 0;
 	transferPart = 1;
 
 	// warm caches
@@ -201,6 +197,7 @@ void CKernelLaunch::Run( void )
 
 	c64CycleCount = resetCounter = 0;
 	disableCart = transferStarted = currentOfs = 0;
+	prgWindow = prgWindowBase = 0;
 	transferPart = 1;
 	CACHE_PRELOADL2KEEP( &prgData[ prgSizeBelowA000 + 2 ] );
 	CACHE_PRELOADL2KEEP( &prgData[ 0 ] );
@@ -285,14 +282,36 @@ void CKernelLaunch::FIQHandler (void *pParam)
 		}
 	}
 
-	// access to CBM80 ROM (launch code)
+	// access to CBM80 ROM (launch code) or the PRG window at $9000
 	if ( CPU_READS_FROM_BUS && ACCESS( ROM_LH ) )
-		WRITE_D0to7_TO_BUS( launchCode[ GET_ADDRESS + LAUNCH_BYTES_TO_SKIP ] );
+	{
+		if ( prgWindow && ( GET_ADDRESS & 0x1000 ) )
+			D = prgData[ ( prgWindowBase + ( GET_ADDRESS & 0x0fff ) ) & 0xffff ]; else
+			D = launchCode[ GET_ADDRESS + LAUNCH_BYTES_TO_SKIP ];
+		WRITE_D0to7_TO_BUS( D );
+	}
 
 	if ( IO1_ACCESS ) 
 	{
 		if ( CPU_WRITES_TO_BUS ) 
 		{
+			// $DE03 -> PRG pages D..D+15 (of the current part) at $9000, $DE04 -> launch code again
+			if ( GET_IO12_ADDRESS == 3 )
+			{
+				READ_D0to7_FROM_BUS( D )
+				prgWindowBase = ( transferPart == 1 ? prgSizeBelowA000 + 2 : 2 ) + ( D << 8 );
+				prgWindow = 1;
+				CACHE_PRELOADL2KEEP( &prgData[ prgWindowBase & 0xffff ] );
+				FINISH_BUS_HANDLING
+				return;
+			}
+			if ( GET_IO12_ADDRESS == 4 )
+			{
+				prgWindow = 0;
+				FINISH_BUS_HANDLING
+				return;
+			}
+
 			transferStarted = 1;
 
 			// any write to IO1 will (re)start the PRG transfer
@@ -33,6 +33,8 @@ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
 #include "config.h"
 #include "c64screen.h"
 #include "charlogo.h"
+#include "buscal.h"
+#include "prefetch.h"
 
 // we will read these files
 static const char DRIVE[] = "SD:";
@@ -111,6 +113,60 @@ static u32 colorTransferBytes;
 static u8 *colorTransfer = &c64screen[ 0 ];
 static u8 *charsetTransfer = &charset[ 0 ];
 
+//
+// delta screen transfer ($DF00 <- 2, then reading $DF09, see updateScreenDelta in rpimenu.c):
+// the stream consists of rows which differ from what the C64 already has, each row is
+//   hi, lo byte of the screen address ($0400 + 40 * row, color RAM = address + $D400)
+//   20 x ( screen char, packed colors of this and the next char, screen char )
+// and is terminated by a 0 (hi byte of the address is never 0).
+// screenShadow is what the C64 has, i.e. the snapshot the last consumed stream was built from. A full
+// transfer ($DF00 <- 1) invalidates it.
+//
+#define SCREEN_DELTA_ROW_BYTES	( 2 + 60 )
+
+static u8 screenDelta[ 25 * SCREEN_DELTA_ROW_BYTES + 1 ] AAA;
+static u8 *screenDeltaTransfer = &screenDelta[ 0 ];
+static u8 *screenDeltaEnd = &screenDelta[ 0 ];
+static u8 screenShadow[ 2 ][ 1000 ], screenPending[ 2 ][ 1000 ];
+static volatile u32 screenShadowValid = 0, screenDeltaConsumed = 0;
+
+static void buildScreenDelta()
+{
+	if ( screenDeltaConsumed )
+	{
+		memcpy( screenShadow, screenPending, sizeof( screenShadow ) );
+		screenDeltaConsumed = 0;
+		screenShadowValid = 1;
+	}
+
+	u8 *p = screenDelta;
+	for ( u32 row = 0; row < 25; row++ )
+	{
+		u32 ofs = row * 40;
+		if ( screenShadowValid && 
+			 !memcmp( &screenShadow[ 0 ][ ofs ], &c64screen[ ofs ], 40 ) && 
+			 !memcmp( &screenShadow[ 1 ][ ofs ], &c64color[ ofs ], 40 ) )
+			continue;
+
+		*( p ++ ) = ( 0x0400 + ofs ) >> 8;
+		*( p ++ ) = ( 0x0400 + ofs ) & 255;
+		for ( u32 i = ofs; i < ofs + 40; i += 2 )
+		{
+			*( p ++ ) = c64screen[ i ];
+			*( p ++ ) = ( c64color[ i + 1 ] << 4 ) | ( c64color[ i ] & 15 );
+			*( p ++ ) = c64screen[ i + 1 ];
+		}
+	}
+	*( p ++ ) = 0;
+
+	memcpy( screenPending[ 0 ], c64screen, 1000 );
+	memcpy( screenPending[ 1 ], c64color, 1000 );
+
+	screenDeltaTransfer = screenDelta;
+	screenDeltaEnd = p;
+	CACHE_PRELOAD_DATA_CACHE( screenDelta, p - screenDelta, CACHE_PRELOADL2KEEP );
+}
+
 static u32 LED_DEACTIVATE_CART1_HIGH;	
 static u32 LED_DEACTIVATE_CART1_LOW;	
 static u32 LED_DEACTIVATE_CART2_HIGH;	
@@ -439,6 +495,10 @@ void CKernelMenu::Run( void )
 	FILENAME[0]		= 0;
 	first			= 1;
 
+	// the C64 starts with a full screen transfer
+	screenShadowValid   = 0;
+	screenDeltaConsumed = 0;
+
 	wireSIDAvailable = 0;
 	wireSIDGotLow    = 0;
 	wireSIDGotHigh   = 0;
@@ -512,6 +572,9 @@ void CKernelMenu::Run( void )
 
 		asm volatile ("wfi");
 
+		busCalUpdate( logger );
+		busCalMeasureClock( logger, c64CycleCount, updateMenu != 0 );
+
 		if ( launchKernel )
 		{
 			m_InputPin.DisableInterrupt();
@@ -554,13 +617,21 @@ void CKernelMenu::Run( void )
 
 			startForC128 = 0;
 			handleC64( lastChar, &launchKernel, FILENAME, filenameKernal, menuItemStr, &startForC128 );
+			if ( !launchKernel )
+				prefetchFileUnderCursor();
 			lastChar = 0xfffffff;
 			refresh++;
 			//temperature = m_CPUThrottle.GetTemperature();
 			renderC64();
+			buildScreenDelta();
 			warmCache( pFIQ );
 			doneWithHandling = 1;
 			updateMenu = 0;
+		} else
+		{
+			// speculative load of the file under the cursor, one chunk per iteration
+			if ( prefetchStep( logger, c64CycleCount ) )
+				warmCache( pFIQ );
 		}
 	}
 
@@ -588,6 +659,53 @@ void CKernelMenu::FIQHandler (void *pParam)
 	c64CycleCount ++;
 	WAIT_AND_READ_ADDR8to12_ROMLH_IO12_BA
 
+	// timing calibration (buscal.h): only the test registers are served, everything else is ignored
+	if ( busCal.state == BUSCAL_RUNNING )
+	{
+		if ( busCal.roundActive && ( busCal.nWrites == BUSCAL_TRANSFERS || c64CycleCount - busCal.roundStart > BUSCAL_ROUND_CYCLES ) )
+			busCalEndRound();
+
+		busCalCheckTimeout( c64CycleCount );
+
+		if ( BUTTON_PRESSED )
+		{
+			if ( busCal.state == BUSCAL_RUNNING )
+			{
+				busCalEndRound();
+				busCal.roundDone = 0;
+				busCal.state = BUSCAL_FAILED;
+			}
+			FINISH_BUS_HANDLING
+			activateCart();
+			return;
+		}
+
+		if ( IO2_ACCESS )
+		{
+			u32 A = GET_IO12_ADDRESS;
+			if ( CPU_READS_FROM_BUS )
+			{
+				D = 0;
+				if ( A == 6 ) D = BUSCAL_MAGIC; else
+				if ( A == 7 ) D = busCal.pattern[ busCal.nReads ++ & ( BUSCAL_TRANSFERS - 1 ) ];
+				WRITE_D0to7_TO_BUS( D )
+			} else
+			{
+				READ_D0to7_FROM_BUS( D )
+				if ( A == 6 ) busCalStartRound( c64CycleCount ); else
+				if ( A == 8 && busCal.roundActive )
+				{
+					if ( D != ( busCal.pattern[ busCal.nWrites & ( BUSCAL_TRANSFERS - 1 ) ] ^ 0xff ) )
+						busCal.errors ++;
+					busCal.nWrites ++;
+				}
+			}
+		}
+
+		FINISH_BUS_HANDLING
+		return;
+	}
+
 	if ( BUTTON_PRESSED )
 	{
 		FINISH_BUS_HANDLING
@@ -676,6 +794,13 @@ void CKernelMenu::FIQHandler (void *pParam)
 			colorTransfer = &c64color[ 0 ];		colorTransferBytes = 0;
 			CACHE_PRELOADL2STRM( screenTransfer );
 			CACHE_PRELOADL2STRM( colorTransfer );
+			screenShadowValid = 0;
+		} else
+		if ( A == 0 && D == 2 )
+		{
+			// start delta screen transfer
+			screenDeltaTransfer = &screenDelta[ 0 ];
+			CACHE_PRELOADL2KEEP( screenDeltaTransfer );
 		} else
 		if ( A == 1 )
 		{
@@ -704,6 +829,13 @@ void CKernelMenu::FIQHandler (void *pParam)
 			charsetTransfer = &charset[ 0 ];
 			CACHE_PRELOADL2STRM( charsetTransfer );
 		} else
+		if ( A == 6 && busCal.state == BUSCAL_REQUESTED )
+		{
+			// first round of the timing calibration
+			busCalStartRound( c64CycleCount );
+			FINISH_BUS_HANDLING
+			return;
+		} else
 		if ( A == 16 )
 		{
 			wireKernalDetectMode = 1;
@@ -751,6 +883,18 @@ void CKernelMenu::FIQHandler (void *pParam)
 		if ( A == 4 )
 		{
 			D = *( charsetTransfer ++ );
+		} else
+		if ( A == 9 )
+		{
+			D = *( screenDeltaTransfer ++ );
+			if ( screenDeltaTransfer == screenDeltaEnd )
+				screenDeltaConsumed = 1;
+			CACHE_PRELOADL2KEEP( screenDeltaTransfer + 32 );
+		} else
+		if ( A == 6 )
+		{
+			// asks the C64 to start calibrateTiming
+			D = busCal.state == BUSCAL_REQUESTED ? BUSCAL_MAGIC : 0;
 		} else
 			D = injectCode[ A ];
 
@@ -837,6 +981,10 @@ int main( void )
 		InvalidateDataCache();
 		InvalidateInstructionCache();
 
+#ifdef FIQ_STATS
+		fiqStatsReset();
+#endif
+
 		/* for debugging purposes only*/
 		if ( launchKernel == 255 ) 
 		{
@@ -965,6 +1113,11 @@ int main( void )
 		default:
 			break;
 		}
+
+#ifdef FIQ_STATS
+		// timing of the handlers of the kernel we just returned from
+		fiqStatsWrite( logger, FILENAME );
+#endif
 	}
 
 	return EXIT_HALT;
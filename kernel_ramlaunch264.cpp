@@ -149,18 +149,10 @@ void CKernelRL::Run( void )
 
 		if ( !tftLoadBackgroundTGA( (char*)DRIVE, fn ) )
 		{
-			if ( strstr( FILENAME_RAM, ".neocrt" ) == 0 )
-				tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB_RAMONLY, 8 ); else
-				tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-			int w, h; 
 			extern char FILENAME_LOGO_RGBA[128];
-			extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-			if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-			{
-				tftBlendRGBA( tempTGA, tftBackground, 0 );
-			}
+			if ( strstr( FILENAME_RAM, ".neocrt" ) == 0 )
+				tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB_RAMONLY, 8, FILENAME_LOGO_RGBA ); else
+				tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 			tftCopyBackground2Framebuffer();
 		}
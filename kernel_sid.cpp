@@ -283,6 +283,17 @@ void initSID()
 		ringTime[ i ] = 0;
 }
 
+static void initMixer()
+{
+	mixerReset();
+
+	// yes, it's 1 byte shifted in the buffer, need to fix: the 1st output channel uses the 'right' volumes
+	mixerSetGain( MIXER_SID1, cfgVolSID1_Right, cfgVolSID1_Left );
+	mixerSetGain( MIXER_SID2, cfgVolSID2_Right, cfgVolSID2_Left );
+	mixerSetGain( MIXER_OPL,  cfgVolOPL_Right,  cfgVolOPL_Left );
+	mixerSetGain( MIXER_MIDI, cfgMIDI ? 256 : 0, cfgMIDI ? 256 : 0 );
+}
+
 
 unsigned long long cycleCountC64;
 
@@ -357,7 +368,11 @@ void quitSID()
 
 #ifdef SUPPORT_MIDI
 	if ( TinySoundFont )
+	{
 		tsf_close( TinySoundFont );
+		TinySoundFont = NULL;
+	}
+	soundFontClose();
 #endif
 }
 
@@ -389,6 +404,7 @@ static void initVisualization()
 	memset( scopeValues, 0, 256 );
 	nPrevLEDs[0] = nPrevLEDs[1] = nPrevLEDs[2] = 0;
 	ledValueAvg[0] = ledValueAvg[1] = ledValueAvg[2] = 0.01f;
+	visInit();
 }
 
 static unsigned char tftBackground2[ 240 * 240 * 2 ];
@@ -404,6 +420,7 @@ static int busValue = 0;
 static int busValueTTL = 0;
 static unsigned long long nCyclesEmulated = 0;
 static unsigned long long samplesElapsed = 0;
+static unsigned long long nextSampleCycleX65536 = 0;	// emulation cycle (16.16) at which the next sample is due
 
 static u32 resetFromCodeState = 0;
 static u32 _playingPSID = 0;
@@ -458,7 +475,7 @@ static void prepareOnReset( bool refresh = false )
 		FORCE_READ_LINEAR32a( (void*)&FIQ_HANDLER, 6*1024, 32768 );
 	}
 
-	resetCounter = cycleCountC64 = nCyclesEmulated = samplesElapsed = 0;
+	resetCounter = cycleCountC64 = nCyclesEmulated = samplesElapsed = nextSampleCycleX65536 = 0;
 }
 
 //static u32 haltC64 = 0, letgoC64 = 0;
@@ -468,24 +485,108 @@ static int startVCHIQ = 0;
 
 #define SAMPLERATE 44100
 
-u32 SAMPLERATE_ADJUSTED = SAMPLERATE;
-extern u32 nSamplesPrecompute;
-u32 trackSampleProgress;
-
-static s32 avgSamplesAvail = 0;
-static s32 avgCounter = 0;
-static u32 adjustRateAllowed = 0;
-static u32 targetSamplesAvail = 0, targetCount = 0;
-
 u32 fillSoundBuffer;
 extern bool CVCHIQ_CB_Manual;
 
 #ifdef SUPPORT_MIDI
 
-#define MIDI_BUF_SIZE_BITS	5
-const int midiBufferSize = 1 << MIDI_BUF_SIZE_BITS;
-static float midiSampleBuffer[ 1 << (MIDI_BUF_SIZE_BITS) ] AAA;
-static u32 midiBufferOfs = midiBufferSize;
+// TinySoundFont renders one mixer block at a time
+static float midiSampleBuffer[ MIXER_BLOCK_SIZE ] AAA;
+
+// the SoundFont is loaded streamed: only presets/instruments/zones are parsed at start, sample data is requested
+// at program change (or the first note on of a region) and read in the main loop, at most MIDI_SAMPLE_PAGE_SIZE
+// bytes per iteration, into an LRU cache
+#define MIDI_SAMPLE_CACHE_SIZE	( 48 * 1024 * 1024 )
+#define MIDI_SAMPLE_PAGE_SIZE	( 16 * 1024 )
+
+static char soundFontFilename[ 256 ];
+
+// the file stays open while the kernel runs. Other code mounting the drive with its own FATFS unregisters ours
+// (fs_type = 0), the file is opened again at the next access then.
+static FATFS soundFontFS;
+static FIL soundFontFile;
+static u32 soundFontOpen = 0;
+
+static void soundFontClose()
+{
+	if ( soundFontOpen && soundFontFS.fs_type != 0 )
+	{
+		f_close( &soundFontFile );
+		f_mount( 0, DRIVE, 0 );
+	}
+	soundFontOpen = 0;
+}
+
+static int soundFontReopen()
+{
+	if ( soundFontOpen && soundFontFS.fs_type != 0 )
+		return 1;
+
+	soundFontOpen = 0;
+	if ( f_mount( &soundFontFS, DRIVE, 1 ) != FR_OK )
+		return 0;
+
+	if ( f_open( &soundFontFile, soundFontFilename, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+	{
+		f_mount( 0, DRIVE, 0 );
+		return 0;
+	}
+
+	soundFontOpen = 1;
+	return 1;
+}
+
+static int soundFontStreamRead( void *data, void *ptr, unsigned int size )
+{
+	u32 nBytesRead;
+	if ( f_read( (FIL*)data, ptr, size, &nBytesRead ) != FR_OK )
+		return 0;
+	return nBytesRead;
+}
+
+static int soundFontStreamSkip( void *data, unsigned int count )
+{
+	FIL *file = (FIL*)data;
+	return f_lseek( file, f_tell( file ) + count ) == FR_OK;
+}
+
+// only called from tsf_sample_cache_service in the main loop
+static int soundFontReadAt( void *data, unsigned int offset, void *ptr, unsigned int size )
+{
+	u32 nBytesRead = 0;
+
+	if ( !soundFontReopen() )
+		return 0;
+
+	if ( f_lseek( &soundFontFile, offset ) != FR_OK || f_read( &soundFontFile, ptr, size, &nBytesRead ) != FR_OK )
+		nBytesRead = 0;
+
+	return nBytesRead;
+}
+
+static tsf *loadSoundFontStreamed( const char *filename )
+{
+	tsf *res = NULL;
+
+	soundFontClose();
+	strncpy( soundFontFilename, filename, 255 );
+	soundFontFilename[ 255 ] = 0;
+
+	if ( !soundFontReopen() )
+	{
+		logger->Write( "RaspiMenu", LogNotice, "Cannot open file: %s", filename );
+		return NULL;
+	}
+
+	struct tsf_stream stream = { &soundFontFile, soundFontStreamRead, soundFontStreamSkip };
+	struct tsf_sample_source source = { soundFontFilename, soundFontReadAt };
+	res = tsf_load_streamed( &stream, &source, MIDI_SAMPLE_CACHE_SIZE );
+
+	if ( res == NULL )
+		soundFontClose();
+
+	return res;
+}
 
 #endif
 
@@ -531,16 +632,8 @@ void CKernel::Run( void )
 	} else
 	if ( screenType == 1 )
 	{
-		tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-		int w, h; 
 		extern char FILENAME_LOGO_RGBA[128];
-		extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-		if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-		{
-			tftBlendRGBA( tempTGA, tftBackground, 0 );
-		}
+		tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 		tftCopyBackground2Framebuffer();
 
@@ -611,34 +704,32 @@ void CKernel::Run( void )
 #ifdef SUPPORT_MIDI
 	if ( cfgMIDI )
 	{
-		u32 size;
 		cfgMIDI = 0;
 		char filename[256];
 		sprintf( filename, "SD:MIDI/instrument%02d.sf2", cfgSoundFont );
-		if ( getFileSize( logger, DRIVE, filename, &size ) )
-		{
-			if ( size < 256 * 1024 * 1024 )
-			{
-				u8 *soundfont = new u8[ size ];
 
-				if ( readFile( logger, DRIVE, filename, soundfont, &size ) )
-				{
-					TinySoundFont = tsf_load_memory( soundfont, size );
-					tsf_set_output( TinySoundFont, TSF_MONO, SAMPLERATE, 0.0f );
-					//tsf_set_output( TinySoundFont, TSF_STEREO_INTERLEAVED, SAMPLERATE, 0.0f );
-					tsf_set_volume( TinySoundFont, 0.5f * (float)cfgMIDIVolume / 15.0f );
-					tsf_set_max_voices( TinySoundFont, 64 );
-					tsf_channel_set_bank_preset( TinySoundFont, 9, 128, 0 );
-					cfgMIDI = 1;
-				}
-				delete [] soundfont;
-
-				memset( midiSampleBuffer, 0, midiBufferSize * sizeof( float ) );
-			}
+		TinySoundFont = loadSoundFontStreamed( filename );
+		if ( TinySoundFont )
+		{
+			tsf_set_output( TinySoundFont, TSF_MONO, SAMPLERATE, 0.0f );
+			//tsf_set_output( TinySoundFont, TSF_STEREO_INTERLEAVED, SAMPLERATE, 0.0f );
+			tsf_set_volume( TinySoundFont, 0.5f * (float)cfgMIDIVolume / 15.0f );
+			tsf_set_max_voices( TinySoundFont, 64 );
+
+			// program 0 on all channels, drums on channel 10: requests their samples
+			for ( int c = 0; c < 16; c++ )
+				if ( c != 9 )
+					tsf_channel_set_presetnumber( TinySoundFont, c, 0 );
+			tsf_channel_set_bank_preset( TinySoundFont, 9, 128, 0 );
+			cfgMIDI = 1;
 		}
+
+		memset( midiSampleBuffer, 0, MIXER_BLOCK_SIZE * sizeof( float ) );
 	}
 #endif
 
+	initMixer();
+
 	//
 	// initialize sound output (either PWM which is output in the FIQ handler, or via HDMI)
 	//
@@ -710,6 +801,7 @@ void CKernel::Run( void )
 	cycleCountC64 = 0;
 	nCyclesEmulated = 0;
 	samplesElapsed = 0;
+	nextSampleCycleX65536 = 0;
 
 	// how far did we consume the commands in the ring buffer?
 	unsigned int ringRead = 0;
@@ -766,8 +858,11 @@ startHereAfterReset:
 	resetCounter = cycleCountC64 = 0;
 	nCyclesEmulated = 0;
 	samplesElapsed = 0;
+	nextSampleCycleX65536 = 0;
 	ringRead = ringWrite = 0;
 
+	hdmiSyncReset( CLOCKFREQ, SAMPLERATE );
+
 	latchSetClear( 0, allUsedLEDs );
 
 	static u32 hdmiVol = 1;
@@ -795,7 +890,18 @@ startHereAfterReset:
 		}
 		if ( cycleCountC64 > 2000000 && resetCounter > 500000 ) {
 			CVCHIQ_CB_Manual = false;
-			//logger->Write( "", LogNotice, "adjusted sample rate: %u Hz", (u32)SAMPLERATE_ADJUSTED );
+			if ( outputHDMI )
+				logger->Write( "", LogNotice, "HDMI sync (%s): fill %d (target %d, min %d, max %d), rate %u Hz (%d ppm), underruns %u, overruns %u, fallbacks %u", hdmiProfiles[ hdmiProfileActive ].name,
+					hdmiSync.fillAvg, hdmiSync.target, hdmiSync.fillMin, hdmiSync.fillMax, hdmiSync.rateHz, hdmiSync.ppm, hdmiSync.underruns, hdmiSync.overruns, hdmiSync.fallbacks );
+#ifdef SUPPORT_MIDI
+			// notes dropped because their samples were not paged in yet, see MIDI_SAMPLE_PAGE_SIZE
+			if ( cfgMIDI && TinySoundFont )
+			{
+				u32 bytes, hits, misses, dropped;
+				tsf_get_sample_cache_stats( TinySoundFont, &bytes, &hits, &misses, &dropped );
+				logger->Write( "", LogNotice, "SoundFont sample cache: %u KB, %u hits, %u misses, %u notes dropped", bytes >> 10, hits, misses, dropped );
+			}
+#endif
 			quitSID();
 			EnableIRQs();
 			m_InputPin.DisableInterrupt();
@@ -811,17 +917,13 @@ startHereAfterReset:
 				if ( outputHDMI )
 				{
 					CVCHIQSoundBaseDevice *sd = (CVCHIQSoundBaseDevice*)m_pSound;
+					sd->DrainSpanQueue();
 					while ( sd->IsActive() ) {}
 					//sd->SetControl( VCHIQ_SOUND_VOLUME_DEFAULT, VCHIQSoundDestinationAuto );
 					hdmiVol = 1;
 				}
 				nSamplesInThisRun = startVCHIQ = 0;
 				initSoundOutput( &m_pSound, pVCHIQ, outputPWM, outputHDMI );
-				avgSamplesAvail = 0;
-				avgCounter = 0;
-				adjustRateAllowed = 0;
-				targetSamplesAvail = 0;
-				targetCount = 0;
 			}
 
 			resetReleased = 0xff;
@@ -872,6 +974,12 @@ startHereAfterReset:
 		}
 		#endif
 
+#ifdef SUPPORT_MIDI
+		// page in requested SoundFont samples, never from within the emulation/rendering below
+		if ( cfgMIDI )
+			tsf_sample_cache_service( TinySoundFont, MIDI_SAMPLE_PAGE_SIZE );
+#endif
+
 	#ifndef EMULATION_IN_FIQ
 
 		s16 val1, val2;
@@ -897,7 +1005,7 @@ startHereAfterReset:
 					CVCHIQ_CB_Device = NULL;
 				}
 
-				if ( samplesElapsed > (8+1) * nSamplesPrecompute / 2 && !startVCHIQ )
+				if ( samplesElapsed > nSamplesStart && !startVCHIQ )
 				{
 					m_pSound->Start();
 					fillSoundBuffer = 1;
@@ -908,79 +1016,12 @@ startHereAfterReset:
 				if ( fillSoundBuffer )
 				{
 					fillSoundBuffer = 0;
-
-					extern u32 samplesInBuffer();
-					#define TYPE		s16
-					#define TYPE_SIZE	sizeof (s16)
-
-					s32 nFramesComputed = samplesInBuffer();
-					s32 nFramesMax = m_pSound->GetQueueSizeFrames() - m_pSound->GetQueueFramesAvail();
-					trackSampleProgress = 1024 * 1024 + ( nFramesComputed - nFramesMax );
-
-					s32 nWriteFrames = min( nFramesComputed, nFramesMax );
-
-				#if 1
-					if ( nWriteFrames * 2 + PCMCountLast > PCMBufferSize )
-					{
-						m_pSound->Write( &PCMBuffer[ PCMCountLast ], (PCMBufferSize - PCMCountLast) * TYPE_SIZE );
-						m_pSound->Write( &PCMBuffer[ 0 ], (2 * nWriteFrames - (PCMBufferSize - PCMCountLast)) * TYPE_SIZE );
-					} else
-					{
-						m_pSound->Write( &PCMBuffer[ PCMCountLast ], 2 * nWriteFrames * TYPE_SIZE );
-					}
-					PCMCountLast += nWriteFrames * 2;
-					PCMCountLast %= PCMBufferSize;
-				#else
-					short temp[ 16384 ];
-					short *p = (short*)temp;
-					for ( u32 j = 0; j < nWriteFrames; j++ )
-					{
-						*(p++) = PCMBuffer[ PCMCountLast++ ];
-						*(p++) = PCMBuffer[ PCMCountLast++ ];
-						PCMCountLast %= PCMBufferSize;
-					}
-
-					unsigned nWriteBytes = 2 * nWriteFrames * TYPE_SIZE;
-					m_pSound->Write( &temp[ 0 ], nWriteBytes );
-				#endif
+					updateHDMISync( samplesElapsed );
 				}
-				if ( nSamplesInThisRun > 2205 / 8 )
+				// yield 8 times per queue length
+				if ( nSamplesInThisRun > nSamplesPrecompute / 8 )
 				{
-					if ( trackSampleProgress )
-					{
-						avgSamplesAvail += (s32)trackSampleProgress - 1024 * 1024;
-						avgCounter ++;
-
-						if ( avgCounter > 50 )
-						{
-							s32 avail = (s32)avgSamplesAvail / avgCounter;
-							if ( targetSamplesAvail == 0 && ++ targetCount > 2 )
-								CVCHIQ_CB_Manual = true; 
-							if ( targetSamplesAvail == 0 && ++ targetCount > 10 )
-								targetSamplesAvail = max( avail, (s32)nSamplesPrecompute );
-
-							if ( targetSamplesAvail != 0 )
-							{
-								if ( avail < (s32)targetSamplesAvail )
-								{
-									if ( avail < 5 * (s32)targetSamplesAvail / 100 && SAMPLERATE_ADJUSTED < SAMPLERATE )
-										SAMPLERATE_ADJUSTED = SAMPLERATE; else
-										SAMPLERATE_ADJUSTED ++; 
-								} else
-								if ( avail > (s32)targetSamplesAvail )
-								{
-									if ( avail > 105 * (s32)targetSamplesAvail / 100 && SAMPLERATE_ADJUSTED > SAMPLERATE )
-										SAMPLERATE_ADJUSTED = SAMPLERATE; else
-										SAMPLERATE_ADJUSTED --; 
-								}
-								adjustRateAllowed = 0;
-							}
-							//logger->Write( "", LogNotice, "samples ahead: %d (target: %d), rate: %u Hz", avail, targetSamplesAvail, SAMPLERATE_ADJUSTED );
-							avgSamplesAvail = avgCounter = 0;
-						}
-						trackSampleProgress = 0;
-					}
-
+					//logger->Write( "", LogNotice, "fill: %d (target: %d), rate: %u Hz", hdmiSync.fillAvg, hdmiSync.target, hdmiSync.rateHz );
 					{
 						if ( nCyclesEmulated < (2*64000) )
 						{
@@ -1017,9 +1058,8 @@ startHereAfterReset:
 				#endif
 
 		#else
-			unsigned long long samplesElapsedBefore = samplesElapsed;
-
-			long long cycleNextSampleReady = ( ( unsigned long long )(samplesElapsedBefore+1) * ( unsigned long long )CLOCKFREQ ) / ( unsigned long long )SAMPLERATE_ADJUSTED;
+			// fractional resampling: the step between two samples is steered by the HDMI clock drift controller
+			unsigned long long cycleNextSampleReady = nextSampleCycleX65536 >> 16;
 			u32 cyclesToNextSample = cycleNextSampleReady - nCyclesEmulated;
 
 			do { // do SID emulation until time passed to create an additional sample (i.e. there may be several cycles until a sample value is created)
@@ -1138,15 +1178,14 @@ startHereAfterReset:
 		#ifdef SMPCARRY
 			}
 		#else
-//				samplesElapsed = ( ( unsigned long long )nCyclesEmulated * ( unsigned long long )SAMPLERATE ) / ( unsigned long long )CLOCKFREQ;
-				samplesElapsed = ( ( unsigned long long )nCyclesEmulated * ( unsigned long long )SAMPLERATE_ADJUSTED ) / ( unsigned long long )CLOCKFREQ;
-
-				if ( nCyclesEmulated >= cycleCount && samplesElapsed == samplesElapsedBefore )
+				if ( nCyclesEmulated >= cycleCount && nCyclesEmulated < cycleNextSampleReady )
 					goto NoSampleGeneratedYet;
 
-			} while ( samplesElapsed == samplesElapsedBefore );
+			} while ( nCyclesEmulated < cycleNextSampleReady );
+
+			samplesElapsed ++;
+			nextSampleCycleX65536 += cyclesPerSampleX65536;
 		#endif
-			CACHE_PRELOADL2STRMW( &sampleBuffer[ smpCur ] );
 			val1 = sid[ 0 ]->output();
 			val2 = 0;
 			valOPL = 0;
@@ -1166,103 +1205,112 @@ startHereAfterReset:
 		#endif
 
 			//
-			// mixer
+			// mixer: collect one block of samples per source, then mix at once
 			//
-			register s32 left, right;
+			mixerIn[ MIXER_SID1 ][ mixerPos ] = val1;
+			mixerIn[ MIXER_SID2 ][ mixerPos ] = val2;
+			mixerIn[ MIXER_OPL ][ mixerPos ] = valOPL;
 
-#ifdef SUPPORT_MIDI
-			register s32 midiSampleLeft;
+			if ( ++ mixerPos < MIXER_BLOCK_SIZE )
+				goto NoSampleGeneratedYet;
+			mixerPos = 0;
 
-			midiSampleLeft = 0;
+#ifdef SUPPORT_MIDI
 			if ( cfgMIDI )
 			{
-				if ( midiBufferOfs >= midiBufferSize )
-				{
-					tsf_render_float( TinySoundFont, &midiSampleBuffer[0], midiBufferSize, 0 );
-					midiBufferOfs = 0;
-				} 
-
-				midiSampleLeft = midiSampleBuffer[ midiBufferOfs ] * 32767.0f;
-				midiSampleBuffer[ midiBufferOfs ] = 0.0f;
-				midiBufferOfs ++;
-				midiSampleLeft = max( -31768+2, min( 31767-2, midiSampleLeft ) );
+				tsf_render_float( TinySoundFont, &midiSampleBuffer[0], MIXER_BLOCK_SIZE, 0 );
+				mixerConvertFloatBlock( MIXER_MIDI, midiSampleBuffer );
 			}
 #endif
-			// yes, it's 1 byte shifted in the buffer, need to fix
-			right = ( val1 * cfgVolSID1_Left  + val2 * cfgVolSID2_Left  + valOPL * cfgVolOPL_Left ) >> 8;
-			left  = ( val1 * cfgVolSID1_Right + val2 * cfgVolSID2_Right + valOPL * cfgVolOPL_Right ) >> 8;
-
-#ifdef SUPPORT_MIDI
-			right += midiSampleLeft;
-			left  += midiSampleLeft;
-#endif
+			// with HDMI output the block is mixed directly into the queue of the sound device
+			s16 *out = mixerOut;
+			#ifdef USE_VCHIQ_SOUND
+			s16 *span = outputHDMI ? hdmiReserveBlock() : NULL;
+			if ( span )
+				out = span;
+			#endif
 
-			right = max( -31768+2, min( 31767-2, right ) );
-			left  = max( -31768+2, min( 31767-2, left ) );
+			mixerRenderBlock( MIXER_MIDI + 1, out );
 
-			#ifdef USE_PWM_DIRECT
-			if ( outputPWM )
-				putSample( left, right );
-			#endif
 			#ifdef USE_VCHIQ_SOUND
-			if ( outputHDMI )
-			{
-				putSample( left );
-				putSample( right );
-			}
+			// the device only reads committed frames and we only read from the block below
+			if ( span )
+				hdmiCommitBlock();
 			#endif
 
-		#if 1
-			// vu meter
-			static u32 vu_nValues = 0;
-			static float vu_Sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
-			
-			//if ( vu_Mode != 2 )
+			CACHE_PRELOADL2STRMW( &sampleBuffer[ smpCur ] );
+
+			for ( u32 smp = 0; smp < MIXER_BLOCK_SIZE; smp++ )
 			{
-				float t = (left+right) / (float)32768.0f * 0.5f;
-				vu_Sum[ 0 ] += t * t * 1.0f;
+				register s32 left  = out[ smp * 2 + 0 ];
+				register s32 right = out[ smp * 2 + 1 ];
 
-				vu_Sum[ 1 ] += val1 * val1 / (float)32768.0f / (float)32768.0f;
-				vu_Sum[ 2 ] += val2 * val2 / (float)32768.0f / (float)32768.0f;
-				vu_Sum[ 3 ] += valOPL * valOPL / (float)32768.0f / (float)32768.0f;
+				val1   = mixerIn[ MIXER_SID1 ][ smp ];
+				val2   = mixerIn[ MIXER_SID2 ][ smp ];
+				valOPL = mixerIn[ MIXER_OPL ][ smp ];
 
-				if ( ++ vu_nValues == 256*2 )
+				#ifdef USE_PWM_DIRECT
+				if ( outputPWM )
+					putSample( left, right );
+				#endif
+
+			#if 1
+				// vu meter
+				static u32 vu_nValues = 0;
+				static float vu_Sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			
+				//if ( vu_Mode != 2 )
 				{
-					for ( u32 i = 0; i < 4; i++ )
+					float t = (left+right) / (float)32768.0f * 0.5f;
+					vu_Sum[ 0 ] += t * t * 1.0f;
+
+					vu_Sum[ 1 ] += val1 * val1 / (float)32768.0f / (float)32768.0f;
+					vu_Sum[ 2 ] += val2 * val2 / (float)32768.0f / (float)32768.0f;
+					vu_Sum[ 3 ] += valOPL * valOPL / (float)32768.0f / (float)32768.0f;
+
+					if ( ++ vu_nValues == 256*2 )
 					{
-						float vu_Volume = max( 0.0f, 2.0f * (log10( 0.1f + sqrt( (float)vu_Sum[ i ] / (float)vu_nValues ) ) + 1.0f) );
-						u32 v = vu_Volume * 1024.0f;
-						if ( i == 0 )
+						for ( u32 i = 0; i < 4; i++ )
 						{
-							// moving average
-							float v = min( 1.0f, (float)vuMeter[ 0 ] / 1024.0f );
-							static float led4Avg = 0.0f;
-							led4Avg = led4Avg * 0.8f + v * ( 1.0f - 0.8f );
+							float vu_Volume = max( 0.0f, 2.0f * (log10( 0.1f + sqrt( (float)vu_Sum[ i ] / (float)vu_nValues ) ) + 1.0f) );
+							u32 v = vu_Volume * 1024.0f;
+							if ( i == 0 )
+							{
+								// moving average
+								float v = min( 1.0f, (float)vuMeter[ 0 ] / 1024.0f );
+								static float led4Avg = 0.0f;
+								led4Avg = led4Avg * 0.8f + v * ( 1.0f - 0.8f );
 
-							vu_nLEDs = max( 0, min( 4, (led4Avg * 8.0f) ) );
-							if ( vu_nLEDs > 4 ) vu_nLEDs = 4;
+								vu_nLEDs = max( 0, min( 4, (led4Avg * 8.0f) ) );
+								if ( vu_nLEDs > 4 ) vu_nLEDs = 4;
+							}
+							vuMeter[ i ] = v;
+							vu_Sum[ i ] = 0;
 						}
-						vuMeter[ i ] = v;
-						vu_Sum[ i ] = 0;
+
+						vu_nValues = 0;
 					}
+				}
 
-					vu_nValues = 0;
+				#ifdef COMPILE_MENU
+				if ( screenType == 0 )
+				{
+					#include "oscilloscope_hack.h"
 				}
+				#endif
+			#endif
 			}
 
 			#ifdef COMPILE_MENU
-			if ( screenType == 0 )
-			{
-				#include "oscilloscope_hack.h"
-			} else
+			// the TFT visualizations run once per block on the decimated samples (see sidvis.h)
 			if ( screenType == 1 )
 			{
+				visPushBlock( out );
 				const float scaleVis = 1.0f;
 				const u32 nLevelMeters = 3;
 				#include "tft_sid_vis.h"
-			} 
+			}
 			#endif
-		#endif
 		NoSampleGeneratedYet:;
 		}
 	#endif
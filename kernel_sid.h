@@ -115,6 +115,8 @@ extern unsigned int SID_DigiBoost[2];
 #include "gpio_defs.h"
 #include "latch.h"
 #include "sound.h"
+#include "mixer.h"
+#include "sidvis.h"
 #include "helpers.h"
 
 #ifdef USE_OLED
@@ -203,6 +203,14 @@ void initSID()
 
 	outputDigiblaster = 0;
 
+	// yes, it's 1 byte shifted in the buffer, need to fix: the 1st output channel uses the 'right' volumes
+	mixerReset();
+	mixerSetGain( MIXER_SID1, cfgVolSID1_Right, cfgVolSID1_Left );
+	mixerSetGain( MIXER_SID2, cfgVolSID2_Right, cfgVolSID2_Left );
+	mixerSetGain( MIXER_OPL,  cfgVolOPL_Right,  cfgVolOPL_Left );
+	mixerSetGain( MIXER_DIGIBLASTER, digiblasterVolume, digiblasterVolume );
+	mixerSetGain( MIXER_TED, tedVolume, tedVolume );
+
 	// ring buffer init
 	ringWrite = 0;
 	for ( int i = 0; i < RING_SIZE; i++ )
@@ -222,8 +230,6 @@ unsigned long long cycleCountC64;
 
 // to do: integrate HDMI audio out
 #define SAMPLERATE 44100
-u32 SAMPLERATE_ADJUSTED = SAMPLERATE;
-u32 trackSampleProgress;
 
 #ifdef COMPILE_MENU
 extern CLogger			*logger;
@@ -306,6 +312,7 @@ static void initVisualization()
 	memset( scopeValues, 0, 256 );
 	nPrevLEDs[0] = nPrevLEDs[1] = nPrevLEDs[2] = 0;
 	ledValueAvg[0] = ledValueAvg[1] = ledValueAvg[2] = 0.01f;
+	visInit();
 }
 
 static unsigned char tftBackground2[ 240 * 240 * 2 ];
@@ -350,16 +357,8 @@ void CKernel::Run( void )
 	} else
 	if ( screenType == 1 )
 	{
-		tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-		int w, h; 
 		extern char FILENAME_LOGO_RGBA[128];
-		extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-		if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-		{
-			tftBlendRGBA( tempTGA, tftBackground, 0 );
-		}
+		tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 		tftCopyBackground2Framebuffer();
 
@@ -715,78 +714,94 @@ void CKernel::Run( void )
 			}
 		#endif
 
-			//
-			// mixer
-			//
-			s32 left, right;
-
 			short tedV = 0;
 
 			if ( tedVolume > 0 )
 				tedV = TEDcalcNextSample();
 
-			// yes, it's 1 byte shifted in the buffer, need to fix
-			right = ( val1 * cfgVolSID1_Left  + val2 * cfgVolSID2_Left  + valOPL * cfgVolOPL_Left + 2 * outputDigiblaster * digiblasterVolume + tedV * tedVolume ) >> 8;
-			left  = ( val1 * cfgVolSID1_Right + val2 * cfgVolSID2_Right + valOPL * cfgVolOPL_Right + 2 * outputDigiblaster * digiblasterVolume + tedV * tedVolume ) >> 8;
+			//
+			// mixer: collect one block of samples per source, then mix at once
+			//
+			mixerIn[ MIXER_SID1 ][ mixerPos ] = val1;
+			mixerIn[ MIXER_SID2 ][ mixerPos ] = val2;
+			mixerIn[ MIXER_OPL ][ mixerPos ] = valOPL;
+			mixerIn[ MIXER_DIGIBLASTER ][ mixerPos ] = 2 * outputDigiblaster;
+			mixerIn[ MIXER_TED ][ mixerPos ] = tedV;
 
-			right = max( -32767, min( 32767, right ) );
-			left  = max( -32767, min( 32767, left ) );
+			if ( ++ mixerPos < MIXER_BLOCK_SIZE )
+				continue;
+			mixerPos = 0;
 
-			#ifdef USE_PWM_DIRECT
-			putSample( left, right );
-			#else
-			putSample( left );
-			putSample( right );
-			#endif
+			mixerRenderBlock( MIXER_TED + 1 );
 
-			// vu meter
-			static u32 vu_nValues = 0;
-			static float vu_Sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
-			
-			//if ( vu_Mode != 2 )
+			for ( u32 smp = 0; smp < MIXER_BLOCK_SIZE; smp++ )
 			{
-				float t = (left+right) / (float)32768.0f * 0.5f;
-				vu_Sum[ 0 ] += t * t * 1.0f;
+				s32 left  = mixerOut[ smp * 2 + 0 ];
+				s32 right = mixerOut[ smp * 2 + 1 ];
 
-				vu_Sum[ 1 ] += val1 * val1 / (float)32768.0f / (float)32768.0f;
-				vu_Sum[ 2 ] += val2 * val2 / (float)32768.0f / (float)32768.0f;
-				vu_Sum[ 3 ] += valOPL * valOPL / (float)32768.0f / (float)32768.0f;
+				val1   = mixerIn[ MIXER_SID1 ][ smp ];
+				val2   = mixerIn[ MIXER_SID2 ][ smp ];
+				valOPL = mixerIn[ MIXER_OPL ][ smp ];
 
-				if ( ++ vu_nValues == 256*2 )
+				#ifdef USE_PWM_DIRECT
+				putSample( left, right );
+				#else
+				putSample( left );
+				putSample( right );
+				#endif
+
+				// vu meter
+				static u32 vu_nValues = 0;
+				static float vu_Sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			
+				//if ( vu_Mode != 2 )
 				{
-					for ( u32 i = 0; i < 4; i++ )
+					float t = (left+right) / (float)32768.0f * 0.5f;
+					vu_Sum[ 0 ] += t * t * 1.0f;
+
+					vu_Sum[ 1 ] += val1 * val1 / (float)32768.0f / (float)32768.0f;
+					vu_Sum[ 2 ] += val2 * val2 / (float)32768.0f / (float)32768.0f;
+					vu_Sum[ 3 ] += valOPL * valOPL / (float)32768.0f / (float)32768.0f;
+
+					if ( ++ vu_nValues == 256*2 )
 					{
-						float vu_Volume = max( 0.0f, 2.0f * (log10( 0.1f + sqrt( (float)vu_Sum[ i ] / (float)vu_nValues ) ) + 1.0f) );
-						u32 v = vu_Volume * 1024.0f;
-						if ( i == 0 )
+						for ( u32 i = 0; i < 4; i++ )
 						{
-							// moving average
-							float v = min( 1.0f, (float)vuMeter[ 0 ] / 1024.0f );
-							static float led4Avg = 0.0f;
-							led4Avg = led4Avg * 0.8f + v * ( 1.0f - 0.8f );
-
-							vu_nLEDs = max( 0, min( 4, (led4Avg * 8.0f) ) );
-							if ( vu_nLEDs > 4 ) vu_nLEDs = 4;
+							float vu_Volume = max( 0.0f, 2.0f * (log10( 0.1f + sqrt( (float)vu_Sum[ i ] / (float)vu_nValues ) ) + 1.0f) );
+							u32 v = vu_Volume * 1024.0f;
+							if ( i == 0 )
+							{
+								// moving average
+								float v = min( 1.0f, (float)vuMeter[ 0 ] / 1024.0f );
+								static float led4Avg = 0.0f;
+								led4Avg = led4Avg * 0.8f + v * ( 1.0f - 0.8f );
+
+								vu_nLEDs = max( 0, min( 4, (led4Avg * 8.0f) ) );
+								if ( vu_nLEDs > 4 ) vu_nLEDs = 4;
+							}
+							vuMeter[ i ] = v;
+							vu_Sum[ i ] = 0;
 						}
-						vuMeter[ i ] = v;
-						vu_Sum[ i ] = 0;
+
+						vu_nValues = 0;
 					}
+				}
 
-					vu_nValues = 0;
+				// ugly code which renders 3 oscilloscopes (SID1, SID2, FM) to HDMI and 1 for the OLED
+				if ( screenType == 0 )
+				{
+					#include "oscilloscope_hack.h"
 				}
 			}
 
-			// ugly code which renders 3 oscilloscopes (SID1, SID2, FM) to HDMI and 1 for the OLED
-			if ( screenType == 0 )
-			{
-				#include "oscilloscope_hack.h"
-			} else
+			// the TFT visualizations run once per block on the decimated samples (see sidvis.h)
 			if ( screenType == 1 )
 			{
+				visPushBlock( mixerOut );
 				const float scaleVis = 1.0f;
 				const u32 nLevelMeters = 3;
 				#include "tft_sid_vis.h"
-			} 
+			}
 		}
 	#endif
 	}
@@ -130,6 +130,11 @@ void initSID8()
 		}
 	}
 
+	// odd SIDs are mixed to the 1st, even SIDs to the 2nd output channel (each at half volume)
+	mixerReset();
+	for ( int i = 0; i < NUM_SIDS; i++ )
+		mixerSetGain( i, ( i & 1 ) ? 128 : 0, ( i & 1 ) ? 0 : 128 );
+
 	// ring buffer init
 	ringWrite = 0;
 	for ( int i = 0; i < RING_SIZE; i++ )
@@ -236,6 +241,7 @@ static void initVisualization()
 	memset( scopeValues, 0, 256 );
 	nPrevLEDs[0] = nPrevLEDs[1] = nPrevLEDs[2] = 0;
 	ledValueAvg[0] = ledValueAvg[1] = ledValueAvg[2] = 0.01f;
+	visInit();
 }
 
 static unsigned char tftBackground2[ 240 * 240 * 2 ];
@@ -273,14 +279,6 @@ static void prepareOnReset( bool refresh = false )
 	resetCounter = cycleCountC64 = nCyclesEmulated = samplesElapsed = 0;
 }
 
-extern u32 SAMPLERATE_ADJUSTED;
-extern u32 nSamplesPrecompute;
-extern u32 trackSampleProgress;
-
-static s32 avgSamplesAvail = 0;
-static s32 avgCounter = 0;
-static u32 adjustRateAllowed = 0;
-static u32 targetSamplesAvail = 0, targetCount = 0;
 
 extern u32 fillSoundBuffer;
 extern bool CVCHIQ_CB_Manual;
@@ -319,16 +317,8 @@ void CKernel::Run( void )
 	} else
 	if ( screenType == 1 )
 	{
-		tftLoadBackgroundTGA( DRIVE, FILENAME_SPLASH_RGB, 8 );
-
-		int w, h; 
 		extern char FILENAME_LOGO_RGBA[128];
-		extern unsigned char tempTGA[ 256 * 256 * 4 ];
-
-		if ( tftLoadTGA( DRIVE, FILENAME_LOGO_RGBA, tempTGA, &w, &h, true ) )
-		{
-			tftBlendRGBA( tempTGA, tftBackground, 0 );
-		}
+		tftLoadBackgroundWithLogo( DRIVE, FILENAME_SPLASH_RGB, 8, FILENAME_LOGO_RGBA );
 
 		tftCopyBackground2Framebuffer();
 
@@ -475,6 +465,8 @@ startHereAfterReset:
 	samplesElapsed = 0;
 	ringRead = ringWrite = 0;
 
+	hdmiSyncReset( CLOCKFREQ, SAMPLERATE );
+
 	latchSetClear( 0, allUsedLEDs );
 
 	static u32 hdmiVol = 1;
@@ -503,7 +495,9 @@ startHereAfterReset:
 		}
 		if ( cycleCountC64 > 2000000 && resetCounter > 500000 ) {
 			CVCHIQ_CB_Manual = false;
-			//logger->Write( "", LogNotice, "adjusted sample rate: %u Hz", (u32)SAMPLERATE_ADJUSTED );
+			if ( outputHDMI )
+				logger->Write( "", LogNotice, "HDMI sync (%s): fill %d (target %d, min %d, max %d), rate %u Hz (%d ppm), underruns %u, overruns %u, fallbacks %u", hdmiProfiles[ hdmiProfileActive ].name,
+					hdmiSync.fillAvg, hdmiSync.target, hdmiSync.fillMin, hdmiSync.fillMax, hdmiSync.rateHz, hdmiSync.ppm, hdmiSync.underruns, hdmiSync.overruns, hdmiSync.fallbacks );
 			quitSID8();
 			EnableIRQs();
 			m_InputPin.DisableInterrupt();
@@ -519,17 +513,13 @@ startHereAfterReset:
 				if ( outputHDMI )
 				{
 					CVCHIQSoundBaseDevice *sd = (CVCHIQSoundBaseDevice*)m_pSound;
+					sd->DrainSpanQueue();
 					while ( sd->IsActive() ) {}
 					//sd->SetControl( VCHIQ_SOUND_VOLUME_DEFAULT, VCHIQSoundDestinationAuto );
 					hdmiVol = 1;
 				}
 				nSamplesInThisRun = startVCHIQ = 0;
 				initSoundOutput( &m_pSound, pVCHIQ, outputPWM, outputHDMI );
-				avgSamplesAvail = 0;
-				avgCounter = 0;
-				adjustRateAllowed = 0;
-				targetSamplesAvail = 0;
-				targetCount = 0;
 			}
 
 			resetReleased = 0xff;
@@ -584,7 +574,7 @@ startHereAfterReset:
 					CVCHIQ_CB_Device = NULL;
 				}
 
-				if ( samplesElapsed > 8 * nSamplesPrecompute / 2 && !startVCHIQ )
+				if ( samplesElapsed > nSamplesStart && !startVCHIQ )
 				{
 					m_pSound->Start();
 					fillSoundBuffer = 1;
@@ -595,79 +585,12 @@ startHereAfterReset:
 				if ( fillSoundBuffer )
 				{
 					fillSoundBuffer = 0;
-
-					extern u32 samplesInBuffer();
-					#define TYPE		s16
-					#define TYPE_SIZE	sizeof (s16)
-
-					s32 nFramesComputed = samplesInBuffer();
-					s32 nFramesMax = m_pSound->GetQueueSizeFrames() - m_pSound->GetQueueFramesAvail();
-					trackSampleProgress = 1024 * 1024 + ( nFramesComputed - nFramesMax );
-
-					s32 nWriteFrames = min( nFramesComputed, nFramesMax );
-
-				#if 1
-					if ( nWriteFrames * 2 + PCMCountLast > PCMBufferSize )
-					{
-						m_pSound->Write( &PCMBuffer[ PCMCountLast ], (PCMBufferSize - PCMCountLast) * TYPE_SIZE );
-						m_pSound->Write( &PCMBuffer[ 0 ], (2 * nWriteFrames - (PCMBufferSize - PCMCountLast)) * TYPE_SIZE );
-					} else
-					{
-						m_pSound->Write( &PCMBuffer[ PCMCountLast ], 2 * nWriteFrames * TYPE_SIZE );
-					}
-					PCMCountLast += nWriteFrames * 2;
-					PCMCountLast %= PCMBufferSize;
-				#else
-					short temp[ 16384 ];
-					short *p = (short*)temp;
-					for ( u32 j = 0; j < nWriteFrames; j++ )
-					{
-						*(p++) = PCMBuffer[ PCMCountLast++ ];
-						*(p++) = PCMBuffer[ PCMCountLast++ ];
-						PCMCountLast %= PCMBufferSize;
-					}
-
-					unsigned nWriteBytes = 2 * nWriteFrames * TYPE_SIZE;
-					m_pSound->Write( &temp[ 0 ], nWriteBytes );
-				#endif
+					updateHDMISync( samplesElapsed );
 				}
-				if ( nSamplesInThisRun > 2205 / 8 )
+				// yield 8 times per queue length
+				if ( nSamplesInThisRun > nSamplesPrecompute / 8 )
 				{
-					//trackSampleProgress = 1024 * 1024 + ( nFramesComputed - nFramesMax );
-					if ( trackSampleProgress )
-					{
-						avgSamplesAvail += (s32)trackSampleProgress - 1024 * 1024;
-						avgCounter ++;
-
-						if ( avgCounter > 50 )
-						{
-							s32 avail = (s32)avgSamplesAvail / avgCounter;
-							if ( targetSamplesAvail == 0 && ++ targetCount > 2 )
-								CVCHIQ_CB_Manual = true; 
-							if ( targetSamplesAvail == 0 && ++ targetCount > 10 )
-								targetSamplesAvail = max( avail, (s32)nSamplesPrecompute );
-
-							if ( targetSamplesAvail != 0 )
-							{
-								if ( avail < (s32)targetSamplesAvail )
-								{
-									if ( avail < 5 * (s32)targetSamplesAvail / 100 && SAMPLERATE_ADJUSTED < SAMPLERATE )
-										SAMPLERATE_ADJUSTED = SAMPLERATE; else
-										SAMPLERATE_ADJUSTED ++; 
-								} else
-								if ( avail > (s32)targetSamplesAvail )
-								{
-									if ( avail > 105 * (s32)targetSamplesAvail / 100 && SAMPLERATE_ADJUSTED > SAMPLERATE )
-										SAMPLERATE_ADJUSTED = SAMPLERATE; else
-										SAMPLERATE_ADJUSTED --; 
-								}
-								adjustRateAllowed = 0;
-							}
-							//logger->Write( "", LogNotice, "samples ahead: %d (target: %d), rate: %u Hz", avail, targetSamplesAvail, SAMPLERATE_ADJUSTED );
-							avgSamplesAvail = avgCounter = 0;
-						}
-						trackSampleProgress = 0;
-					}
+					//logger->Write( "", LogNotice, "fill: %d (target: %d), rate: %u Hz", hdmiSync.fillAvg, hdmiSync.target, hdmiSync.rateHz );
 
 					{
 						if ( nCyclesEmulated < (4*256000) )
@@ -689,7 +612,8 @@ startHereAfterReset:
 			CACHE_PRELOADL2STRMW( &smpCur );
 
 			static u32 carrySamples = 0;
-			u32 samplesToEmulateX65536 = ( ( unsigned long long )65536 * ( unsigned long long )CLOCKFREQ ) / ( unsigned long long )SAMPLERATE_ADJUSTED + ( unsigned long long )carrySamples;
+			// fractional resampling: the step between two samples is steered by the HDMI clock drift controller
+			u32 samplesToEmulateX65536 = cyclesPerSampleX65536 + carrySamples;
 
 			u32 samplesToEmulate = samplesToEmulateX65536 >> 16;
 			carrySamples = (samplesToEmulateX65536 & 65535);
@@ -725,94 +649,100 @@ startHereAfterReset:
 
 			}
 
-			samplesElapsed = ( ( unsigned long long )nCyclesEmulated * ( unsigned long long )SAMPLERATE_ADJUSTED ) / ( unsigned long long )CLOCKFREQ;
+			samplesElapsed ++;
 
 			//
-			// mixer
+			// mixer: collect one block of samples per source, then mix at once
 			//
+			for ( u32 i = 0; i < NUM_SIDS; i++ )
+				mixerIn[ i ][ mixerPos ] = sid[ i ]->output();
 
-			CACHE_PRELOADL2STRMW( &sampleBuffer[ smpCur ] );
-			s32 left = 0, right = 0;
-			
-			// yes, it's 1 byte shifted in the buffer, need to fix
-			s32 l1, l2, l3, l4, r1, r2, r3, r4;
-			l1 = sid[1]->output();
-			l2 = sid[3]->output();
-			l3 = sid[5]->output();
-			l4 = sid[7]->output();
-			r1 = sid[0]->output();
-			r2 = sid[2]->output();
-			r3 = sid[4]->output();
-			r4 = sid[6]->output();
-
-			left = ( l1 + l2 + l3 + l4 ) >> 1;
-			right = ( r1 + r2 + r3 + r4 ) >> 1;
-
-			right = max( -32767, min( 32767, right ) );
-			left  = max( -32767, min( 32767, left ) );
-
-			#ifdef USE_PWM_DIRECT
-			if ( outputPWM )
-				putSample( left, right );
+			if ( ++ mixerPos < MIXER_BLOCK_SIZE )
+				continue;
+			mixerPos = 0;
+
+			// with HDMI output the block is mixed directly into the queue of the sound device
+			s16 *out = mixerOut;
+			#ifdef USE_VCHIQ_SOUND
+			s16 *span = outputHDMI ? hdmiReserveBlock() : NULL;
+			if ( span )
+				out = span;
 			#endif
+
+			mixerRenderBlock( NUM_SIDS, out );
+
 			#ifdef USE_VCHIQ_SOUND
-			if ( outputHDMI )
-			{
-				putSample( left );
-				putSample( right );
-			}
+			// the device only reads committed frames and we only read from the block below
+			if ( span )
+				hdmiCommitBlock();
 			#endif
 
-		#if 1
-			// vu meter
-			static u32 vu_nValues = 0;
-			static float vu_Sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
-			
-			//if ( vu_Mode != 2 )
+			CACHE_PRELOADL2STRMW( &sampleBuffer[ smpCur ] );
+
+			for ( u32 smp = 0; smp < MIXER_BLOCK_SIZE; smp++ )
 			{
-				float t = (left+right) / (float)32768.0f * 0.5f;
-				vu_Sum[ 0 ] += t * t * 1.0f;
+				s32 left  = out[ smp * 2 + 0 ];
+				s32 right = out[ smp * 2 + 1 ];
 
-				vu_Sum[ 1 ] += left * left/ (float)32768.0f / (float)32768.0f;
-				vu_Sum[ 2 ] += right * right / (float)32768.0f / (float)32768.0f;
-				//vu_Sum[ 3 ] += valOPL * valOPL / (float)32768.0f / (float)32768.0f;
+				#ifdef USE_PWM_DIRECT
+				if ( outputPWM )
+					putSample( left, right );
+				#endif
 
-				if ( ++ vu_nValues == 256*2 )
+			#if 1
+				// vu meter
+				static u32 vu_nValues = 0;
+				static float vu_Sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			
+				//if ( vu_Mode != 2 )
 				{
-					for ( u32 i = 0; i < 3; i++ )
+					float t = (left+right) / (float)32768.0f * 0.5f;
+					vu_Sum[ 0 ] += t * t * 1.0f;
+
+					vu_Sum[ 1 ] += left * left/ (float)32768.0f / (float)32768.0f;
+					vu_Sum[ 2 ] += right * right / (float)32768.0f / (float)32768.0f;
+					//vu_Sum[ 3 ] += valOPL * valOPL / (float)32768.0f / (float)32768.0f;
+
+					if ( ++ vu_nValues == 256*2 )
 					{
-						float vu_Volume = max( 0.0f, 2.0f * (log10( 0.1f + sqrt( (float)vu_Sum[ i ] / (float)vu_nValues ) ) + 1.0f) );
-						u32 v = vu_Volume * 1024.0f;
-						if ( i == 0 )
+						for ( u32 i = 0; i < 3; i++ )
 						{
-							// moving average
-							float v = min( 1.0f, (float)vuMeter[ 0 ] / 1024.0f );
-							static float led4Avg = 0.0f;
-							led4Avg = led4Avg * 0.8f + v * ( 1.0f - 0.8f );
+							float vu_Volume = max( 0.0f, 2.0f * (log10( 0.1f + sqrt( (float)vu_Sum[ i ] / (float)vu_nValues ) ) + 1.0f) );
+							u32 v = vu_Volume * 1024.0f;
+							if ( i == 0 )
+							{
+								// moving average
+								float v = min( 1.0f, (float)vuMeter[ 0 ] / 1024.0f );
+								static float led4Avg = 0.0f;
+								led4Avg = led4Avg * 0.8f + v * ( 1.0f - 0.8f );
 
-							vu_nLEDs = max( 0, min( 4, (led4Avg * 8.0f) ) );
-							if ( vu_nLEDs > 4 ) vu_nLEDs = 4;
+								vu_nLEDs = max( 0, min( 4, (led4Avg * 8.0f) ) );
+								if ( vu_nLEDs > 4 ) vu_nLEDs = 4;
+							}
+							vuMeter[ i ] = v;
+							vu_Sum[ i ] = 0;
 						}
-						vuMeter[ i ] = v;
-						vu_Sum[ i ] = 0;
+
+						vu_nValues = 0;
 					}
+				}
 
-					vu_nValues = 0;
+				// ugly code which renders 3 oscilloscopes (SID1, SID2, FM) to HDMI and 1 for the OLED
+				if ( screenType == 0 )
+				{
+					#include "oscilloscope_hack.h"
 				}
+			#endif
 			}
 
-			// ugly code which renders 3 oscilloscopes (SID1, SID2, FM) to HDMI and 1 for the OLED
-			if ( screenType == 0 )
-			{
-				#include "oscilloscope_hack.h"
-			} else
+			// the TFT visualizations run once per block on the decimated samples (see sidvis.h)
 			if ( screenType == 1 )
 			{
+				visPushBlock( out );
 				const float scaleVis = 2.0f;
 				const u32 nLevelMeters = 2;
 				#include "tft_sid_vis.h"
-			} 
-		#endif
+			}
 		}
 	#endif
 	}
@@ -78,6 +78,8 @@
 #include "gpio_defs.h"
 #include "latch.h"
 #include "sound.h"
+#include "mixer.h"
+#include "sidvis.h"
 #include "helpers.h"
 
 #ifdef USE_OLED
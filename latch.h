@@ -181,6 +181,21 @@ static __attribute__( ( always_inline ) ) inline void put4BitCommand( u32 c )
 	i2cBufferCountCur &= ( FAKE_I2C_BUF_SIZE - 1 );
 }
 
+// 16 commands at once, the first one in the lowest 4 bits (one 8 byte store unless unaligned or wrapping around)
+static __attribute__( ( always_inline ) ) inline void put4BitCommands16( u64 c )
+{
+	if ( ( i2cBufferCountCur & 1 ) || i2cBufferCountCur > FAKE_I2C_BUF_SIZE - 16 )
+	{
+		for ( u32 i = 0; i < 16; i++, c >>= 4 )
+			put4BitCommand( (u32)c );
+	} else
+	{
+		memcpy( &i2cBuffer[ i2cBufferCountCur >> 1 ], &c, 8 );
+		i2cBufferCountCur += 16;
+		i2cBufferCountCur &= ( FAKE_I2C_BUF_SIZE - 1 );
+	}
+}
+
 static __attribute__( ( always_inline ) ) inline u32 get4BitCommand()
 {
 	u32 memOfs = i2cBufferCountLast >> 1;
@@ -282,6 +297,8 @@ static __attribute__( ( always_inline ) ) inline void flushI2CBuffer( bool witho
 	i2cBufferCountLast = i2cBufferCountCur = 0;
 }
 
+// 4-bit commands: bits 3-2 select SCL, SDA, LED3 (reset) or LED2 (DC), bit 0 is the new value.
+// bit 1 set (only used with bits 3-2 = 0): SCL low and SDA = bit 0 in one latch update, i.e. one entry per clock edge
 static __attribute__( ( always_inline ) ) inline void prepareOutputLatch4Bit()
 {
 	test:
@@ -289,13 +306,19 @@ static __attribute__( ( always_inline ) ) inline void prepareOutputLatch4Bit()
 	{
 		u32 v = get4BitCommand();
 
-		const u32 tab[4] = { LATCH_SCL, LATCH_SDA, LATCH_LED3, LATCH_LED2 };
-		u32 c = tab[ v >> 2 ]; 
-
 		u32 oldLatchD = latchD;
-		if ( v & 1 )
-			latchD |= c; else
-			latchD &= ~c;
+		if ( v & 2 )
+		{
+			latchD = ( latchD & ~( LATCH_SCL | LATCH_SDA ) ) | ( ( v & 1 ) << D7 );
+		} else
+		{
+			const u32 tab[4] = { LATCH_SCL, LATCH_SDA, LATCH_LED3, LATCH_LED2 };
+			u32 c = tab[ v >> 2 ]; 
+
+			if ( v & 1 )
+				latchD |= c; else
+				latchD &= ~c;
+		}
 		if ( oldLatchD == latchD )
 			goto test;
 	} else
@@ -47,6 +47,11 @@ static const char FILENAME_CBM128[] = "SD:C64/launch128.cbm80";	// launch code (
 static u32	configGAMEEXROMSet, configGAMEEXROMClr;
 static u32	disableCart, ultimaxDisabled, transferStarted, currentOfs, transferPart;
 
+// PRG window: writing page n to $DE03 shows the PRG pages n..n+15 (of the current part) at $9000-$9FFF,
+// writing to $DE04 switches back to the launch code. The C64 copies from there with LDA abs,Y/STA (zp),Y
+// instead of one LDA $DE00 per byte (see WINDOWCOPY in C64Side/cart.a)
+static u32	prgWindow, prgWindowBase;
+
 static u32 prgSize;
 static unsigned char prgData[ 65536 ] AAA;
 static u32 startAddr, prgSizeAboveA000, prgSizeBelowA000;
@@ -111,6 +116,7 @@ static void launchInitLoader( bool ultimax, bool c128 )
 static void launchPrepareAndWarmCache()
 {
 	disableCart = transferStarted = currentOfs = 0;
+	prgWindow = prgWindowBase = 0;
 	transferPart = 1;
 
 	// launch code / CBM80
@@ -128,7 +134,21 @@ static void launchPrepareAndWarmCache()
 	if ( !disableCart )	{														\
 		if ( IO1_ACCESS ) {														\
 			if ( CPU_WRITES_TO_BUS ) {											\
-				/* any write to IO1 will (re)start the PRG transfer */			\
+				/* $DE03/$DE04: PRG window on/off, see above */					\
+				if ( GET_IO12_ADDRESS == 3 ) {									\
+					READ_D0to7_FROM_BUS( D )									\
+					prgWindowBase = ( transferPart == 1 ? prgSizeBelowA000 + 2 : 2 ) + ( D << 8 ); \
+					prgWindow = 1;												\
+					CACHE_PRELOADL2KEEP( &prgData[ prgWindowBase & 0xffff ] );	\
+					FINISH_BUS_HANDLING											\
+					return;														\
+				}																\
+				if ( GET_IO12_ADDRESS == 4 ) {									\
+					prgWindow = 0;												\
+					FINISH_BUS_HANDLING											\
+					return;														\
+				}																\
+				/* any other write to IO1 will (re)start the PRG transfer */	\
 				transferStarted = 1;											\
 				if ( GET_IO12_ADDRESS == 2 ) {									\
 					currentOfs = prgSizeBelowA000 + 2;							\
@@ -184,9 +204,13 @@ static void launchPrepareAndWarmCache()
 			}																	\
 		}																		\
 																				\
-		/* access to CBM80 ROM (launch code) */									\
-		if ( CPU_READS_FROM_BUS && ROML_ACCESS )								\
-			WRITE_D0to7_TO_BUS( launchCode[ GET_ADDRESS + LAUNCH_BYTES_TO_SKIP ] );	\
+		/* access to CBM80 ROM (launch code) or the PRG window at $9000 */		\
+		if ( CPU_READS_FROM_BUS && ROML_ACCESS ) {								\
+			if ( prgWindow && ( GET_ADDRESS & 0x1000 ) )						\
+				D = prgData[ ( prgWindowBase + ( GET_ADDRESS & 0x0fff ) ) & 0xffff ]; else \
+				D = launchCode[ GET_ADDRESS + LAUNCH_BYTES_TO_SKIP ];			\
+			WRITE_D0to7_TO_BUS( D );											\
+		}																		\
 																				\
 		OUTPUT_LATCH_AND_FINISH_BUS_HANDLING									\
 		return;																	\
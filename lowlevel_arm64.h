@@ -31,6 +31,7 @@
 #define _lowlevel_arm_h
 
 #include <circle/types.h>
+#include "fiqstats.h"
 
 #ifndef MACHINE_C264
 extern u32 WAIT_FOR_SIGNALS;
@@ -163,6 +164,7 @@ extern u32 machine264;
 		register u32 DD = ( (D) & 255 ) << D0;											\
 		write32( ARM_GPIO_GPSET0, DD  );												\
 		write32( ARM_GPIO_GPCLR0, (D_FLAG & ( ~DD )) | (1 << GPIO_OE) | bCTRL257 );		\
+		FIQ_STATS_DATA( WAIT_CYCLE_READ )												\
 		WAIT_UP_TO_CYCLE( WAIT_CYCLE_READ );											\
 		write32( ARM_GPIO_GPSET0, (1 << GPIO_OE) );													
 
@@ -178,6 +180,7 @@ extern u32 machine264;
 		register u32 DD = ( (D) & 255 ) << D0;											\
 		write32( ARM_GPIO_GPSET0, DD  );												\
 		write32( ARM_GPIO_GPCLR0, (D_FLAG & ( ~DD )) | (1 << GPIO_OE) | bCTRL257 );		\
+		FIQ_STATS_DATA( WAIT_CYCLE_READ_VIC2 )											\
 		WAIT_UP_TO_CYCLE( WAIT_CYCLE_READ_VIC2 );										\
 		write32( ARM_GPIO_GPSET0, (1 << GPIO_OE) );													
 
@@ -185,12 +188,14 @@ extern u32 machine264;
 		register u32 DD = ( (D) & 255 ) << D0;											\
 		write32( ARM_GPIO_GPSET0, DD  );												\
 		write32( ARM_GPIO_GPCLR0, (D_FLAG & ( ~DD )) | (1 << GPIO_OE) | bCTRL257 );		\
+		FIQ_STATS_DATA( WAIT_CYCLE_READ_BADLINE )										\
 		WAIT_UP_TO_CYCLE( WAIT_CYCLE_READ_BADLINE );									\
 		write32( ARM_GPIO_GPSET0, (1 << GPIO_OE) );													
 
 #define GET_DATA_FROM_BUS_AND_CLEAR257( D ) \
 			SET_BANK2_INPUT															\
 			write32( ARM_GPIO_GPCLR0, (1 << GPIO_OE) | bCTRL257 );					\
+			FIQ_STATS_DATA( WAIT_CYCLE_WRITEDATA )									\
 			WAIT_UP_TO_CYCLE( WAIT_CYCLE_WRITEDATA );								\
 			D = ( read32( ARM_GPIO_GPLEV0 ) >> D0 ) & 255;							\
 			write32( ARM_GPIO_GPSET0, 1 << GPIO_OE );								\
@@ -0,0 +1,136 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ md5.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - MD5 message digest (RFC 1321), e.g. for the HVSC databases and the PSID cache
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include "md5.h"
+
+static const u32 md5K[ 64 ] =
+{
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const u8 md5R[ 16 ] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+static void md5Block( u32 *state, const u8 *block )
+{
+	u32 m[ 16 ];
+	for ( u32 i = 0; i < 16; i++ )
+		m[ i ] = block[ i * 4 ] | ( block[ i * 4 + 1 ] << 8 ) | ( block[ i * 4 + 2 ] << 16 ) | ( (u32)block[ i * 4 + 3 ] << 24 );
+
+	u32 a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+
+	for ( u32 i = 0; i < 64; i++ )
+	{
+		u32 f, g;
+		switch ( i >> 4 )
+		{
+		case 0:  f = ( b & c ) | ( ~b & d ); g = i; break;
+		case 1:  f = ( d & b ) | ( ~d & c ); g = ( 5 * i + 1 ) & 15; break;
+		case 2:  f = b ^ c ^ d;              g = ( 3 * i + 5 ) & 15; break;
+		default: f = c ^ ( b | ~d );         g = ( 7 * i ) & 15; break;
+		}
+
+		u32 r = md5R[ ( ( i >> 4 ) << 2 ) | ( i & 3 ) ];
+		u32 t = a + f + md5K[ i ] + m[ g ];
+		a = d; d = c; c = b;
+		b += ( t << r ) | ( t >> ( 32 - r ) );
+	}
+
+	state[ 0 ] += a; state[ 1 ] += b; state[ 2 ] += c; state[ 3 ] += d;
+}
+
+void md5Init( MD5CTX *ctx )
+{
+	ctx->state[ 0 ] = 0x67452301;
+	ctx->state[ 1 ] = 0xefcdab89;
+	ctx->state[ 2 ] = 0x98badcfe;
+	ctx->state[ 3 ] = 0x10325476;
+	ctx->count = 0;
+}
+
+void md5Update( MD5CTX *ctx, const void *data, u32 size )
+{
+	const u8 *p = (const u8 *)data;
+	u32 fill = (u32)( ctx->count & 63 );
+	ctx->count += size;
+
+	if ( fill )
+	{
+		u32 n = 64 - fill;
+		if ( size < n )
+		{
+			memcpy( ctx->buffer + fill, p, size );
+			return;
+		}
+		memcpy( ctx->buffer + fill, p, n );
+		md5Block( ctx->state, ctx->buffer );
+		p += n; size -= n;
+	}
+
+	for ( ; size >= 64; p += 64, size -= 64 )
+		md5Block( ctx->state, p );
+
+	if ( size )
+		memcpy( ctx->buffer, p, size );
+}
+
+void md5Final( MD5CTX *ctx, u8 *digest )
+{
+	u64 bits = ctx->count * 8;
+	u8 pad[ 72 ];
+	u32 fill = (u32)( ctx->count & 63 );
+	u32 n = ( fill < 56 ? 56 : 120 ) - fill;
+
+	memset( pad, 0, sizeof( pad ) );
+	pad[ 0 ] = 0x80;
+	for ( u32 i = 0; i < 8; i++ )
+		pad[ n + i ] = (u8)( bits >> ( i * 8 ) );
+	md5Update( ctx, pad, n + 8 );
+
+	for ( u32 i = 0; i < 16; i++ )
+		digest[ i ] = (u8)( ctx->state[ i >> 2 ] >> ( ( i & 3 ) * 8 ) );
+}
+
+void md5ToHex( const u8 *digest, char *hex )
+{
+	static const char digits[] = "0123456789abcdef";
+	for ( u32 i = 0; i < MD5_DIGEST_SIZE; i++ )
+	{
+		hex[ i * 2 + 0 ] = digits[ digest[ i ] >> 4 ];
+		hex[ i * 2 + 1 ] = digits[ digest[ i ] & 15 ];
+	}
+	hex[ MD5_DIGEST_SIZE * 2 ] = 0;
+}
@@ -0,0 +1,51 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ md5.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - MD5 message digest (RFC 1321), e.g. for the HVSC databases and the PSID cache
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _md5_h
+#define _md5_h
+
+#include <circle/types.h>
+
+#define MD5_DIGEST_SIZE		16
+
+typedef struct
+{
+	u32 state[ 4 ];
+	u64 count;				// bytes
+	u8  buffer[ 64 ];
+} MD5CTX;
+
+extern void md5Init( MD5CTX *ctx );
+extern void md5Update( MD5CTX *ctx, const void *data, u32 size );
+extern void md5Final( MD5CTX *ctx, u8 *digest );
+
+// lower case, 32 characters + terminating 0
+extern void md5ToHex( const u8 *digest, char *hex );
+
+#endif
@@ -0,0 +1,55 @@
+/*
+  _________.__    .___      __   .__        __           _________                        .___
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __      /   _____/ ____  __ __  ____    __| _/
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /      \_____  \ /  _ \|  |  \/    \  / __ |
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <       /        (  <_> )  |  /   |  \/ /_/ |
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     /_______  /\____/|____/|___|  /\____ |
+        \/         \/    \/     \/       \/     \/             \/                  \/      \/
+
+ mixer.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - fixed-point stereo mixer shared by all SID kernels
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include "lowlevel_arm64.h"
+#include "mixer.h"
+
+s16 mixerIn[ MIXER_MAX_SOURCES ][ MIXER_BLOCK_SIZE ] AAA;
+s16 mixerOut[ MIXER_BLOCK_SIZE * 2 ] AAA;
+s16 mixerGain1st[ MIXER_MAX_SOURCES ], mixerGain2nd[ MIXER_MAX_SOURCES ];
+u32 mixerPos = 0;
+
+void mixerReset()
+{
+	memset( mixerIn, 0, sizeof( mixerIn ) );
+	memset( mixerOut, 0, sizeof( mixerOut ) );
+	memset( mixerGain1st, 0, sizeof( mixerGain1st ) );
+	memset( mixerGain2nd, 0, sizeof( mixerGain2nd ) );
+	mixerPos = 0;
+}
+
+void mixerSetGain( u32 source, s32 gain1st, s32 gain2nd )
+{
+	if ( source >= MIXER_MAX_SOURCES )
+		return;
+
+	mixerGain1st[ source ] = gain1st;
+	mixerGain2nd[ source ] = gain2nd;
+}
@@ -0,0 +1,133 @@
+/*
+  _________.__    .___      __   .__        __           _________                        .___
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __      /   _____/ ____  __ __  ____    __| _/
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /      \_____  \ /  _ \|  |  \/    \  / __ |
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <       /        (  <_> )  |  /   |  \/ /_/ |
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     /_______  /\____/|____/|___|  /\____ |
+        \/         \/    \/     \/       \/     \/             \/                  \/      \/
+
+ mixer.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - fixed-point stereo mixer shared by all SID kernels
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _mixer_h_
+#define _mixer_h_
+
+#include <circle/types.h>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+//
+// the emulation loops write one sample per source into mixerIn[ source ][ mixerPos ],
+// once a block is complete it is mixed at once:
+//   out = saturate16( sum( in * gain ) >> 8 ), gains are 8.8 fixed point (256 = 1.0)
+//
+#define MIXER_BLOCK_SIZE	32		// must be a multiple of 8
+#define MIXER_MAX_SOURCES	8
+
+// source slots used by the kernels (kernel_sid8 uses all 8 slots for its SIDs)
+enum
+{
+	MIXER_SID1 = 0,
+	MIXER_SID2 = 1,
+	MIXER_OPL = 2,
+	MIXER_MIDI = 3,
+	MIXER_DIGIBLASTER = 4,
+	MIXER_TED = 5
+};
+
+extern s16 mixerIn[ MIXER_MAX_SOURCES ][ MIXER_BLOCK_SIZE ];
+extern s16 mixerOut[ MIXER_BLOCK_SIZE * 2 ];	// interleaved, 1st/2nd sample as passed to putSample
+extern s16 mixerGain1st[ MIXER_MAX_SOURCES ], mixerGain2nd[ MIXER_MAX_SOURCES ];
+extern u32 mixerPos;
+
+// clears all buffers and gains
+extern void mixerReset();
+
+// gains in 1/256 for the 1st and 2nd output channel
+extern void mixerSetGain( u32 source, s32 gain1st, s32 gain2nd );
+
+//
+// mixes sources 0..nSources-1 of the current block into out (interleaved, MIXER_BLOCK_SIZE frames),
+// by default mixerOut, the SID kernels pass a span of the HDMI device queue instead. The result saturates
+// at -32768..32767 in all kernels (kernel_sid clipped at -31766..31765 before, kernel_sid8/264 at +-32767)
+//
+static __attribute__( ( always_inline ) ) inline void mixerRenderBlock( u32 nSources, s16 *out = mixerOut )
+{
+#ifdef __ARM_NEON
+	for ( u32 i = 0; i < MIXER_BLOCK_SIZE; i += 8 )
+	{
+		int32x4_t acc1Lo = vdupq_n_s32( 0 ), acc1Hi = vdupq_n_s32( 0 );
+		int32x4_t acc2Lo = vdupq_n_s32( 0 ), acc2Hi = vdupq_n_s32( 0 );
+
+		for ( u32 s = 0; s < nSources; s++ )
+		{
+			int16x8_t v = vld1q_s16( &mixerIn[ s ][ i ] );
+			acc1Lo = vmlal_n_s16( acc1Lo, vget_low_s16( v ), mixerGain1st[ s ] );
+			acc1Hi = vmlal_high_n_s16( acc1Hi, v, mixerGain1st[ s ] );
+			acc2Lo = vmlal_n_s16( acc2Lo, vget_low_s16( v ), mixerGain2nd[ s ] );
+			acc2Hi = vmlal_high_n_s16( acc2Hi, v, mixerGain2nd[ s ] );
+		}
+
+		// saturating shift and narrow, then store interleaved
+		int16x8x2_t o;
+		o.val[ 0 ] = vcombine_s16( vqshrn_n_s32( acc1Lo, 8 ), vqshrn_n_s32( acc1Hi, 8 ) );
+		o.val[ 1 ] = vcombine_s16( vqshrn_n_s32( acc2Lo, 8 ), vqshrn_n_s32( acc2Hi, 8 ) );
+		vst2q_s16( &out[ i * 2 ], o );
+	}
+#else
+	for ( u32 i = 0; i < MIXER_BLOCK_SIZE; i ++ )
+	{
+		s32 a = 0, b = 0;
+		for ( u32 s = 0; s < nSources; s++ )
+		{
+			a += (s32)mixerIn[ s ][ i ] * mixerGain1st[ s ];
+			b += (s32)mixerIn[ s ][ i ] * mixerGain2nd[ s ];
+		}
+		a >>= 8; b >>= 8;
+		out[ i * 2 + 0 ] = a < -32768 ? -32768 : ( a > 32767 ? 32767 : a );
+		out[ i * 2 + 1 ] = b < -32768 ? -32768 : ( b > 32767 ? 32767 : b );
+	}
+#endif
+}
+
+//
+// converts a block of float samples (-1..1, e.g. from TinySoundFont) into a source slot
+//
+static __attribute__( ( always_inline ) ) inline void mixerConvertFloatBlock( u32 source, const float *in )
+{
+#ifdef __ARM_NEON
+	for ( u32 i = 0; i < MIXER_BLOCK_SIZE; i += 8 )
+	{
+		int32x4_t lo = vcvtq_s32_f32( vmulq_n_f32( vld1q_f32( &in[ i ] ), 32767.0f ) );
+		int32x4_t hi = vcvtq_s32_f32( vmulq_n_f32( vld1q_f32( &in[ i + 4 ] ), 32767.0f ) );
+		vst1q_s16( &mixerIn[ source ][ i ], vcombine_s16( vqmovn_s32( lo ), vqmovn_s32( hi ) ) );
+	}
+#else
+	for ( u32 i = 0; i < MIXER_BLOCK_SIZE; i ++ )
+	{
+		s32 v = (s32)( in[ i ] * 32767.0f );
+		mixerIn[ source ][ i ] = v < -32768 ? -32768 : ( v > 32767 ? 32767 : v );
+	}
+#endif
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include "lowlevel_arm64.h"
 #include "latch.h"
 #include "helpers.h"
+#include "skinformat.h"
 
 u8 oledFrameBuffer[ 128 * 64 / 8 ];
 
@@ -42,11 +43,22 @@ void oledClear()
 	memset( oledFrameBuffer, 0, 128 * 64 / 8 );
 }
 
-static u32 sfb_j, sfb_y, sfb_x;
+//
+// incremental update (SID kernels): the panel contents are kept in a shadow copy and only the runs of changed columns
+// of each page are sent, each as an addressing window (horizontal addressing mode, see ssd1306_init_sequence) followed
+// by the data. Unchanged columns between two changes are sent along if this is cheaper than a new window.
+// Everything which writes to the panel directly (splash screens) invalidates the shadow, the next update is complete.
+//
+#define OLED_WINDOW_COST	10		// bytes for the addressing commands and the data header of a run
+
+static u8  oledShadow[ 128 * 64 / 8 ];
+static u32 oledShadowValid = 0;
+
+static u32 sfb_y, sfb_x, sfb_end;
 
 void sendFramebufferStart()
 {
-	sfb_j = sfb_y = sfb_x = 0;
+	sfb_y = sfb_x = sfb_end = 0;
 }
 
 bool sendFramebufferDone()
@@ -54,42 +66,90 @@ bool sendFramebufferDone()
 	return (sfb_y == 8);
 }
 
+// finds the next run of changed columns starting at sfb_y/sfb_x, sets sfb_end to its end (exclusive)
+static bool oledNextRun()
+{
+	for ( ; sfb_y < 8; sfb_y ++, sfb_x = 0 )
+	{
+		const u8 *fb = &oledFrameBuffer[ sfb_y * 128 ];
+		const u8 *sh = &oledShadow[ sfb_y * 128 ];
+
+		if ( !oledShadowValid )
+		{
+			if ( sfb_x > 0 )
+				continue;
+			sfb_end = 128;
+			return true;
+		}
+
+		while ( sfb_x < 128 && fb[ sfb_x ] == sh[ sfb_x ] )
+			sfb_x ++;
+
+		if ( sfb_x == 128 )
+			continue;
+
+		u32 last = sfb_x;
+		for ( u32 x = sfb_x + 1; x < 128 && x - last <= OLED_WINDOW_COST; x++ )
+			if ( fb[ x ] != sh[ x ] )
+				last = x;
+
+		sfb_end = last + 1;
+		return true;
+	}
+	return false;
+}
+
+extern void ssd1306_send_command_start(void);
+extern void ssd1306_send_command_stop(void);
+
+static void oledWindow( u32 x0, u32 x1, u32 y0, u32 y1 )
+{
+	ssd1306_send_command_start();
+	ssd1306_send_byte( 0x21 );				// column window
+	ssd1306_send_byte( x0 );
+	ssd1306_send_byte( x1 );
+	ssd1306_send_byte( 0x22 );				// page window
+	ssd1306_send_byte( y0 );
+	ssd1306_send_byte( y1 );
+	ssd1306_send_command_stop();
+}
+
 void sendFramebufferNext( u32 nBytes )
 {
 	if( sfb_y == 8 ) return;
 
-	if ( sfb_x == 0 /*&& sfb_y == 0*/ )
+	if ( sfb_x == sfb_end )
 	{
-		//ssd1306_setpos( 0, sfb_y );
-
-		extern void ssd1306_send_command_start(void);
-		extern void ssd1306_send_command_stop(void);
-		ssd1306_send_command_start();
-		u32 col = 0;
-		ssd1306_send_command( 0xb0 | sfb_y );
-		ssd1306_send_command( 0x00 | (col & 0xf) );
-		ssd1306_send_command( 0x10 | (col >> 4) );
-	  //ssd1306_send_command( 0x81 );
-	  //ssd1306_send_command( 0xcf );
-		ssd1306_send_command_stop();
+		if ( !oledNextRun() )
+		{
+			oledShadowValid = 1;
+			return;
+		}
 
+		oledWindow( sfb_x, sfb_end - 1, sfb_y, sfb_y );
 		ssd1306_send_data_start();
 	}
 
-	for ( u32 i = 0; i < nBytes; i++ )
+	for ( u32 i = 0; i < nBytes && sfb_x < sfb_end; i++ )
 	{
-		//ssd1306_send_data_start();
-		ssd1306_send_byte( oledFrameBuffer[ sfb_j ++ ] );
-		//ssd1306_send_data_stop();
+		u32 j = sfb_x + sfb_y * 128;
+		ssd1306_send_byte( oledFrameBuffer[ j ] );
+		oledShadow[ j ] = oledFrameBuffer[ j ];
 		sfb_x ++;
 	}
 
-	if ( sfb_x == 128 )
+	if ( sfb_x == sfb_end )
 	{
-		sfb_x = 0; sfb_y ++;
+		ssd1306_send_data_stop();
 
-		if ( sfb_y == 8 )
-			ssd1306_send_data_stop();
+		// look ahead such that sendFramebufferDone() is true after the last run, sendFramebuffer and splashScreen2
+		// expect the full window
+		if ( !oledNextRun() )
+		{
+			oledWindow( 0, 127, 0, 7 );
+			oledShadowValid = 1;
+		} else
+			sfb_end = sfb_x;
 	}
 }
 
@@ -104,6 +164,7 @@ void sendFramebuffer()
 			ssd1306_send_byte( oledFrameBuffer[ j++ ] );
 	}
 	ssd1306_send_data_stop();
+	oledShadowValid = 0;
 }
 
 
@@ -123,6 +184,7 @@ void splashScreen2( const u8 *fb )
 	//SendCommand(SSD1306_CMD_SET_COLUMN_HIGH | (col >> 4));	// 0x10 column address upper bits
 
 	flushI2CBuffer( true );
+	oledShadowValid = 0;
 
 	for ( int y = 0; y < 64 / 8; y++ )
 	{
@@ -179,6 +241,16 @@ int splashScreenFile( const char *drive, char *fn )
 	if ( readFile( logger, (char*)drive, fn, temp, &size ) )
 	{
 		u8 buf[ 1024 ];
+
+		// converted by Tools/skinconv: already in the page layout
+		if ( skinIsSkin( temp, size ) )
+		{
+			if ( !skinDecode( temp, size, SKIN_MONO, 128, 64, buf ) )
+				return 0;
+			splashScreen( buf );
+			return 1;
+		}
+
 		memset( buf, 0, 1024 );
 		for ( int i = 0; i < 8192; i++ )
 			if ( temp[ i ] >= 128 )
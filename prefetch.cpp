@@ -0,0 +1,272 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ prefetch.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - speculative loading of the file under the cursor of the browser
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include "lowlevel_arm64.h"
+#include "helpers.h"
+#include "prefetch.h"
+
+#ifdef COMPILE_MENU_WITH_PREFETCH
+
+extern int screenType;
+
+enum
+{
+	PF_EMPTY = 0,
+	PF_LOADING,
+	PF_COMPLETE,
+	PF_FAILED
+};
+
+typedef struct
+{
+	char name[ 1024 ];
+	u8  *data;
+	u32 maxSize;
+	u32 size, loaded;
+	u32 state;
+} PREFETCHSLOT;
+
+static u8 prefetchMain[ PREFETCH_MAIN_SIZE ] AAA;
+static u8 prefetchAsset[ PREFETCH_ASSETS ][ PREFETCH_ASSET_SIZE ] AAA;
+
+// slot 0 is the file under the cursor, the others hold the assets (which mostly stay the same between files)
+static PREFETCHSLOT slot[ 1 + PREFETCH_ASSETS ];
+static u32 prefetchActive = 0, prefetchSettle = 0, prefetchSelectTime = 0;
+
+// the file being loaded stays open between chunks. Other code (e.g. readFile) mounts the drive with its own FATFS,
+// which unregisters ours (fs_type = 0) and invalidates the file: it is opened again at the next chunk then.
+static FATFS prefetchFS;
+static FIL prefetchFile;
+static PREFETCHSLOT *prefetchOpen = NULL;
+
+static void prefetchClose()
+{
+	if ( prefetchOpen != NULL && prefetchFS.fs_type != 0 )
+	{
+		f_close( &prefetchFile );
+		f_mount( 0, "SD:", 0 );
+	}
+	prefetchOpen = NULL;
+}
+
+static int prefetchOpenSlot( PREFETCHSLOT *s )
+{
+	if ( prefetchOpen == s && prefetchFS.fs_type != 0 )
+		return 1;
+
+	prefetchClose();
+
+	if ( f_mount( &prefetchFS, "SD:", 1 ) != FR_OK )
+		return 0;
+
+	FILINFO info;
+	if ( f_stat( s->name, &info ) != FR_OK || f_open( &prefetchFile, s->name, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+	{
+		f_mount( 0, "SD:", 0 );
+		return 0;
+	}
+
+	if ( s->loaded == 0 )
+		s->size = (u32)info.fsize;
+
+	prefetchOpen = s;
+
+	// too large, or changed while we were loading
+	return (u32)info.fsize <= s->maxSize && (u32)info.fsize == s->size && f_lseek( &prefetchFile, s->loaded ) == FR_OK;
+}
+
+// files the kernels load in addition, same names as in kernel_launch.cpp and kernel_ef.cpp
+static u32 prefetchAssetNames( const char *path, u32 kind, char names[ PREFETCH_ASSETS ][ 1024 ] )
+{
+	u32 n = 0;
+
+	if ( kind == PREFETCH_CRT || kind == PREFETCH_D64 )
+	{
+		strcpy( names[ n ++ ], "SD:C64/eapi.prg" );
+		if ( screenType == 1 )
+		{
+			// individual splash screen of the .CRT, see KernelEFRun (a converted .D64 is started as SD:C64/temp.crt)
+			u32 l = strlen( path );
+			if ( kind == PREFETCH_CRT && l > 4 && l < 1024 )
+			{
+				memcpy( names[ n ], path, l - 4 );
+				strcpy( &names[ n ++ ][ l - 4 ], ".tga" );
+			}
+			strcpy( names[ n ++ ], "SD:SPLASH/sk64_ef3_bg.tga" );
+		}
+	} else
+	{
+		strcpy( names[ n ++ ], modeC128 ? "SD:C64/launch128.cbm80" : "SD:C64/launch.cbm80" );
+		if ( screenType == 1 )
+			strcpy( names[ n ++ ], "SD:SPLASH/sk64_launch.tga" );
+	}
+
+	return n;
+}
+
+static void prefetchSetSlot( PREFETCHSLOT *s, const char *name )
+{
+	if ( prefetchOpen == s )
+		prefetchClose();
+	strncpy( s->name, name, 1023 );
+	s->name[ 1023 ] = 0;
+	s->size = s->loaded = 0;
+	s->state = PF_LOADING;
+}
+
+void prefetchSelect( const char *path, u32 kind )
+{
+	if ( slot[ 0 ].data == NULL )
+	{
+		slot[ 0 ].data = prefetchMain;
+		slot[ 0 ].maxSize = PREFETCH_MAIN_SIZE;
+		for ( u32 i = 0; i < PREFETCH_ASSETS; i++ )
+		{
+			slot[ 1 + i ].data = prefetchAsset[ i ];
+			slot[ 1 + i ].maxSize = PREFETCH_ASSET_SIZE;
+		}
+	}
+
+	// e.g. cursor on a directory or outside of the browser: stop, a partially loaded file is continued when selected again
+	if ( path == NULL || kind == PREFETCH_NONE )
+	{
+		prefetchActive = 0;
+		return;
+	}
+
+	prefetchActive = 1;
+
+	if ( strcmp( slot[ 0 ].name, path ) == 0 && slot[ 0 ].state != PF_EMPTY )
+		return;
+
+	// cursor moved: drop the previous file (also if it was loaded only partially) and wait until the cursor rests
+	prefetchSetSlot( &slot[ 0 ], path );
+	prefetchSettle = 1;
+
+	char names[ PREFETCH_ASSETS ][ 1024 ];
+	u32 nNames = prefetchAssetNames( path, kind, names );
+
+	// keep assets which are already there, reuse the other slots
+	u32 keep = 0;
+	for ( u32 j = 0; j < nNames; j++ )
+		for ( u32 i = 1; i <= PREFETCH_ASSETS; i++ )
+			if ( slot[ i ].state != PF_EMPTY && strcmp( slot[ i ].name, names[ j ] ) == 0 )
+				keep |= ( 1 << i ) | ( 1 << ( 16 + j ) );
+
+	for ( u32 j = 0; j < nNames; j++ )
+	{
+		if ( keep & ( 1 << ( 16 + j ) ) )
+			continue;
+		for ( u32 i = 1; i <= PREFETCH_ASSETS; i++ )
+			if ( !( keep & ( 1 << i ) ) )
+			{
+				prefetchSetSlot( &slot[ i ], names[ j ] );
+				keep |= 1 << i;
+				break;
+			}
+	}
+}
+
+u32 prefetchStep( CLogger *logger, u32 c64CycleCount )
+{
+	if ( !prefetchActive )
+	{
+		prefetchClose();
+		return 0;
+	}
+
+	if ( prefetchSettle )
+	{
+		prefetchSettle = 0;
+		prefetchSelectTime = c64CycleCount;
+	}
+	if ( c64CycleCount - prefetchSelectTime < PREFETCH_SETTLE_CYCLES )
+		return 0;
+
+	PREFETCHSLOT *s = NULL;
+	for ( u32 i = 0; i <= PREFETCH_ASSETS && s == NULL; i++ )
+		if ( slot[ i ].state == PF_LOADING )
+			s = &slot[ i ];
+
+	if ( s == NULL )
+	{
+		prefetchClose();
+		prefetchActive = 0;
+		return 0;
+	}
+
+	if ( !prefetchOpenSlot( s ) )
+	{
+		s->state = PF_FAILED;
+		prefetchClose();
+		return 1;
+	}
+
+	u32 nBytes = min( (u32)PREFETCH_CHUNK, s->size - s->loaded ), nBytesRead = 0;
+
+	if ( f_read( &prefetchFile, s->data + s->loaded, nBytes, &nBytesRead ) != FR_OK || nBytesRead != nBytes )
+		s->state = PF_FAILED; else
+	{
+		s->loaded += nBytes;
+		if ( s->loaded == s->size )
+			s->state = PF_COMPLETE;
+	}
+
+	if ( s->state != PF_LOADING )
+		prefetchClose();
+
+	return 1;
+}
+
+int prefetchGet( const char *filename, u8 *data, u32 *size, u32 maxSize )
+{
+	for ( u32 i = 0; i <= PREFETCH_ASSETS; i++ )
+		if ( slot[ i ].state == PF_COMPLETE && strcmp( slot[ i ].name, filename ) == 0 )
+		{
+			*size = slot[ i ].size;
+			memcpy( data, slot[ i ].data, min( slot[ i ].size, maxSize ) );
+			return 1;
+		}
+
+	return 0;
+}
+
+void prefetchInvalidate( const char *filename )
+{
+	for ( u32 i = 0; i <= PREFETCH_ASSETS; i++ )
+		if ( slot[ i ].state != PF_EMPTY && strcmp( slot[ i ].name, filename ) == 0 )
+		{
+			if ( prefetchOpen == &slot[ i ] )
+				prefetchClose();
+			slot[ i ].state = PF_EMPTY;
+		}
+}
+
+#endif
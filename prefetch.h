@@ -0,0 +1,85 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ prefetch.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - speculative loading of the file under the cursor of the browser
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _prefetch_h
+#define _prefetch_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+//
+// while the browser cursor rests on a PRG/CRT/SID/D64 the menu main loop reads this file (and the files the kernel
+// will load with it, e.g. launch code, EAPI, splash screens) into reserved RAM, one chunk per iteration such that
+// key presses are handled with a delay of at most one chunk. Moving the cursor cancels a load which is in progress.
+// readFile, readCRTFile, readCRTHeader and readD64File take the data from there if the file is complete, otherwise
+// they read from the SD card as before. Writing a file (createFile in helpers.h) drops it from the slots.
+//
+// only built into the C64/C128 menu (COMPILE_MENU_WITH_PREFETCH), all other kernels use the stubs below
+//
+#define PREFETCH_MAIN_SIZE		( 1032 * 1024 )		// largest file: .CRT (see readCRTFile)
+#define PREFETCH_ASSETS			4
+#define PREFETCH_ASSET_SIZE		( 260 * 1024 )		// largest asset: 256x256 RGBA .TGA
+#define PREFETCH_CHUNK			( 32 * 1024 )
+#define PREFETCH_SETTLE_CYCLES	150000				// C64 cycles the cursor must rest before loading starts
+
+// what the cursor is on, selects the assets
+enum
+{
+	PREFETCH_NONE = 0,
+	PREFETCH_PRG,
+	PREFETCH_CRT,
+	PREFETCH_SID,
+	PREFETCH_D64,			// disk image: converted by D2EF and started by the EasyFlash kernel
+	PREFETCH_FILE_IN_D64	// file in a disk image: started by the launcher, the disk image is loaded
+};
+
+#ifdef COMPILE_MENU_WITH_PREFETCH
+
+// browser: file under the cursor (NULL or PREFETCH_NONE: stop loading), called after every key press
+extern void prefetchSelect( const char *path, u32 kind );
+
+// menu main loop: loads the next chunk once the cursor rested for PREFETCH_SETTLE_CYCLES, returns 1 if it accessed
+// the SD card (the caller should warm the caches for the FIQ handler again)
+extern u32 prefetchStep( CLogger *logger, u32 c64CycleCount );
+
+// copies the file if it has been loaded completely (at most maxSize bytes), *size is the file size
+extern int prefetchGet( const char *filename, u8 *data, u32 *size, u32 maxSize = 0xffffffff );
+
+extern void prefetchInvalidate( const char *filename );
+
+#else
+
+static inline void prefetchSelect( const char *path, u32 kind ) {}
+static inline u32 prefetchStep( CLogger *logger, u32 c64CycleCount ) { return 0; }
+static inline int prefetchGet( const char *filename, u8 *data, u32 *size, u32 maxSize = 0xffffffff ) { return 0; }
+static inline void prefetchInvalidate( const char *filename ) {}
+
+#endif
+
+#endif
@@ -0,0 +1,243 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ psidcache.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - cache of converted PSID files (psid64 output) on the SD card
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/timer.h>
+#include "helpers.h"
+#include "psidcache.h"
+#include "sdcache.h"
+#include "songlengths.h"
+#include "stilindex.h"
+#include "PSID/psid64/psid64.h"
+#include "PSID/libpsid64/sidid.h"
+#include "PSID/libpsid64/exomizer/exomizer.h"
+
+// statistics since the menu has been started
+static SDCACHESTATS psidCache = { "PSID cache", 0, 0, 0 };
+
+static char stilText[ 4096 ];
+
+// the automaton is built at the first conversion, NULL if there is no (valid) sidid.cfg
+static SidId *sidId = NULL;
+static u32 sidIdStamp = 0;
+
+#if PSIDCACHE_COMPRESS
+static unsigned int psidClock()
+{
+	return CTimer::GetClockTicks();
+}
+
+// hash chains with 16 candidates per position, offsets up to 16k, passes until the budget is used up
+static const exomizer_options psidCompressOptions = { 16, 16384, 0, PSIDCACHE_COMPRESS_BUDGET, psidClock };
+#endif
+
+static void loadSidId( CLogger *logger )
+{
+	static bool tried = false;
+	if ( tried )
+		return;
+	tried = true;
+
+	u32 size;
+	if ( !getFileSize( logger, "SD:", SIDID_CONFIG, &size ) || size == 0 )
+		return;
+
+	u8 *cfg = new u8[ size ];
+	if ( readFile( logger, "SD:", SIDID_CONFIG, cfg, &size ) )
+	{
+		u32 t0 = CTimer::GetClockTicks();
+
+		sidId = new SidId();
+		if ( !sidId->readConfig( (const char *)cfg, size ) )
+		{
+			delete sidId;
+			sidId = NULL;
+		} else
+		{
+			sidIdStamp = 2166136261u;
+			for ( u32 i = 0; i < size; i++ )
+				sidIdStamp = ( sidIdStamp ^ cfg[ i ] ) * 16777619u;
+			logger->Write( "RaspiMenu", LogNotice, "sidid.cfg: automaton built in %u us", CTimer::GetClockTicks() - t0 );
+		}
+	}
+	delete [] cfg;
+}
+
+static int psidCacheLoad( const u8 *key, PSIDCACHEHEADER *header, u8 *prg )
+{
+	char name[ 64 ];
+	sdCacheFileName( name, PSIDCACHE_PATH, key, ".p64" );
+
+	FATFS m_FileSystem;
+	if ( f_mount( &m_FileSystem, "SD:", 1 ) != FR_OK )
+		return 0;
+
+	int ok = 0;
+	FILINFO info;
+	FIL file;
+	if ( f_stat( name, &info ) == FR_OK && f_open( &file, name, FA_READ | FA_OPEN_EXISTING ) == FR_OK )
+	{
+		u32 nBytesRead;
+		if ( f_read( &file, header, sizeof( PSIDCACHEHEADER ), &nBytesRead ) == FR_OK && nBytesRead == sizeof( PSIDCACHEHEADER ) &&
+			 memcmp( header->magic, PSIDCACHE_MAGIC, 8 ) == 0 && header->version == PSIDCACHE_VERSION &&
+			 memcmp( header->key, key, MD5_DIGEST_SIZE ) == 0 &&
+			 header->prgSize <= 65536 && (u32)info.fsize == sizeof( PSIDCACHEHEADER ) + header->prgSize )
+		{
+			ok = f_read( &file, prg, header->prgSize, &nBytesRead ) == FR_OK && nBytesRead == header->prgSize;
+		}
+		f_close( &file );
+	}
+
+	f_mount( 0, "SD:", 0 );
+	return ok;
+}
+
+static void psidCacheStore( CLogger *logger, const PSIDCACHEHEADER *header, const u8 *prg )
+{
+	char name[ 64 ];
+	sdCacheFileName( name, PSIDCACHE_PATH, header->key, ".p64" );
+
+	const void *data[ 2 ] = { header, prg };
+	const u32 size[ 2 ] = { sizeof( PSIDCACHEHEADER ), header->prgSize };
+	sdCacheStore( logger, &psidCache, PSIDCACHE_PATH, name, 2, data, size );
+}
+
+int psidConvertCached( CLogger *logger, const char *path, u8 *sidData, u32 sidSize, u8 *prg, u32 *prgSize )
+{
+	Psid64 *psid64 = new Psid64();
+
+	psid64->setVerbose(false);
+	psid64->setUseGlobalComment(false);
+	psid64->setBlankScreen(false);
+	psid64->setNoDriver(false);
+#if PSIDCACHE_COMPRESS
+	psid64->setCompress(true);
+	psid64->setCompressOptions(&psidCompressOptions);
+#endif
+
+	loadSidId( logger );
+	psid64->setSidId( sidId );
+
+	// key: tune + everything which changes the output of psid64
+	u32 stamp = songLengthsStamp();
+	u32 stampStil = stilStamp();
+	u8 options[ 20 ] = {
+		(u8)psid64->getNoDriver(), (u8)psid64->getBlankScreen(), (u8)psid64->getCompress(), (u8)psid64->getUseGlobalComment(),
+		(u8)psid64->getInitialSong(), (u8)( psid64->getInitialSong() >> 8 ),
+		(u8)PSIDCACHE_VERSION, (u8)( PSIDCACHE_VERSION >> 8 ),
+		(u8)stamp, (u8)( stamp >> 8 ), (u8)( stamp >> 16 ), (u8)( stamp >> 24 ),
+		(u8)stampStil, (u8)( stampStil >> 8 ), (u8)( stampStil >> 16 ), (u8)( stampStil >> 24 ),
+		(u8)sidIdStamp, (u8)( sidIdStamp >> 8 ), (u8)( sidIdStamp >> 16 ), (u8)( sidIdStamp >> 24 ) };
+
+	u8 pathKey[ 8 ] = { 0 };
+	stilPathKey( path, pathKey );
+
+	u8 md5[ MD5_DIGEST_SIZE ];
+
+	PSIDCACHEHEADER header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, PSIDCACHE_MAGIC, 8 );
+	header.version = PSIDCACHE_VERSION;
+
+	MD5CTX ctx;
+	md5Init( &ctx );
+	md5Update( &ctx, sidData, sidSize );
+	md5Final( &ctx, md5 );
+
+	md5Init( &ctx );
+	md5Update( &ctx, md5, MD5_DIGEST_SIZE );
+	md5Update( &ctx, pathKey, sizeof( pathKey ) );
+	md5Update( &ctx, options, sizeof( options ) );
+	md5Final( &ctx, header.key );
+
+	PSIDCACHEHEADER cached;
+	if ( psidCacheLoad( header.key, &cached, prg ) )
+	{
+		delete psid64;
+
+		*prgSize = cached.prgSize;
+		psidCache.hits ++;
+		logger->Write( "RaspiMenu", LogNotice, "PSID cache hit: driver $%02x00, screen $%02x00, %u bytes (%u hits, %u misses)",
+			cached.driverPage, cached.screenPage, cached.prgSize, psidCache.hits, psidCache.misses );
+		return 1;
+	}
+
+	psidCache.misses ++;
+
+	u32 t0 = CTimer::GetClockTicks();
+
+	// the HVSC database uses the MD5 of the file as well
+	u16 lengths[ 256 ];
+	u32 nSongs = songLengthsLookup( logger, md5, lengths, 256 );
+	psid64->setSongLengths( lengths, min( 256, nSongs ) );
+
+	// scroll text, only for tunes in the HVSC folder structure
+	if ( stilLookup( logger, path, stilText, sizeof( stilText ) ) )
+		psid64->setStilText( stilText );
+
+	bool ok = psid64->load( sidData, sidSize ) && psid64->convert();
+
+	// e.g. tunes with packed data do not get smaller (or Exomizer ran out of memory), use the plain conversion then
+	if ( !ok && psid64->getCompress() )
+	{
+		psid64->setCompress(false);
+		ok = psid64->convert();
+	}
+
+	if ( !ok || psid64->m_programSize > 65536 )
+	{
+		logger->Write( "RaspiMenu", LogWarning, "PSID conversion failed: %s", psid64->getStatus() ? psid64->getStatus() : "" );
+		*prgSize = 0;
+		delete psid64;
+		return 0;
+	}
+
+	u32 t = CTimer::GetClockTicks() - t0;
+
+	memcpy( prg, psid64->m_programData, psid64->m_programSize );
+	*prgSize = psid64->m_programSize;
+
+	header.driverPage = psid64->getDriverPage();
+	header.screenPage = psid64->getScreenPage();
+	header.charPage = psid64->getCharPage();
+	header.stilPage = psid64->getStilPage();
+	header.songlengthsPage = psid64->getSonglengthsPage();
+	header.prgSize = *prgSize;
+
+	if ( psid64->getPlayerId() )
+		logger->Write( "RaspiMenu", LogNotice, "player: %s", psid64->getPlayerId() );
+
+	delete psid64;
+
+	sdCacheConverted( logger, &psidCache, t, header.prgSize );
+
+	psidCacheStore( logger, &header, prg );
+
+	return 1;
+}
@@ -0,0 +1,75 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ psidcache.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - cache of converted PSID files (psid64 output) on the SD card
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _psidcache_h
+#define _psidcache_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "md5.h"
+
+//
+// launching a .sid runs psid64 (relocation, driver placement, screen) on every start. The output is stored in
+// PSIDCACHE_PATH and reused when the same tune is launched again. The key is the MD5 of the .sid file, its HVSC path
+// (the STIL entry depends on it), the converter options, the stamps of the song length and STIL indices and of
+// sidid.cfg, and PSIDCACHE_VERSION -- increase the latter whenever psid64 changes its output (driver, screen, themes).
+//
+// one file per tune, named after the key: the header below followed by the .prg
+//
+#define PSIDCACHE_PATH			"SD:C64/PSIDCACHE"
+#define PSIDCACHE_MAGIC			"SK64PSID"
+#define PSIDCACHE_VERSION		5
+
+// crunch the converted tunes with Exomizer (fast match finder, the optimal parse passes are limited to the budget
+// in microseconds). Off by default: whether a smaller .prg pays off depends on the transfer time versus the time the
+// C64 needs to decrunch it.
+#define PSIDCACHE_COMPRESS			0
+#define PSIDCACHE_COMPRESS_BUDGET	500000
+
+// player identification patterns (from psid64 or SIDId), optional
+#define SIDID_CONFIG			"SD:C64/sidid.cfg"
+
+typedef struct
+{
+	char magic[ 8 ];
+	u32  version;
+	u8   key[ MD5_DIGEST_SIZE ];
+
+	// memory layout chosen by psid64 (start pages, 0 = not present)
+	u8   driverPage, screenPage, charPage, stilPage, songlengthsPage;
+	u8   pad[ 3 ];
+
+	u32  prgSize;
+} __attribute__((packed)) PSIDCACHEHEADER;
+
+// converts the .sid ('path' is its location on the SD card) to a .prg (at most 64k), or takes it from the cache.
+// Returns 0 if the conversion failed.
+extern int psidConvertCached( CLogger *logger, const char *path, u8 *sidData, u32 sidSize, u8 *prg, u32 *prgSize );
+
+#endif
@@ -0,0 +1,85 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ sdcache.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - common code of the caches of converted files on the SD card
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <circle/util.h>
+#include "helpers.h"
+#include "sdcache.h"
+
+void sdCacheFileName( char *name, const char *dir, const u8 *key, const char *ext )
+{
+	char hex[ MD5_DIGEST_SIZE * 2 + 1 ];
+	md5ToHex( key, hex );
+	strcpy( name, dir );
+	strcat( name, "/" );
+	strcat( name, hex );
+	strcat( name, ext );
+}
+
+int sdCacheStore( CLogger *logger, SDCACHESTATS *stats, const char *dir, const char *name, u32 nParts, const void * const *data, const u32 *size )
+{
+	FATFS m_FileSystem;
+	if ( f_mount( &m_FileSystem, "SD:", 1 ) != FR_OK )
+		return 0;
+
+	// FR_EXIST after the first time
+	f_mkdir( dir );
+
+	int ok = 0;
+	FIL file;
+	if ( createFile( &file, name ) == FR_OK )
+	{
+		ok = 1;
+		for ( u32 i = 0; i < nParts && ok; i++ )
+		{
+			u32 nBytesWritten;
+			ok = f_write( &file, data[ i ], size[ i ], &nBytesWritten ) == FR_OK && nBytesWritten == size[ i ];
+		}
+		f_close( &file );
+
+		// do not leave a truncated entry behind
+		if ( !ok )
+		{
+			f_unlink( name );
+			logger->Write( "RaspiMenu", LogWarning, "%s: cannot write %s", stats->name, name );
+		}
+	} else
+		logger->Write( "RaspiMenu", LogWarning, "%s: cannot create %s", stats->name, name );
+
+	f_mount( 0, "SD:", 0 );
+	return ok;
+}
+
+void sdCacheConverted( CLogger *logger, SDCACHESTATS *stats, u32 ticks, u32 size )
+{
+	stats->convertTime += ticks;
+
+	logger->Write( "RaspiMenu", LogNotice, "%s miss: converted in %u.%03u ms, %u bytes (%u hits, %u misses, %u ms converting)",
+		stats->name, ticks / 1000, ticks % 1000, size, stats->hits, stats->misses, (u32)( stats->convertTime / 1000 ) );
+}
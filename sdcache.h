@@ -0,0 +1,59 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ sdcache.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - common code of the caches of converted files on the SD card
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _sdcache_h
+#define _sdcache_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+#include "md5.h"
+
+//
+// the PSID and D2EF caches store one file per converted input in their directory on the SD card, named after
+// the MD5 key (see psidcache.h, d2efcache.h). Hits, misses and the time spent converting are logged.
+//
+typedef struct
+{
+	const char *name;			// prefix of the log messages, e.g. "PSID cache"
+	u32 hits, misses;
+	u64 convertTime;			// microseconds, all misses
+} SDCACHESTATS;
+
+// "<dir>/<key in hex><ext>"
+extern void sdCacheFileName( char *name, const char *dir, const u8 *key, const char *ext );
+
+// writes the 'nParts' buffers (e.g. header and data) to 'name', the directory is created at the first store.
+// Returns 0 (and leaves no partial entry behind) if the file cannot be written.
+extern int sdCacheStore( CLogger *logger, SDCACHESTATS *stats, const char *dir, const char *name, u32 nParts, const void * const *data, const u32 *size );
+
+// logs a conversion which took 'ticks' microseconds and produced 'size' bytes (call after counting the miss)
+extern void sdCacheConverted( CLogger *logger, SDCACHESTATS *stats, u32 ticks, u32 size );
+
+#endif
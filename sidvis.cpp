@@ -0,0 +1,185 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ sidvis.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - block-based input and spectrum analysis for the SID visualizations
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <math.h>
+#include "lowlevel_arm64.h"
+#include "sidvis.h"
+
+#define VIS_TW_SHIFT		14
+
+s16 visRing[ VIS_RING_SIZE ] AAA;
+u32 visRingPos = 0;
+u8 visBarHeight[ VIS_BARS ];
+
+static s32 fftRe[ VIS_FFT_SIZE ] AAA, fftIm[ VIS_FFT_SIZE ] AAA;
+
+// twiddles of all stages, stage with butterfly distance 'half' at offset half-1 (contiguous for the vector loop)
+static s32 twRe[ VIS_FFT_SIZE ] AAA, twIm[ VIS_FFT_SIZE ] AAA;
+
+static s16 hann[ VIS_FFT_SIZE ];
+static u8  bitReverse[ VIS_FFT_SIZE ];
+
+// first FFT bin of each bar, the last entry is the end of the last bar
+static u8  barBin[ VIS_BARS + 1 ];
+static u32 barBinsReady = 0;
+
+void visInit()
+{
+	memset( visRing, 0, sizeof( visRing ) );
+	visRingPos = 0;
+	memset( visBarHeight, 0, sizeof( visBarHeight ) );
+
+	if ( barBinsReady )
+		return;
+
+	const float pi = 3.14159265358979f;
+
+	for ( u32 half = 1; half < VIS_FFT_SIZE; half <<= 1 )
+		for ( u32 j = 0; j < half; j++ )
+		{
+			twRe[ half - 1 + j ] = (s32)(  cosf( pi * j / half ) * ( 1 << VIS_TW_SHIFT ) );
+			twIm[ half - 1 + j ] = (s32)( -sinf( pi * j / half ) * ( 1 << VIS_TW_SHIFT ) );
+		}
+
+	for ( u32 i = 0; i < VIS_FFT_SIZE; i++ )
+	{
+		hann[ i ] = (s16)( 32767.0f * 0.5f * ( 1.0f - cosf( 2.0f * pi * i / VIS_FFT_SIZE ) ) );
+
+		u32 r = 0;
+		for ( u32 b = 0; b < VIS_FFT_LOG2; b++ )
+			if ( i & ( 1 << b ) )
+				r |= 1 << ( VIS_FFT_LOG2 - 1 - b );
+		bitReverse[ i ] = r;
+	}
+
+	// logarithmic bands from bin 1 to the Nyquist frequency, at least one bin each
+	u32 prev = 0;
+	for ( u32 b = 0; b <= VIS_BARS; b++ )
+	{
+		u32 e = (u32)powf( (float)( VIS_FFT_SIZE / 2 ), (float)b / (float)VIS_BARS );
+		if ( e <= prev )
+			e = prev + 1;
+		barBin[ b ] = e;
+		prev = e;
+	}
+	// the last bands get squeezed if the low ones were widened
+	for ( s32 b = VIS_BARS; b >= 0 && barBin[ b ] > VIS_FFT_SIZE / 2 - ( VIS_BARS - b ); b-- )
+		barBin[ b ] = VIS_FFT_SIZE / 2 - ( VIS_BARS - b );
+
+	barBinsReady = 1;
+}
+
+static void fft()
+{
+	for ( u32 half = 1; half < VIS_FFT_SIZE; half <<= 1 )
+	{
+		const s32 *wr = &twRe[ half - 1 ], *wi = &twIm[ half - 1 ];
+
+		for ( u32 i = 0; i < VIS_FFT_SIZE; i += 2 * half )
+		{
+			s32 *ar = &fftRe[ i ], *ai = &fftIm[ i ];
+			s32 *br = &fftRe[ i + half ], *bi = &fftIm[ i + half ];
+
+		#ifdef __ARM_NEON
+			if ( half >= 4 )
+			{
+				for ( u32 j = 0; j < half; j += 4 )
+				{
+					int32x4_t xr = vld1q_s32( &br[ j ] ), xi = vld1q_s32( &bi[ j ] );
+					int32x4_t cr = vld1q_s32( &wr[ j ] ), ci = vld1q_s32( &wi[ j ] );
+					int32x4_t tr = vshrq_n_s32( vmlsq_s32( vmulq_s32( xr, cr ), xi, ci ), VIS_TW_SHIFT );
+					int32x4_t ti = vshrq_n_s32( vmlaq_s32( vmulq_s32( xr, ci ), xi, cr ), VIS_TW_SHIFT );
+					int32x4_t yr = vld1q_s32( &ar[ j ] ), yi = vld1q_s32( &ai[ j ] );
+					vst1q_s32( &ar[ j ], vhaddq_s32( yr, tr ) );
+					vst1q_s32( &ai[ j ], vhaddq_s32( yi, ti ) );
+					vst1q_s32( &br[ j ], vhsubq_s32( yr, tr ) );
+					vst1q_s32( &bi[ j ], vhsubq_s32( yi, ti ) );
+				}
+				continue;
+			}
+		#endif
+
+			for ( u32 j = 0; j < half; j++ )
+			{
+				s32 tr = ( br[ j ] * wr[ j ] - bi[ j ] * wi[ j ] ) >> VIS_TW_SHIFT;
+				s32 ti = ( br[ j ] * wi[ j ] + bi[ j ] * wr[ j ] ) >> VIS_TW_SHIFT;
+				s32 yr = ar[ j ], yi = ai[ j ];
+				ar[ j ] = ( yr + tr ) >> 1;
+				ai[ j ] = ( yi + ti ) >> 1;
+				br[ j ] = ( yr - tr ) >> 1;
+				bi[ j ] = ( yi - ti ) >> 1;
+			}
+		}
+	}
+}
+
+// log2 in 1/8 steps
+static u32 log2x8( u32 v )
+{
+	if ( v == 0 )
+		return 0;
+	u32 l = 31 - __builtin_clz( v );
+	u32 f = l >= 3 ? ( v >> ( l - 3 ) ) & 7 : ( v << ( 3 - l ) ) & 7;
+	return l * 8 + f;
+}
+
+void visSpectrum( u8 *bars, u32 nBars, u32 maxHeight )
+{
+	u32 start = visRingPos - VIS_FFT_SIZE;
+	for ( u32 i = 0; i < VIS_FFT_SIZE; i++ )
+	{
+		u32 r = bitReverse[ i ];
+		fftRe[ r ] = ( (s32)visRing[ ( start + i ) & ( VIS_RING_SIZE - 1 ) ] * hann[ i ] ) >> 15;
+		fftIm[ r ] = 0;
+	}
+
+	fft();
+
+	// the output is scaled by 1/VIS_FFT_SIZE: a full scale sine has |X| of about 2^13, i.e. log2(|X|^2) = 26
+	const u32 floor = 6 * 8, top = 26 * 8;
+
+	if ( nBars > VIS_BARS )
+		nBars = VIS_BARS;
+
+	for ( u32 b = 0; b < nBars; b++ )
+	{
+		u32 m = 0;
+		for ( u32 k = barBin[ b ]; k < barBin[ b + 1 ]; k++ )
+		{
+			u32 p = (u32)( fftRe[ k ] * fftRe[ k ] ) + (u32)( fftIm[ k ] * fftIm[ k ] );
+			if ( p > m ) m = p;
+		}
+
+		u32 l = log2x8( m );
+		l = l < floor ? 0 : l - floor;
+		u32 h = l * maxHeight / ( top - floor );
+		bars[ b ] = h > maxHeight ? maxHeight : h;
+	}
+}
@@ -0,0 +1,91 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ sidvis.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - block-based input and spectrum analysis for the SID visualizations
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _sidvis_h_
+#define _sidvis_h_
+
+#include <circle/types.h>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+#include "mixer.h"
+
+//
+// input of the TFT visualizations (tft_sid_vis.h): the SID kernels push each mixed block, the mono sum is decimated
+// into a small ring, and the visualization step runs once per block (not per sample) and only reads from the ring.
+// The spectrum is a 256 point fixed-point FFT (Q14 twiddles, scaled by 1/2 per stage) of the latest decimated samples.
+//
+#define VIS_DECIMATION		4				// 44.1 kHz -> about 11 kHz, the spectrum shows up to 5.5 kHz
+#define VIS_RING_SIZE		1024			// decimated samples, power of 2
+#define VIS_FFT_LOG2		8
+#define VIS_FFT_SIZE		( 1 << VIS_FFT_LOG2 )
+
+// layout of the spectrum analyzer (image coordinates, same area as the level meters)
+#define VIS_BARS			28
+#define VIS_BAR_X			8
+#define VIS_BAR_PITCH		8
+#define VIS_BAR_WIDTH		6
+#define VIS_BAR_BOTTOM		214
+#define VIS_BAR_MAX_HEIGHT	96
+
+extern s16 visRing[ VIS_RING_SIZE ];
+extern u32 visRingPos;
+
+// heights of the bars currently on the screen
+extern u8 visBarHeight[ VIS_BARS ];
+
+extern void visInit();
+
+// 'nBars' bar heights (0..maxHeight) from the most recent VIS_FFT_SIZE decimated samples, log. frequency and amplitude scale
+extern void visSpectrum( u8 *bars, u32 nBars, u32 maxHeight );
+
+// emulation loop, once per mixer block: 'out' is interleaved, MIXER_BLOCK_SIZE frames
+static __attribute__( ( always_inline ) ) inline void visPushBlock( const s16 *out )
+{
+	for ( u32 i = 0; i < MIXER_BLOCK_SIZE * 2; i += VIS_DECIMATION * 2 )
+	{
+	#if defined( __ARM_NEON ) && VIS_DECIMATION == 4
+		s32 s = vaddlvq_s16( vld1q_s16( &out[ i ] ) );		// 4 stereo frames
+	#else
+		s32 s = 0;
+		for ( u32 j = 0; j < VIS_DECIMATION * 2; j++ )
+			s += out[ i + j ];
+	#endif
+		visRing[ visRingPos ] = s / ( VIS_DECIMATION * 2 );
+		visRingPos = ( visRingPos + 1 ) & ( VIS_RING_SIZE - 1 );
+	}
+}
+
+// most recent decimated sample
+static __attribute__( ( always_inline ) ) inline s32 visLatest()
+{
+	return visRing[ ( visRingPos - 1 ) & ( VIS_RING_SIZE - 1 ) ];
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ skinformat.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - pre-converted splash screens for the TFT and OLED displays
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _skinformat_h
+#define _skinformat_h
+
+//
+// pre-converted splash screens ("skins"), written by Tools/skinconv: the TFT image is dithered and stored in RGB565
+// (the layout of tftBackground), the OLED image is thresholded and stored in the page layout of the SSD1306 (oledFrameBuffer).
+// tftLoadBackgroundTGA and splashScreenFile recognize the header, i.e. a converted file replaces a .tga/.logo file under
+// the same name and the loader only copies (or unpacks) the pixels.
+//
+// header (16 bytes, little endian), followed by the pixel data:
+//   0   'S' 'K' '6' '4'
+//   4   format, SKIN_RGB565 or SKIN_MONO
+//   5   flags, SKIN_RLE: PackBits-compressed pixel data
+//   6   width, height (2 bytes each)
+//   10  size of the pixel data in bytes
+//   14  reserved (0)
+//
+// PackBits: a control byte n < 128 is followed by n+1 literal units, n >= 128 by one unit which is repeated 257-n times.
+// A unit is one pixel (2 bytes) for SKIN_RGB565 and one byte (8 pixels) for SKIN_MONO.
+//
+// header only, Tools/skinconv includes it as well
+//
+#define SKIN_HEADER_SIZE	16
+
+#define SKIN_RGB565			1
+#define SKIN_MONO			2
+
+#define SKIN_RLE			1
+
+static inline int skinIsSkin( const unsigned char *file, unsigned int fileSize )
+{
+	return fileSize >= SKIN_HEADER_SIZE && file[ 0 ] == 'S' && file[ 1 ] == 'K' && file[ 2 ] == '6' && file[ 3 ] == '4';
+}
+
+// unpacks a skin of the given format and resolution to 'dst', returns 0 if the file does not match or is corrupt
+static inline int skinDecode( const unsigned char *file, unsigned int fileSize, unsigned int format, unsigned int width, unsigned int height, unsigned char *dst )
+{
+	if ( !skinIsSkin( file, fileSize ) || file[ 4 ] != format ||
+		 (unsigned int)( file[ 6 ] | ( file[ 7 ] << 8 ) ) != width || (unsigned int)( file[ 8 ] | ( file[ 9 ] << 8 ) ) != height )
+		return 0;
+
+	unsigned int unit = format == SKIN_RGB565 ? 2 : 1;
+	unsigned int size = format == SKIN_RGB565 ? width * height * 2 : width * height / 8;
+	unsigned int stored = file[ 10 ] | ( file[ 11 ] << 8 ) | ( file[ 12 ] << 16 ) | ( (unsigned int)file[ 13 ] << 24 );
+
+	const unsigned char *src = &file[ SKIN_HEADER_SIZE ];
+	const unsigned char *end = &file[ fileSize ];
+
+	if ( stored != size )
+		return 0;
+
+	if ( !( file[ 5 ] & SKIN_RLE ) )
+	{
+		if ( (unsigned int)( end - src ) < size )
+			return 0;
+		for ( unsigned int i = 0; i < size; i++ )
+			dst[ i ] = src[ i ];
+		return 1;
+	}
+
+	unsigned int pos = 0;
+	while ( pos < size )
+	{
+		if ( src >= end )
+			return 0;
+		unsigned int n = *( src++ );
+		if ( n < 128 )
+		{
+			n = ( n + 1 ) * unit;
+			if ( pos + n > size || src + n > end )
+				return 0;
+			for ( unsigned int i = 0; i < n; i++ )
+				dst[ pos ++ ] = *( src++ );
+		} else
+		{
+			n = 257 - n;
+			if ( pos + n * unit > size || src + unit > end )
+				return 0;
+			for ( unsigned int i = 0; i < n; i++ )
+				for ( unsigned int j = 0; j < unit; j++ )
+					dst[ pos ++ ] = src[ j ];
+			src += unit;
+		}
+	}
+	return 1;
+}
+
+#endif
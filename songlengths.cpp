@@ -0,0 +1,85 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ songlengths.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - song lengths of HVSC tunes from the prebuilt index (hvscformat.h)
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/timer.h>
+#include "helpers.h"
+#include "hvscformat.h"
+#include "songlengths.h"
+
+static HVSCINDEX slIndex = { SONGLENGTHS_INDEX, HVSC_SL_ENTRY_SIZE, 16, hvscIsSongLengths, HVSC_INDEX_UNKNOWN };
+
+u32 songLengthsStamp()
+{
+	return hvscIndexStamp( &slIndex );
+}
+
+u32 songLengthsLookup( CLogger *logger, const u8 *md5, u16 *lengths, u32 maxSongs )
+{
+	if ( slIndex.state == HVSC_INDEX_MISSING )
+		return 0;
+
+	u32 t0 = CTimer::GetClockTicks();
+
+	FATFS m_FileSystem;
+	if ( f_mount( &m_FileSystem, "SD:", 1 ) != FR_OK )
+		return 0;
+
+	FIL file;
+	if ( !hvscIndexOpen( &slIndex, &file ) )
+	{
+		f_mount( 0, "SD:", 0 );
+		return 0;
+	}
+
+	u32 nSongs = 0;
+
+	const u8 *entry = hvscIndexFind( &slIndex, &file, md5 );
+	if ( entry )
+	{
+		u32 ofs = hvscRead32( &slIndex.header[ 16 ] ) + hvscRead32( &entry[ 16 ] );
+		u8 data[ 2 + 256 * 2 ];
+
+		if ( hvscIndexRead( &file, ofs, data, 2 ) )
+		{
+			nSongs = min( 256, hvscRead16( data ) );
+			if ( !hvscIndexRead( &file, ofs + 2, data + 2, nSongs * 2 ) )
+				nSongs = 0;
+			for ( u32 i = 0; i < nSongs && i < maxSongs; i++ )
+				lengths[ i ] = hvscRead16( &data[ 2 + i * 2 ] );
+		}
+	}
+
+	f_close( &file );
+	f_mount( 0, "SD:", 0 );
+
+	logger->Write( "RaspiMenu", LogNotice, "song lengths: %u subtunes, lookup took %u us", nSongs, CTimer::GetClockTicks() - t0 );
+
+	return nSongs;
+}
@@ -0,0 +1,45 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ songlengths.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - song lengths of HVSC tunes from the prebuilt index (hvscformat.h)
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _songlengths_h
+#define _songlengths_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+#define SONGLENGTHS_INDEX		"SD:C64/songlengths.idx"
+
+// stamp of the index (see hvscformat.h), 0 if there is none. The header is read at the first call only.
+extern u32 songLengthsStamp();
+
+// looks up the tune by the MD5 of its .sid file, returns the number of subtunes (0: not found/no index),
+// at most 'maxSongs' lengths (seconds) are copied
+extern u32 songLengthsLookup( CLogger *logger, const u8 *md5, u16 *lengths, u32 maxSongs );
+
+#endif
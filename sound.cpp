@@ -29,14 +29,7 @@
 */
 #include "kernel_sid.h"
 
-#define WRITE_CHANNELS		2		// 1: Mono, 2: Stereo
-#define CHUNK_SIZE			2000	// number of samples, written to sound device at once
-
-#define FORMAT		SoundFormatSigned16
-#define TYPE		s16
-#define TYPE_SIZE	sizeof (s16)
-#define FACTOR		((1 << 15)-1)
-#define NULL_LEVEL	0
+extern CLogger *logger;
 
 // forward declarations
 void initPWMOutput();
@@ -44,11 +37,11 @@ void cbSound( void *d );
 void clearSoundBuffer();
 
 #ifdef USE_VCHIQ_SOUND
-short PCMBuffer[ PCMBufferSize ];
+static CVCHIQSoundBaseDevice *hdmiDevice = NULL;
+static u32 hdmiUnderrunsLast = 0;
 #endif
 
-u32 nSamplesPrecompute; 
-static int FirstBufferUpdate = 1;
+u32 nSamplesPrecompute, nSamplesStart; 
 u32 soundDebugCode;
 
 void initSoundOutput( CSoundBaseDevice **m_pSound, CVCHIQDevice *m_VCHIQ, u32 outputPWM, u32 outputHDMI )
@@ -67,27 +60,21 @@ void initSoundOutput( CSoundBaseDevice **m_pSound, CVCHIQDevice *m_VCHIQ, u32 ou
 	//( *m_pSound ) = new CPWMSoundBaseDevice( &m_Interrupt, SAMPLERATE, CHUNK_SIZE );
 	if ( (*m_pSound) == NULL )
 	{
-		( *m_pSound ) = new CVCHIQSoundBaseDevice( m_VCHIQ, SAMPLERATE, CHUNK_SIZE, VCHIQSoundDestinationHDMI );
-		( *m_pSound )->AllocateQueue( QUEUE_SIZE_MSECS );
-		( *m_pSound )->SetWriteFormat( FORMAT, WRITE_CHANNELS );
-		( *m_pSound )->RegisterNeedDataCallback( cbSound, (void*)( *m_pSound ) );
-	}
-
-	extern u32 SAMPLERATE_ADJUSTED;
-	SAMPLERATE_ADJUSTED = SAMPLERATE;
-	FirstBufferUpdate = 1;
+		hdmiProfileActive = hdmiProfileRequested;
+		logger->Write( "", LogNotice, "HDMI audio: %s profile", hdmiProfiles[ hdmiProfileActive ].name );
+
+		// the mixer renders directly into the span queue of the device, no intermediate PCM buffer and no copies
+		hdmiDevice = new CVCHIQSoundBaseDevice( m_VCHIQ, SAMPLERATE, hdmiProfiles[ hdmiProfileActive ].chunkSize, VCHIQSoundDestinationHDMI );
+		hdmiDevice->AllocateSpanQueue( PCM_QUEUE_FRAMES );
+		hdmiDevice->RegisterChunkCallback( cbSound, (void*)hdmiDevice );
+		( *m_pSound ) = hdmiDevice;
+	} else
+		hdmiDevice->ClearSpanQueue();
 
-	clearSoundBuffer();
-	PCMCountLast = PCMCountCur = 0;
-	nSamplesPrecompute = QUEUE_SIZE_MSECS * SAMPLERATE / 1000;
+	hdmiUnderrunsLast = 0;
+	nSamplesPrecompute = hdmiQueueFrames( SAMPLERATE );
+	nSamplesStart = hdmiStartFrames( SAMPLERATE );
 	soundDebugCode = 0;
-
-/*	for ( u32 i = 0; i < QUEUE_SIZE_MSECS * SAMPLERATE / 1000 * 3 / 2; i++ )
-	{
-		putSample( 0 );
-		putSample( 0 );
-	}*/
-
 #endif
 }
 
@@ -175,70 +162,71 @@ void initPWMOutput()
 //  \___|_  /_______  /\____|__  /___|    /_______  /\____/|____/|___|  /\____ | 
 //        \/        \/         \/                 \/                  \/      \/ 
 #ifdef USE_VCHIQ_SOUND
-u32 PCMCountLast, PCMCountCur;
-
-u32 samplesInBuffer()
-{
-	u32 nFrames;
-	if ( PCMCountLast <= PCMCountCur )
-		nFrames = PCMCountCur - PCMCountLast; else
-		nFrames = PCMCountCur + PCMBufferSize - PCMCountLast; 
-	return nFrames;
-}
 
-u32 samplesInBufferFree()
+s16 *hdmiReserveBlock()
 {
-	return PCMBufferSize - 16 - samplesInBuffer();
+	s16 *p = hdmiDevice->ReserveSpan( MIXER_BLOCK_SIZE );
+	if ( p == NULL )
+		hdmiSync.overruns ++;
+	return p;
 }
 
-bool pcmBufferFull()
+void hdmiCommitBlock()
 {
-	if ( ( (PCMCountCur+1) == (PCMCountLast) ) ||
-		 ( PCMCountCur == (PCMBufferSize-1) && PCMCountLast == 0 ) )
-		return true;
-
-	return false;	     
+	hdmiDevice->CommitSpan( MIXER_BLOCK_SIZE );
 }
-#endif
 
 //
-// callback called when more samples are needed by the HDMI sound playback
-// this code is incredibly ugly and inefficient (more memory copies than necessary)
+// callback called after the HDMI sound playback took a chunk from the span queue
+// the clock drift controller runs in the main loop of the kernel
 //
-#ifdef USE_VCHIQ_SOUND
 
-//
-// don't look too close... 
-// this is more than ugly, but the version without this copying has a bug when reaching the end of the buffer
-// presumably this happens when writing part 1 of two does not transfer all bytes and then we're loosing a frame 
-// once this is fixed, call 2x m_pSound->Write instead of copying the data to temp
-//
 void cbSound( void *d )
 {
 	extern u32 fillSoundBuffer;
 	fillSoundBuffer = 1;
-	return; 
+}
 
-	CSoundBaseDevice *m_pSound = (CSoundBaseDevice*)d;
-	extern u32 trackSampleProgress;
+// after this many chunks sent to the HDMI sound device we take over the VCHIQ callbacks
+#define HDMI_MANUAL_CALLBACK_AFTER	150
 
-	s32 nFramesComputed = samplesInBuffer();
-	s32 nFramesMax = m_pSound->GetQueueSizeFrames() - m_pSound->GetQueueFramesAvail();
-	trackSampleProgress = 1024 * 1024 + ( nFramesComputed - nFramesMax );
+//
+// called from the main loop of the SID kernels after the device took a chunk
+//
+void updateHDMISync( unsigned long long samplesElapsed )
+{
+	extern bool CVCHIQ_CB_Manual;
 
-	s32 nWriteFrames = min( nFramesComputed, nFramesMax );
+	// everything rendered, but not yet played: span queue + chunks in flight
+	s32 nFrames = hdmiDevice->GetSpanFramesQueued() + hdmiDevice->GetFramesInFlight();
 
-	if ( nWriteFrames * 2 + PCMCountLast > PCMBufferSize )
-	{
-		m_pSound->Write( &PCMBuffer[ PCMCountLast ], (PCMBufferSize - PCMCountLast) * TYPE_SIZE );
-		m_pSound->Write( &PCMBuffer[ 0 ], (2 * nWriteFrames - (PCMBufferSize - PCMCountLast)) * TYPE_SIZE );
-	} else
+	u32 underruns = hdmiDevice->GetSpanUnderruns();
+	bool underrun = underruns != hdmiUnderrunsLast;
+	hdmiUnderrunsLast = underruns;
+
+	if ( hdmiSyncUpdate( nFrames, underrun, samplesElapsed ) )
 	{
-		m_pSound->Write( &PCMBuffer[ PCMCountLast ], 2 * nWriteFrames * TYPE_SIZE );
+		// too many underruns with the low latency profile: use larger chunks and fill up the queue with silence
+		logger->Write( "", LogNotice, "HDMI audio: underruns, falling back to %s profile", hdmiProfiles[ hdmiProfileActive ].name );
+		hdmiDevice->SetChunkSize( hdmiProfiles[ hdmiProfileActive ].chunkSize );
+
+		nSamplesPrecompute = hdmiQueueFrames( SAMPLERATE );
+		nSamplesStart = hdmiStartFrames( SAMPLERATE );
+
+		// never in between hdmiReserveBlock/hdmiCommitBlock, the kernels reserve and commit within one block
+		while ( nFrames < hdmiSync.target )
+		{
+			s16 *p = hdmiDevice->ReserveSpan( MIXER_BLOCK_SIZE );
+			if ( p == NULL )
+				break;
+			memset( p, 0, MIXER_BLOCK_SIZE * 2 * sizeof( s16 ) );
+			hdmiDevice->CommitSpan( MIXER_BLOCK_SIZE );
+			nFrames += MIXER_BLOCK_SIZE;
+		}
 	}
-	PCMCountLast += nWriteFrames * 2;
-	PCMCountLast %= PCMBufferSize;
-	return;
+
+	if ( hdmiSync.updates == HDMI_MANUAL_CALLBACK_AFTER )
+		CVCHIQ_CB_Manual = true; 
 }
 
 #endif
@@ -248,8 +236,5 @@ void clearSoundBuffer()
 #ifdef USE_PWM_DIRECT
 	memset( sampleBuffer, 0, sizeof( u32 ) * 128 );
 #endif
-#ifdef USE_VCHIQ_SOUND
-	memset( PCMBuffer, 0, sizeof( short ) * PCMBufferSize );
-#endif
 }
 
@@ -30,14 +30,22 @@
 #ifndef _sound_h_
 #define _sound_h_
 
-#define PCMBufferSize (48000/4)
-#define QUEUE_SIZE_MSECS 	50		// size of the sound queue in milliseconds duration
-extern u32 nSamplesPrecompute; 
+#include "hdmisync.h"
+
+#define PCM_QUEUE_FRAMES	8192	// frames of the HDMI span queue (power of 2, multiple of MIXER_BLOCK_SIZE, must hold the fill target of every profile)
+extern u32 nSamplesPrecompute; 		// frames in the VCHIQ queue for the active profile
+extern u32 nSamplesStart;			// frames to emulate before starting HDMI playback
 
 extern u32 PWMRange;
 
 extern void initSoundOutput( CSoundBaseDevice **m_pSound = NULL, CVCHIQDevice *m_VCHIQ = NULL, u32 outputPWM = 0, u32 outputHDMI = 0 );
 extern void clearSoundBuffer();
+extern void updateHDMISync( unsigned long long samplesElapsed );
+
+// the SID kernels mix directly into the HDMI device queue, one MIXER_BLOCK_SIZE block at a time
+// (hdmiReserveBlock returns NULL if the queue is full, the block is then dropped and counted as overrun)
+extern s16 *hdmiReserveBlock();
+extern void hdmiCommitBlock();
 
 extern u32 sampleBuffer[ 128 ];
 extern u32 smpLast, smpCur;
@@ -56,14 +64,5 @@ static __attribute__( ( always_inline ) ) inline s32 getSample()
 	return ret;
 }
 
-extern short PCMBuffer[ PCMBufferSize ];
-extern u32 PCMCountLast, PCMCountCur;
-
-static __attribute__( ( always_inline ) ) inline void putSample( short s )
-{
-	PCMBuffer[ PCMCountCur ++ ]	= s;
-	PCMCountCur %= PCMBufferSize;
-}
-
 
 #endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ stilindex.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - STIL entries of HVSC tunes via the prebuilt index (hvscformat.h)
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/timer.h>
+#include "helpers.h"
+#include "hvscformat.h"
+#include "stilindex.h"
+
+// the index belongs to the STIL.txt on the SD card only if that has the size stored in the header
+static int stilIsValid( const u8 *header )
+{
+	FILINFO info;
+	return hvscIsStil( header ) && f_stat( STIL_TEXT, &info ) == FR_OK && (u32)info.fsize == hvscRead32( &header[ 16 ] );
+}
+
+static HVSCINDEX stilIndex = { STIL_INDEX, HVSC_STIL_ENTRY_SIZE, 8, stilIsValid, HVSC_INDEX_UNKNOWN };
+
+int stilPathKey( const char *path, u8 *key )
+{
+	static const char *hvscDirs[ 3 ] = { "/musicians/", "/games/", "/demos/" };
+
+	char p[ 1024 ];
+	u32 n = 0;
+	for ( ; path[ n ] && n < sizeof( p ) - 1; n++ )
+	{
+		char c = path[ n ] == '\\' ? '/' : path[ n ];
+		p[ n ] = ( c >= 'A' && c <= 'Z' ) ? c + 'a' - 'A' : c;
+	}
+	p[ n ] = 0;
+
+	for ( u32 i = 0; i < 3; i++ )
+	{
+		const char *h = strstr( p, hvscDirs[ i ] );
+		if ( h != NULL )
+		{
+			hvscPathKey( h, key );
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+u32 stilStamp()
+{
+	return hvscIndexStamp( &stilIndex );
+}
+
+u32 stilLookup( CLogger *logger, const char *path, char *text, u32 maxSize )
+{
+	u8 key[ 8 ];
+
+	text[ 0 ] = 0;
+	if ( stilIndex.state == HVSC_INDEX_MISSING || !stilPathKey( path, key ) )
+		return 0;
+
+	u32 t0 = CTimer::GetClockTicks();
+
+	FATFS m_FileSystem;
+	if ( f_mount( &m_FileSystem, "SD:", 1 ) != FR_OK )
+		return 0;
+
+	FIL file;
+	if ( !hvscIndexOpen( &stilIndex, &file ) )
+	{
+		f_mount( 0, "SD:", 0 );
+		return 0;
+	}
+
+	u32 ofs = 0, length = 0;
+
+	const u8 *entry = hvscIndexFind( &stilIndex, &file, key );
+	if ( entry )
+	{
+		ofs = hvscRead32( &entry[ 8 ] );
+		length = hvscRead32( &entry[ 12 ] );
+	}
+
+	f_close( &file );
+
+	// the entry itself: one seek into STIL.txt
+	if ( length > 0 )
+	{
+		length = min( length, maxSize - 1 );
+		if ( f_open( &file, STIL_TEXT, FA_READ | FA_OPEN_EXISTING ) != FR_OK )
+			length = 0; else
+		{
+			if ( !hvscIndexRead( &file, ofs, text, length ) )
+				length = 0;
+			f_close( &file );
+		}
+		text[ length ] = 0;
+	}
+
+	f_mount( 0, "SD:", 0 );
+
+	logger->Write( "RaspiMenu", LogNotice, "STIL: %u bytes, lookup took %u us", length, CTimer::GetClockTicks() - t0 );
+
+	return length;
+}
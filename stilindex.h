@@ -0,0 +1,48 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ stilindex.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - STIL entries of HVSC tunes via the prebuilt index (hvscformat.h)
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _stilindex_h
+#define _stilindex_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+#define STIL_INDEX				"SD:C64/stil.idx"
+#define STIL_TEXT				"SD:C64/STIL.txt"
+
+// hash of the HVSC part of the path (from /MUSICIANS/, /GAMES/ or /DEMOS/ on), returns 0 if the file is not in the HVSC
+extern int stilPathKey( const char *path, u8 *key );
+
+// stamp of the index (see hvscformat.h), 0 if there is none or if it does not match STIL.txt
+extern u32 stilStamp();
+
+// copies the STIL entry of the .sid file at 'path' (0-terminated, at most maxSize-1 characters), returns its length (0 = none)
+extern u32 stilLookup( CLogger *logger, const char *path, char *text, u32 maxSize );
+
+#endif
@@ -28,28 +28,37 @@
  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 				{
-					if ( visUpdate && visMode == 0 && bufferIsFreeI2C() > 1024 ) // oscilloscope
+					//
+					// this runs once per mixer block (not per sample), the samples come from the decimated ring of sidvis.h
+					//
+					if ( visUpdate && visMode == 0 ) // oscilloscope
 					{
-						if ( scopeX == 0 )
-							tftClearDirty();
-					
-						s32 y = 160 + min( 40, max( -40, ( left + right ) / 1 / 192 ) );
-						y = max( 10, min( 229, y ) );
-
-						if ( y != scopeValues[scopeX] )
+						// a few columns per block, as long as the latch output keeps up
+						for ( u32 n = 0; n < 4 && bufferIsFreeI2C() > 1024; n++ )
 						{
-							extern unsigned char tftFrameBuffer12Bit[ 240 * 240 * 3 / 2 ];
-							setDoubleWPixel12( scopeValues[scopeX], scopeX*2, *(u32*)&tftFrameBuffer12Bit[ scopeX * 2 * 3 / 2 + scopeValues[scopeX] * 240 * 3 / 2 ] );
-							setDoubleWPixel12( y, scopeX*2, 0xffffffff );
+							if ( scopeX == 0 )
+								tftClearDirty();
+						
+							// the ring holds (left+right)/2, one of the latest 4 decimated samples per column
+							s32 v = visRing[ ( visRingPos - 4 + n ) & ( VIS_RING_SIZE - 1 ) ];
+							s32 y = 160 + min( 40, max( -40, v / 96 ) );
+							y = max( 10, min( 229, y ) );
+
+							if ( y != scopeValues[scopeX] )
+							{
+								extern unsigned char tftFrameBuffer12Bit[ 240 * 240 * 3 / 2 ];
+								setDoubleWPixel12( scopeValues[scopeX], scopeX*2, *(u32*)&tftFrameBuffer12Bit[ scopeX * 2 * 3 / 2 + scopeValues[scopeX] * 240 * 3 / 2 ] );
+								setDoubleWPixel12( y, scopeX*2, 0xffffffff );
 
-							scopeValues[scopeX] = y;
-						}
+								scopeValues[scopeX] = y;
+							}
 
-						scopeX++;
-						if ( scopeX >= 118 )
-						{
-							//visUpdate = 0;
-							scopeX = 0;
+							scopeX++;
+							if ( scopeX >= 118 )
+							{
+								//visUpdate = 0;
+								scopeX = 0;
+							}
 						}
 
 						if ( visModeGotoNext )
@@ -224,7 +233,63 @@
 							}
 						}
 					} else
-					if ( visMode == 5 ) // transition vu meter -> level meter
+					if ( visMode == 6 ) // spectrum analyzer
+					{
+						if ( visUpdate )
+						{
+							visUpdate = 0;
+							tftClearDirty();
+
+							u8 bars[ VIS_BARS ];
+							visSpectrum( bars, VIS_BARS, VIS_BAR_MAX_HEIGHT );
+
+							for ( u32 b = 0; b < VIS_BARS; b++ )
+							{
+								u32 h = min( VIS_BAR_MAX_HEIGHT, (u32)( bars[ b ] * scaleVis ) );
+								u32 hPrev = visBarHeight[ b ];
+								const u32 x = VIS_BAR_X + b * VIS_BAR_PITCH;
+
+								// bars fall slowly
+								if ( h + 4 < hPrev )
+									h = hPrev - 4;
+
+								if ( h > hPrev ) // grow: green to red from the bottom
+								{
+									for ( u32 j = VIS_BAR_BOTTOM - h; j < VIS_BAR_BOTTOM - hPrev; j++ )
+									{
+										u32 t = ( VIS_BAR_BOTTOM - j ) * 255 / VIS_BAR_MAX_HEIGHT;
+										u32 c = rgb24to16( min( 255, t * 2 ), min( 255, ( 255 - t ) * 2 ), 48 );
+										for ( u32 i = x; i < x + VIS_BAR_WIDTH; i++ )
+											setPixelDirty( j, i, c );
+									}
+								} else
+								if ( h < hPrev ) // shrink: restore the background
+								{
+									for ( u32 j = VIS_BAR_BOTTOM - hPrev; j < VIS_BAR_BOTTOM - h; j++ )
+										for ( u32 i = x; i < x + VIS_BAR_WIDTH; i++ )
+											setPixelDirty( j, i, *(u16*)&tftBackground2[ (i + j * 240) * 2 ] );
+								}
+
+								visBarHeight[ b ] = h;
+							}
+						} else
+						{
+							if ( bufferEmptyI2C() )
+							{
+								if ( tftUpdateNextDirtyRegions() == 0 )
+								{
+									visUpdate = 1;
+									
+									if ( visModeGotoNext )
+									{
+										visModeGotoNext = 0;
+										visMode ++;
+									}
+								}
+							}
+						}
+					} else
+					if ( visMode == 5 || visMode == 7 ) // transition level meter -> spectrum, spectrum -> oscilloscope
 					{
 						if ( visUpdate )
 						{
@@ -240,7 +305,8 @@
 						{
 							visUpdate = 1;
 							visModeGotoNext = 0;
-							visMode = 0;
+							visMode = visMode == 5 ? 6 : 0;
+							memset( visBarHeight, 0, sizeof( visBarHeight ) );
 	
 							px = 120.0f;
 							dx = 0.0f;
@@ -29,6 +29,7 @@
 */
 
 #include "tft_st7789.h"
+#include "skinformat.h"
 
 #define OLED_DC		LATCH_LED2
 #define OLED_RES	LATCH_LED3
@@ -43,6 +44,7 @@ const u32 RAMWR = 0x2C; // write to display RAM
 #define CMD_SDA	(1<<2)
 #define CMD_RES	(2<<2)
 #define CMD_DC 	(3<<2)
+#define CMD_SCL_LOW_SDA	(0<<2|2)		// SCL low and SDA = bit 0 in one latch update (see prepareOutputLatch4Bit)
 
 #define TFT_SCK_LOW		put4BitCommand( CMD_SCL + 0 );
 #define TFT_SCK_HIGH	put4BitCommand( CMD_SCL + 1 );
@@ -69,28 +71,32 @@ void delay( u32 d )
 
 u32 lastBit = 0;
 
-// send a byte to the display
-void tftSendData( u8 d )
+// the latch commands for one byte, MSB first: SCL low together with the data bit, then SCL high (2 latch updates per bit,
+// instead of 2 or 3 with separate SDA changes). The ST7789 samples SDA at the rising edge of SCL.
+static u64 tftByteCommands[ 256 ];
+
+static void tftPrepareByteCommands()
 {
-	for ( u8 bit = 0x80; bit; bit >>= 1 )
+	for ( u32 d = 0; d < 256; d++ )
 	{
-		TFT_SCK_LOW
-
-		if ( ( d & bit ) && lastBit == 0 )
-		{
-			TFT_SDA_HIGH
-			lastBit = 1;
-		} else
-		if ( !( d & bit ) && lastBit == 1 )
+		u64 c = 0;
+		for ( u32 i = 0; i < 8; i++ )
 		{
-			TFT_SDA_LOW
-			lastBit = 0;
+			u32 b = ( d >> ( 7 - i ) ) & 1;
+			c |= (u64)( CMD_SCL_LOW_SDA + b ) << ( i * 8 );
+			c |= (u64)( CMD_SCL + 1 ) << ( i * 8 + 4 );
 		}
-
-		TFT_SCK_HIGH
+		tftByteCommands[ d ] = c;
 	}
 }
 
+// send a byte to the display
+void tftSendData( u8 d )
+{
+	put4BitCommands16( tftByteCommands[ d ] );
+	lastBit = d & 1;
+}
+
 void tftSendDataImm( u8 d )
 {
 	for ( u8 bit = 0x80; bit; bit >>= 1 )
@@ -181,6 +187,8 @@ static const u8 negGamma[] = { 0xD0, 0x00, 0x02, 0x07, 0x0A, 0x28, 0x31, 0x54, 0
 
 void tftInitDisplay() 
 {
+	tftPrepareByteCommands();
+
 	TFT_SDA_LOW
 	lastBit = 0;
 
@@ -226,6 +234,8 @@ void tftInitDisplay()
 
 void tftInitDisplayImm() 
 {
+	tftPrepareByteCommands();
+
 	TFTimm_SDA_LOW
 	TFT_SDA_LOW
 	lastBit = 0;
@@ -476,51 +486,53 @@ int tftSplashScreenFile( const char *drive, const char *fn )
 
 
 
-// loads a 24/32-bit, uncompressed Targa file
-int tftLoadTGA( const char *drive, const char *name, unsigned char *dst, int *imgWidth, int *imgHeight, int wantAlpha )
+// decodes a 24/32-bit, uncompressed Targa file
+static int tftDecodeTGA( const u8 *tga, unsigned char *dst, int *imgWidth, int *imgHeight, int wantAlpha )
 {
-	u8 tga[ 256 * 256 * 4 ];
-	u32 size;
-	extern CLogger *logger;
-	if ( readFile( logger, (char*)drive, name, tga, &size ) )
-	{
-		unsigned char *type = &tga[ 0 ];
-		if ( type[ 1 ] != 0 || ( type[ 2 ] != 2 && type[ 2 ] != 3 ) )
-			return 0;
-
-		unsigned char *info = &tga[ 12 ];
-		*imgWidth   = info[ 0 ] + info[ 1 ] * 256;
-		*imgHeight  = info[ 2 ] + info[ 3 ] * 256;
-		int imgBits = info[ 4 ];
+	const unsigned char *type = &tga[ 0 ];
+	if ( type[ 1 ] != 0 || ( type[ 2 ] != 2 && type[ 2 ] != 3 ) )
+		return 0;
 
-		if ( imgBits != 32 && imgBits != 24 )
-			return -1;
+	const unsigned char *info = &tga[ 12 ];
+	*imgWidth   = info[ 0 ] + info[ 1 ] * 256;
+	*imgHeight  = info[ 2 ] + info[ 3 ] * 256;
+	int imgBits = info[ 4 ];
 
-		int bytesPerPixel = imgBits / 8;
-		int bytesPerPixelTarget;
+	if ( imgBits != 32 && imgBits != 24 )
+		return -1;
 
-		if ( wantAlpha )
-			bytesPerPixelTarget = 4; else
-			bytesPerPixelTarget = 3;
+	int bytesPerPixel = imgBits / 8;
+	int bytesPerPixelTarget;
 
-		size = *imgWidth * *imgHeight;
+	if ( wantAlpha )
+		bytesPerPixelTarget = 4; else
+		bytesPerPixelTarget = 3;
 
-		for ( int j = 0; j < *imgHeight; j++ )
+	for ( int j = 0; j < *imgHeight; j++ )
+	{
+		unsigned char *p = &dst[ bytesPerPixelTarget * *imgWidth * ( *imgHeight - 1 - j ) ];
+		for ( int i = 0; i < *imgWidth * bytesPerPixel; i += bytesPerPixel )
 		{
-			unsigned char *p = &dst[ bytesPerPixelTarget * *imgWidth * ( *imgHeight - 1 - j ) ];
-			for ( int i = 0; i < *imgWidth * bytesPerPixel; i += bytesPerPixel )
-			{
-				*( p++ ) = tga[ i + 2 + 18 + j * *imgWidth * bytesPerPixel ];
-				*( p++ ) = tga[ i + 1 + 18 + j * *imgWidth * bytesPerPixel ];
-				*( p++ ) = tga[ i + 0 + 18 + j * *imgWidth * bytesPerPixel ];
-				if ( wantAlpha && imgBits == 32 )
-					*( p++ ) = tga[ i + 3 + 18 + j * *imgWidth * bytesPerPixel ]; else
-				if ( wantAlpha )
-					*( p++ ) = 255;
-			}
+			*( p++ ) = tga[ i + 2 + 18 + j * *imgWidth * bytesPerPixel ];
+			*( p++ ) = tga[ i + 1 + 18 + j * *imgWidth * bytesPerPixel ];
+			*( p++ ) = tga[ i + 0 + 18 + j * *imgWidth * bytesPerPixel ];
+			if ( wantAlpha && imgBits == 32 )
+				*( p++ ) = tga[ i + 3 + 18 + j * *imgWidth * bytesPerPixel ]; else
+			if ( wantAlpha )
+				*( p++ ) = 255;
 		}
-		return 1;
 	}
+	return 1;
+}
+
+// loads a 24/32-bit, uncompressed Targa file
+int tftLoadTGA( const char *drive, const char *name, unsigned char *dst, int *imgWidth, int *imgHeight, int wantAlpha )
+{
+	u8 tga[ 256 * 256 * 4 ];
+	u32 size;
+	extern CLogger *logger;
+	if ( readFile( logger, (char*)drive, name, tga, &size ) )
+		return tftDecodeTGA( tga, dst, imgWidth, imgHeight, wantAlpha );
 	return 0;
 }
 
@@ -575,57 +587,87 @@ bool tftIsDirtyRegion()
 }
 
 
-int tftUpdateNextDirtyRegions()
+//
+// the dirty tiles are sent as rectangles: starting at the next dirty tile the span of dirty tiles in this tile row is
+// extended downwards as long as the tiles below are dirty as well (and the rectangle has at most DIRTY_MAX_PIXELS).
+// Each window costs 11 bytes (CASET, RASET, RAMWR), a clean tile 24 bytes (12-bit), i.e. sending clean tiles to bridge
+// gaps, or the full screen, never saves bytes and only dirty tiles are merged.
+//
+#define DIRTY_TILES			( 240 / DIRTY_SIZE )
+#define DIRTY_MAX_PIXELS	1024
+
+// returns the next rectangle (in pixels) and marks its tiles as clean
+static int tftNextDirtyRect( u32 *x, u32 *y, u32 *w, u32 *h )
 {
 	if ( nDirtyRegions == 0 )
 		return 0;
 
-	while ( tftDirty[ curDirtyRegion ] == 0 && curDirtyRegion < ((240/DIRTY_SIZE)*(240/DIRTY_SIZE)) )
+	while ( curDirtyRegion < DIRTY_TILES * DIRTY_TILES && tftDirty[ curDirtyRegion ] == 0 )
 		curDirtyRegion ++;
-	
-	u32 x = ( curDirtyRegion % (240/DIRTY_SIZE) ) * DIRTY_SIZE;
-	u32 y = ( curDirtyRegion / (240/DIRTY_SIZE) ) * DIRTY_SIZE;
 
-	u16 c[ DIRTY_SIZE * DIRTY_SIZE ];
-	u16 *dst = &c[ 0 ];
+	if ( curDirtyRegion >= DIRTY_TILES * DIRTY_TILES )
+	{
+		nDirtyRegions = 0;
+		return 0;
+	}
 
-	for ( u32 j = 0; j < DIRTY_SIZE; j++ )
-		for ( u32 i = 0; i < DIRTY_SIZE; i++ )
-		{
-			*(dst++) = *(u16*)&tftFrameBuffer[ ((x+j) + (y+i) * 240) * 2 ];
-		}
+	u32 tx = curDirtyRegion % DIRTY_TILES;
+	u32 ty = curDirtyRegion / DIRTY_TILES;
+
+	u32 nx = 1;
+	while ( tx + nx < DIRTY_TILES && tftDirty[ curDirtyRegion + nx ] )
+		nx ++;
+
+	u32 ny = 1;
+	while ( ty + ny < DIRTY_TILES && nx * ( ny + 1 ) * DIRTY_SIZE * DIRTY_SIZE <= DIRTY_MAX_PIXELS )
+	{
+		u8 *t = &tftDirty[ tx + ( ty + ny ) * DIRTY_TILES ];
+		u32 i = 0;
+		while ( i < nx && t[ i ] ) i ++;
+		if ( i < nx )
+			break;
+		ny ++;
+	}
 
-	setMultiplePixels12( x, y, DIRTY_SIZE-1, DIRTY_SIZE-1, c );
+	for ( u32 j = 0; j < ny; j++ )
+		memset( &tftDirty[ tx + ( ty + j ) * DIRTY_TILES ], 0, nx );
+	nDirtyRegions -= nx * ny;
+	curDirtyRegion += nx;
 
-	tftDirty[ curDirtyRegion++ ] = 0;
-	nDirtyRegions --;
+	*x = tx * DIRTY_SIZE;	*w = nx * DIRTY_SIZE;
+	*y = ty * DIRTY_SIZE;	*h = ny * DIRTY_SIZE;
 	return 1;
 }
 
-int tftUpdateNextDirtyRegionsImm()
+// the frame buffer is transposed (see tftPrepareDirtyUpdates), the window is filled along y first
+static void tftGatherDirtyRect( u32 x, u32 y, u32 w, u32 h, u16 *c )
 {
-	if ( nDirtyRegions == 0 )
-		return 0;
-
-	while ( tftDirty[ curDirtyRegion ] == 0 && curDirtyRegion < ((240/DIRTY_SIZE)*(240/DIRTY_SIZE)) )
-		curDirtyRegion ++;
-	
-	u32 x = ( curDirtyRegion % (240/DIRTY_SIZE) ) * DIRTY_SIZE;
-	u32 y = ( curDirtyRegion / (240/DIRTY_SIZE) ) * DIRTY_SIZE;
+	for ( u32 j = 0; j < w; j++ )
+		for ( u32 i = 0; i < h; i++ )
+			*(c++) = *(u16*)&tftFrameBuffer[ ((x+j) + (y+i) * 240) * 2 ];
+}
 
-	u16 c[ DIRTY_SIZE * DIRTY_SIZE ];
-	u16 *dst = &c[ 0 ];
+int tftUpdateNextDirtyRegions()
+{
+	u32 x, y, w, h;
+	if ( !tftNextDirtyRect( &x, &y, &w, &h ) )
+		return 0;
 
-	for ( u32 j = 0; j < DIRTY_SIZE; j++ )
-		for ( u32 i = 0; i < DIRTY_SIZE; i++ )
-		{
-			*(dst++) = *(u16*)&tftFrameBuffer[ ((x+j) + (y+i) * 240) * 2 ];
-		}
+	u16 c[ DIRTY_MAX_PIXELS ];
+	tftGatherDirtyRect( x, y, w, h, c );
+	setMultiplePixels12( x, y, w-1, h-1, c );
+	return 1;
+}
 
-	setMultiplePixelsImm( x, y, DIRTY_SIZE-1, DIRTY_SIZE-1, c );
+int tftUpdateNextDirtyRegionsImm()
+{
+	u32 x, y, w, h;
+	if ( !tftNextDirtyRect( &x, &y, &w, &h ) )
+		return 0;
 
-	tftDirty[ curDirtyRegion++ ] = 0;
-	nDirtyRegions --;
+	u16 c[ DIRTY_MAX_PIXELS ];
+	tftGatherDirtyRect( x, y, w, h, c );
+	setMultiplePixelsImm( x, y, w-1, h-1, c );
 	return 1;
 }
 
@@ -714,11 +756,96 @@ void tftConvertFrameBuffer12Bit()
 
 
 
-int tftLoadBackgroundTGA( const char *drive, const char *name, int dither )
+//
+// the kernels load the same splash screens, logo and LED images every time they are started: the converted
+// (dithered, RGB565) backgrounds are kept in RAM, keyed by filename(s) and dither amount, and copied to tftBackground
+// on the next request. The slots are filled on first use and live as long as the menu, the oldest one is replaced.
+//
+#define TFT_CACHE_SLOTS		8
+#define TFT_CACHE_KEY		512
+#define TFT_CACHE_ANY_DITHER	-1		// skins are dithered already, they match any dither amount
+
+typedef struct
+{
+	char key[ TFT_CACHE_KEY ];
+	int  dither;
+	u32  lastUse;
+} TFTCACHESLOT;
+
+static TFTCACHESLOT tftCache[ TFT_CACHE_SLOTS ];
+static unsigned char tftCacheImage[ TFT_CACHE_SLOTS ][ 240 * 240 * 2 ];
+static u32 tftCacheTime = 0;
+
+static int tftCacheMakeKey( char *key, const char *name, const char *logo )
+{
+	if ( strlen( name ) + ( logo ? strlen( logo ) : 0 ) + 2 > TFT_CACHE_KEY )
+		return 0;
+	strcpy( key, name );
+	if ( logo )
+	{
+		strcat( key, "|" );
+		strcat( key, logo );
+	}
+	return 1;
+}
+
+static int tftCacheGet( const char *key, int dither )
+{
+	for ( int i = 0; i < TFT_CACHE_SLOTS; i++ )
+		if ( tftCache[ i ].key[ 0 ] && ( tftCache[ i ].dither == dither || tftCache[ i ].dither == TFT_CACHE_ANY_DITHER ) &&
+			 strcmp( tftCache[ i ].key, key ) == 0 )
+		{
+			memcpy( tftBackground, tftCacheImage[ i ], 240 * 240 * 2 );
+			tftCache[ i ].lastUse = ++ tftCacheTime;
+			return 1;
+		}
+	return 0;
+}
+
+static void tftCachePut( const char *key, int dither )
+{
+	int s = 0;
+	for ( int i = 1; i < TFT_CACHE_SLOTS; i++ )
+		if ( tftCache[ i ].lastUse < tftCache[ s ].lastUse )
+			s = i;
+
+	strcpy( tftCache[ s ].key, key );
+	tftCache[ s ].dither = dither;
+	tftCache[ s ].lastUse = ++ tftCacheTime;
+	memcpy( tftCacheImage[ s ], tftBackground, 240 * 240 * 2 );
+}
+
+// 'complete' is set if the image covered the whole background, i.e. the result does not depend on the previous one,
+// 'dither' is set to TFT_CACHE_ANY_DITHER if the result does not depend on it
+static int tftLoadBackground( const char *drive, const char *name, int *dither, int *complete )
 {
 	int w, h;
 
-	int r = tftLoadTGA( drive, name, tempTGA, &w, &h, false );
+	*complete = 1;
+
+	char key[ TFT_CACHE_KEY ];
+	int cacheable = tftCacheMakeKey( key, name, NULL );
+	if ( cacheable && tftCacheGet( key, *dither ) )
+		return 1;
+
+	u8 file[ 256 * 256 * 4 ];
+	u32 size;
+	extern CLogger *logger;
+	if ( !readFile( logger, (char*)drive, name, file, &size ) )
+		return 0;
+
+	// converted by Tools/skinconv: already dithered and in RGB565
+	if ( skinIsSkin( file, size ) )
+	{
+		if ( !skinDecode( file, size, SKIN_RGB565, 240, 240, tftBackground ) )
+			return 0;
+		*dither = TFT_CACHE_ANY_DITHER;
+		if ( cacheable )
+			tftCachePut( key, *dither );
+		return 1;
+	}
+
+	int r = tftDecodeTGA( file, tempTGA, &w, &h, false );
 
 	if ( r == 0 )
 		return 0;
@@ -729,26 +856,70 @@ int tftLoadBackgroundTGA( const char *drive, const char *name, int dither )
 		{
 			unsigned char *p = &tempTGA[ bytesPerPixel * ( x + y * w ) ];
 
-			if ( dither )
+			if ( *dither )
 			{
 				for ( int i = 0; i < 3; i++ )
-					p[ i ] = ditherColor( p[ i ], x, y, dither );
+					p[ i ] = ditherColor( p[ i ], x, y, *dither );
 			}
 
 			*(unsigned short*)&tftBackground[ ( x + y * 240 ) * 2 + 0 ] = rgb24to16( p[0], p[1], p[2] );
 		}
 
+	// smaller images leave parts of the previous background, these are not cached
+	*complete = w >= 240 && h >= 240;
+	if ( cacheable && *complete )
+		tftCachePut( key, *dither );
+
 	//tftCopyBackground2Framebuffer();
 	return 1;
 }
 
+int tftLoadBackgroundTGA( const char *drive, const char *name, int dither )
+{
+	int complete;
+	return tftLoadBackground( drive, name, &dither, &complete );
+}
+
+// splash screen with the (RGBA) logo blended on top, as shown by the kernels
+int tftLoadBackgroundWithLogo( const char *drive, const char *name, int dither, const char *logo )
+{
+	char key[ TFT_CACHE_KEY ];
+	int cacheable = tftCacheMakeKey( key, name, logo );
+	if ( cacheable && tftCacheGet( key, dither ) )
+		return 1;
+
+	int complete;
+	int r = tftLoadBackground( drive, name, &dither, &complete );
+
+	int w, h; 
+	if ( tftLoadTGA( drive, logo, tempTGA, &w, &h, true ) )
+	{
+		tftBlendRGBA( tempTGA, tftBackground, 0 );
+	} else
+		cacheable = 0;
+
+	// as above, a smaller splash screen leaves parts of the previous background
+	if ( cacheable && r && complete )
+		tftCachePut( key, dither );
+
+	return r;
+}
+
 
 void tftLoadCharset( const char *drive, const char *name )
 {
+	// the converted charset stays valid until a different one is loaded
+	static char charsetName[ 256 ] = { 0 };
+	if ( charsetName[ 0 ] && strcmp( charsetName, name ) == 0 )
+		return;
+
 	u32 size;
 	extern CLogger *logger;
 	if ( readFile( logger, (char*)drive, name, charset, &size ) )
 	{
+		if ( strlen( name ) < 256 )
+			strcpy( charsetName, name );
+
 		memset( rgbChars, 255, 256 * 16 * 16 );
 
 		for ( int c = 0; c < 256; c++ )
@@ -61,6 +61,7 @@ extern void tftInitImm();
 extern u32 rgb24to16( u32 r, u32 g, u32 b );
 extern int tftLoadTGA( const char *drive, const char *name, unsigned char *dst, int *imgWidth, int *imgHeight, int wantAlpha );
 extern int tftLoadBackgroundTGA( const char *drive, const char *name, int dither = 0 );
+extern int tftLoadBackgroundWithLogo( const char *drive, const char *name, int dither, const char *logo );
 extern void tftConvertFrameBuffer12Bit();
 extern void tftBlendRGBA( unsigned char *rgba, unsigned char *dst, int dither = 0 );
 extern void tftBlendRGBA( u32 r_, u32 g_, u32 b_, u32 a, unsigned char *dst, int dither );
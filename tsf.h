@@ -94,6 +94,34 @@ struct tsf_stream
 // Generic SoundFont loading method using the stream structure above
 TSFDEF tsf* tsf_load(struct tsf_stream* stream);
 
+// Random access to the sample data of a SoundFont for streamed loading
+struct tsf_sample_source
+{
+	// Custom data given to the function as the first parameter
+	void* data;
+
+	// Function pointer will be called to read 'size' bytes at absolute file position 'offset' into ptr (returns number of read bytes)
+	int (*read_at)(void* data, unsigned int offset, void* ptr, unsigned int size);
+};
+
+// Streamed SoundFont loading: only the preset/instrument/zone chunks are parsed from 'stream',
+// the sample data is read from 'source' by tsf_sample_cache_service and kept in an LRU cache of
+// at most 'cache_bytes' bytes (least recently used samples not playing are evicted). Selecting a
+// preset for a channel requests its samples, a note on of a region whose sample is not there yet
+// requests it and is skipped (counted as dropped note). Rendering and note handling never read from 'source'.
+TSFDEF tsf* tsf_load_streamed(struct tsf_stream* stream, const struct tsf_sample_source* source, unsigned int cache_bytes);
+
+// Reads requested sample data of a streamed SoundFont, at most 'max_bytes' bytes of the file per call
+// (to be called regularly from outside the rendering, e.g. the main loop). Returns 1 if it read anything.
+TSFDEF int tsf_sample_cache_service(tsf* f, unsigned int max_bytes);
+
+// Requests the samples of all regions of a preset of a streamed SoundFont (done by the channel preset functions)
+TSFDEF void tsf_sample_cache_request_preset(tsf* f, int preset_index);
+
+// Statistics of the sample cache of a streamed SoundFont (pointers may be NULL): hits and misses count
+// regions, dropped counts note ons of which at least one region was skipped because of a miss
+TSFDEF void tsf_get_sample_cache_stats(const tsf* f, unsigned int* bytes_used, unsigned int* hits, unsigned int* misses, unsigned int* dropped);
+
 // Free the memory related to this tsf instance
 TSFDEF void tsf_close(tsf* f);
 
@@ -318,6 +346,15 @@ struct tsf
 	enum TSFOutputMode outputmode;
 	float outSampleRate;
 	float globalGainDB;
+
+	// streamed sample data (fontSamples is NULL then)
+	struct tsf_sample_source sampleSource;
+	struct tsf_sample_cache* sampleCache;
+	int sampleCacheNum;
+	int *sampleQueue, sampleQueueHead, sampleQueueTail;
+	unsigned int fontSampleCount, fontSampleFileOffset;
+	unsigned int sampleCacheBytes, sampleCacheBytesMax, sampleCacheTick;
+	unsigned int sampleCacheHits, sampleCacheMisses, sampleCacheDropped;
 };
 
 #ifndef TSF_NO_STDIO
@@ -413,6 +450,16 @@ struct tsf_region
 	int freqModLFO, modLfoToPitch;
 	float delayVibLFO;
 	int freqVibLFO, vibLfoToPitch;
+	int sampleIndex;
+};
+
+struct tsf_sample_cache
+{
+	float* data;
+	unsigned int start, end, lastUse;
+	unsigned int loaded;	// samples read so far, the data is used by voices only when ready
+	int inUse;				// number of voices playing this sample
+	char ready, queued;
 };
 
 struct tsf_preset
@@ -427,10 +474,11 @@ struct tsf_voice
 {
 	int playingPreset, playingKey, playingChannel;
 	struct tsf_region* region;
+	float* input;
 	double pitchInputTimecents, pitchOutputFactor;
 	double sourceSamplePosition;
 	float  noteGainDB, panFactorLeft, panFactorRight;
-	unsigned int playIndex, loopStart, loopEnd;
+	unsigned int playIndex, loopStart, loopEnd, sampleEnd;
 	struct tsf_voice_envelope ampenv, modenv;
 	struct tsf_voice_lowpass lowpass;
 	struct tsf_voice_lfo modlfo, viblfo;
@@ -822,6 +870,7 @@ static void tsf_load_presets(tsf* res, struct tsf_hydra *hydra, unsigned int fon
 								if (zoneRegion.pitch_keycenter == -1) zoneRegion.pitch_keycenter = pshdr->originalPitch;
 								zoneRegion.tune += pshdr->pitchCorrection;
 								zoneRegion.sample_rate = pshdr->sampleRate;
+								zoneRegion.sampleIndex = pigen->genAmount.wordAmount;
 								if (zoneRegion.end && zoneRegion.end < fontSampleCount) zoneRegion.end++;
 								else zoneRegion.end = fontSampleCount;
 
@@ -1038,8 +1087,9 @@ static void tsf_voice_lfo_process(struct tsf_voice_lfo* e, int blockSamples)
 	else if (e->level < -1.0f) { e->delta = -e->delta; e->level = -2.0f - e->level; }
 }
 
-static void tsf_voice_kill(struct tsf_voice* v)
+static void tsf_voice_kill(tsf* f, struct tsf_voice* v)
 {
+	if (f->sampleCache && v->region->sampleIndex >= 0) f->sampleCache[v->region->sampleIndex].inUse--;
 	v->playingPreset = -1;
 }
 
@@ -1086,7 +1136,7 @@ static void tsf_voice_calcpitchratio(struct tsf_voice* v, float pitchShift, floa
 static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, int numSamples)
 {
 	struct tsf_region* region = v->region;
-	float* input = f->fontSamples;
+	float* input = v->input;
 	float* outL = outputBuffer;
 	//float* outR = (f->outputmode == TSF_STEREO_UNWEAVED ? outL + numSamples : TSF_NULL);
 
@@ -1096,7 +1146,7 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 	TSF_BOOL updateVibLFO = (v->viblfo.delta && (region->vibLfoToPitch));
 	TSF_BOOL isLooping    = (v->loopStart < v->loopEnd);
 	unsigned int tmpLoopStart = v->loopStart, tmpLoopEnd = v->loopEnd;
-	double tmpSampleEndDbl = (double)region->end, tmpLoopEndDbl = (double)tmpLoopEnd + 1.0;
+	double tmpSampleEndDbl = (double)v->sampleEnd, tmpLoopEndDbl = (double)tmpLoopEnd + 1.0;
 	double tmpSourceSamplePosition = v->sourceSamplePosition;
 	struct tsf_voice_lowpass tmpLowpass = v->lowpass;
 
@@ -1219,7 +1269,7 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 
 		if (tmpSourceSamplePosition >= tmpSampleEndDbl || v->ampenv.segment == TSF_SEGMENT_DONE)
 		{
-			tsf_voice_kill(v);
+			tsf_voice_kill(f, v);
 			return;
 		}
 	}
@@ -1368,7 +1418,7 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 
 		if (tmpSourceSamplePosition >= tmpSampleEndDbl || v->ampenv.segment == TSF_SEGMENT_DONE)
 		{
-			tsf_voice_kill(v);
+			tsf_voice_kill(f, v);
 			return;
 		}
 	}
@@ -1378,14 +1428,180 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 }
 */
 
-TSFDEF tsf* tsf_load(struct tsf_stream* stream)
+// Wraps a stream and keeps track of the absolute position (needed to locate the sample data for streamed loading)
+struct tsf_stream_counting { struct tsf_stream* stream; unsigned int pos; };
+static int tsf_stream_counting_read(struct tsf_stream_counting* c, void* ptr, unsigned int size) { int n = c->stream->read(c->stream->data, ptr, size); if (n > 0) c->pos += n; return n; }
+static int tsf_stream_counting_skip(struct tsf_stream_counting* c, unsigned int count) { if (!c->stream->skip(c->stream->data, count)) return 0; c->pos += count; return 1; }
+
+static void tsf_sample_cache_setup(tsf* res, int sampleNum)
+{
+	struct tsf_preset *preset, *presetEnd;
+	struct tsf_region *region, *regionEnd;
+	struct tsf_sample_cache *c;
+	int i;
+
+	res->sampleCacheNum = sampleNum;
+	res->sampleCache = (struct tsf_sample_cache*)TSF_MALLOC(sampleNum * sizeof(struct tsf_sample_cache));
+	for (i = 0; i < sampleNum; i++)
+	{
+		res->sampleCache[i].data = TSF_NULL;
+		res->sampleCache[i].start = res->fontSampleCount;
+		res->sampleCache[i].end = res->sampleCache[i].lastUse = res->sampleCache[i].loaded = 0;
+		res->sampleCache[i].inUse = 0;
+		res->sampleCache[i].ready = res->sampleCache[i].queued = 0;
+	}
+
+	// every sample is queued at most once, one extra entry to tell a full ring from an empty one
+	res->sampleQueue = (int*)TSF_MALLOC((sampleNum + 1) * sizeof(int));
+	res->sampleQueueHead = res->sampleQueueTail = 0;
+
+	// The block of a sample covers all regions using it, including the interpolation neighbour at the end and loop points.
+	for (preset = res->presets, presetEnd = preset + res->presetNum; preset != presetEnd; preset++)
+		for (region = preset->regions, regionEnd = region + preset->regionNum; region != regionEnd; region++)
+		{
+			unsigned int lo = region->offset, hi = region->end + 1;
+			if (region->sampleIndex < 0 || region->sampleIndex >= sampleNum) { region->sampleIndex = -1; continue; }
+			if (region->loop_mode != TSF_LOOPMODE_NONE && region->loop_start < region->loop_end)
+			{
+				if (region->loop_start < lo) lo = region->loop_start;
+				if (region->loop_end + 1 > hi) hi = region->loop_end + 1;
+			}
+			if (hi > res->fontSampleCount) hi = res->fontSampleCount;
+			c = &res->sampleCache[region->sampleIndex];
+			if (lo < c->start) c->start = lo;
+			if (hi > c->end) c->end = hi;
+		}
+}
+
+static void tsf_sample_cache_request(tsf* f, int sampleIndex)
+{
+	struct tsf_sample_cache* c;
+	if (sampleIndex < 0) return;
+	c = &f->sampleCache[sampleIndex];
+	if (c->ready || c->queued || c->end <= c->start) return;
+	c->queued = 1;
+	f->sampleQueue[f->sampleQueueTail] = sampleIndex;
+	if (++f->sampleQueueTail > f->sampleCacheNum) f->sampleQueueTail = 0;
+}
+
+// Called at note on: no file access, a missing sample is requested and the region is skipped.
+static TSF_BOOL tsf_sample_cache_fetch(tsf* f, int sampleIndex)
+{
+	struct tsf_sample_cache* c;
+	if (sampleIndex < 0) return TSF_FALSE;
+	c = &f->sampleCache[sampleIndex];
+	if (c->ready) { c->lastUse = ++f->sampleCacheTick; f->sampleCacheHits++; return TSF_TRUE; }
+	f->sampleCacheMisses++;
+	tsf_sample_cache_request(f, sampleIndex);
+	return TSF_FALSE;
+}
+
+// Allocates the block of the sample at the head of the queue, making room by evicting the least recently used samples which are not played right now.
+static TSF_BOOL tsf_sample_cache_alloc(tsf* f, struct tsf_sample_cache* c)
+{
+	unsigned int bytes = (c->end - c->start) * sizeof(float);
+	if (bytes > f->sampleCacheBytesMax) return TSF_FALSE;
+
+	while (f->sampleCacheBytes + bytes > f->sampleCacheBytesMax)
+	{
+		struct tsf_sample_cache *e, *eEnd, *victim = TSF_NULL;
+		for (e = f->sampleCache, eEnd = e + f->sampleCacheNum; e != eEnd; e++)
+			if (e->ready && e->inUse == 0 && (!victim || e->lastUse < victim->lastUse))
+				victim = e;
+		if (!victim) return TSF_FALSE;
+		TSF_FREE(victim->data);
+		victim->data = TSF_NULL;
+		victim->ready = 0;
+		victim->loaded = 0;
+		f->sampleCacheBytes -= (victim->end - victim->start) * sizeof(float);
+	}
+
+	// One extra sample as interpolation guard (in case the sample ends with the sample data chunk).
+	c->data = (float*)TSF_MALLOC(bytes + sizeof(float));
+	if (!c->data) return TSF_FALSE;
+	c->loaded = 0;
+	f->sampleCacheBytes += bytes;
+	return TSF_TRUE;
+}
+
+TSFDEF int tsf_sample_cache_service(tsf* f, unsigned int max_bytes)
+{
+	struct tsf_sample_cache* c;
+	unsigned int count, n, i;
+	float* out; short* in;
+
+	if (!f || !f->sampleCache || f->sampleQueueHead == f->sampleQueueTail) return 0;
+	c = &f->sampleCache[f->sampleQueue[f->sampleQueueHead]];
+	count = c->end - c->start;
+
+	if (!c->data && !tsf_sample_cache_alloc(f, c))
+	{
+		// does not fit (right now), a later note on requests it again
+		c->queued = 0;
+		if (++f->sampleQueueHead > f->sampleCacheNum) f->sampleQueueHead = 0;
+		return 0;
+	}
+
+	// The 16-bit sample data is read into the upper half of the buffer and converted to float in place, one part per call
+	// (each float is written after the short at the same index has been read, and covers only shorts which have been read before).
+	out = c->data;
+	in = (short*)out + count;
+	n = count - c->loaded;
+	if (n > max_bytes / sizeof(short)) n = max_bytes / sizeof(short);
+	if (n == 0) n = 1;
+	if (f->sampleSource.read_at(f->sampleSource.data, f->fontSampleFileOffset + (c->start + c->loaded) * sizeof(short), in + c->loaded, n * sizeof(short)) != (int)(n * sizeof(short)))
+	{
+		TSF_FREE(c->data);
+		c->data = TSF_NULL;
+		c->loaded = 0;
+		c->queued = 0;
+		f->sampleCacheBytes -= count * sizeof(float);
+		if (++f->sampleQueueHead > f->sampleCacheNum) f->sampleQueueHead = 0;
+		return 1;
+	}
+	for (i = c->loaded; i < c->loaded + n; i++)
+	{
+		short v = in[i];
+		out[i] = (float)(v / 32767.0);
+	}
+	c->loaded += n;
+
+	if (c->loaded == count)
+	{
+		out[count] = 0.0f;
+		c->ready = 1;
+		c->queued = 0;
+		c->lastUse = ++f->sampleCacheTick;
+		if (++f->sampleQueueHead > f->sampleCacheNum) f->sampleQueueHead = 0;
+	}
+	return 1;
+}
+
+TSFDEF void tsf_sample_cache_request_preset(tsf* f, int preset_index)
+{
+	struct tsf_region *region, *regionEnd;
+	if (!f->sampleCache || preset_index < 0 || preset_index >= f->presetNum) return;
+	for (region = f->presets[preset_index].regions, regionEnd = region + f->presets[preset_index].regionNum; region != regionEnd; region++)
+		tsf_sample_cache_request(f, region->sampleIndex);
+}
+
+static tsf* tsf_load_internal(struct tsf_stream* stream, const struct tsf_sample_source* source, unsigned int cache_bytes)
 {
 	tsf* res = TSF_NULL;
 	struct tsf_riffchunk chunkHead;
 	struct tsf_riffchunk chunkList;
 	struct tsf_hydra hydra;
 	float* fontSamples = TSF_NULL;
-	unsigned int fontSampleCount = 0;
+	unsigned int fontSampleCount = 0, fontSampleFileOffset = 0;
+	TSF_BOOL haveSamples = TSF_FALSE;
+	struct tsf_stream countingStream = { TSF_NULL, (int(*)(void*,void*,unsigned int))&tsf_stream_counting_read, (int(*)(void*,unsigned int))&tsf_stream_counting_skip };
+	struct tsf_stream_counting counting = { stream, 0 };
+
+	if (source)
+	{
+		countingStream.data = &counting;
+		stream = &countingStream;
+	}
 
 	if (!tsf_riffchunk_read(TSF_NULL, &chunkHead, stream) || !TSF_FourCCEquals(chunkHead.id, "sfbk"))
 	{
@@ -1426,9 +1642,17 @@ TSFDEF tsf* tsf_load(struct tsf_stream* stream)
 		{
 			while (tsf_riffchunk_read(&chunkList, &chunk, stream))
 			{
-				if (TSF_FourCCEquals(chunk.id, "smpl"))
+				if (TSF_FourCCEquals(chunk.id, "smpl") && source)
+				{
+					// Only remember where the sample data is, it is read on demand.
+					fontSampleCount = chunk.size / sizeof(short);
+					fontSampleFileOffset = counting.pos;
+					haveSamples = stream->skip(stream->data, chunk.size);
+				}
+				else if (TSF_FourCCEquals(chunk.id, "smpl"))
 				{
 					tsf_load_samples(&fontSamples, &fontSampleCount, &chunk, stream);
+					haveSamples = (fontSamples != TSF_NULL);
 				}
 				else stream->skip(stream->data, chunk.size);
 			}
@@ -1439,7 +1663,7 @@ TSFDEF tsf* tsf_load(struct tsf_stream* stream)
 	{
 		//if (e) *e = TSF_INVALID_INCOMPLETE;
 	}
-	else if (fontSamples == TSF_NULL)
+	else if (!haveSamples)
 	{
 		//if (e) *e = TSF_INVALID_NOSAMPLEDATA;
 	}
@@ -1450,9 +1674,17 @@ TSFDEF tsf* tsf_load(struct tsf_stream* stream)
 		res->presetNum = hydra.phdrNum - 1;
 		res->presets = (struct tsf_preset*)TSF_MALLOC(res->presetNum * sizeof(struct tsf_preset));
 		res->fontSamples = fontSamples;
+		res->fontSampleCount = fontSampleCount;
 		res->outSampleRate = 44100.0f;
 		fontSamples = TSF_NULL; //don't free below
 		tsf_load_presets(res, &hydra, fontSampleCount);
+		if (source)
+		{
+			res->sampleSource = *source;
+			res->fontSampleFileOffset = fontSampleFileOffset;
+			res->sampleCacheBytesMax = cache_bytes;
+			tsf_sample_cache_setup(res, hydra.shdrNum);
+		}
 	}
 	TSF_FREE(hydra.phdrs); TSF_FREE(hydra.pbags); TSF_FREE(hydra.pmods);
 	TSF_FREE(hydra.pgens); TSF_FREE(hydra.insts); TSF_FREE(hydra.ibags);
@@ -1461,6 +1693,24 @@ TSFDEF tsf* tsf_load(struct tsf_stream* stream)
 	return res;
 }
 
+TSFDEF tsf* tsf_load(struct tsf_stream* stream)
+{
+	return tsf_load_internal(stream, TSF_NULL, 0);
+}
+
+TSFDEF tsf* tsf_load_streamed(struct tsf_stream* stream, const struct tsf_sample_source* source, unsigned int cache_bytes)
+{
+	return tsf_load_internal(stream, source, cache_bytes);
+}
+
+TSFDEF void tsf_get_sample_cache_stats(const tsf* f, unsigned int* bytes_used, unsigned int* hits, unsigned int* misses, unsigned int* dropped)
+{
+	if (bytes_used) *bytes_used = f->sampleCacheBytes;
+	if (hits) *hits = f->sampleCacheHits;
+	if (misses) *misses = f->sampleCacheMisses;
+	if (dropped) *dropped = f->sampleCacheDropped;
+}
+
 TSFDEF void tsf_close(tsf* f)
 {
 	struct tsf_preset *preset, *presetEnd;
@@ -1469,6 +1719,14 @@ TSFDEF void tsf_close(tsf* f)
 		TSF_FREE(preset->regions);
 	TSF_FREE(f->presets);
 	TSF_FREE(f->fontSamples);
+	if (f->sampleCache)
+	{
+		int i;
+		for (i = 0; i < f->sampleCacheNum; i++)
+			TSF_FREE(f->sampleCache[i].data);
+		TSF_FREE(f->sampleCache);
+		TSF_FREE(f->sampleQueue);
+	}
 	TSF_FREE(f->voices);
 	if (f->channels) { TSF_FREE(f->channels->channels); TSF_FREE(f->channels); }
 	TSF_FREE(f->outputSamples);
@@ -1534,6 +1792,7 @@ TSFDEF void tsf_note_on(tsf* f, int preset_index, int key, float vel)
 {
 	short midiVelocity = (short)(vel * 127);
 	int voicePlayIndex;
+	TSF_BOOL dropped = TSF_FALSE;
 	struct tsf_region *region, *regionEnd;
 
 	if (preset_index < 0 || preset_index >= f->presetNum) return;
@@ -1543,9 +1802,12 @@ TSFDEF void tsf_note_on(tsf* f, int preset_index, int key, float vel)
 	voicePlayIndex = f->voicePlayIndex++;
 	for (region = f->presets[preset_index].regions, regionEnd = region + f->presets[preset_index].regionNum; region != regionEnd; region++)
 	{
-		struct tsf_voice *voice, *v, *vEnd; TSF_BOOL doLoop; float lowpassFilterQDB, lowpassFc;
+		struct tsf_voice *voice, *v, *vEnd; TSF_BOOL doLoop; float lowpassFilterQDB, lowpassFc; unsigned int sampleBase = 0;
 		if (key < region->lokey || key > region->hikey || midiVelocity < region->lovel || midiVelocity > region->hivel) continue;
 
+		// Page in the sample data of streamed SoundFonts.
+		if (f->sampleCache && !tsf_sample_cache_fetch(f, region->sampleIndex)) { dropped = TSF_TRUE; continue; }
+
 		voice = TSF_NULL, v = f->voices, vEnd = v + f->voiceNum;
 		if (region->group)
 		{
@@ -1570,6 +1832,7 @@ TSFDEF void tsf_note_on(tsf* f, int preset_index, int key, float vel)
 
 		voice->region = region;
 		voice->playingPreset = preset_index;
+		if (f->sampleCache) f->sampleCache[region->sampleIndex].inUse++;
 		voice->playingKey = key;
 		voice->playIndex = voicePlayIndex;
 		voice->noteGainDB = f->globalGainDB - region->attenuation - tsf_gainToDecibels(1.0f / vel);
@@ -1586,13 +1849,20 @@ TSFDEF void tsf_note_on(tsf* f, int preset_index, int key, float vel)
 			voice->panFactorRight = TSF_SQRTF(0.5f + region->pan);
 		}
 
-		// Offset/end.
-		voice->sourceSamplePosition = region->offset;
+		// Offset/end (relative to the sample block the voice reads from).
+		if (f->sampleCache)
+		{
+			voice->input = f->sampleCache[region->sampleIndex].data;
+			sampleBase = f->sampleCache[region->sampleIndex].start;
+		}
+		else voice->input = f->fontSamples;
+		voice->sourceSamplePosition = region->offset - sampleBase;
+		voice->sampleEnd = region->end - sampleBase;
 
 		// Loop.
 		doLoop = (region->loop_mode != TSF_LOOPMODE_NONE && region->loop_start < region->loop_end);
-		voice->loopStart = (doLoop ? region->loop_start : 0);
-		voice->loopEnd = (doLoop ? region->loop_end : 0);
+		voice->loopStart = (doLoop ? region->loop_start - sampleBase : 0);
+		voice->loopEnd = (doLoop ? region->loop_end - sampleBase : 0);
 
 		// Setup envelopes.
 		tsf_voice_envelope_setup(&voice->ampenv, &region->ampenv, key, midiVelocity, TSF_TRUE, f->outSampleRate);
@@ -1610,6 +1880,7 @@ TSFDEF void tsf_note_on(tsf* f, int preset_index, int key, float vel)
 		tsf_voice_lfo_setup(&voice->modlfo, region->delayModLFO, region->freqModLFO, f->outSampleRate);
 		tsf_voice_lfo_setup(&voice->viblfo, region->delayVibLFO, region->freqVibLFO, f->outSampleRate);
 	}
+	if (dropped) f->sampleCacheDropped++;
 }
 
 TSFDEF int tsf_bank_note_on(tsf* f, int bank, int preset_number, int key, float vel)
@@ -1757,6 +2028,7 @@ static void tsf_channel_applypitch(tsf* f, int channel, struct tsf_channel* c)
 TSFDEF void tsf_channel_set_presetindex(tsf* f, int channel, int preset_index)
 {
 	tsf_channel_init(f, channel)->presetIndex = (unsigned short)preset_index;
+	tsf_sample_cache_request_preset(f, preset_index);
 }
 
 TSFDEF int tsf_channel_set_presetnumber(tsf* f, int channel, int preset_number, int flag_mididrums)
@@ -1775,6 +2047,7 @@ TSFDEF int tsf_channel_set_presetnumber(tsf* f, int channel, int preset_number,
 	if (preset_index != -1)
 	{
 		c->presetIndex = (unsigned short)preset_index;
+		tsf_sample_cache_request_preset(f, preset_index);
 		return 1;
 	}
 	return 0;
@@ -1792,6 +2065,7 @@ TSFDEF int tsf_channel_set_bank_preset(tsf* f, int channel, int bank, int preset
 	if (preset_index == -1) return 0;
 	c->presetIndex = (unsigned short)preset_index;
 	c->bank = (unsigned short)bank;
+	tsf_sample_cache_request_preset(f, preset_index);
 	return 1;
 }
 
@@ -0,0 +1,103 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ workset.cpp
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - working set profiles for cache warming
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <circle/util.h>
+#include <circle/string.h>
+#include <stdio.h>
+#include "lowlevel_arm64.h"
+#include "helpers.h"
+#include "workset.h"
+
+WORKINGSET workingSet AAA;
+
+u32 workingSetProfile = 0;
+
+typedef struct
+{
+	u32 magic, tag, nLines;
+} WSHEADER;
+
+static u8 wsFile[ sizeof( WSHEADER ) + WS_MAX_LINES * sizeof( u16 ) ];
+
+bool wsLoad( CLogger *logger, const char *DRIVE, const char *filename, u32 tag )
+{
+	char fn[ 4096 ];
+	u32 size = 0;
+
+	workingSet.recording = 0;
+	workingSet.nLines = 0;
+
+	sprintf( fn, "%s.ws", filename );
+	if ( !getFileSize( logger, DRIVE, fn, &size ) || size < sizeof( WSHEADER ) || size > sizeof( wsFile ) ||
+		 !readFile( logger, DRIVE, fn, wsFile, &size ) )
+		return false;
+
+	WSHEADER *h = (WSHEADER*)wsFile;
+	if ( h->magic != WS_MAGIC || h->tag != tag || h->nLines > WS_MAX_LINES || size != sizeof( WSHEADER ) + h->nLines * sizeof( u16 ) )
+	{
+		logger->Write( "RaspiFlash", LogWarning, "ignoring working set %s", fn );
+		return false;
+	}
+
+	workingSet.nLines = h->nLines;
+	memcpy( workingSet.order, &wsFile[ sizeof( WSHEADER ) ], h->nLines * sizeof( u16 ) );
+
+	return true;
+}
+
+void wsSave( CLogger *logger, const char *DRIVE, const char *filename, u32 tag )
+{
+	char fn[ 4096 ];
+
+	WSHEADER *h = (WSHEADER*)wsFile;
+	h->magic = WS_MAGIC;
+	h->tag = tag;
+	h->nLines = workingSet.nLines;
+	memcpy( &wsFile[ sizeof( WSHEADER ) ], workingSet.order, h->nLines * sizeof( u16 ) );
+
+	sprintf( fn, "%s.ws", filename );
+	writeFile( logger, DRIVE, fn, wsFile, sizeof( WSHEADER ) + h->nLines * sizeof( u16 ) );
+}
+
+void wsStartRecording()
+{
+	memset( &workingSet, 0, sizeof( WORKINGSET ) );
+	workingSet.recording = 1;
+}
+
+void wsPreload( const u8 *base )
+{
+	// hints first such that the fetches overlap, then one access per line as the hints alone are not reliable
+	for ( u32 i = 0; i < workingSet.nLines; i++ )
+		CACHE_PRELOADL2KEEP( &base[ (u32)workingSet.order[ i ] << WS_LINE_SHIFT ] );
+
+	__attribute__((unused)) volatile u32 forceRead;
+	for ( u32 i = 0; i < workingSet.nLines; i++ )
+		forceRead = *(u32*)&base[ (u32)workingSet.order[ i ] << WS_LINE_SHIFT ];
+}
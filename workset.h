@@ -0,0 +1,87 @@
+/*
+  _________.__    .___      __   .__        __        _________   ________   _____
+ /   _____/|__| __| _/____ |  | _|__| ____ |  | __    \_   ___ \ /  _____/  /  |  |
+ \_____  \ |  |/ __ |/ __ \|  |/ /  |/ ___\|  |/ /    /    \  \//   __  \  /   |  |_
+ /        \|  / /_/ \  ___/|    <|  \  \___|    <     \     \___\  |__\  \/    ^   /
+/_______  /|__\____ |\___  >__|_ \__|\___  >__|_ \     \______  /\_____  /\____   |
+        \/         \/    \/     \/       \/     \/            \/       \/      |__|
+
+ workset.h
+
+ RasPiC64 - A framework for interfacing the C64 and a Raspberry Pi 3B/3B+
+          - working set profiles for cache warming
+ Copyright (c) 2019-2021 Carsten Dachsbacher <frenetic@dachsbacher.de>
+
+ Logo created with http://patorjk.com/software/taag/
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _workset_h
+#define _workset_h
+
+#include <circle/types.h>
+#include <circle/logger.h>
+
+//
+// instead of warming the caches with fixed recipes (reading the whole flash linearly and randomly) the kernels can
+// preload what the FIQ handler actually accessed during the first seconds of a previous launch of the same file:
+//
+// with 'CACHE_PROFILE ON' in the config file, a launch without a working set records every cache line of the flash
+// the handler reads from (in order of first access) and writes the list to <file>.ws. Later launches find this file
+// and preload exactly these lines in the recorded order, the generic warm-up is used when there is no working set.
+//
+#define WS_LINE_SHIFT		6
+#define WS_MAX_LINES		( ( 1024 + 8 ) * 1024 >> WS_LINE_SHIFT )	// covers flash_cacheoptimized_pool
+#define WS_PROFILE_CYCLES	( 5 * 1000000 )								// about 5 seconds of C64 time
+#define WS_MAGIC			0x31535753									// "SWS1"
+
+typedef struct
+{
+	u32 recording;
+	u32 nLines;
+	u32 visited[ WS_MAX_LINES / 32 ];
+	u16 order[ WS_MAX_LINES ];
+} WORKINGSET;
+
+extern WORKINGSET workingSet;
+
+// from the config file: record working sets for files which do not have one yet
+extern u32 workingSetProfile;
+
+// loads <filename>.ws, 'tag' must match the value stored with it (e.g. the number of banks)
+extern bool wsLoad( CLogger *logger, const char *DRIVE, const char *filename, u32 tag );
+
+// writes the recorded lines to <filename>.ws
+extern void wsSave( CLogger *logger, const char *DRIVE, const char *filename, u32 tag );
+
+// clears the working set and starts recording
+extern void wsStartRecording();
+
+// preloads the lines of the working set into the L2 cache in access order
+extern void wsPreload( const u8 *base );
+
+// FIQ handler: 'ofs' is the byte offset of the access relative to the base which is later passed to wsPreload
+static __attribute__( ( always_inline ) ) inline void wsRecord( u32 ofs )
+{
+	register u32 l = ofs >> WS_LINE_SHIFT;
+	if ( l < WS_MAX_LINES && !( workingSet.visited[ l >> 5 ] & ( 1 << ( l & 31 ) ) ) )
+	{
+		workingSet.visited[ l >> 5 ] |= 1 << ( l & 31 );
+		workingSet.order[ workingSet.nLines ++ ] = l;
+	}
+}
+
+#define WS_RECORD( ofs ) { if ( workingSet.recording ) wsRecord( ofs ); }
+
+#endif